@@ -26,7 +26,11 @@ class RequestType(enum.IntEnum):
     IsButtonPressed = 16,
     SetFrameAdvancing = 17,
     AdvanceFrame = 18,
-    GetCurrentFrame = 19
+    GetCurrentFrame = 19,
+    GetHLEProfile = 20,
+    ResetHLEProfile = 21,
+    StartFrameProfile = 27,
+    StopFrameProfile = 28
 
 
 CITRA_PORT = "45987"
@@ -320,3 +324,45 @@ class Citra:
         data = self._read_and_validate_header(
             raw_reply, request_id, RequestType.GetCurrentFrame)
         return data
+
+    # Gets the HLE service call profile as a JSON string.
+    def get_hle_profile(self):
+        request_data = struct.pack("II", 0, 0)
+        request, request_id = self._generate_header(
+            RequestType.GetHLEProfile, len(request_data))
+        request += request_data
+        self.socket.send(request)
+        raw_reply = self.socket.recv()
+        data = self._read_and_validate_header(
+            raw_reply, request_id, RequestType.GetHLEProfile)
+        return data.decode("utf-8") if data is not None else None
+
+    # Zeroes the HLE service call profile.
+    def reset_hle_profile(self):
+        request_data = struct.pack("II", 0, 0)
+        request, request_id = self._generate_header(
+            RequestType.ResetHLEProfile, len(request_data))
+        request += request_data
+        self.socket.send(request)
+        self.socket.recv()
+
+    # Starts recording the frame profiler timelines, dropping the previous recording.
+    def start_frame_profile(self):
+        request_data = struct.pack("II", 0, 0)
+        request, request_id = self._generate_header(
+            RequestType.StartFrameProfile, len(request_data))
+        request += request_data
+        self.socket.send(request)
+        self.socket.recv()
+
+    # Stops recording and gets the timelines as a Chrome trace-event JSON string.
+    def stop_frame_profile(self):
+        request_data = struct.pack("II", 0, 0)
+        request, request_id = self._generate_header(
+            RequestType.StopFrameProfile, len(request_data))
+        request += request_data
+        self.socket.send(request)
+        raw_reply = self.socket.recv()
+        data = self._read_and_validate_header(
+            raw_reply, request_id, RequestType.StopFrameProfile)
+        return data.decode("utf-8") if data is not None else None
@@ -13,6 +13,7 @@
 #include "common/assert.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "common/profiling.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/hle/service/dsp/dsp_dsp.h"
@@ -294,6 +295,7 @@ StereoFrame16 DspHle::Impl::GenerateCurrentFrame() {
 }
 
 bool DspHle::Impl::Tick() {
+    PROFILE_SCOPE("audio", "DspHle::Tick");
     if (!IsOutputAllowed())
         return false;
     // TODO: Check dsp::DSP semaphore (which indicates emulated program has finished writing to
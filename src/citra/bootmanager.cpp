@@ -14,6 +14,7 @@
 #include "citra/main.h"
 #include "citra/mii_selector.h"
 #include "citra/swkbd.h"
+#include "common/profiling.h"
 #include "common/scm_rev.h"
 #include "common/string_util.h"
 #include "core/3ds.h"
@@ -30,6 +31,8 @@
 EmuThread::EmuThread(Core::System& system, Screens* screens) : system{system}, screens{screens} {}
 
 void EmuThread::run() {
+    // The CPU, the HLE DSP and the GL renderer all run here
+    Common::Profiling::SetThreadName("EmuThread");
     screens->MakeCurrent();
     stop_run = false;
     while (!stop_run) {
@@ -249,6 +249,9 @@ void Config::Load() {
     Settings::values.use_virtual_sd = qt_config->value("use_virtual_sd", true).toBool();
     Settings::values.nand_dir = qt_config->value("nand_dir", "").toString().toStdString();
     Settings::values.sdmc_dir = qt_config->value("sdmc_dir", "").toString().toStdString();
+    Settings::values.use_content_cache = qt_config->value("use_content_cache", false).toBool();
+    Settings::values.content_cache_size_mb =
+        qt_config->value("content_cache_size_mb", 4096).toUInt();
     qt_config->endGroup();
     qt_config->beginGroup("System");
     Settings::values.region_value =
@@ -259,9 +262,16 @@ void Config::Load() {
     qt_config->endGroup();
     qt_config->beginGroup("Miscellaneous");
     Settings::values.log_filter = qt_config->value("log_filter", "*:Info").toString().toStdString();
+    Settings::values.log_binary = qt_config->value("log_binary", false).toBool();
+    Settings::values.dump_hle_profile = qt_config->value("dump_hle_profile", false).toBool();
+    qt_config->endGroup();
+    qt_config->beginGroup("Scripting");
+    Settings::values.rpc_port = static_cast<u16>(qt_config->value("rpc_port", 45987).toInt());
+    Settings::values.rpc_router_mode = qt_config->value("rpc_router_mode", false).toBool();
     qt_config->endGroup();
     qt_config->beginGroup("Hacks");
     Settings::values.priority_boost = qt_config->value("priority_boost", false).toBool();
+    Settings::values.skip_idle_loops = qt_config->value("skip_idle_loops", false).toBool();
     Settings::values.ticks_mode =
         static_cast<Settings::TicksMode>(qt_config->value("ticks_mode", 0).toInt());
     Settings::values.ticks = qt_config->value("ticks", 0).toULongLong();
@@ -477,6 +487,8 @@ void Config::Save() {
     qt_config->setValue("use_virtual_sd", Settings::values.use_virtual_sd);
     qt_config->setValue("nand_dir", QString::fromStdString(Settings::values.nand_dir));
     qt_config->setValue("sdmc_dir", QString::fromStdString(Settings::values.sdmc_dir));
+    qt_config->setValue("use_content_cache", Settings::values.use_content_cache);
+    qt_config->setValue("content_cache_size_mb", Settings::values.content_cache_size_mb);
     qt_config->endGroup();
     qt_config->beginGroup("System");
     qt_config->setValue("region_value", Settings::values.region_value);
@@ -485,9 +497,16 @@ void Config::Save() {
     qt_config->endGroup();
     qt_config->beginGroup("Miscellaneous");
     qt_config->setValue("log_filter", QString::fromStdString(Settings::values.log_filter));
+    qt_config->setValue("log_binary", Settings::values.log_binary);
+    qt_config->setValue("dump_hle_profile", Settings::values.dump_hle_profile);
+    qt_config->endGroup();
+    qt_config->beginGroup("Scripting");
+    qt_config->setValue("rpc_port", Settings::values.rpc_port);
+    qt_config->setValue("rpc_router_mode", Settings::values.rpc_router_mode);
     qt_config->endGroup();
     qt_config->beginGroup("Hacks");
     qt_config->setValue("priority_boost", Settings::values.priority_boost);
+    qt_config->setValue("skip_idle_loops", Settings::values.skip_idle_loops);
     qt_config->setValue("ticks_mode", static_cast<int>(Settings::values.ticks_mode));
     qt_config->setValue("ticks", static_cast<unsigned long long>(Settings::values.ticks));
     qt_config->setValue("ignore_format_reinterpretation",
@@ -16,6 +16,7 @@ ConfigureHacks::~ConfigureHacks() {}
 
 void ConfigureHacks::LoadConfiguration(Core::System& system) {
     ui->toggle_priority_boost->setChecked(Settings::values.priority_boost);
+    ui->toggle_skip_idle_loops->setChecked(Settings::values.skip_idle_loops);
     ui->combo_ticks_mode->setCurrentIndex(static_cast<int>(Settings::values.ticks_mode));
     ui->spinbox_ticks->setValue(static_cast<int>(Settings::values.ticks));
     ui->spinbox_ticks->setEnabled(Settings::values.ticks_mode == Settings::TicksMode::Custom);
@@ -32,6 +33,7 @@ void ConfigureHacks::LoadConfiguration(Core::System& system) {
 
 void ConfigureHacks::ApplyConfiguration(Core::System& system) {
     Settings::values.priority_boost = ui->toggle_priority_boost->isChecked();
+    Settings::values.skip_idle_loops = ui->toggle_skip_idle_loops->isChecked();
     Settings::values.ticks_mode =
         static_cast<Settings::TicksMode>(ui->combo_ticks_mode->currentIndex());
     Settings::values.ticks = static_cast<u64>(ui->spinbox_ticks->value());
@@ -43,6 +43,7 @@
 #include "common/logging/filter.h"
 #include "common/logging/log.h"
 #include "common/logging/text_formatter.h"
+#include "common/profiling.h"
 #include "common/scm_rev.h"
 #include "common/scope_exit.h"
 #include "core/3ds.h"
@@ -57,6 +58,7 @@
 #include "core/hle/service/nwm/nwm_ext.h"
 #include "core/hle/service/ptm/ptm.h"
 #include "core/loader/loader.h"
+#include "core/memory.h"
 #include "core/movie.h"
 #include "core/rpc/rpc_server.h"
 #include "core/settings.h"
@@ -401,6 +403,11 @@ void GMainWindow::ConnectMenuEvents() {
     connect(ui.action_Cheats, &QAction::triggered, this, &GMainWindow::OnCheats);
     connect(ui.action_Control_Panel, &QAction::triggered, this, &GMainWindow::OnControlPanel);
     connect(ui.action_Dump_RAM, &QAction::triggered, this, &GMainWindow::OnDumpRAM);
+    connect(ui.action_Record_Frame_Profile, &QAction::triggered, this,
+            &GMainWindow::OnRecordFrameProfile);
+#ifndef ENABLE_FRAME_PROFILER
+    ui.action_Record_Frame_Profile->setVisible(false);
+#endif
 
     // View
     ui.action_Show_Filter_Bar->setShortcut(QKeySequence("CTRL+F"));
@@ -883,6 +890,11 @@ void GMainWindow::OnCIAInstallReport(Service::AM::InstallStatus status, const QS
                                       "before being used with Citra. A real console is required.")
                                   .arg(filename));
         break;
+    case Service::AM::InstallStatus::ErrorHashMismatch:
+        QMessageBox::critical(
+            this, "Corrupted File",
+            QString("%1 is corrupted, a content doesn't match its hash").arg(filename));
+        break;
     }
 }
 
@@ -1372,6 +1384,21 @@ void GMainWindow::OnDumpRAM() {
     LOG_INFO(Frontend, "Memory dump finished.");
 }
 
+void GMainWindow::OnRecordFrameProfile(bool checked) {
+    if (checked) {
+        Common::Profiling::Start();
+        return;
+    }
+    Common::Profiling::Stop();
+    const auto path{QFileDialog::getSaveFileName(this, "Save Frame Profile", QString(),
+                                                 "Chrome Trace (*.json)")};
+    if (path.isEmpty())
+        return;
+    const std::string json{Common::Profiling::ExportChromeTrace()};
+    if (FileUtil::WriteStringToFile(true, json, path.toStdString().c_str()) != json.size())
+        LOG_ERROR(Frontend, "Failed to write the frame profile to {}", path.toStdString());
+}
+
 void GMainWindow::UpdatePerfStats() {
     if (!emu_thread) {
         perf_stats_update_timer.stop();
@@ -1389,6 +1416,9 @@ void GMainWindow::UpdatePerfStats() {
                                       .arg(results.emulation_speed * 100.0, 0, 'f', 0)
                                       .arg(results.program_fps, 0, 'f', 0)
                                       .arg(results.frametime * 1000.0, 0, 'f', 2));
+    perf_stats_label->setToolTip(
+        QString("Performance information (Speed | FPS | Frametime)\nGuest memory in use: %1 MiB")
+            .arg(Memory::GetCommittedBytes() / 0x100000));
     perf_stats_label->setVisible(true);
 }
 
@@ -1632,8 +1662,15 @@ int main(int argc, char* argv[]) {
     Log::Filter log_filter;
     log_filter.ParseFilterString(Settings::values.log_filter);
     Log::SetGlobalFilter(log_filter);
-    Log::AddBackend(std::make_unique<Log::FileBackend>(
-        FileUtil::GetUserPath(FileUtil::UserPath::UserDir) + LOG_FILE));
+    auto file_backend{std::make_unique<Log::FileBackend>(
+        FileUtil::GetUserPath(FileUtil::UserPath::UserDir) + LOG_FILE)};
+    if (Settings::values.log_binary) {
+        // The binary log gets every message, the text log only the important ones
+        file_backend->SetFilter(Log::Filter{Log::Level::Info});
+        Log::AddBackend(std::make_unique<Log::BinaryFileBackend>(
+            FileUtil::GetUserPath(FileUtil::UserPath::UserDir) + LOG_BINARY_FILE));
+    }
+    Log::AddBackend(std::move(file_backend));
     ToggleConsole();
     config.LogErrors();
     Settings::LogSettings();
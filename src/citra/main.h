@@ -116,6 +116,7 @@ private slots:
     void OnStopRecordingPlayback();
     void OnCaptureScreenshot();
     void OnDumpRAM();
+    void OnRecordFrameProfile(bool checked);
     void OnCoreError(Core::System::ResultStatus, const std::string&);
 
     /// Called when user selects Help -> About Citra
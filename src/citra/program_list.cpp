@@ -22,6 +22,7 @@
 #include <QTreeView>
 #include "citra/main.h"
 #include "citra/program_list.h"
+#include "citra/program_list_cache.h"
 #include "citra/program_list_p.h"
 #include "citra/program_list_worker.h"
 #include "citra/ui_settings.h"
@@ -571,7 +572,9 @@ void ProgramList::PopulateAsync(QList<UISettings::AppDir>& program_dirs) {
     item_model->removeRows(0, item_model->rowCount());
     search_field->clear();
     emit ShouldCancelWorker();
-    auto worker{new ProgramListWorker(system, program_dirs)};
+    if (!metadata_cache)
+        metadata_cache = std::make_shared<ProgramMetadataCache>();
+    auto worker{new ProgramListWorker(system, program_dirs, metadata_cache)};
     connect(worker, &ProgramListWorker::EntryReady, this, &ProgramList::AddEntry,
             Qt::QueuedConnection);
     connect(worker, &ProgramListWorker::DirEntryReady, this, &ProgramList::AddDirEntry,
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <memory>
 #include <QString>
 #include <QWidget>
 #include "common/common_types.h"
@@ -14,6 +15,7 @@ class System;
 } // namespace Core
 
 class ProgramListWorker;
+class ProgramMetadataCache;
 class ProgramListDir;
 class ProgramListSearchField;
 class GMainWindow;
@@ -100,6 +102,7 @@ private:
     QTreeView* tree_view;
     QStandardItemModel* item_model;
     ProgramListWorker* current_worker;
+    std::shared_ptr<ProgramMetadataCache> metadata_cache;
     QFileSystemWatcher* watcher;
     Core::System& system;
 
@@ -0,0 +1,148 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <QByteArray>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QString>
+#include "citra/program_list_cache.h"
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+
+namespace {
+
+constexpr quint32 CACHE_MAGIC{0x4C504D43}; // "CMPL"
+constexpr quint32 CACHE_VERSION{2};
+
+QString GetCachePath() {
+    return QString::fromStdString(FileUtil::GetUserPath(FileUtil::UserPath::CacheDir) +
+                                  "program_list.bin");
+}
+
+/// Identifies the AES keys and seed database by the modification time and size of their files
+u64 GetKeysFingerprint() {
+    const std::string sysdata_dir{FileUtil::GetUserPath(FileUtil::UserPath::SysDataDir)};
+    std::array<s64, 4> state{};
+    std::size_t i{};
+    for (const char* name : {AES_KEYS, "seeddb.bin"}) {
+        QFileInfo info{QString::fromStdString(sysdata_dir + name)};
+        if (info.exists()) {
+            state[i] = info.lastModified().toMSecsSinceEpoch();
+            state[i + 1] = info.size();
+        }
+        i += 2;
+    }
+    return Common::ComputeStructHash64(state);
+}
+
+} // Anonymous namespace
+
+ProgramMetadataCache::ProgramMetadataCache() {
+    Load();
+}
+
+void ProgramMetadataCache::Load() {
+    QFile file{GetCachePath()};
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+    QDataStream stream{&file};
+    quint32 magic, version, count;
+    quint64 fingerprint;
+    stream >> magic >> version >> fingerprint >> count;
+    if (stream.status() != QDataStream::Ok || magic != CACHE_MAGIC || version != CACHE_VERSION) {
+        LOG_INFO(Frontend, "Ignoring outdated program list cache");
+        return;
+    }
+    keys_fingerprint = fingerprint;
+    entries.reserve(count);
+    for (quint32 i{}; i < count; ++i) {
+        QString path;
+        qint64 modified_time, update_modified_time;
+        quint64 size, program_id, extdata_id;
+        quint32 file_type;
+        QByteArray smdh;
+        stream >> path >> modified_time >> size >> update_modified_time >> program_id >>
+            extdata_id >> file_type >> smdh;
+        if (stream.status() != QDataStream::Ok) {
+            LOG_ERROR(Frontend, "Program list cache is corrupted");
+            entries.clear();
+            return;
+        }
+        ProgramMetadata metadata{program_id, extdata_id,
+                                 static_cast<Loader::FileType>(file_type),
+                                 std::vector<u8>(smdh.begin(), smdh.end())};
+        entries.insert_or_assign(
+            path.toStdString(),
+            Entry{modified_time, size, update_modified_time, std::move(metadata)});
+    }
+}
+
+void ProgramMetadataCache::CheckKeys() {
+    const u64 fingerprint{GetKeysFingerprint()};
+    std::lock_guard lock{mutex};
+    if (fingerprint == keys_fingerprint)
+        return;
+    if (!entries.empty())
+        LOG_INFO(Frontend, "AES keys or seed database changed, rescanning all programs");
+    entries.clear();
+    keys_fingerprint = fingerprint;
+    is_dirty = true;
+}
+
+ProgramMetadataCache::Entry* ProgramMetadataCache::FindEntry(const std::string& path,
+                                                            s64 modified_time, u64 size) {
+    auto itr{entries.find(path)};
+    if (itr == entries.end() || itr->second.modified_time != modified_time ||
+        itr->second.size != size)
+        return nullptr;
+    return &itr->second;
+}
+
+void ProgramMetadataCache::Store(const std::string& path, s64 modified_time, u64 size,
+                                 s64 update_modified_time, const ProgramMetadata& metadata) {
+    std::lock_guard lock{mutex};
+    entries.insert_or_assign(path,
+                             Entry{modified_time, size, update_modified_time, metadata, true});
+    is_dirty = true;
+}
+
+void ProgramMetadataCache::Save(bool prune) {
+    std::lock_guard lock{mutex};
+    if (prune)
+        for (auto itr{entries.begin()}; itr != entries.end();) {
+            if (itr->second.is_used) {
+                itr->second.is_used = false;
+                ++itr;
+                continue;
+            }
+            itr = entries.erase(itr);
+            is_dirty = true;
+        }
+    if (!is_dirty)
+        return;
+    FileUtil::CreateFullPath(FileUtil::GetUserPath(FileUtil::UserPath::CacheDir));
+    QFile file{GetCachePath()};
+    if (!file.open(QIODevice::WriteOnly)) {
+        LOG_ERROR(Frontend, "Couldn't write program list cache");
+        return;
+    }
+    QDataStream stream{&file};
+    stream << CACHE_MAGIC << CACHE_VERSION << static_cast<quint64>(keys_fingerprint)
+           << static_cast<quint32>(entries.size());
+    for (const auto& [path, entry] : entries)
+        stream << QString::fromStdString(path) << static_cast<qint64>(entry.modified_time)
+               << static_cast<quint64>(entry.size)
+               << static_cast<qint64>(entry.update_modified_time)
+               << static_cast<quint64>(entry.metadata.program_id)
+               << static_cast<quint64>(entry.metadata.extdata_id)
+               << static_cast<quint32>(entry.metadata.file_type)
+               << QByteArray(reinterpret_cast<const char*>(entry.metadata.smdh.data()),
+                             static_cast<int>(entry.metadata.smdh.size()));
+    is_dirty = false;
+}
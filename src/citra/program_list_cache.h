@@ -0,0 +1,93 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+#include "core/loader/loader.h"
+
+/// What the program list shows for a file, as read through its loader
+struct ProgramMetadata {
+    u64 program_id{};
+    u64 extdata_id{};
+    Loader::FileType file_type{Loader::FileType::Error}; ///< Error if the file couldn't be loaded
+    std::vector<u8> smdh;                                ///< From the update title if installed
+};
+
+/**
+ * On-disk index of program metadata, keyed by path and validated by modification time and size,
+ * so the program list only has to open files that changed since the last scan. As decrypting the
+ * metadata depends on the AES keys and seed database, the whole index is dropped when they change.
+ * Thread-safe.
+ */
+class ProgramMetadataCache {
+public:
+    ProgramMetadataCache();
+
+    /**
+     * Looks up the metadata of a file
+     * @param modified_time Current modification time of the file, in ms since the epoch
+     * @param size Current size of the file
+     * @param update_modified_time Function returning the modification time of the update title
+     * for a program ID, or 0 if it isn't installed
+     */
+    template <typename UpdateTimeGetter>
+    std::optional<ProgramMetadata> Find(const std::string& path, s64 modified_time, u64 size,
+                                        UpdateTimeGetter&& update_modified_time) {
+        u64 program_id;
+        {
+            std::lock_guard lock{mutex};
+            const Entry* entry{FindEntry(path, modified_time, size)};
+            if (!entry)
+                return {};
+            program_id = entry->metadata.program_id;
+        }
+        // Stats the update title, so the other workers aren't held up meanwhile
+        const s64 current_update_time{update_modified_time(program_id)};
+        std::lock_guard lock{mutex};
+        Entry* entry{FindEntry(path, modified_time, size)};
+        if (!entry || entry->metadata.program_id != program_id ||
+            entry->update_modified_time != current_update_time)
+            return {};
+        entry->is_used = true;
+        return entry->metadata;
+    }
+
+    /// Drops all entries if the AES keys or seed database changed, to be called before each scan
+    void CheckKeys();
+
+    void Store(const std::string& path, s64 modified_time, u64 size, s64 update_modified_time,
+               const ProgramMetadata& metadata);
+
+    /**
+     * Writes the index to disk if anything changed since it was loaded
+     * @param prune Whether to drop entries that weren't looked up or stored since the last save,
+     * only to be used after a complete scan
+     */
+    void Save(bool prune);
+
+private:
+    struct Entry {
+        s64 modified_time;
+        u64 size;
+        s64 update_modified_time;
+        ProgramMetadata metadata;
+        bool is_used{};
+    };
+
+    void Load();
+
+    /// Returns the entry of the file if it didn't change, the mutex must be held
+    Entry* FindEntry(const std::string& path, s64 modified_time, u64 size);
+
+    std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+    u64 keys_fingerprint{}; ///< Of the key files the entries were read with
+    bool is_dirty{};
+};
@@ -2,12 +2,17 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <memory>
+#include <thread>
+#include <QDateTime>
 #include <QFileInfo>
 #include "citra/program_list.h"
+#include "citra/program_list_cache.h"
 #include "citra/program_list_p.h"
 #include "citra/program_list_worker.h"
 #include "citra/ui_settings.h"
+#include "common/thread_pool.h"
 #include "core/hle/service/am/am.h"
 #include "core/hle/service/fs/archive.h"
 #include "core/loader/loader.h"
@@ -19,67 +24,131 @@ static bool HasSupportedFileExtension(const std::string& file_name) {
     return ProgramList::supported_file_extensions.contains(file.suffix(), Qt::CaseInsensitive);
 }
 
+/// Number of files read in parallel before their entries are added
+constexpr std::size_t SCAN_BATCH_SIZE{64};
+
+/// Opening the files is I/O bound on network storage, so the scan uses more threads than cores
+Common::ThreadPool& GetScanPool() {
+    // The thread calling ParallelFor takes part too
+    static Common::ThreadPool thread_pool{std::max(std::thread::hardware_concurrency(), 4u) - 1};
+    return thread_pool;
+}
+
+/// Whether a read went through, or the loader doesn't have that information at all
+bool IsReadComplete(Loader::ResultStatus status) {
+    return status == Loader::ResultStatus::Success ||
+           status == Loader::ResultStatus::ErrorNotUsed ||
+           status == Loader::ResultStatus::ErrorNotImplemented;
+}
+
 } // Anonymous namespace
 
-void ProgramListWorker::AddFstEntriesToProgramList(const std::string& dir_path,
-                                                   unsigned int recursion,
-                                                   ProgramListDir* parent_dir) {
-    const auto callback{[this, recursion, parent_dir](u64* num_entries_out,
-                                                      const std::string& directory,
-                                                      const std::string& virtual_name) -> bool {
+s64 ProgramListWorker::GetUpdateModifiedTime(u64 program_id) {
+    if (program_id < 0x0004000000000000 || program_id > 0x00040000FFFFFFFF)
+        return 0;
+    QFileInfo update{QString::fromStdString(Service::AM::GetProgramContentPath(
+        Service::FS::MediaType::SDMC, program_id + 0x0000000E00000000))};
+    return update.exists() ? update.lastModified().toMSecsSinceEpoch() : 0;
+}
+
+ProgramMetadata ProgramListWorker::ReadMetadata(const std::string& path) {
+    QFileInfo info{QString::fromStdString(path)};
+    const s64 modified_time{info.lastModified().toMSecsSinceEpoch()};
+    const u64 size{static_cast<u64>(info.size())};
+    auto cached{metadata_cache->Find(path, modified_time, size, GetUpdateModifiedTime)};
+    if (cached)
+        return std::move(*cached);
+    ProgramMetadata metadata;
+    // Reads fail without the keys or seed of an encrypted program, which may be added later, so
+    // incomplete metadata isn't cached
+    bool is_complete{};
+    auto loader{Loader::GetLoader(system, path)};
+    if (loader) {
+        metadata.file_type = loader->GetFileType();
+        is_complete = metadata.file_type != Loader::FileType::Error;
+        is_complete &= IsReadComplete(loader->ReadProgramId(metadata.program_id));
+        is_complete &= IsReadComplete(loader->ReadExtdataId(metadata.extdata_id));
+        is_complete &= IsReadComplete(loader->ReadIcon(metadata.smdh));
+        if (GetUpdateModifiedTime(metadata.program_id)) {
+            auto update_path{Service::AM::GetProgramContentPath(
+                Service::FS::MediaType::SDMC, metadata.program_id + 0x0000000E00000000)};
+            auto update_loader{Loader::GetLoader(system, update_path)};
+            if (update_loader) {
+                std::vector<u8> update_smdh;
+                is_complete &= IsReadComplete(update_loader->ReadIcon(update_smdh));
+                metadata.smdh = std::move(update_smdh);
+            }
+        }
+    }
+    if (is_complete)
+        metadata_cache->Store(path, modified_time, size,
+                              GetUpdateModifiedTime(metadata.program_id), metadata);
+    return metadata;
+}
+
+void ProgramListWorker::CollectProgramPaths(const std::string& dir_path, unsigned int recursion,
+                                            std::vector<std::string>& paths) {
+    const auto callback{[this, recursion, &paths](u64* num_entries_out,
+                                                  const std::string& directory,
+                                                  const std::string& virtual_name) -> bool {
         auto physical_name{fmt::format("{}/{}", directory, virtual_name)};
         if (stop_processing)
             return false; // Breaks the callback loop.
         bool is_dir{FileUtil::IsDirectory(physical_name)};
-        if (!is_dir && HasSupportedFileExtension(physical_name)) {
-            auto loader{Loader::GetLoader(system, physical_name)};
-            if (!loader)
-                return true;
-            u64 program_id;
-            loader->ReadProgramId(program_id);
-            u64 extdata_id;
-            loader->ReadExtdataId(extdata_id);
-            auto smdh{[this, program_id, &loader]() -> std::vector<u8> {
-                std::vector<u8> original_smdh;
-                loader->ReadIcon(original_smdh);
-                if (program_id < 0x0004000000000000 || program_id > 0x00040000FFFFFFFF)
-                    return original_smdh;
-                auto update_path{Service::AM::GetProgramContentPath(
-                    Service::FS::MediaType::SDMC, program_id + 0x0000000E00000000)};
-                if (!FileUtil::Exists(update_path))
-                    return original_smdh;
-                auto update_loader{Loader::GetLoader(system, update_path)};
-                if (!update_loader)
-                    return original_smdh;
-                std::vector<u8> update_smdh;
-                update_loader->ReadIcon(update_smdh);
-                return update_smdh;
-            }()};
-            if (!Loader::IsValidSMDH(smdh) && UISettings::values.program_list_hide_no_icon)
+        if (!is_dir && HasSupportedFileExtension(physical_name))
+            paths.push_back(std::move(physical_name));
+        else if (is_dir && recursion > 0) {
+            watch_list.append(QString::fromStdString(physical_name));
+            CollectProgramPaths(physical_name, recursion - 1, paths);
+        }
+        return true;
+    }};
+    FileUtil::ForeachDirectoryEntry(nullptr, dir_path, callback);
+}
+
+void ProgramListWorker::AddFstEntriesToProgramList(const std::string& dir_path,
+                                                   unsigned int recursion,
+                                                   ProgramListDir* parent_dir) {
+    std::vector<std::string> paths;
+    CollectProgramPaths(dir_path, recursion, paths);
+    std::vector<ProgramMetadata> batch;
+    for (std::size_t batch_start{}; batch_start < paths.size() && !stop_processing;
+         batch_start += SCAN_BATCH_SIZE) {
+        // Read a batch in parallel, then create the items on this thread so entries show up as
+        // the scan progresses
+        const std::size_t batch_size{std::min(SCAN_BATCH_SIZE, paths.size() - batch_start)};
+        batch.assign(batch_size, {});
+        GetScanPool().ParallelFor(0, batch_size, 1, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i{begin}; i < end && !stop_processing; ++i)
+                batch[i] = ReadMetadata(paths[batch_start + i]);
+        });
+        for (std::size_t i{}; i < batch_size && !stop_processing; ++i) {
+            const auto& metadata{batch[i]};
+            const auto& physical_name{paths[batch_start + i]};
+            if (metadata.file_type == Loader::FileType::Error)
+                continue;
+            if (!Loader::IsValidSMDH(metadata.smdh) &&
+                UISettings::values.program_list_hide_no_icon)
                 // Skip this invalid entry
-                return true;
+                continue;
             emit EntryReady(
                 {
-                    new ProgramListItemPath(QString::fromStdString(physical_name), smdh, program_id,
-                                            extdata_id),
-                    new ProgramListItemIssues(program_id),
-                    new ProgramListItemRegion(smdh),
+                    new ProgramListItemPath(QString::fromStdString(physical_name), metadata.smdh,
+                                            metadata.program_id, metadata.extdata_id),
+                    new ProgramListItemIssues(metadata.program_id),
+                    new ProgramListItemRegion(metadata.smdh),
                     new ProgramListItem(
-                        QString::fromStdString(Loader::GetFileTypeString(loader->GetFileType()))),
+                        QString::fromStdString(Loader::GetFileTypeString(metadata.file_type))),
                     new ProgramListItemSize(FileUtil::GetSize(physical_name)),
                 },
                 parent_dir);
-        } else if (is_dir && recursion > 0) {
-            watch_list.append(QString::fromStdString(physical_name));
-            AddFstEntriesToProgramList(physical_name, recursion - 1, parent_dir);
         }
-        return true;
-    }};
-    FileUtil::ForeachDirectoryEntry(nullptr, dir_path, callback);
+    }
 }
 
 void ProgramListWorker::run() {
     stop_processing = false;
+    metadata_cache->CheckKeys();
     for (auto& program_dir : program_dirs) {
         if (program_dir.path == "INSTALLED") {
             // Add normal programs
@@ -126,6 +195,7 @@ void ProgramListWorker::run() {
                                        program_dir.deep_scan ? 256 : 0, program_list_dir);
         }
     }
+    metadata_cache->Save(!stop_processing);
     emit Finished(watch_list);
 }
 
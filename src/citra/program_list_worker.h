@@ -5,7 +5,9 @@
 #pragma once
 
 #include <atomic>
+#include <memory>
 #include <string>
+#include <vector>
 #include <QList>
 #include <QObject>
 #include <QRunnable>
@@ -16,6 +18,9 @@ namespace Core {
 class System;
 } // namespace Core
 
+class ProgramMetadataCache;
+struct ProgramMetadata;
+
 /**
  * Asynchronous worker object for populating the program list.
  * Communicates with other threads through Qt's signal/slot system.
@@ -24,8 +29,10 @@ class ProgramListWorker : public QObject, public QRunnable {
     Q_OBJECT
 
 public:
-    explicit ProgramListWorker(Core::System& system, QList<UISettings::AppDir>& program_dirs)
-        : QObject{}, QRunnable{}, program_dirs{program_dirs}, system{system} {}
+    explicit ProgramListWorker(Core::System& system, QList<UISettings::AppDir>& program_dirs,
+                               std::shared_ptr<ProgramMetadataCache> metadata_cache)
+        : QObject{}, QRunnable{}, program_dirs{program_dirs},
+          metadata_cache{std::move(metadata_cache)}, system{system} {}
 
 public slots:
     /// Starts the processing of directory tree information.
@@ -54,8 +61,19 @@ private:
     void AddFstEntriesToProgramList(const std::string& dir_path, unsigned int recursion,
                                     ProgramListDir* parent_dir);
 
+    /// Collects the files with a supported extension, adding the directories to the watch list
+    void CollectProgramPaths(const std::string& dir_path, unsigned int recursion,
+                             std::vector<std::string>& paths);
+
+    /// Gets the metadata of a program from the cache, or through its loader if it changed
+    ProgramMetadata ReadMetadata(const std::string& path);
+
+    /// Returns the modification time of a program's installed update, or 0 if there's none
+    static s64 GetUpdateModifiedTime(u64 program_id);
+
     QStringList watch_list;
     QList<UISettings::AppDir>& program_dirs;
+    std::shared_ptr<ProgramMetadataCache> metadata_cache;
     std::atomic_bool stop_processing{};
     Core::System& system;
 };
@@ -0,0 +1,1136 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <fmt/format.h>
+#include <getopt.h>
+#include <json.hpp>
+#include <nihstro/inline_assembly.h>
+#include "audio_core/codec.h"
+#include "audio_core/interpolate.h"
+#include "common/cityhash.h"
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/file_sys/romfs_reader.h"
+#include "core/hle/kernel/address_arbiter.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/memory.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/thread.h"
+#include "core/hle/kernel/vm_manager.h"
+#include "core/hle/service/y2r/y2r_u.h"
+#include "core/hw/gpu.h"
+#include "core/hw/y2r.h"
+#include "core/memory.h"
+#include "core/memory_setup.h"
+#include "video_core/regs_pipeline.h"
+#include "video_core/renderer/rasterizer_cache.h"
+#include "video_core/shader/compiler.h"
+#include "video_core/shader/shader.h"
+#include "video_core/texture/etc1.h"
+#include "video_core/texture/texture_decode.h"
+#include "video_core/vertex_loader.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// Version of the JSON results, bumped when the benchmarks change in ways that break comparisons
+constexpr u32 RESULTS_VERSION{2};
+
+/// SplitMix64, so that every run sees the same inputs
+class Random {
+public:
+    explicit Random(u64 seed) : state{seed} {}
+
+    u64 Next() {
+        u64 z{state += 0x9E3779B97F4A7C15};
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+        return z ^ (z >> 31);
+    }
+
+    void Fill(u8* data, std::size_t size) {
+        for (std::size_t i{}; i < size; i += sizeof(u64)) {
+            const u64 value{Next()};
+            std::memcpy(data + i, &value, std::min(sizeof(u64), size - i));
+        }
+    }
+
+private:
+    u64 state;
+};
+
+/// Keeps the results of the benchmarked code observable, so that it isn't optimized out
+volatile u8 sink;
+
+void Consume(const void* data) {
+    sink = sink + *static_cast<const u8*>(data);
+}
+
+struct Benchmark {
+    std::string name;
+    /// Bytes processed by each call, for the throughput, or 0
+    u64 bytes_per_op;
+    std::function<void()> op;
+    /// Prepares the benchmark before it's first run, returning false to skip it
+    std::function<bool()> setup;
+};
+
+struct Result {
+    std::string name;
+    double ns_per_op;
+    u64 bytes_per_op;
+    u64 iterations;
+};
+
+struct Options {
+    std::string filter;
+    std::string memory_trace;
+    double min_time_ms{500.0};
+    u32 samples{5};
+};
+
+/// Base physical and virtual addresses of the scratch memory the benchmarks use
+constexpr PAddr SCRATCH_PADDR{Memory::FCRAM_PADDR};
+constexpr VAddr SCRATCH_VADDR{Memory::LINEAR_HEAP_VADDR};
+constexpr u32 SCRATCH_SIZE{32 * 1024 * 1024};
+
+u8* GetScratch(u32 offset) {
+    return Memory::GetPhysicalPointer(SCRATCH_PADDR + offset);
+}
+
+void AddTextureBenchmarks(std::vector<Benchmark>& benchmarks) {
+    using Pica::TexturingRegs;
+    static constexpr std::array<std::pair<TexturingRegs::TextureFormat, const char*>, 14>
+        formats{{
+            {TexturingRegs::TextureFormat::RGBA8, "RGBA8"},
+            {TexturingRegs::TextureFormat::RGB8, "RGB8"},
+            {TexturingRegs::TextureFormat::RGB5A1, "RGB5A1"},
+            {TexturingRegs::TextureFormat::RGB565, "RGB565"},
+            {TexturingRegs::TextureFormat::RGBA4, "RGBA4"},
+            {TexturingRegs::TextureFormat::IA8, "IA8"},
+            {TexturingRegs::TextureFormat::RG8, "RG8"},
+            {TexturingRegs::TextureFormat::I8, "I8"},
+            {TexturingRegs::TextureFormat::A8, "A8"},
+            {TexturingRegs::TextureFormat::IA4, "IA4"},
+            {TexturingRegs::TextureFormat::I4, "I4"},
+            {TexturingRegs::TextureFormat::A4, "A4"},
+            {TexturingRegs::TextureFormat::ETC1, "ETC1"},
+            {TexturingRegs::TextureFormat::ETC1A4, "ETC1A4"},
+        }};
+    constexpr u32 size{256};
+    for (const auto& [format, format_name] : formats) {
+        Pica::Texture::TextureInfo info{};
+        info.physical_address = SCRATCH_PADDR;
+        info.width = size;
+        info.height = size;
+        info.format = format;
+        info.SetDefaultStride();
+        auto output{std::make_shared<std::vector<u8>>(size * size * 4)};
+        // Decodes every texel, as the rasterizer cache does when loading a texture
+        benchmarks.push_back({fmt::format("texture_decode/{}", format_name), size * size * 4,
+                              [info, output] {
+                                  const u8* source{GetScratch(0)};
+                                  u8* out{output->data()};
+                                  for (u32 y{}; y < info.height; ++y)
+                                      for (u32 x{}; x < info.width; ++x) {
+                                          auto texel{Pica::Texture::LookupTexture(
+                                              source, x, y, info)};
+                                          std::memcpy(out, texel.AsArray(), 4);
+                                          out += 4;
+                                      }
+                                  Consume(output->data());
+                              }});
+    }
+}
+
+void AddMortonBenchmarks(std::vector<Benchmark>& benchmarks) {
+    using PixelFormat = SurfaceParams::PixelFormat;
+    static constexpr std::array<std::pair<PixelFormat, const char*>, 8> formats{{
+        {PixelFormat::RGBA8, "RGBA8"},
+        {PixelFormat::RGB8, "RGB8"},
+        {PixelFormat::RGB5A1, "RGB5A1"},
+        {PixelFormat::RGB565, "RGB565"},
+        {PixelFormat::RGBA4, "RGBA4"},
+        {PixelFormat::D16, "D16"},
+        {PixelFormat::D24, "D24"},
+        {PixelFormat::D24S8, "D24S8"},
+    }};
+    constexpr u32 width{512}, height{256};
+    for (const auto& [format, format_name] : formats) {
+        const u32 size{width * height * SurfaceParams::GetFormatBpp(format) / 8};
+        auto gl_buffer{std::make_shared<std::vector<u8>>(
+            width * height * CachedSurface::GetGLBytesPerPixel(format))};
+        const auto to_gl{CachedSurface::GetMortonToGLFunction(format)};
+        const auto to_morton{CachedSurface::GetGLToMortonFunction(format)};
+        benchmarks.push_back({fmt::format("morton_to_gl/{}", format_name), size,
+                              [=] {
+                                  to_gl(width, height, gl_buffer->data(), SCRATCH_PADDR,
+                                        SCRATCH_PADDR, SCRATCH_PADDR + size);
+                                  Consume(gl_buffer->data());
+                              }});
+        // Writes to the second half of the scratch memory, keeping the inputs of the others
+        constexpr u32 output_offset{SCRATCH_SIZE / 2};
+        benchmarks.push_back({fmt::format("gl_to_morton/{}", format_name), size,
+                              [=] {
+                                  to_morton(width, height, gl_buffer->data(),
+                                            SCRATCH_PADDR + output_offset,
+                                            SCRATCH_PADDR + output_offset,
+                                            SCRATCH_PADDR + output_offset + size);
+                                  Consume(GetScratch(output_offset));
+                              }});
+    }
+}
+
+void AddETC1Benchmark(std::vector<Benchmark>& benchmarks) {
+    constexpr std::size_t blocks{4096};
+    auto values{std::make_shared<std::vector<u64>>(blocks)};
+    Random random{0xE7C1};
+    for (auto& value : *values)
+        value = random.Next();
+    benchmarks.push_back({"etc1/subtile", blocks * 16 * 3, [values] {
+                              u32 sum{};
+                              for (const u64 value : *values)
+                                  for (u32 y{}; y < 4; ++y)
+                                      for (u32 x{}; x < 4; ++x)
+                                          sum += Pica::Texture::SampleETC1Subtile(value, x, y).r();
+                              Consume(&sum);
+                          }});
+}
+
+/// Builds a shader setup holding the program, with deterministic uniforms
+std::shared_ptr<Pica::Shader::ShaderSetup> MakeShaderSetup(
+    std::initializer_list<nihstro::InlineAsm> code) {
+    const auto binary{nihstro::InlineAsm::CompileToRawBinary(code)};
+    auto setup{std::make_shared<Pica::Shader::ShaderSetup>()};
+    setup->program_code.fill(0);
+    setup->swizzle_data.fill(0);
+    std::transform(binary.program.begin(), binary.program.end(), setup->program_code.begin(),
+                   [](const auto& instr) { return instr.hex; });
+    std::transform(binary.swizzle_table.begin(), binary.swizzle_table.end(),
+                   setup->swizzle_data.begin(), [](const auto& swizzle) { return swizzle.hex; });
+    for (std::size_t i{}; i < 96; ++i)
+        for (std::size_t j{}; j < 4; ++j)
+            setup->uniforms.f[i][j] = Pica::float24::FromFloat32(
+                static_cast<float>((i * 4 + j) % 7) * 0.25f - 0.5f);
+    return setup;
+}
+
+void AddShaderBenchmarks(std::vector<Benchmark>& benchmarks) {
+    using nihstro::OpCode;
+    using Pica::Shader::ShaderSetup;
+    using Pica::Shader::UnitState;
+    const auto v{[](int index) { return SourceRegister::MakeInput(index); }};
+    const auto r{[](int index) { return SourceRegister::MakeTemporary(index); }};
+    const auto c{[](int index) { return SourceRegister::MakeFloat(index); }};
+    const auto o{[](int index) { return DestRegister::MakeOutput(index); }};
+    // Copies the attributes through, like the vertex shaders of 2D drawing
+    const auto passthrough{MakeShaderSetup({
+        {OpCode::Id::MOV, o(0), v(0)},
+        {OpCode::Id::MOV, o(1), v(1)},
+        {OpCode::Id::MOV, o(2), v(2)},
+        {OpCode::Id::END},
+    })};
+    // A model-view-projection transform with a simple diffuse light
+    const auto transform{MakeShaderSetup({
+        {OpCode::Id::DP4, r(0), c(0), v(0)},
+        {OpCode::Id::DP4, r(1), c(1), v(0)},
+        {OpCode::Id::DP4, r(2), c(2), v(0)},
+        {OpCode::Id::DP4, r(3), c(3), v(0)},
+        {OpCode::Id::MUL, r(4), c(4), r(0)},
+        {OpCode::Id::ADD, r(4), c(5), r(4)},
+        {OpCode::Id::MOV, o(0), r(4)},
+        {OpCode::Id::DP3, r(5), c(6), v(1)},
+        {OpCode::Id::RSQ, r(6), r(5)},
+        {OpCode::Id::MUL, r(5), r(5), r(6)},
+        {OpCode::Id::MAX, r(5), c(7), r(5)},
+        {OpCode::Id::MUL, o(1), r(5), v(2)},
+        {OpCode::Id::MOV, o(2), v(3)},
+        {OpCode::Id::END},
+    })};
+    // The instructions the JIT implements with subroutines and approximations
+    const auto math{MakeShaderSetup({
+        {OpCode::Id::RCP, r(0), v(0)},
+        {OpCode::Id::RSQ, r(1), v(1)},
+        {OpCode::Id::LG2, r(2), v(2)},
+        {OpCode::Id::EX2, r(3), r(2)},
+        {OpCode::Id::MUL, r(0), r(0), r(1)},
+        {OpCode::Id::ADD, r(0), r(0), r(3)},
+        {OpCode::Id::FLR, r(4), r(0)},
+        {OpCode::Id::MIN, r(4), c(0), r(4)},
+        {OpCode::Id::MOV, o(0), r(4)},
+        {OpCode::Id::END},
+    })};
+    const std::array<std::pair<std::shared_ptr<ShaderSetup>, const char*>, 3> programs{{
+        {passthrough, "passthrough"},
+        {transform, "transform"},
+        {math, "math"},
+    }};
+    constexpr u32 vertices{1024};
+    auto inputs{std::make_shared<std::vector<Pica::Shader::AttributeBuffer>>(vertices)};
+    Random random{0x5BAD};
+    for (auto& input : *inputs)
+        for (auto& attribute : input.attr)
+            for (std::size_t i{}; i < 4; ++i)
+                attribute[i] = Pica::float24::FromFloat32(
+                    static_cast<float>(random.Next() % 2000) / 100.0f - 10.0f + 0.01f);
+    for (const auto& [setup, program_name] : programs) {
+        benchmarks.push_back({fmt::format("shader_jit_compile/{}", program_name), 0,
+                              [setup = setup] {
+                                  Pica::Shader::Shader shader;
+                                  shader.Compile(&setup->program_code, &setup->swizzle_data);
+                                  Consume(&shader);
+                              }});
+        auto shader{std::make_shared<Pica::Shader::Shader>()};
+        shader->Compile(&setup->program_code, &setup->swizzle_data);
+        benchmarks.push_back({fmt::format("shader_jit_run/{}", program_name), 0,
+                              [setup = setup, shader, inputs] {
+                                  UnitState state;
+                                  for (const auto& input : *inputs) {
+                                      std::memcpy(state.registers.input, input.attr,
+                                                  sizeof(input.attr));
+                                      shader->Run(*setup, state, 0);
+                                  }
+                                  Consume(&state.registers.output[0]);
+                              }});
+    }
+}
+
+void AddVertexLoaderBenchmark(std::vector<Benchmark>& benchmarks) {
+    // Position as floats, color as bytes and two texture coordinates as shorts
+    Pica::PipelineRegs regs{};
+    auto& attributes{regs.vertex_attributes};
+    attributes.base_address.Assign(SCRATCH_PADDR / 16);
+    attributes.format0.Assign(Pica::PipelineRegs::VertexAttributeFormat::Float);
+    attributes.size0.Assign(2);
+    attributes.format1.Assign(Pica::PipelineRegs::VertexAttributeFormat::UnsignedByte);
+    attributes.size1.Assign(3);
+    attributes.format2.Assign(Pica::PipelineRegs::VertexAttributeFormat::Short);
+    attributes.size2.Assign(1);
+    attributes.format3.Assign(Pica::PipelineRegs::VertexAttributeFormat::Short);
+    attributes.size3.Assign(1);
+    attributes.max_attribute_index.Assign(3);
+    auto& loader{attributes.attribute_loaders[0]};
+    loader.data_offset.Assign(0);
+    loader.comp0.Assign(0);
+    loader.comp1.Assign(1);
+    loader.comp2.Assign(2);
+    loader.comp3.Assign(3);
+    loader.component_count.Assign(4);
+    loader.byte_count.Assign(24);
+    auto vertex_loader{std::make_shared<Pica::VertexLoader>(regs)};
+    constexpr int vertices{4096};
+    benchmarks.push_back({"vertex_loader/float_byte_short", vertices * 24, [vertex_loader] {
+                              Pica::Shader::AttributeBuffer input;
+                              for (int vertex{}; vertex < vertices; ++vertex)
+                                  vertex_loader->LoadVertex(SCRATCH_PADDR, vertex, vertex, input);
+                              Consume(&input);
+                          }});
+}
+
+void AddDisplayTransferBenchmarks(std::vector<Benchmark>& benchmarks) {
+    using GPU::Regs;
+    struct Transfer {
+        const char* name;
+        Regs::PixelFormat input_format;
+        Regs::PixelFormat output_format;
+        bool input_linear;
+        Regs::DisplayTransferConfig::ScalingMode scaling;
+    };
+    static constexpr std::array<Transfer, 4> transfers{{
+        {"RGBA8_to_RGB8", Regs::PixelFormat::RGBA8, Regs::PixelFormat::RGB8, false,
+         Regs::DisplayTransferConfig::NoScale},
+        {"RGBA8_to_RGB565", Regs::PixelFormat::RGBA8, Regs::PixelFormat::RGB565, false,
+         Regs::DisplayTransferConfig::NoScale},
+        {"RGBA8_scale_xy", Regs::PixelFormat::RGBA8, Regs::PixelFormat::RGBA8, false,
+         Regs::DisplayTransferConfig::ScaleXY},
+        {"linear_RGB565_to_RGBA8", Regs::PixelFormat::RGB565, Regs::PixelFormat::RGBA8, true,
+         Regs::DisplayTransferConfig::NoScale},
+    }};
+    // The top screen framebuffer
+    constexpr u32 width{240}, height{400};
+    for (const auto& transfer : transfers) {
+        Regs::DisplayTransferConfig config{};
+        config.input_width.Assign(width);
+        config.input_height.Assign(height);
+        config.output_width.Assign(width);
+        config.output_height.Assign(height);
+        config.input_format.Assign(transfer.input_format);
+        config.output_format.Assign(transfer.output_format);
+        config.input_linear.Assign(transfer.input_linear);
+        config.scaling.Assign(transfer.scaling);
+        benchmarks.push_back(
+            {fmt::format("display_transfer/{}", transfer.name),
+             width * height * static_cast<u64>(Regs::BytesPerPixel(transfer.input_format)),
+             [config] {
+                 GPU::PerformDisplayTransfer(config, GetScratch(0), GetScratch(SCRATCH_SIZE / 2));
+                 Consume(GetScratch(SCRATCH_SIZE / 2));
+             }});
+    }
+}
+
+void AddY2RBenchmarks(std::vector<Benchmark>& benchmarks) {
+    using namespace Service::Y2R;
+    constexpr u16 width{400}, height{240};
+    const auto make_buffer{[](u32 offset, u32 image_size, u16 transfer_unit) {
+        return ConversionBuffer{SCRATCH_VADDR + offset, image_size, transfer_unit, 0};
+    }};
+    for (const auto block_alignment : {BlockAlignment::Linear, BlockAlignment::Block8x8}) {
+        ConversionConfiguration config{};
+        config.input_format = InputFormat::YUV422_Indiv8;
+        config.output_format = OutputFormat::RGBA8;
+        config.rotation = Rotation::None;
+        config.block_alignment = block_alignment;
+        config.input_line_width = width;
+        config.input_lines = height;
+        config.SetStandardCoefficient(StandardCoefficient::ITU_Rec601);
+        config.alpha = 0xFF;
+        config.src_Y = make_buffer(0, width * height, width);
+        config.src_U = make_buffer(width * height, width * height / 2, width / 2);
+        config.src_V = make_buffer(width * height * 3 / 2, width * height / 2, width / 2);
+        config.dst = make_buffer(SCRATCH_SIZE / 2, width * height * 4, width * 4);
+        benchmarks.push_back(
+            {fmt::format("y2r/YUV422_to_RGBA8_{}",
+                         block_alignment == BlockAlignment::Linear ? "linear" : "tiled"),
+             width * height * 2, [config] {
+                 // The conversion advances the buffers, so each run starts from a copy
+                 ConversionConfiguration cvt{config};
+                 HW::Y2R::PerformConversion(cvt);
+                 Consume(GetScratch(SCRATCH_SIZE / 2));
+             }});
+    }
+}
+
+void AddAudioBenchmarks(std::vector<Benchmark>& benchmarks) {
+    // ADPCM frames are 8 bytes holding 14 samples
+    constexpr std::size_t frames{1024};
+    constexpr std::size_t samples{frames * 14};
+    auto adpcm{std::make_shared<std::vector<u8>>(frames * 8)};
+    Random random{0xADCB};
+    random.Fill(adpcm->data(), adpcm->size());
+    // Keep the scale and coefficient index in range
+    for (std::size_t i{}; i < adpcm->size(); i += 8)
+        (*adpcm)[i] &= 0x7B;
+    std::array<s16, 16> coefficients;
+    for (std::size_t i{}; i < coefficients.size(); ++i)
+        coefficients[i] = static_cast<s16>((i % 2 == 0 ? 1800 : -900) + static_cast<s16>(i * 37));
+    benchmarks.push_back({"adpcm_decode", adpcm->size(), [adpcm, coefficients] {
+                              AudioCore::Codec::ADPCMState state{};
+                              const auto output{AudioCore::Codec::DecodeADPCM(
+                                  adpcm->data(), samples, coefficients, state)};
+                              Consume(&output.back());
+                          }});
+    auto input{std::make_shared<AudioCore::StereoBuffer16>()};
+    for (std::size_t i{}; i < 512; ++i)
+        input->push_back({static_cast<s16>(random.Next()), static_cast<s16>(random.Next())});
+    const std::array<std::pair<float, const char*>, 2> rates{{{0.75f, "upsample"},
+                                                             {1.5f, "downsample"}}};
+    for (const auto& [rate, rate_name] : rates) {
+        benchmarks.push_back(
+            {fmt::format("interpolate_none/{}", rate_name), 0, [input, rate = rate] {
+                 AudioCore::AudioInterp::State state;
+                 AudioCore::StereoBuffer16 buffer{*input};
+                 AudioCore::StereoFrame16 frame;
+                 std::size_t outputi{};
+                 AudioCore::AudioInterp::None(state, buffer, rate, frame, outputi);
+                 Consume(&frame[0]);
+             }});
+        benchmarks.push_back(
+            {fmt::format("interpolate_linear/{}", rate_name), 0, [input, rate = rate] {
+                 AudioCore::AudioInterp::State state;
+                 AudioCore::StereoBuffer16 buffer{*input};
+                 AudioCore::StereoFrame16 frame;
+                 std::size_t outputi{};
+                 AudioCore::AudioInterp::Linear(state, buffer, rate, frame, outputi);
+                 Consume(&frame[0]);
+             }});
+    }
+}
+
+void AddCityHashBenchmarks(std::vector<Benchmark>& benchmarks) {
+    for (const u32 size : {64u, 4096u, 1024u * 1024u})
+        benchmarks.push_back({fmt::format("cityhash64/{}", size), size, [size] {
+                                  const u64 hash{Common::CityHash64(
+                                      reinterpret_cast<const char*>(GetScratch(0)), size)};
+                                  Consume(&hash);
+                              }});
+}
+
+/// Path of the encrypted RomFS image, created when the RomFS benchmark runs and removed in main
+std::string romfs_path;
+
+void AddRomFSBenchmark(std::vector<Benchmark>& benchmarks) {
+    static constexpr std::size_t size{16 * 1024 * 1024};
+    static constexpr std::size_t read_size{1024 * 1024};
+    auto reader{std::make_shared<std::shared_ptr<FileSys::RomFSReader>>()};
+    auto buffer{std::make_shared<std::vector<u8>>(read_size)};
+    auto offset{std::make_shared<std::size_t>()};
+    benchmarks.push_back(
+        {"romfs_ctr_decrypt/1MiB", read_size,
+         [reader, buffer, offset] {
+             // Walks through the image in steps that aren't block aligned
+             *offset = (*offset + read_size + 0x1230) % (size - read_size);
+             (*reader)->ReadFile(*offset, read_size, buffer->data());
+             Consume(buffer->data());
+         },
+         [reader] {
+             romfs_path =
+                 FileUtil::GetUserPath(FileUtil::UserPath::CacheDir) + "citra_bench_romfs.bin";
+             FileUtil::CreateFullPath(romfs_path);
+             {
+                 std::vector<u8> data(size);
+                 Random{0x50F5}.Fill(data.data(), data.size());
+                 FileUtil::IOFile file{romfs_path, "wb"};
+                 if (file.WriteBytes(data.data(), data.size()) != data.size()) {
+                     std::cerr << "Failed to write " << romfs_path
+                               << ", skipping the RomFS benchmark\n";
+                     return false;
+                 }
+             }
+             auto mapped_file{std::make_shared<FileUtil::MappedFile>(romfs_path)};
+             std::array<u8, 16> key, ctr;
+             Random random{0xAE5C};
+             random.Fill(key.data(), key.size());
+             random.Fill(ctr.data(), ctr.size());
+             *reader = std::make_shared<FileSys::RomFSReader>(mapped_file, 0, size, key, ctr,
+                                                              0x1000);
+             return true;
+         }});
+}
+
+void AddTimingBenchmark(std::vector<Benchmark>& benchmarks) {
+    // Events rescheduling themselves from their callbacks, like the hardware timers do
+    constexpr std::size_t event_types{32};
+    constexpr u32 advances{4096};
+    struct State {
+        Core::Timing timing;
+        std::vector<Core::TimingEventType*> types;
+        u64 callbacks{};
+    };
+    // The events keep rescheduling themselves, so each call only times the advances
+    auto state{std::make_shared<std::unique_ptr<State>>()};
+    benchmarks.push_back(
+        {"core_timing/schedule_advance", 0,
+         [state] {
+             auto& timing{(*state)->timing};
+             for (u32 i{}; i < advances; ++i) {
+                 timing.Advance();
+                 timing.AddTicks(timing.GetDowncount());
+             }
+             Consume(&(*state)->callbacks);
+         },
+         [state] {
+             *state = std::make_unique<State>();
+             auto& [timing, types, callbacks]{**state};
+             Random random{0x7141};
+             types.resize(event_types);
+             for (std::size_t i{}; i < event_types; ++i) {
+                 const s64 period{static_cast<s64>(1000 + i * 377)};
+                 types[i] = timing.RegisterEvent(
+                     fmt::format("event{}", i),
+                     [&timing = timing, &types = types, &callbacks = callbacks, i,
+                      period](u64, s64) {
+                         ++callbacks;
+                         timing.ScheduleEvent(period, types[i]);
+                     });
+             }
+             for (std::size_t i{}; i < event_types; ++i)
+                 timing.ScheduleEvent(random.Next() % 20000, types[i]);
+             return true;
+         }});
+}
+
+void AddArbiterBenchmarks(std::vector<Benchmark>& benchmarks) {
+    // The threads of a process on a bare kernel wait on the arbiter as the scheduler runs them,
+    // like they do through svcArbitrateAddress, and are then signalled from outside
+    constexpr u32 num_threads{512};
+    constexpr u32 words_offset{0x10000};
+    constexpr VAddr words_vaddr{SCRATCH_VADDR + words_offset};
+    /// The TLS pages come from the base region, put past the memory replay region
+    constexpr u32 tls_region_base{Memory::FCRAM_SIZE - 0x100000};
+    struct State {
+        Kernel::SharedPtr<Kernel::AddressArbiter> arbiter;
+        std::vector<Kernel::SharedPtr<Kernel::Thread>> threads;
+        Random random{0xA4B1};
+
+        ~State() {
+            arbiter = nullptr;
+            threads.clear();
+            Core::System::GetInstance().ShutdownKernel();
+        }
+    };
+    auto state{std::make_shared<std::unique_ptr<State>>()};
+    const auto setup{[state] {
+        // Every thread waits while its word is less than 1
+        std::memset(GetScratch(words_offset), 0, num_threads * sizeof(u32));
+        if (*state)
+            return true;
+        auto& system{Core::System::GetInstance()};
+        system.InitKernel();
+        auto& kernel{system.Kernel()};
+        kernel.GetMemoryRegion(Kernel::MemoryRegion::Base)->Reset(tls_region_base, 0x100000);
+        auto process{kernel.CreateProcess(kernel.CreateCodeSet("bench", 0))};
+        // Threads need a mapped entry point, they never run
+        process->vm_manager.MapBackingMemory(Memory::PROCESS_IMAGE_VADDR, GetScratch(0),
+                                             Memory::PAGE_SIZE, Kernel::MemoryState::Code);
+        // The process is current from the start, so the scheduler keeps the page table of the
+        // benchmarks, which the words are read through
+        kernel.SetCurrentProcess(process);
+        *state = std::make_unique<State>();
+        auto& [arbiter, threads, random]{**state};
+        arbiter = kernel.CreateAddressArbiter("bench");
+        for (u32 i{}; i < num_threads; ++i) {
+            auto thread{kernel.CreateThread(fmt::format("waiter{}", i),
+                                            Memory::PROCESS_IMAGE_VADDR,
+                                            static_cast<u32>(random.Next() % 64), 0,
+                                            Kernel::ThreadProcessorId0, Memory::HEAP_VADDR_END,
+                                            *process)};
+            if (thread.Failed())
+                return false;
+            threads.push_back(std::move(thread).Unwrap());
+        }
+        return true;
+    }};
+    // Runs every thread until it waits on the word of its address, the ones with an ID that's a
+    // multiple of timeout_every (if not 0) wait with a timeout
+    const auto wait_all{[](Kernel::AddressArbiter& arbiter, u32 addresses, u32 timeout_every) {
+        auto& thread_manager{Core::System::GetInstance().Kernel().GetThreadManager()};
+        for (u32 i{}; i < num_threads; ++i) {
+            thread_manager.Reschedule();
+            Kernel::Thread* thread{thread_manager.GetCurrentThread()};
+            const u32 id{thread->GetThreadId()};
+            const VAddr address{words_vaddr + id % addresses * 4};
+            if (timeout_every && id % timeout_every == 0)
+                arbiter.ArbitrateAddress(thread, Kernel::ArbitrationType::WaitIfLessThanWithTimeout,
+                                         address, 1, 1000);
+            else
+                arbiter.ArbitrateAddress(thread, Kernel::ArbitrationType::WaitIfLessThan, address,
+                                         1, 0);
+        }
+        // Nothing is left to run
+        thread_manager.Reschedule();
+    }};
+    // Each address is signalled one thread at a time, like a semaphore
+    for (const u32 addresses : {1u, 64u})
+        benchmarks.push_back(
+            {fmt::format("arbiter/wait_signal_one/{}", addresses), 0,
+             [state, wait_all, addresses] {
+                 auto& arbiter{*(*state)->arbiter};
+                 wait_all(arbiter, addresses, 0);
+                 for (u32 i{}; i < addresses; ++i)
+                     for (u32 j{}; j < num_threads / addresses; ++j)
+                         arbiter.ArbitrateAddress(nullptr, Kernel::ArbitrationType::Signal,
+                                                  words_vaddr + i * 4, 1, 0);
+             },
+             setup});
+    // Half of the threads time out and leave the list, then the rest are signalled at once
+    benchmarks.push_back({"arbiter/timeout_signal_all", 0,
+                          [state, wait_all] {
+                              auto& arbiter{*(*state)->arbiter};
+                              wait_all(arbiter, 1, 2);
+                              auto& timing{Core::System::GetInstance().CoreTiming()};
+                              timing.AddTicks(timing.GetDowncount());
+                              timing.Advance();
+                              arbiter.ArbitrateAddress(nullptr, Kernel::ArbitrationType::Signal,
+                                                       words_vaddr, -1, 0);
+                          },
+                          setup});
+    // The scheduler runs the threads by priority so they mostly wait in order, changing their
+    // priorities while they wait moves them around the list
+    benchmarks.push_back({"arbiter/reprioritize_signal_all", 0,
+                          [state, wait_all] {
+                              auto& [arbiter, threads, random]{**state};
+                              wait_all(*arbiter, 1, 0);
+                              for (auto& thread : threads)
+                                  thread->SetPriority(static_cast<u32>(random.Next() % 64));
+                              arbiter->ArbitrateAddress(
+                                  nullptr, Kernel::ArbitrationType::Signal, words_vaddr, -1, 0);
+                          },
+                          setup});
+}
+
+/// svcControlMemory operations, as in svc.cpp
+constexpr u32 MEMOP_FREE{1};
+constexpr u32 MEMOP_COMMIT{3};
+constexpr u32 MEMOP_PROTECT{6};
+constexpr u32 MEMOP_OPERATION_MASK{0xFF};
+constexpr u32 MEMOP_REGION_MASK{0xF00};
+constexpr u32 MEMOP_LINEAR{0x10000};
+
+struct MemoryOperation {
+    u32 operation;
+    VAddr address;
+    u32 size;
+    Kernel::VMAPermission permissions;
+};
+
+/**
+ * Applies svcControlMemory operations to a memory region and an address space the way Process
+ * does, without the kernel around them. The region lies past the scratch memory, as freeing it
+ * hands its pages back to the host.
+ */
+class MemoryReplayer {
+public:
+    static constexpr u32 REGION_BASE{SCRATCH_SIZE};
+    static constexpr u32 REGION_SIZE{64 * 1024 * 1024};
+    /// The linear heap starts with the region, like it does with the application region
+    static constexpr VAddr LINEAR_BASE{Memory::LINEAR_HEAP_VADDR - REGION_BASE};
+
+    MemoryReplayer() {
+        region.Reset(REGION_BASE, REGION_SIZE);
+    }
+
+    /// Returns the address the operation applied to, or 0 if it failed
+    VAddr Apply(const MemoryOperation& operation) {
+        const VAddr address{operation.address};
+        const u32 size{operation.size};
+        switch (operation.operation & MEMOP_OPERATION_MASK) {
+        case MEMOP_FREE:
+            if (!IsMapped(address, size))
+                return 0;
+            if (address >= Memory::HEAP_VADDR && address < Memory::HEAP_VADDR_END)
+                HeapFree(address, size);
+            else
+                LinearFree(address, size);
+            return address;
+        case MEMOP_COMMIT:
+            if (size == 0)
+                return 0;
+            if (operation.operation & MEMOP_LINEAR)
+                return LinearAllocate(address, size, operation.permissions);
+            return HeapAllocate(address, size, operation.permissions);
+        case MEMOP_PROTECT:
+            if (!IsMapped(address, size))
+                return 0;
+            vm_manager.ReprotectRange(address, size, operation.permissions);
+            return address;
+        }
+        return 0;
+    }
+
+    /// Frees everything the operations left allocated, returning to the initial state
+    void Reset() {
+        std::vector<std::pair<VAddr, u32>> mapped;
+        for (const auto& [base, vma] : vm_manager.vma_map)
+            if (vma.type == Kernel::VMAType::BackingMemory)
+                mapped.emplace_back(base, vma.size);
+        for (const auto& [base, size] : mapped)
+            Apply({MEMOP_FREE, base, size, Kernel::VMAPermission::None});
+    }
+
+private:
+    bool IsMapped(VAddr address, u32 size) const {
+        if (size == 0 || address + size < address)
+            return false;
+        for (VAddr current{address}; current < address + size;) {
+            const auto vma{vm_manager.FindVMA(current)};
+            if (vma == vm_manager.vma_map.end() ||
+                vma->second.type != Kernel::VMAType::BackingMemory)
+                return false;
+            current = vma->second.base + vma->second.size;
+        }
+        return true;
+    }
+
+    VAddr HeapAllocate(VAddr target, u32 size, Kernel::VMAPermission permissions) {
+        if (target < Memory::HEAP_VADDR || target + size > Memory::HEAP_VADDR_END ||
+            target + size < target)
+            return 0;
+        const auto vma{vm_manager.FindVMA(target)};
+        if (vma->second.type != Kernel::VMAType::Free ||
+            vma->second.base + vma->second.size < target + size)
+            return 0;
+        const auto blocks{region.HeapAllocate(size)};
+        if (blocks.empty())
+            return 0;
+        VAddr block_target{target};
+        for (const auto& block : blocks) {
+            const u32 block_size{block.upper() - block.lower()};
+            Memory::fcram.Zero(block.lower(), block_size);
+            const auto mapped{
+                vm_manager.MapBackingMemory(block_target, Memory::fcram.data() + block.lower(),
+                                            block_size, Kernel::MemoryState::Private)};
+            vm_manager.Reprotect(*mapped, permissions);
+            block_target += block_size;
+        }
+        return target;
+    }
+
+    void HeapFree(VAddr target, u32 size) {
+        const auto blocks{vm_manager.GetBackingBlocksForRange(target, size).Unwrap()};
+        for (const auto& [memory, block_size] : blocks)
+            region.Free(Memory::GetFCRAMOffset(memory), block_size);
+        vm_manager.UnmapRange(target, size);
+    }
+
+    VAddr LinearAllocate(VAddr target, u32 size, Kernel::VMAPermission permissions) {
+        u32 offset;
+        if (target == 0) {
+            const auto allocated{region.LinearAllocate(size)};
+            if (!allocated)
+                return 0;
+            offset = *allocated;
+        } else {
+            offset = target - LINEAR_BASE;
+            if (target < LINEAR_BASE || offset < REGION_BASE ||
+                size > REGION_BASE + REGION_SIZE - offset || !region.LinearAllocate(offset, size))
+                return 0;
+        }
+        Memory::fcram.Zero(offset, size);
+        const auto mapped{vm_manager.MapBackingMemory(offset + LINEAR_BASE,
+                                                      Memory::fcram.data() + offset, size,
+                                                      Kernel::MemoryState::Continuous)};
+        vm_manager.Reprotect(*mapped, permissions);
+        return offset + LINEAR_BASE;
+    }
+
+    void LinearFree(VAddr target, u32 size) {
+        vm_manager.UnmapRange(target, size);
+        region.Free(target - LINEAR_BASE, size);
+    }
+
+    Kernel::MemoryRegionInfo region;
+    Kernel::VMManager vm_manager;
+};
+
+/**
+ * Records a trace modeled on games: a heap committed at boot then grown and shrunk at its end,
+ * and GPU buffers allocated from the linear heap and freed out of order.
+ */
+std::vector<MemoryOperation> RecordMemoryTrace() {
+    using Kernel::VMAPermission;
+    constexpr u32 page_size{Memory::PAGE_SIZE};
+    // The addresses of linear allocations are the ones the allocator returns. The page table of
+    // the replayer is too large for the stack.
+    auto recorder{std::make_unique<MemoryReplayer>()};
+    std::vector<MemoryOperation> trace;
+    const auto record{[&recorder, &trace](const MemoryOperation& operation) {
+        const VAddr address{recorder->Apply(operation)};
+        if (address)
+            trace.push_back(operation);
+        return address;
+    }};
+    Random random{0x3E40};
+    u32 heap_size{24 * 1024 * 1024};
+    record({MEMOP_COMMIT, Memory::HEAP_VADDR, heap_size, VMAPermission::ReadWrite});
+    std::vector<std::pair<VAddr, u32>> buffers;
+    for (u32 i{}; i < 2048; ++i) {
+        const u64 choice{random.Next() % 16};
+        if (choice == 0) {
+            const u32 size{static_cast<u32>(1 + random.Next() % 16) * page_size};
+            if (random.Next() % 2 && heap_size > size) {
+                heap_size -= size;
+                record({MEMOP_FREE, Memory::HEAP_VADDR + heap_size, size, VMAPermission::None});
+            } else if (record({MEMOP_COMMIT, Memory::HEAP_VADDR + heap_size, size,
+                               VMAPermission::ReadWrite})) {
+                heap_size += size;
+            }
+        } else if (choice == 1) {
+            const VAddr address{Memory::HEAP_VADDR +
+                                static_cast<u32>(random.Next() % (heap_size / page_size)) *
+                                    page_size};
+            record({MEMOP_PROTECT, address, page_size,
+                    random.Next() % 2 ? VMAPermission::Read : VMAPermission::ReadWrite});
+        } else if (choice < 9 || buffers.empty()) {
+            // Buffers of up to 128 KiB, and the odd render target of up to 1 MiB
+            const u32 size{static_cast<u32>(1 + random.Next() % (choice == 2 ? 256 : 32)) *
+                           page_size};
+            if (const VAddr address{record(
+                    {MEMOP_COMMIT | MEMOP_LINEAR, 0, size, VMAPermission::ReadWrite})})
+                buffers.emplace_back(address, size);
+        } else {
+            const std::size_t index{random.Next() % buffers.size()};
+            record({MEMOP_FREE, buffers[index].first, buffers[index].second,
+                    VMAPermission::None});
+            buffers[index] = buffers.back();
+            buffers.pop_back();
+        }
+    }
+    return trace;
+}
+
+/// Reads the svcControlMemory calls from a log of the emulator with Kernel.SVC:Debug enabled
+std::vector<MemoryOperation> LoadMemoryTrace(const std::string& path) {
+    std::vector<MemoryOperation> trace;
+    std::ifstream file{path};
+    if (!file) {
+        std::cerr << "Can't open the memory trace " << path << '\n';
+        return trace;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        const auto position{line.find("operation=0x")};
+        if (position == std::string::npos)
+            continue;
+        u32 operation, address, address1, size, permissions;
+        if (std::sscanf(line.c_str() + position,
+                        "operation=0x%X, addr0=0x%X, addr1=0x%X, size=0x%X, permissions=0x%X",
+                        &operation, &address, &address1, &size, &permissions) == 5)
+            trace.push_back({operation & ~MEMOP_REGION_MASK, address, size,
+                             static_cast<Kernel::VMAPermission>(permissions & 3)});
+    }
+    return trace;
+}
+
+void AddMemoryTraceBenchmarks(std::vector<Benchmark>& benchmarks, const Options& options) {
+    std::vector<std::pair<std::string, std::vector<MemoryOperation>>> traces;
+    traces.emplace_back("synthetic", RecordMemoryTrace());
+    if (!options.memory_trace.empty())
+        traces.emplace_back("recorded", LoadMemoryTrace(options.memory_trace));
+    for (auto& [trace_name, operations] : traces) {
+        auto trace{std::make_shared<std::vector<MemoryOperation>>(std::move(operations))};
+        auto replayer{std::make_shared<MemoryReplayer>()};
+        benchmarks.push_back({fmt::format("control_memory/{}", trace_name), 0, [trace, replayer] {
+                                  VAddr last{};
+                                  for (const auto& operation : *trace)
+                                      last = replayer->Apply(operation);
+                                  replayer->Reset();
+                                  Consume(&last);
+                              }});
+    }
+}
+
+std::vector<Benchmark> CreateBenchmarks(const Options& options) {
+    std::vector<Benchmark> benchmarks;
+    AddTextureBenchmarks(benchmarks);
+    AddMortonBenchmarks(benchmarks);
+    AddETC1Benchmark(benchmarks);
+    AddShaderBenchmarks(benchmarks);
+    AddVertexLoaderBenchmark(benchmarks);
+    AddDisplayTransferBenchmarks(benchmarks);
+    AddY2RBenchmarks(benchmarks);
+    AddAudioBenchmarks(benchmarks);
+    AddCityHashBenchmarks(benchmarks);
+    AddRomFSBenchmark(benchmarks);
+    AddTimingBenchmark(benchmarks);
+    AddArbiterBenchmarks(benchmarks);
+    AddMemoryTraceBenchmarks(benchmarks, options);
+    return benchmarks;
+}
+
+/**
+ * Runs the benchmark in batches sized to take about min_time / samples each, and returns the
+ * median time per call of the batches, which shrugs off the odd preempted batch.
+ */
+Result Run(const Benchmark& benchmark, const Options& options) {
+    const auto time_batch{[&benchmark](u64 iterations) {
+        const auto start{Clock::now()};
+        for (u64 i{}; i < iterations; ++i)
+            benchmark.op();
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }};
+    // Warm up, then grow the batch until it takes long enough to time reliably
+    time_batch(1);
+    const double batch_ns{options.min_time_ms * 1e6 / options.samples};
+    u64 iterations{1};
+    double elapsed{time_batch(iterations)};
+    while (elapsed < batch_ns) {
+        const double factor{elapsed > 0 ? std::min(batch_ns / elapsed * 1.2, 10.0) : 10.0};
+        iterations = std::max(iterations + 1, static_cast<u64>(iterations * factor));
+        elapsed = time_batch(iterations);
+    }
+    std::vector<double> samples{elapsed / iterations};
+    while (samples.size() < options.samples)
+        samples.push_back(time_batch(iterations) / iterations);
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return {benchmark.name, samples[samples.size() / 2], benchmark.bytes_per_op,
+            iterations * options.samples};
+}
+
+nlohmann::json ToJSON(const std::vector<Result>& results) {
+    nlohmann::json json;
+    json["version"] = RESULTS_VERSION;
+    auto& benchmarks{json["benchmarks"]};
+    benchmarks = nlohmann::json::array();
+    for (const auto& result : results)
+        benchmarks.push_back({
+            {"name", result.name},
+            {"ns_per_op", result.ns_per_op},
+            {"bytes_per_op", result.bytes_per_op},
+            {"iterations", result.iterations},
+        });
+    return json;
+}
+
+/// Reads the time per call of each benchmark from a previous --output file
+bool LoadBaseline(const std::string& path, std::unordered_map<std::string, double>& baseline) {
+    std::ifstream file{path};
+    if (!file) {
+        std::cerr << "Can't open the baseline " << path << '\n';
+        return false;
+    }
+    try {
+        const auto json{nlohmann::json::parse(file)};
+        if (json.at("version").get<u32>() != RESULTS_VERSION) {
+            std::cerr << "The baseline " << path << " is from another version of the benchmarks\n";
+            return false;
+        }
+        for (const auto& benchmark : json.at("benchmarks"))
+            baseline[benchmark.at("name").get<std::string>()] =
+                benchmark.at("ns_per_op").get<double>();
+    } catch (const nlohmann::json::exception& e) {
+        std::cerr << "Invalid baseline " << path << ": " << e.what() << '\n';
+        return false;
+    }
+    return true;
+}
+
+std::string FormatTime(double ns) {
+    if (ns >= 1e6)
+        return fmt::format("{:.3f}ms", ns / 1e6);
+    if (ns >= 1e3)
+        return fmt::format("{:.3f}us", ns / 1e3);
+    return fmt::format("{:.1f}ns", ns);
+}
+
+void PrintHelp(const char* argv0) {
+    std::cout
+        << "Usage: " << argv0
+        << " [options]\n"
+           "Benchmarks the emulator's hot kernels on synthetic inputs.\n"
+           "-f, --filter       Only run the benchmarks whose names contain this string\n"
+           "-m, --memory-trace Also replay the svcControlMemory calls logged in this file, with\n"
+           "                   Kernel.SVC:Debug enabled\n"
+           "-l, --list         List the benchmarks and exit\n"
+           "-t, --min-time     Milliseconds to spend on each benchmark (default 500)\n"
+           "-s, --samples      Number of timed batches, the median is kept (default 5)\n"
+           "-o, --output       Write the results as JSON to this file\n"
+           "-b, --baseline     Compare with the results of a previous --output\n"
+           "-r, --threshold    Slowdown in percent over the baseline that counts as a regression,\n"
+           "                   making the exit code 1 (default 10)\n"
+           "-h, --help         Display this help and exit\n";
+}
+
+} // Anonymous namespace
+
+/// Application entry point
+int main(int argc, char** argv) {
+    Options options;
+    std::string output_path, baseline_path;
+    double threshold{10.0};
+    bool list{};
+    int option_index{};
+    static struct option long_options[]{
+        {"filter", required_argument, 0, 'f'},   {"list", no_argument, 0, 'l'},
+        {"min-time", required_argument, 0, 't'}, {"samples", required_argument, 0, 's'},
+        {"output", required_argument, 0, 'o'},   {"baseline", required_argument, 0, 'b'},
+        {"threshold", required_argument, 0, 'r'}, {"memory-trace", required_argument, 0, 'm'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0},
+    };
+    while (optind < argc) {
+        int arg{getopt_long(argc, argv, "f:lt:s:o:b:r:m:h", long_options, &option_index)};
+        if (arg == -1)
+            break;
+        switch (arg) {
+        case 'f':
+            options.filter = optarg;
+            break;
+        case 'l':
+            list = true;
+            break;
+        case 't':
+            options.min_time_ms = std::strtod(optarg, nullptr);
+            break;
+        case 's':
+            options.samples = std::strtoul(optarg, nullptr, 0);
+            break;
+        case 'o':
+            output_path = optarg;
+            break;
+        case 'b':
+            baseline_path = optarg;
+            break;
+        case 'r':
+            threshold = std::strtod(optarg, nullptr);
+            break;
+        case 'm':
+            options.memory_trace = optarg;
+            break;
+        case 'h':
+            PrintHelp(argv[0]);
+            return 0;
+        default:
+            PrintHelp(argv[0]);
+            return -1;
+        }
+    }
+    if (options.min_time_ms <= 0 || options.samples == 0) {
+        PrintHelp(argv[0]);
+        return -1;
+    }
+    Log::Filter log_filter{Log::Level::Error};
+    Log::SetGlobalFilter(log_filter);
+    Log::AddBackend(std::make_unique<Log::ColorConsoleBackend>());
+    std::unordered_map<std::string, double> baseline;
+    if (!baseline_path.empty() && !LoadBaseline(baseline_path, baseline))
+        return -1;
+
+    // The guest memory accesses of the kernels go to the scratch memory, through the physical
+    // pointers or this page table
+    auto page_table{std::make_unique<Memory::PageTable>()};
+    page_table->pointers.fill(nullptr);
+    page_table->attributes.fill(Memory::PageType::Unmapped);
+    Memory::MapMemoryRegion(*page_table, SCRATCH_VADDR, SCRATCH_SIZE, GetScratch(0));
+    Memory::SetCurrentPageTable(page_table.get());
+    Random{0xC17A}.Fill(GetScratch(0), SCRATCH_SIZE);
+
+    const auto benchmarks{CreateBenchmarks(options)};
+    std::vector<Result> results;
+    bool regressed{};
+    for (const auto& benchmark : benchmarks) {
+        if (benchmark.name.find(options.filter) == std::string::npos)
+            continue;
+        if (list) {
+            std::cout << benchmark.name << '\n';
+            continue;
+        }
+        if (benchmark.setup && !benchmark.setup())
+            continue;
+        const auto result{Run(benchmark, options)};
+        std::string line{fmt::format("{:<40} {:>12}", result.name, FormatTime(result.ns_per_op))};
+        if (result.bytes_per_op)
+            line += fmt::format(" {:>10.1f}MB/s", result.bytes_per_op / result.ns_per_op * 1e3);
+        else
+            line += std::string(14, ' ');
+        const auto itr{baseline.find(result.name)};
+        if (itr != baseline.end()) {
+            const double change{(result.ns_per_op / itr->second - 1.0) * 100.0};
+            const bool is_regression{change > threshold};
+            regressed |= is_regression;
+            line += fmt::format("  {:>12} {:>+7.1f}%{}", FormatTime(itr->second), change,
+                                is_regression ? "  REGRESSION" : "");
+        }
+        std::cout << line << std::endl;
+        results.push_back(result);
+    }
+    if (!romfs_path.empty())
+        FileUtil::Delete(romfs_path);
+    if (!output_path.empty()) {
+        std::ofstream file{output_path};
+        file << ToJSON(results).dump(4) << '\n';
+        if (!file) {
+            std::cerr << "Failed to write the results to " << output_path << '\n';
+            return -1;
+        }
+    }
+    return regressed ? 1 : 0;
+}
@@ -0,0 +1,36 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include "common/common_types.h"
+
+namespace Common {
+
+/// Index of the highest set bit, the value must not be 0
+inline u32 MostSignificantBit32(u32 value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse(&index, value);
+    return static_cast<u32>(index);
+#else
+    return 31 - static_cast<u32>(__builtin_clz(value));
+#endif
+}
+
+/// Index of the highest set bit, the value must not be 0
+inline u32 MostSignificantBit64(u64 value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<u32>(index);
+#else
+    return 63 - static_cast<u32>(__builtin_clzll(value));
+#endif
+}
+
+} // namespace Common
@@ -24,9 +24,11 @@
 #define NAND_DIR "nand"
 #define SYSDATA_DIR "sysdata"
 #define CHEATS_DIR "cheats"
+#define CACHE_DIR "cache"
 
 // Filenames
 #define LOG_FILE "log.txt"
+#define LOG_BINARY_FILE "log.bin"
 
 // System files
 #define AES_KEYS "aes_keys.txt"
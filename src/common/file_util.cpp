@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <array>
+#include <cstring>
 #include <memory>
 #include <unordered_map>
 #include "common/assert.h"
@@ -41,8 +42,10 @@
 #include <cstdlib>
 #include <cstring>
 #include <dirent.h>
+#include <fcntl.h>
 #include <pwd.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #endif
 
 #if defined(__APPLE__)
@@ -590,6 +593,7 @@ const std::string& GetUserPath(UserPath path, const std::string& settings_dir) {
         paths.emplace(UserPath::NANDDir, user_path + NAND_DIR DIR_SEP);
         paths.emplace(UserPath::SysDataDir, user_path + SYSDATA_DIR DIR_SEP);
         paths.emplace(UserPath::CheatsDir, user_path + CHEATS_DIR DIR_SEP);
+        paths.emplace(UserPath::CacheDir, user_path + CACHE_DIR DIR_SEP);
     }
     return paths[path];
 }
@@ -731,4 +735,113 @@ bool IOFile::Resize(u64 size) {
     return m_good;
 }
 
+MappedFile::MappedFile() {}
+
+MappedFile::MappedFile(const std::string& filename) {
+    Open(filename);
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) {
+    Swap(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) {
+    Swap(other);
+    return *this;
+}
+
+void MappedFile::Swap(MappedFile& other) {
+    std::swap(data, other.data);
+    std::swap(size, other.size);
+    std::swap(is_open, other.is_open);
+#ifdef _WIN32
+    std::swap(mapping_handle, other.mapping_handle);
+#endif
+}
+
+bool MappedFile::Open(const std::string& filename) {
+    Close();
+#ifdef _WIN32
+    HANDLE file{CreateFileW(Common::UTF8ToUTF16W(filename).c_str(), GENERIC_READ,
+                            FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr)};
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        CloseHandle(file);
+        return false;
+    }
+    size = static_cast<u64>(file_size.QuadPart);
+    if (size) {
+        mapping_handle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_handle)
+            data = static_cast<const u8*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+        if (!data) {
+            LOG_ERROR(Common_Filesystem, "Failed to map {}: {}", filename, GetLastErrorMsg());
+            if (mapping_handle)
+                CloseHandle(mapping_handle);
+            mapping_handle = nullptr;
+            CloseHandle(file);
+            size = 0;
+            return false;
+        }
+    }
+    // The mapping keeps the file alive
+    CloseHandle(file);
+#else
+    int fd{open(filename.c_str(), O_RDONLY)};
+    if (fd == -1)
+        return false;
+    size = FileUtil::GetSize(fd);
+    if (size) {
+        void* ptr{mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0)};
+        if (ptr == MAP_FAILED) {
+            LOG_ERROR(Common_Filesystem, "Failed to map {}: {}", filename, GetLastErrorMsg());
+            close(fd);
+            size = 0;
+            return false;
+        }
+        data = static_cast<const u8*>(ptr);
+    }
+    // The mapping keeps the file alive
+    close(fd);
+#endif
+    is_open = true;
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data) {
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+        CloseHandle(mapping_handle);
+        mapping_handle = nullptr;
+#else
+        munmap(const_cast<u8*>(data), size);
+#endif
+    }
+    data = nullptr;
+    size = 0;
+    is_open = false;
+}
+
+const u8* MappedFile::GetPointer(u64 offset, std::size_t length) const {
+    if (offset > size || length > size - offset)
+        return nullptr;
+    return data + offset;
+}
+
+std::size_t MappedFile::ReadBytes(u64 offset, void* buffer, std::size_t length) const {
+    if (offset >= size)
+        return 0;
+    std::size_t read_length{static_cast<std::size_t>(std::min<u64>(length, size - offset))};
+    std::memcpy(buffer, data + offset, read_length);
+    return read_length;
+}
+
 } // namespace FileUtil
@@ -27,6 +27,7 @@ enum class UserPath {
     SDMCDir,
     SysDataDir,
     CheatsDir,
+    CacheDir,
     UserDir,
 };
 
@@ -247,6 +248,57 @@ private:
     bool m_good{true};
 };
 
+// Read-only mapping of a whole file into the address space. Reads are served straight from the
+// host page cache, so several emulator instances opening the same file share its pages.
+class MappedFile : public NonCopyable {
+public:
+    MappedFile();
+    explicit MappedFile(const std::string& filename);
+
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other);
+    MappedFile& operator=(MappedFile&& other);
+
+    void Swap(MappedFile& other);
+
+    bool Open(const std::string& filename);
+    void Close();
+
+    /**
+     * Gets a view of a range of the file without copying it
+     * @param offset Offset of the range from the start of the file
+     * @param length Length of the range
+     * @return Pointer to the data, or nullptr if the range isn't fully inside the file
+     */
+    const u8* GetPointer(u64 offset, std::size_t length) const;
+
+    /**
+     * Copies a range of the file into a buffer
+     * @param offset Offset of the range from the start of the file
+     * @param data Buffer to copy into
+     * @param length Maximum number of bytes to copy
+     * @return Number of bytes copied, which is less than length at the end of the file
+     */
+    std::size_t ReadBytes(u64 offset, void* data, std::size_t length) const;
+
+    bool IsOpen() const {
+        return is_open;
+    }
+
+    u64 GetSize() const {
+        return size;
+    }
+
+private:
+    const u8* data{};
+    u64 size{};
+    bool is_open{};
+#ifdef _WIN32
+    void* mapping_handle{};
+#endif
+};
+
 } // namespace FileUtil
 
 // To deal with Windows being dumb at unicode:
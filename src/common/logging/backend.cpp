@@ -8,6 +8,7 @@
 #include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <thread>
 #include <vector>
 #ifdef _WIN32
@@ -18,13 +19,126 @@
 #endif
 #include "common/assert.h"
 #include "common/logging/backend.h"
+#include "common/logging/binary_log.h"
 #include "common/logging/log.h"
 #include "common/logging/text_formatter.h"
 #include "common/string_util.h"
-#include "common/threadsafe_queue.h"
 
 namespace Log {
 
+namespace {
+
+std::chrono::microseconds GetTimestamp() {
+    using std::chrono::steady_clock;
+    static const steady_clock::time_point time_origin{steady_clock::now()};
+    return std::chrono::duration_cast<std::chrono::microseconds>(steady_clock::now() -
+                                                                 time_origin);
+}
+
+/**
+ * Bounded lock-free ring of records, after Dmitry Vyukov's MPMC queue with a single consumer. The
+ * sequence of a slot says whether it's free for the producer that claimed its position, or holds a
+ * committed record for the backend thread. Records are filled in place, so logging doesn't
+ * allocate.
+ */
+class RecordRing {
+public:
+    RecordRing() {
+        for (std::size_t i{}; i < SIZE; ++i)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    Record& Reserve() {
+        std::size_t position{enqueue_position.load(std::memory_order_relaxed)};
+        for (;;) {
+            Slot& slot{slots[position & MASK]};
+            const std::size_t sequence{slot.sequence.load(std::memory_order_acquire)};
+            const auto difference{static_cast<std::ptrdiff_t>(sequence - position)};
+            if (difference == 0) {
+                if (enqueue_position.compare_exchange_weak(position, position + 1,
+                                                           std::memory_order_relaxed)) {
+                    slot.record.ring_position = position;
+                    return slot.record;
+                }
+            } else if (difference < 0) {
+                // Full, wait for the backend thread rather than dropping messages
+                Wake();
+                std::this_thread::yield();
+                position = enqueue_position.load(std::memory_order_relaxed);
+            } else {
+                position = enqueue_position.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void Commit(Record& record) {
+        const std::size_t position{record.ring_position};
+        slots[position & MASK].sequence.store(position + 1, std::memory_order_release);
+        // Pairs with the fence in Wait, so either the producer sees the waiting flag or the
+        // backend thread sees the record
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting.load(std::memory_order_relaxed))
+            Wake();
+    }
+
+    /// Returns the oldest committed record, if any. Only for the backend thread
+    Record* Front() {
+        Slot& slot{slots[dequeue_position & MASK]};
+        if (slot.sequence.load(std::memory_order_acquire) != dequeue_position + 1)
+            return nullptr;
+        return &slot.record;
+    }
+
+    /// Frees the record returned by Front
+    void Pop() {
+        Slot& slot{slots[dequeue_position & MASK]};
+        slot.record.message.reset();
+        slot.sequence.store(dequeue_position + SIZE, std::memory_order_release);
+        ++dequeue_position;
+    }
+
+    /// Blocks the backend thread until a record is committed or Wake is called
+    void Wait() {
+        std::unique_lock lock{mutex};
+        waiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        // The timeout is only a safety net
+        if (!Front() && !woken)
+            cv.wait_for(lock, std::chrono::milliseconds{100});
+        woken = false;
+        waiting.store(false, std::memory_order_relaxed);
+    }
+
+    void Wake() {
+        std::lock_guard lock{mutex};
+        woken = true;
+        cv.notify_one();
+    }
+
+private:
+    static constexpr std::size_t SIZE{8192};
+    static constexpr std::size_t MASK{SIZE - 1};
+    static_assert((SIZE & MASK) == 0, "The ring size must be a power of two");
+
+    struct alignas(64) Slot {
+        std::atomic<std::size_t> sequence;
+        Record record;
+    };
+
+    std::unique_ptr<Slot[]> slots{new Slot[SIZE]};
+    alignas(64) std::atomic<std::size_t> enqueue_position{};
+    alignas(64) std::size_t dequeue_position{};
+    std::atomic_bool waiting{};
+    bool woken{};
+    std::mutex mutex;
+    std::condition_variable cv;
+};
+
+/// Set on the backend thread, which must never log: it would wait on itself when the ring is full
+thread_local bool is_backend_thread{};
+
+} // Anonymous namespace
+
 /**
  * Static state as a singleton.
  */
@@ -38,8 +152,12 @@ public:
     Impl(Impl const&) = delete;
     const Impl& operator=(Impl const&) = delete;
 
-    void PushEntry(Entry e) {
-        message_queue.Push(std::move(e));
+    Record& BeginRecord() {
+        return ring.Reserve();
+    }
+
+    void CommitRecord(Record& record) {
+        ring.Commit(record);
     }
 
     void AddBackend(std::unique_ptr<Backend> backend) {
@@ -51,7 +169,6 @@ public:
         std::lock_guard lock{writing_mutex};
         const auto it{
             std::remove_if(backends.begin(), backends.end(), [&backend_name](const auto& i) {
-                LOG_CRITICAL(Log, "{}", i->GetName());
                 return backend_name == i->GetName();
             })};
         backends.erase(it, backends.end());
@@ -67,35 +184,57 @@ public:
 
 private:
     Impl() {
-        backend_thread = std::thread([&] {
-            Entry entry;
-            auto write_logs{[&](Entry& e) {
-                std::lock_guard lock{writing_mutex};
-                for (const auto& backend : backends) {
-                    backend->Write(e);
-                }
-            }};
-            for (;;) {
-                entry = message_queue.PopWait();
-                if (entry.final_entry) {
-                    break;
-                }
-                write_logs(entry);
-            }
-        });
+        backend_thread = std::thread{&Impl::BackendLoop, this};
     }
 
     ~Impl() {
-        Entry entry;
-        entry.final_entry = true;
-        message_queue.Push(entry);
+        stopping.store(true, std::memory_order_relaxed);
+        ring.Wake();
         backend_thread.join();
     }
 
+    void BackendLoop() {
+        is_backend_thread = true;
+        for (;;) {
+            Record* record{ring.Front()};
+            if (!record) {
+                {
+                    std::lock_guard lock{writing_mutex};
+                    for (const auto& backend : backends)
+                        backend->Flush();
+                }
+                if (stopping.load(std::memory_order_relaxed))
+                    return;
+                ring.Wait();
+                continue;
+            }
+            Write(*record);
+            ring.Pop();
+        }
+    }
+
+    void Write(Record& record) {
+        std::lock_guard lock{writing_mutex};
+        // The message is only formatted if a text backend wants it, and once for all of them
+        std::optional<Entry> entry;
+        for (const auto& backend : backends) {
+            if (!backend->GetFilter().CheckMessage(record.log_class, record.log_level))
+                continue;
+            if (backend->TakesRecords()) {
+                backend->WriteRecord(record);
+                continue;
+            }
+            if (!entry)
+                entry = CreateEntry(record);
+            backend->Write(*entry);
+        }
+    }
+
+    RecordRing ring;
     std::mutex writing_mutex;
     std::thread backend_thread;
     std::vector<std::unique_ptr<Backend>> backends;
-    Common::MPSCQueue<Log::Entry> message_queue;
+    std::atomic_bool stopping{};
     Filter filter;
 };
 
@@ -105,19 +244,80 @@ void ColorConsoleBackend::Write(const Entry& entry) {
 
 // _SH_DENYWR allows read only access to the file for other programs.
 // It is #defined to 0 on other platforms
-FileBackend::FileBackend(const std::string& filename) : file{filename, "w", _SH_DENYWR} {}
+LogFile::LogFile(std::string filename, const char* openmode)
+    : filename{std::move(filename)}, openmode{openmode},
+      file{this->filename, openmode, _SH_DENYWR} {
+    buffer.reserve(BUFFER_SIZE);
+}
 
-void FileBackend::Write(const Entry& entry) {
-    // prevent logs from going over the maximum size (in case its spamming and the user doesn't
-    // know)
-    constexpr std::size_t MAX_BYTES_WRITTEN{50 * 1024L * 1024L};
-    if (!file.IsOpen() || bytes_written > MAX_BYTES_WRITTEN) {
+LogFile::~LogFile() {
+    Flush();
+}
+
+bool LogFile::Rotate() {
+    if (size < MAX_SIZE)
+        return false;
+    Flush();
+    file.Close();
+    const std::string old_filename{filename + ".1"};
+    FileUtil::Delete(old_filename);
+    FileUtil::Rename(filename, old_filename);
+    file.Open(filename, openmode, _SH_DENYWR);
+    size = 0;
+    return true;
+}
+
+void LogFile::Write(std::string_view data) {
+    if (!file.IsOpen())
         return;
-    }
-    bytes_written += file.WriteString(FormatLogMessage(entry).append(1, '\n'));
-    if (entry.log_level >= Level::Error) {
+    buffer.append(data);
+    size += data.size();
+    if (buffer.size() >= BUFFER_SIZE)
+        Flush();
+}
+
+void LogFile::Flush() {
+    if (buffer.empty())
+        return;
+    file.WriteString(buffer);
+    file.Flush();
+    buffer.clear();
+}
+
+FileBackend::FileBackend(const std::string& filename) : file{filename, "w"} {}
+
+void FileBackend::Write(const Entry& entry) {
+    file.Rotate();
+    file.Write(FormatLogMessage(entry).append(1, '\n'));
+    if (entry.log_level >= Level::Error)
         file.Flush();
-    }
+}
+
+void FileBackend::Flush() {
+    file.Flush();
+}
+
+BinaryFileBackend::BinaryFileBackend(const std::string& filename)
+    : file{filename, "wb"}, encoder{std::make_unique<BinaryLogEncoder>()} {
+    encoder->Begin(buffer);
+    file.Write(buffer);
+    buffer.clear();
+}
+
+BinaryFileBackend::~BinaryFileBackend() = default;
+
+void BinaryFileBackend::WriteRecord(const Record& record) {
+    if (file.Rotate())
+        encoder->Begin(buffer);
+    encoder->Encode(buffer, record);
+    file.Write(buffer);
+    buffer.clear();
+    if (record.log_level >= Level::Error)
+        file.Flush();
+}
+
+void BinaryFileBackend::Flush() {
+    file.Flush();
 }
 
 void DebuggerBackend::Write(const Entry& entry) {
@@ -229,13 +429,8 @@ const char* GetLevelName(Level log_level) {
 
 Entry CreateEntry(Class log_class, Level log_level, const char* filename, unsigned int line_nr,
                   const char* function, std::string message) {
-    using std::chrono::duration_cast;
-    using std::chrono::steady_clock;
-
-    static steady_clock::time_point time_origin{steady_clock::now()};
-
     Entry entry{};
-    entry.timestamp = duration_cast<std::chrono::microseconds>(steady_clock::now() - time_origin);
+    entry.timestamp = GetTimestamp();
     entry.log_class = log_class;
     entry.log_level = log_level;
     entry.filename = Common::TrimSourcePath(filename);
@@ -246,6 +441,23 @@ Entry CreateEntry(Class log_class, Level log_level, const char* filename, unsign
     return entry;
 }
 
+Entry CreateEntry(const Record& record) {
+    Entry entry{};
+    entry.timestamp = record.timestamp;
+    entry.log_class = record.log_class;
+    entry.log_level = record.log_level;
+    entry.filename = Common::TrimSourcePath(record.filename);
+    entry.line_num = record.line_num;
+    entry.function = record.function;
+    if (record.format)
+        entry.message = FormatRecordMessage(record.format, record.num_args, record.data.data(),
+                                            record.data_size);
+    else
+        entry.message = *record.message;
+
+    return entry;
+}
+
 void SetGlobalFilter(const Filter& filter) {
     Impl::Instance().SetGlobalFilter(filter);
 }
@@ -258,17 +470,36 @@ void RemoveBackend(std::string_view backend_name) {
     Impl::Instance().RemoveBackend(backend_name);
 }
 
+bool CheckFilter(Class log_class, Level log_level) {
+    return Impl::Instance().GetGlobalFilter().CheckMessage(log_class, log_level) &&
+           !is_backend_thread;
+}
+
+Record& BeginRecord(Class log_class, Level log_level, const char* filename, unsigned int line_num,
+                    const char* function, const char* format) {
+    Record& record{Impl::Instance().BeginRecord()};
+    record.timestamp = GetTimestamp();
+    record.filename = filename;
+    record.function = function;
+    record.format = format;
+    record.line_num = line_num;
+    record.log_class = log_class;
+    record.log_level = log_level;
+    return record;
+}
+
+void CommitRecord(Record& record) {
+    Impl::Instance().CommitRecord(record);
+}
+
 void FmtLogMessageImpl(Class log_class, Level log_level, const char* filename,
                        unsigned int line_num, const char* function, const char* format,
                        const fmt::format_args& args) {
-    auto& instance{Impl::Instance()};
-    const auto& filter{instance.GetGlobalFilter()};
-    if (!filter.CheckMessage(log_class, log_level))
-        return;
-
-    Entry entry{CreateEntry(log_class, log_level, filename, line_num, function,
-                            fmt::vformat(format, args))};
-
-    instance.PushEntry(std::move(entry));
+    auto message{std::make_unique<std::string>(fmt::vformat(format, args))};
+    Record& record{BeginRecord(log_class, log_level, filename, line_num, function, nullptr)};
+    record.message = std::move(message);
+    record.num_args = 0;
+    record.data_size = 0;
+    CommitRecord(record);
 }
 } // namespace Log
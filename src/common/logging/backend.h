@@ -14,6 +14,7 @@
 
 namespace Log {
 
+class BinaryLogEncoder;
 class Filter;
 
 /**
@@ -28,7 +29,6 @@ struct Entry {
     unsigned int line_num;
     std::string function;
     std::string message;
-    bool final_entry{};
 
     Entry() = default;
     Entry(Entry&& o) = default;
@@ -49,11 +49,25 @@ public:
         filter = new_filter;
     }
 
+    const Filter& GetFilter() const {
+        return filter;
+    }
+
     virtual const char* GetName() const = 0;
     virtual void Write(const Entry& entry) = 0;
 
+    /// Whether the backend is given the records as logged, through WriteRecord, instead of entries
+    virtual bool TakesRecords() const {
+        return false;
+    }
+
+    virtual void WriteRecord(const Record& record) {}
+
+    /// Called by the backend thread once it has written all pending messages
+    virtual void Flush() {}
+
 private:
-    Filter filter;
+    Filter filter{Level::Trace};
 };
 
 /// Backend that writes to stderr and with color
@@ -68,6 +82,37 @@ public:
     void Write(const Entry& entry) override;
 };
 
+/**
+ * Log file written through a buffer. Once it grows over the size limit, it's moved to
+ * "<filename>.1", replacing the previous one, and a new file is started.
+ */
+class LogFile {
+public:
+    static constexpr std::size_t MAX_SIZE{50 * 1024 * 1024};
+
+    LogFile(std::string filename, const char* openmode);
+    ~LogFile();
+
+    bool IsOpen() const {
+        return file.IsOpen();
+    }
+
+    /// Starts a new file if the current one is full, returns whether it did
+    bool Rotate();
+
+    void Write(std::string_view data);
+    void Flush();
+
+private:
+    static constexpr std::size_t BUFFER_SIZE{64 * 1024};
+
+    std::string filename;
+    const char* openmode;
+    FileUtil::IOFile file;
+    std::string buffer;
+    std::size_t size{};
+};
+
 /// Backend that writes to a file passed into the constructor
 class FileBackend : public Backend {
 public:
@@ -78,12 +123,43 @@ public:
     }
 
     void Write(const Entry& entry) override;
+    void Flush() override;
 
     static constexpr const char* Name{"file"};
 
 private:
-    FileUtil::IOFile file;
-    std::size_t bytes_written{};
+    LogFile file;
+};
+
+/**
+ * Backend that writes the records unformatted in the compact format of binary_log.h, which
+ * citra-log-decoder turns into text. Cheap enough to keep trace logging on.
+ */
+class BinaryFileBackend : public Backend {
+public:
+    explicit BinaryFileBackend(const std::string& filename);
+    ~BinaryFileBackend() override;
+
+    const char* GetName() const override {
+        return Name;
+    }
+
+    // The messages come through WriteRecord
+    void Write(const Entry& entry) override {}
+
+    bool TakesRecords() const override {
+        return true;
+    }
+
+    void WriteRecord(const Record& record) override;
+    void Flush() override;
+
+    static constexpr const char* Name{"binary_file"};
+
+private:
+    LogFile file;
+    std::unique_ptr<BinaryLogEncoder> encoder;
+    std::string buffer;
 };
 
 /// Backend that writes to Visual Studio's output window
@@ -115,6 +191,9 @@ const char* GetLevelName(Level log_level);
 Entry CreateEntry(Class log_class, Level log_level, const char* filename, unsigned int line_nr,
                   const char* function, std::string message);
 
+/// Creates a log entry from a record, formatting its message
+Entry CreateEntry(const Record& record);
+
 /**
  * The global filter will prevent any messages from even being processed if they are filtered. Each
  * backend can have a filter, but if the level is lower than the global filter, the backend will
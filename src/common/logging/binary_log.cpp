@@ -0,0 +1,120 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/logging/backend.h"
+#include "common/logging/binary_log.h"
+#include "common/logging/record.h"
+#include "common/string_util.h"
+
+namespace Log {
+
+namespace {
+
+template <typename T>
+void Append(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+} // Anonymous namespace
+
+void BinaryLogEncoder::Begin(std::string& out) {
+    string_ids.clear();
+    Append(out, BINARY_LOG_MAGIC);
+    Append(out, BINARY_LOG_VERSION);
+}
+
+u32 BinaryLogEncoder::GetStringId(std::string& out, const char* string, bool is_filename) {
+    if (!string)
+        return 0;
+    const auto [itr, inserted]{
+        string_ids.emplace(string, static_cast<u32>(string_ids.size() + 1))};
+    if (!inserted)
+        return itr->second;
+    const std::string_view value{is_filename ? Common::TrimSourcePath(string) : string};
+    const u16 length{static_cast<u16>(std::min<std::size_t>(value.size(), 0xFFFF))};
+    Append(out, BinaryLogTag::String);
+    Append(out, itr->second);
+    Append(out, length);
+    out.append(value.data(), length);
+    return itr->second;
+}
+
+void BinaryLogEncoder::Encode(std::string& out, const Record& record) {
+    const u32 filename_id{GetStringId(out, record.filename, true)};
+    const u32 function_id{GetStringId(out, record.function, false)};
+    const u32 format_id{GetStringId(out, record.format, false)};
+    Append(out, BinaryLogTag::Record);
+    Append(out, static_cast<u64>(record.timestamp.count()));
+    Append(out, record.log_class);
+    Append(out, record.log_level);
+    Append(out, record.line_num);
+    Append(out, filename_id);
+    Append(out, function_id);
+    Append(out, format_id);
+    Append(out, record.num_args);
+    if (record.format) {
+        Append(out, static_cast<u32>(record.data_size));
+        out.append(reinterpret_cast<const char*>(record.data.data()), record.data_size);
+    } else {
+        const std::string& message{*record.message};
+        Append(out, static_cast<u32>(message.size()));
+        out.append(message);
+    }
+}
+
+template <typename T>
+bool BinaryLogReader::ReadValue(T& value) {
+    return file.ReadBytes(&value, sizeof(value)) == sizeof(value);
+}
+
+BinaryLogReader::BinaryLogReader(const std::string& filename) : file{filename, "rb"} {
+    u32 magic{}, version{};
+    valid = ReadValue(magic) && ReadValue(version) && magic == BINARY_LOG_MAGIC &&
+            version == BINARY_LOG_VERSION;
+}
+
+bool BinaryLogReader::Read(Entry& entry) {
+    if (!valid)
+        return false;
+    BinaryLogTag tag;
+    while (ReadValue(tag)) {
+        if (tag == BinaryLogTag::String) {
+            u32 id;
+            u16 length;
+            if (!ReadValue(id) || !ReadValue(length))
+                return false;
+            std::string string(length, '\0');
+            if (file.ReadBytes(string.data(), length) != length)
+                return false;
+            strings[id] = std::move(string);
+            continue;
+        }
+        if (tag != BinaryLogTag::Record)
+            return false;
+        u64 timestamp;
+        u32 filename_id, function_id, format_id, data_size;
+        u8 num_args;
+        if (!ReadValue(timestamp) || !ReadValue(entry.log_class) ||
+            !ReadValue(entry.log_level) || !ReadValue(entry.line_num) ||
+            !ReadValue(filename_id) || !ReadValue(function_id) || !ReadValue(format_id) ||
+            !ReadValue(num_args) || !ReadValue(data_size))
+            return false;
+        data.resize(data_size);
+        if (file.ReadBytes(data.data(), data_size) != data_size)
+            return false;
+        entry.timestamp = std::chrono::microseconds{timestamp};
+        entry.filename = strings[filename_id];
+        entry.function = strings[function_id];
+        if (format_id == 0)
+            entry.message.assign(data.begin(), data.end());
+        else
+            entry.message = FormatRecordMessage(strings[format_id].c_str(), num_args, data.data(),
+                                                data.size());
+        return true;
+    }
+    return false;
+}
+
+} // namespace Log
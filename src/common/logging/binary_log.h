@@ -0,0 +1,74 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+#include "common/file_util.h"
+
+namespace Log {
+
+struct Entry;
+struct Record;
+
+/**
+ * Binary logs start with the magic and version as u32s, followed by chunks starting with a
+ * BinaryLogTag:
+ *  - String: u32 id, u16 length and the characters. Defines the filenames, functions and format
+ *    strings the records refer to, the first time each is used.
+ *  - Record: u64 timestamp in microseconds, u8 class, u8 level, u32 line, u32 filename id,
+ *    u32 function id, u32 format id, u8 argument count, u32 data size and the data. The data is
+ *    the arguments encoded as in a Record, or the message itself when the format id is zero.
+ * The classes and levels are those of the build that wrote the log.
+ */
+constexpr u32 BINARY_LOG_MAGIC{0x474F4C43}; // "CLOG"
+constexpr u32 BINARY_LOG_VERSION{1};
+
+enum class BinaryLogTag : u8 {
+    String = 1,
+    Record = 2,
+};
+
+/// Turns records into binary log chunks, defining their strings as needed
+class BinaryLogEncoder {
+public:
+    /// Appends the file header and forgets the strings defined so far, for a new file
+    void Begin(std::string& out);
+
+    void Encode(std::string& out, const Record& record);
+
+private:
+    u32 GetStringId(std::string& out, const char* string, bool is_filename);
+
+    // Keyed by address, the strings are literals
+    std::unordered_map<const char*, u32> string_ids;
+};
+
+/// Reads the entries of a binary log
+class BinaryLogReader {
+public:
+    explicit BinaryLogReader(const std::string& filename);
+
+    /// Whether the file is a binary log of a supported version
+    bool IsValid() const {
+        return valid;
+    }
+
+    /// Reads the next entry, returns false at the end of the log
+    bool Read(Entry& entry);
+
+private:
+    template <typename T>
+    bool ReadValue(T& value);
+
+    FileUtil::IOFile file;
+    bool valid{};
+    std::unordered_map<u32, std::string> strings;
+    std::vector<u8> data;
+};
+
+} // namespace Log
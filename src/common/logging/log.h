@@ -6,6 +6,7 @@
 
 #include <fmt/format.h>
 #include "common/common_types.h"
+#include "common/logging/record.h"
 
 namespace Log {
 
@@ -100,14 +101,44 @@ enum class Class : u8 {
     Count               ///< Total number of logging classes
 };
 
-/// Logs a message to the global logger, using fmt
+/// Returns whether the global filter lets messages of this class and level through
+bool CheckFilter(Class log_class, Level log_level);
+
+/**
+ * Reserves a record in the log ring and sets its source location. The caller fills in the
+ * arguments, then hands it to the backend thread with CommitRecord.
+ */
+Record& BeginRecord(Class log_class, Level log_level, const char* filename, unsigned int line_num,
+                    const char* function, const char* format);
+
+void CommitRecord(Record& record);
+
+/// Logs a message to the global logger, formatting it right away
 void FmtLogMessageImpl(Class log_class, Level log_level, const char* filename,
                        unsigned int line_num, const char* function, const char* format,
                        const fmt::format_args& args);
 
+/**
+ * Logs a message to the global logger, using fmt. Arguments of basic types are only copied here,
+ * the backend thread formats them.
+ */
 template <typename... Args>
 void FmtLogMessage(Class log_class, Level log_level, const char* filename, unsigned int line_num,
                    const char* function, const char* format, const Args&... args) {
+    if (!CheckFilter(log_class, log_level))
+        return;
+    if constexpr (Detail::IsEncodable<Args...>) {
+        const std::size_t data_size{(Detail::GetEncodedSize(args) + ... + 0)};
+        if (data_size <= Record::DATA_SIZE) {
+            Record& record{BeginRecord(log_class, log_level, filename, line_num, function, format)};
+            u8* out{record.data.data()};
+            (Detail::Encode(out, args), ...);
+            record.num_args = static_cast<u8>(sizeof...(Args));
+            record.data_size = static_cast<u16>(data_size);
+            CommitRecord(record);
+            return;
+        }
+    }
     FmtLogMessageImpl(log_class, log_level, filename, line_num, function, format,
                       fmt::make_format_args(args...));
 }
@@ -118,13 +149,12 @@ void FmtLogMessage(Class log_class, Level log_level, const char* filename, unsig
 #define LOG_GENERIC(log_class, level, ...)                                                         \
     ::Log::FmtLogMessage(::Log::Class::log_class, level, __FILE__, __LINE__, __func__, __VA_ARGS__)
 
-#ifdef _DEBUG
+// Trace messages are compiled in everywhere, their arguments are only evaluated when enabled
 #define LOG_TRACE(log_class, ...)                                                                  \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Trace, __FILE__, __LINE__,         \
-                         __func__, __VA_ARGS__)
-#else
-#define LOG_TRACE(log_class, fmt, ...) (void(0))
-#endif
+    (::Log::CheckFilter(::Log::Class::log_class, ::Log::Level::Trace)                              \
+         ? ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Trace, __FILE__,            \
+                                __LINE__, __func__, __VA_ARGS__)                                   \
+         : void(0))
 
 #define LOG_DEBUG(log_class, ...)                                                                  \
     ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Debug, __FILE__, __LINE__,         \
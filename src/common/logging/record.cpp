@@ -0,0 +1,160 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <fmt/format.h>
+#include "common/logging/record.h"
+
+namespace Log {
+
+namespace {
+
+/// An argument read back from a record, formatted as the type it was logged with
+struct DecodedArg {
+    ArgType type{ArgType::None};
+    union {
+        s64 signed_value;
+        u64 unsigned_value;
+        float float_value;
+        double double_value;
+        bool bool_value;
+        char char_value;
+        const void* pointer_value;
+    };
+    std::string_view string_value;
+};
+
+template <typename V>
+bool Read(const u8*& in, const u8* end, V& value) {
+    if (static_cast<std::size_t>(end - in) < sizeof(value))
+        return false;
+    std::memcpy(&value, in, sizeof(value));
+    in += sizeof(value);
+    return true;
+}
+
+bool Decode(const u8*& in, const u8* end, DecodedArg& arg) {
+    u8 type;
+    if (!Read(in, end, type))
+        return false;
+    arg.type = static_cast<ArgType>(type);
+    switch (arg.type) {
+    case ArgType::Signed:
+        return Read(in, end, arg.signed_value);
+    case ArgType::Unsigned:
+        return Read(in, end, arg.unsigned_value);
+    case ArgType::Float:
+        return Read(in, end, arg.float_value);
+    case ArgType::Double:
+        return Read(in, end, arg.double_value);
+    case ArgType::Bool: {
+        u8 value;
+        if (!Read(in, end, value))
+            return false;
+        arg.bool_value = value != 0;
+        return true;
+    }
+    case ArgType::Char:
+        return Read(in, end, arg.char_value);
+    case ArgType::Pointer: {
+        u64 value;
+        if (!Read(in, end, value))
+            return false;
+        arg.pointer_value = reinterpret_cast<const void*>(static_cast<std::uintptr_t>(value));
+        return true;
+    }
+    case ArgType::String: {
+        u16 length;
+        if (!Read(in, end, length) || static_cast<std::size_t>(end - in) < length)
+            return false;
+        arg.string_value = {reinterpret_cast<const char*>(in), length};
+        in += length;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+} // Anonymous namespace
+
+} // namespace Log
+
+namespace fmt {
+
+/// Formats the decoded value with the format spec of its replacement field
+template <>
+struct formatter<Log::DecodedArg> {
+    std::string field{"{}"};
+
+    template <typename ParseContext>
+    auto parse(ParseContext& ctx) {
+        auto it{ctx.begin()};
+        std::string spec;
+        while (it != ctx.end() && *it != '}')
+            spec.push_back(*it++);
+        if (!spec.empty())
+            field = "{:" + spec + "}";
+        return it;
+    }
+
+    template <typename FormatContext>
+    auto format(const Log::DecodedArg& arg, FormatContext& ctx) const {
+        std::string result;
+        switch (arg.type) {
+        case Log::ArgType::Signed:
+            result = fmt::vformat(field, fmt::make_format_args(arg.signed_value));
+            break;
+        case Log::ArgType::Unsigned:
+            result = fmt::vformat(field, fmt::make_format_args(arg.unsigned_value));
+            break;
+        case Log::ArgType::Float:
+            result = fmt::vformat(field, fmt::make_format_args(arg.float_value));
+            break;
+        case Log::ArgType::Double:
+            result = fmt::vformat(field, fmt::make_format_args(arg.double_value));
+            break;
+        case Log::ArgType::Bool:
+            result = fmt::vformat(field, fmt::make_format_args(arg.bool_value));
+            break;
+        case Log::ArgType::Char:
+            result = fmt::vformat(field, fmt::make_format_args(arg.char_value));
+            break;
+        case Log::ArgType::Pointer:
+            result = fmt::vformat(field, fmt::make_format_args(arg.pointer_value));
+            break;
+        case Log::ArgType::String:
+            result = fmt::vformat(field, fmt::make_format_args(arg.string_value));
+            break;
+        default:
+            throw fmt::format_error("argument index out of range");
+        }
+        return std::copy(result.begin(), result.end(), ctx.out());
+    }
+};
+
+} // namespace fmt
+
+namespace Log {
+
+std::string FormatRecordMessage(const char* format, u8 num_args, const u8* data,
+                                std::size_t data_size) {
+    std::array<DecodedArg, Record::MAX_ARGS> args{};
+    const u8* in{data};
+    const u8* const end{data + data_size};
+    for (std::size_t i{}; i < std::min<std::size_t>(num_args, args.size()); ++i)
+        if (!Decode(in, end, args[i]))
+            return fmt::format("Corrupted log record for \"{}\"", format);
+    try {
+        return fmt::vformat(format, fmt::make_format_args(
+                                        args[0], args[1], args[2], args[3], args[4], args[5],
+                                        args[6], args[7], args[8], args[9], args[10], args[11],
+                                        args[12], args[13], args[14], args[15]));
+    } catch (const fmt::format_error& e) {
+        return fmt::format("Failed to format \"{}\": {}", format, e.what());
+    }
+}
+
+} // namespace Log
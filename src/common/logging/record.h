@@ -0,0 +1,151 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "common/common_types.h"
+
+namespace Log {
+
+enum class Class : u8;
+enum class Level : u8;
+
+/// Type tag preceding each encoded argument of a record
+enum class ArgType : u8 {
+    None, ///< Not encodable, the message is formatted by the caller instead
+    Signed,
+    Unsigned,
+    Float,
+    Double,
+    Bool,
+    Char,
+    Pointer,
+    String, ///< u16 length followed by the characters
+};
+
+/**
+ * A log message whose formatting is deferred to the backend thread. The arguments are copied into
+ * data after their ArgType, and format points to the string literal given to the LOG_* macro.
+ * Messages whose arguments can't be encoded are formatted by the caller into message instead, with
+ * format set to null.
+ */
+struct Record {
+    static constexpr std::size_t DATA_SIZE{176};
+    static constexpr std::size_t MAX_ARGS{16};
+
+    std::chrono::microseconds timestamp;
+    const char* filename;
+    const char* function;
+    const char* format;
+    std::unique_ptr<std::string> message;
+    std::size_t ring_position; ///< Set by the ring the record was reserved in
+    u32 line_num;
+    Class log_class;
+    Level log_level;
+    u8 num_args;
+    u16 data_size;
+    std::array<u8, DATA_SIZE> data;
+};
+
+/// Formats the arguments encoded in data with format, for records and binary logs
+std::string FormatRecordMessage(const char* format, u8 num_args, const u8* data,
+                                std::size_t data_size);
+
+namespace Detail {
+
+template <typename T>
+constexpr ArgType GetArgType() {
+    using U = std::remove_cv_t<std::decay_t<T>>;
+    if constexpr (std::is_same_v<U, bool>)
+        return ArgType::Bool;
+    else if constexpr (std::is_same_v<U, char>)
+        return ArgType::Char;
+    else if constexpr (std::is_same_v<U, wchar_t> || std::is_same_v<U, char16_t> ||
+                       std::is_same_v<U, char32_t>)
+        return ArgType::None;
+    else if constexpr (std::is_integral_v<U> && sizeof(U) <= sizeof(u64))
+        return std::is_signed_v<U> ? ArgType::Signed : ArgType::Unsigned;
+    else if constexpr (std::is_same_v<U, float>)
+        return ArgType::Float;
+    else if constexpr (std::is_same_v<U, double>)
+        return ArgType::Double;
+    else if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*> ||
+                       std::is_same_v<U, std::string> || std::is_same_v<U, std::string_view>)
+        return ArgType::String;
+    else if constexpr (std::is_same_v<U, const void*> || std::is_same_v<U, void*> ||
+                       std::is_same_v<U, std::nullptr_t>)
+        return ArgType::Pointer;
+    else
+        return ArgType::None;
+}
+
+template <typename T>
+std::string_view ToStringView(const T& value) {
+    if constexpr (std::is_pointer_v<std::decay_t<T>>)
+        return value ? std::string_view{value} : std::string_view{};
+    else
+        return value;
+}
+
+template <typename T>
+std::size_t GetEncodedSize(const T& value) {
+    constexpr ArgType type{GetArgType<T>()};
+    if constexpr (type == ArgType::String)
+        return 1 + sizeof(u16) + ToStringView(value).size();
+    else if constexpr (type == ArgType::Bool || type == ArgType::Char)
+        return 2;
+    else if constexpr (type == ArgType::Float)
+        return 1 + sizeof(float);
+    else
+        return 1 + sizeof(u64);
+}
+
+template <typename V>
+void Write(u8*& out, const V& value) {
+    std::memcpy(out, &value, sizeof(value));
+    out += sizeof(value);
+}
+
+template <typename T>
+void Encode(u8*& out, const T& value) {
+    constexpr ArgType type{GetArgType<T>()};
+    *out++ = static_cast<u8>(type);
+    if constexpr (type == ArgType::String) {
+        const std::string_view string{ToStringView(value)};
+        Write(out, static_cast<u16>(string.size()));
+        std::memcpy(out, string.data(), string.size());
+        out += string.size();
+    } else if constexpr (type == ArgType::Signed) {
+        Write(out, static_cast<s64>(value));
+    } else if constexpr (type == ArgType::Unsigned) {
+        Write(out, static_cast<u64>(value));
+    } else if constexpr (type == ArgType::Float || type == ArgType::Double) {
+        Write(out, value);
+    } else if constexpr (type == ArgType::Bool) {
+        *out++ = value ? 1 : 0;
+    } else if constexpr (type == ArgType::Char) {
+        *out++ = static_cast<u8>(value);
+    } else if constexpr (type == ArgType::Pointer) {
+        const void* pointer{value};
+        Write(out, static_cast<u64>(reinterpret_cast<std::uintptr_t>(pointer)));
+    }
+}
+
+/// Whether the arguments can be copied into a record instead of formatted by the caller
+template <typename... Args>
+constexpr bool IsEncodable{sizeof...(Args) <= Record::MAX_ARGS &&
+                           ((GetArgType<Args>() != ArgType::None) && ...)};
+
+} // namespace Detail
+
+} // namespace Log
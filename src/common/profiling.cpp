@@ -0,0 +1,207 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <fmt/format.h>
+#include "common/profiling.h"
+
+namespace Common::Profiling {
+
+namespace Detail {
+std::atomic_bool recording{};
+} // namespace Detail
+
+namespace {
+
+/// Duration of the frame markers, which are instants
+constexpr u64 INSTANT{~u64{}};
+
+// The fields are atomics so that exporting can read the ring while its thread writes to it
+struct Event {
+    std::atomic<const char*> category;
+    std::atomic<const char*> name;
+    std::atomic<u64> start;
+    std::atomic<u64> duration;
+};
+
+struct ThreadBuffer {
+    u32 id;
+    std::string name; ///< Guarded by registry_mutex
+    /// Events written so far, the ring holds the last EVENTS_PER_THREAD of them
+    std::atomic<u64> write_index{};
+    std::unique_ptr<Event[]> events{new Event[EVENTS_PER_THREAD]};
+};
+
+struct ExportedEvent {
+    const char* category;
+    const char* name;
+    u64 start;
+    u64 duration;
+};
+
+std::mutex registry_mutex;
+std::vector<std::shared_ptr<ThreadBuffer>> registry;
+u32 next_thread_id{1};
+std::atomic<u64> session_start{};
+
+thread_local std::shared_ptr<ThreadBuffer> thread_buffer;
+thread_local std::string thread_name;
+
+u64 Now() {
+    static const auto epoch{std::chrono::steady_clock::now()};
+    return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::steady_clock::now() - epoch)
+                                .count());
+}
+
+ThreadBuffer& GetThreadBuffer() {
+    if (!thread_buffer) {
+        auto buffer{std::make_shared<ThreadBuffer>()};
+        std::lock_guard lock{registry_mutex};
+        buffer->id = next_thread_id++;
+        buffer->name = thread_name.empty() ? fmt::format("Thread {}", buffer->id) : thread_name;
+        registry.push_back(buffer);
+        thread_buffer = std::move(buffer);
+    }
+    return *thread_buffer;
+}
+
+void Record(const char* category, const char* name, u64 start, u64 duration) {
+    auto& buffer{GetThreadBuffer()};
+    const u64 index{buffer.write_index.load(std::memory_order_relaxed)};
+    auto& event{buffer.events[index % EVENTS_PER_THREAD]};
+    event.category.store(category, std::memory_order_relaxed);
+    event.name.store(name, std::memory_order_relaxed);
+    event.start.store(start, std::memory_order_relaxed);
+    event.duration.store(duration, std::memory_order_relaxed);
+    buffer.write_index.store(index + 1, std::memory_order_release);
+}
+
+/// Copies the events of a ring that are still intact once the copy is done
+std::vector<ExportedEvent> CopyEvents(const ThreadBuffer& buffer) {
+    const u64 end{buffer.write_index.load(std::memory_order_acquire)};
+    const u64 begin{end > EVENTS_PER_THREAD ? end - EVENTS_PER_THREAD : 0};
+    std::vector<ExportedEvent> events;
+    events.reserve(end - begin);
+    for (u64 i{begin}; i < end; ++i) {
+        const auto& event{buffer.events[i % EVENTS_PER_THREAD]};
+        events.push_back({event.category.load(std::memory_order_relaxed),
+                          event.name.load(std::memory_order_relaxed),
+                          event.start.load(std::memory_order_relaxed),
+                          event.duration.load(std::memory_order_relaxed)});
+    }
+    // The thread kept writing meanwhile, drop what it may have overwritten
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const u64 new_end{buffer.write_index.load(std::memory_order_relaxed)};
+    const u64 overwritten{new_end > EVENTS_PER_THREAD ? new_end - EVENTS_PER_THREAD : 0};
+    if (overwritten > begin)
+        events.erase(events.begin(),
+                     events.begin() + static_cast<std::ptrdiff_t>(
+                                          std::min<u64>(overwritten - begin, events.size())));
+    return events;
+}
+
+void AppendEscaped(std::string& out, std::string_view string) {
+    for (const char c : string) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out += fmt::format("\\u{:04x}", c);
+        } else {
+            out += c;
+        }
+    }
+}
+
+} // Anonymous namespace
+
+void Start() {
+    {
+        // Forget the threads that exited
+        std::lock_guard lock{registry_mutex};
+        registry.erase(std::remove_if(registry.begin(), registry.end(),
+                                      [](const auto& buffer) { return buffer.use_count() == 1; }),
+                       registry.end());
+    }
+    session_start.store(Now(), std::memory_order_relaxed);
+    Detail::recording.store(true, std::memory_order_relaxed);
+}
+
+void Stop() {
+    Detail::recording.store(false, std::memory_order_relaxed);
+}
+
+void SetThreadName(std::string name) {
+    thread_name = std::move(name);
+    if (!thread_buffer)
+        return;
+    std::lock_guard lock{registry_mutex};
+    thread_buffer->name = thread_name;
+}
+
+void MarkFrame() {
+    if (IsRecording())
+        Record("frame", "Frame", Now(), INSTANT);
+}
+
+std::string ExportChromeTrace() {
+    std::vector<std::pair<std::shared_ptr<ThreadBuffer>, std::string>> buffers;
+    {
+        std::lock_guard lock{registry_mutex};
+        for (const auto& buffer : registry)
+            buffers.emplace_back(buffer, buffer->name);
+    }
+    const u64 start{session_start.load(std::memory_order_relaxed)};
+    std::string out{"{\"displayTimeUnit\":\"ms\",\"traceEvents\":["};
+    bool first{true};
+    const auto begin_event{[&] {
+        if (!first)
+            out += ',';
+        first = false;
+    }};
+    for (const auto& [buffer, name] : buffers) {
+        begin_event();
+        out += fmt::format("{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},"
+                           "\"args\":{{\"name\":\"",
+                           buffer->id);
+        AppendEscaped(out, name);
+        out += "\"}}";
+        for (const auto& event : CopyEvents(*buffer)) {
+            if (event.start < start)
+                continue;
+            begin_event();
+            out += "{\"name\":\"";
+            AppendEscaped(out, event.name);
+            out += "\",\"cat\":\"";
+            AppendEscaped(out, event.category);
+            const double ts{static_cast<double>(event.start - start) / 1000.0};
+            if (event.duration == INSTANT)
+                out += fmt::format("\",\"ph\":\"i\",\"s\":\"g\",\"ts\":{:.3f},\"pid\":1,\"tid\":{}}}",
+                                   ts, buffer->id);
+            else
+                out += fmt::format(
+                    "\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":1,\"tid\":{}}}", ts,
+                    static_cast<double>(event.duration) / 1000.0, buffer->id);
+        }
+    }
+    out += "]}";
+    return out;
+}
+
+void ScopedTimer::Begin(const char* category, const char* name) {
+    this->category = category;
+    this->name = name;
+    start = Now();
+}
+
+void ScopedTimer::End() {
+    Record(category, name, start, Now() - start);
+}
+
+} // namespace Common::Profiling
@@ -0,0 +1,78 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+
+/**
+ * Frame profiler. Scopes marked with PROFILE_SCOPE are timed while a recording runs and kept in a
+ * ring per thread, so that recording never takes a lock. The last events of each thread can then
+ * be exported as a Chrome trace (chrome://tracing, Perfetto). Building without
+ * ENABLE_FRAME_PROFILER removes the markers entirely.
+ */
+namespace Common::Profiling {
+
+namespace Detail {
+extern std::atomic_bool recording;
+} // namespace Detail
+
+/// Events kept per thread, older ones are overwritten
+constexpr std::size_t EVENTS_PER_THREAD{65536};
+
+/// Drops the events recorded so far and starts recording
+void Start();
+
+void Stop();
+
+inline bool IsRecording() {
+    return Detail::recording.load(std::memory_order_relaxed);
+}
+
+/// Names the calling thread in the exported traces
+void SetThreadName(std::string name);
+
+/// Records the end of a frame, shown as a marker across the timeline
+void MarkFrame();
+
+/// Returns the events recorded since Start as a Chrome trace-event JSON document
+std::string ExportChromeTrace();
+
+/// Times the enclosing scope. The names must be string literals or otherwise outlive the trace.
+class ScopedTimer : NonCopyable {
+public:
+    ScopedTimer(const char* category, const char* name) {
+        if (IsRecording())
+            Begin(category, name);
+    }
+
+    ~ScopedTimer() {
+        if (name)
+            End();
+    }
+
+private:
+    void Begin(const char* category, const char* name);
+    void End();
+
+    const char* category{};
+    const char* name{};
+    u64 start{};
+};
+
+} // namespace Common::Profiling
+
+#ifdef ENABLE_FRAME_PROFILER
+#define PROFILE_SCOPE(category, name)                                                              \
+    ::Common::Profiling::ScopedTimer CONCAT2(profile_scope_, __LINE__) {                           \
+        category, name                                                                             \
+    }
+#define PROFILE_MARK_FRAME() ::Common::Profiling::MarkFrame()
+#else
+#define PROFILE_SCOPE(category, name) (void)0
+#define PROFILE_MARK_FRAME() (void)0
+#endif
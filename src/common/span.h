@@ -0,0 +1,71 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include "common/assert.h"
+
+namespace Common {
+
+/// Non-owning view of a contiguous range of objects, a subset of C++20's std::span
+template <typename T>
+class Span {
+public:
+    using element_type = T;
+    using value_type = std::remove_cv_t<T>;
+    using iterator = T*;
+
+    constexpr Span() = default;
+    constexpr Span(T* data, std::size_t size) : ptr{data}, count{size} {}
+
+    /// Views a container with contiguous storage, such as std::vector or std::array
+    template <typename Container,
+              typename = std::enable_if_t<std::is_convertible_v<
+                  std::remove_pointer_t<decltype(std::declval<Container&>().data())> (*)[],
+                  T (*)[]>>>
+    constexpr Span(Container& container) : ptr{container.data()}, count{container.size()} {}
+
+    /// Views a span of non-const objects as const
+    template <typename U, typename = std::enable_if_t<std::is_convertible_v<U (*)[], T (*)[]>>>
+    constexpr Span(const Span<U>& other) : ptr{other.data()}, count{other.size()} {}
+
+    constexpr T* data() const {
+        return ptr;
+    }
+
+    constexpr std::size_t size() const {
+        return count;
+    }
+
+    constexpr bool empty() const {
+        return count == 0;
+    }
+
+    constexpr iterator begin() const {
+        return ptr;
+    }
+
+    constexpr iterator end() const {
+        return ptr + count;
+    }
+
+    T& operator[](std::size_t index) const {
+        ASSERT(index < count);
+        return ptr[index];
+    }
+
+    Span subspan(std::size_t offset, std::size_t size) const {
+        ASSERT(offset + size <= count);
+        return {ptr + offset, size};
+    }
+
+private:
+    T* ptr{};
+    std::size_t count{};
+};
+
+} // namespace Common
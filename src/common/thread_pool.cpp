@@ -0,0 +1,162 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <string>
+#include "common/assert.h"
+#include "common/profiling.h"
+#include "common/thread_pool.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace Common {
+
+namespace {
+
+// The pool and index of the worker running on this thread, if any
+thread_local const ThreadPool* current_pool{};
+thread_local std::size_t current_worker{};
+
+} // Anonymous namespace
+
+ThreadPool& ThreadPool::GetPool() {
+    static ThreadPool thread_pool{std::max(std::thread::hardware_concurrency(), 1u)};
+    return thread_pool;
+}
+
+ThreadPool& ThreadPool::GetIOPool() {
+    static ThreadPool thread_pool{2};
+    return thread_pool;
+}
+
+ThreadPool& ThreadPool::GetNetworkPool() {
+    static ThreadPool thread_pool{4};
+    return thread_pool;
+}
+
+ThreadPool::ThreadPool(std::size_t num_threads) : num_threads{num_threads} {
+    ASSERT(num_threads);
+    for (std::size_t i{}; i < num_threads; ++i)
+        workers.push_back(std::make_unique<Worker>());
+    // Started once all the deques exist, as the workers steal from each other
+    for (std::size_t i{}; i < num_threads; ++i)
+        workers[i]->thread = std::thread{&ThreadPool::Loop, this, i};
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock{sleep_mutex};
+        stopping = true;
+    }
+    sleep_cv.notify_all();
+    for (auto& worker : workers)
+        worker->thread.join();
+}
+
+void ThreadPool::SetSpinlocking(bool enable) {
+    spinlock_enabled = enable;
+    if (enable) {
+        std::lock_guard lock{sleep_mutex};
+        sleep_cv.notify_all();
+    }
+}
+
+void ThreadPool::SetPinning(bool enable) {
+    const unsigned int cores{std::max(std::thread::hardware_concurrency(), 1u)};
+    for (std::size_t i{}; i < num_threads; ++i) {
+        auto handle{workers[i]->thread.native_handle()};
+#ifdef _WIN32
+        DWORD_PTR process_mask, system_mask;
+        GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask);
+        SetThreadAffinityMask(handle, enable ? DWORD_PTR{1} << (i % cores) : process_mask);
+#elif defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (enable)
+            CPU_SET(i % cores, &set);
+        else
+            for (unsigned int core{}; core < cores; ++core)
+                CPU_SET(core, &set);
+        pthread_setaffinity_np(handle, sizeof(set), &set);
+#else
+        // No thread affinity API, e.g. on macOS
+        (void)handle;
+        (void)cores;
+#endif
+    }
+}
+
+void ThreadPool::Submit(Task task) {
+    const std::size_t index{current_pool == this
+                                ? current_worker
+                                : next_worker.fetch_add(1, std::memory_order_relaxed) %
+                                      num_threads};
+    // Counted first, so that it never goes below zero when a worker takes the task right away
+    pending.fetch_add(1, std::memory_order_seq_cst);
+    {
+        std::lock_guard lock{workers[index]->mutex};
+        workers[index]->tasks.push_back(std::move(task));
+    }
+    // Pairs with the sleeping count in Loop: either this sees the sleeper, or it sees the task
+    if (sleeping.load(std::memory_order_seq_cst) != 0) {
+        std::lock_guard lock{sleep_mutex};
+        sleep_cv.notify_one();
+    }
+}
+
+bool ThreadPool::TryPop(std::size_t index, Task& task) {
+    auto& worker{*workers[index]};
+    std::lock_guard lock{worker.mutex};
+    if (worker.tasks.empty())
+        return false;
+    task = std::move(worker.tasks.front());
+    worker.tasks.pop_front();
+    return true;
+}
+
+bool ThreadPool::TrySteal(std::size_t start, Task& task) {
+    // Thieves take the newest tasks, leaving the oldest to the owner
+    for (std::size_t i{1}; i <= num_threads; ++i) {
+        auto& worker{*workers[(start + i) % num_threads]};
+        std::unique_lock lock{worker.mutex, std::try_to_lock};
+        if (!lock.owns_lock() || worker.tasks.empty())
+            continue;
+        task = std::move(worker.tasks.back());
+        worker.tasks.pop_back();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::Loop(std::size_t index) {
+    current_pool = this;
+    current_worker = index;
+    Profiling::SetThreadName("ThreadPool worker " + std::to_string(index));
+    Task task;
+    for (;;) {
+        if (TryPop(index, task) || TrySteal(index, task)) {
+            pending.fetch_sub(1, std::memory_order_relaxed);
+            task();
+            task = {};
+            continue;
+        }
+        if (stopping.load(std::memory_order_relaxed))
+            return;
+        if (spinlock_enabled.load(std::memory_order_relaxed))
+            continue;
+        std::unique_lock lock{sleep_mutex};
+        sleeping.fetch_add(1, std::memory_order_seq_cst);
+        sleep_cv.wait(lock, [this] {
+            return pending.load(std::memory_order_seq_cst) != 0 || stopping ||
+                   spinlock_enabled.load(std::memory_order_relaxed);
+        });
+        sleeping.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace Common
@@ -2,106 +2,309 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#pragma once
+
+#include <algorithm>
 #include <atomic>
-#include <functional>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
 #include <future>
+#include <memory>
 #include <mutex>
+#include <new>
 #include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
-#include "common/assert.h"
-#include "common/threadsafe_queue.h"
+#include "common/common_types.h"
 
 namespace Common {
 
-class ThreadPool : NonCopyable {
-private:
-    explicit ThreadPool(std::size_t num_threads) : num_threads{num_threads}, workers{num_threads} {
-        ASSERT(num_threads);
+/// Move-only callable, stored inline when it's small so that queuing it doesn't allocate
+class Task {
+public:
+    Task() = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task>>>
+    Task(F&& f) {
+        using Callable = std::decay_t<F>;
+        if constexpr (sizeof(Callable) <= INLINE_SIZE &&
+                      alignof(Callable) <= alignof(std::max_align_t) &&
+                      std::is_nothrow_move_constructible_v<Callable>) {
+            new (storage) Callable(std::forward<F>(f));
+            ops = &inline_ops<Callable>;
+        } else {
+            *reinterpret_cast<Callable**>(storage) = new Callable(std::forward<F>(f));
+            ops = &heap_ops<Callable>;
+        }
     }
 
-public:
-    static ThreadPool& GetPool() {
-        static ThreadPool thread_pool{std::thread::hardware_concurrency()};
-        return thread_pool;
-    }
-
-    void SetSpinlocking(bool enable) {
-        for (auto& worker : workers) {
-            worker.spinlock_enabled = enable;
-            if (enable) {
-                std::unique_lock lock{worker.mutex};
-                lock.unlock();
-                worker.cv.notify_one();
-            }
+    Task(Task&& other) noexcept {
+        MoveFrom(other);
+    }
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            MoveFrom(other);
         }
+        return *this;
+    }
+
+    ~Task() {
+        Reset();
+    }
+
+    explicit operator bool() const {
+        return ops != nullptr;
     }
 
+    void operator()() {
+        ops->invoke(storage);
+    }
+
+private:
+    static constexpr std::size_t INLINE_SIZE{48};
+
+    struct Ops {
+        void (*invoke)(void* storage);
+        void (*move)(void* from, void* to);
+        void (*destroy)(void* storage);
+    };
+
+    template <typename C>
+    static constexpr Ops inline_ops{
+        [](void* storage) { (*static_cast<C*>(storage))(); },
+        [](void* from, void* to) {
+            new (to) C(std::move(*static_cast<C*>(from)));
+            static_cast<C*>(from)->~C();
+        },
+        [](void* storage) { static_cast<C*>(storage)->~C(); },
+    };
+
+    template <typename C>
+    static constexpr Ops heap_ops{
+        [](void* storage) { (**static_cast<C**>(storage))(); },
+        [](void* from, void* to) { *static_cast<C**>(to) = *static_cast<C**>(from); },
+        [](void* storage) { delete *static_cast<C**>(storage); },
+    };
+
+    void MoveFrom(Task& other) {
+        ops = other.ops;
+        if (!ops)
+            return;
+        ops->move(other.storage, storage);
+        other.ops = nullptr;
+    }
+
+    void Reset() {
+        if (!ops)
+            return;
+        ops->destroy(storage);
+        ops = nullptr;
+    }
+
+    alignas(std::max_align_t) unsigned char storage[INLINE_SIZE];
+    const Ops* ops{};
+};
+
+/**
+ * Work-stealing pool. Each worker has its own deque of tasks, and takes from the others' when it
+ * runs out, so a slow task only holds up the worker running it. Tasks pushed from a worker go to
+ * its own deque, others are spread over the workers.
+ */
+class ThreadPool : NonCopyable {
+public:
+    static ThreadPool& GetPool();
+
+    /// Pool for blocking host I/O, kept apart so it never delays the compute tasks
+    static ThreadPool& GetIOPool();
+
+    /// Pool for network transfers, which can take seconds and must not hold up file I/O
+    static ThreadPool& GetNetworkPool();
+
+    explicit ThreadPool(std::size_t num_threads);
+    ~ThreadPool();
+
+    /// Makes idle workers spin instead of sleeping, for latency sensitive work
+    void SetSpinlocking(bool enable);
+
+    /**
+     * Pins each worker to its own core, or lets the OS schedule them anywhere again. Only meant for
+     * dedicated pools, the shared ones leave scheduling to the OS as their workers compete for the
+     * cores with the emu and frontend threads.
+     */
+    void SetPinning(bool enable);
+
+    /// Queues the task, returning a future for its result
     template <typename F, typename... Args>
     auto Push(F&& f, Args&&... args) {
-        auto ret{workers[next_worker].Push(std::forward<F>(f), std::forward<Args>(args)...)};
-        next_worker = (next_worker + 1) % num_threads;
-        return ret;
+        using Result = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+        std::promise<Result> promise;
+        auto future{promise.get_future()};
+        Submit([promise = std::move(promise), f = std::forward<F>(f),
+                args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+            try {
+                if constexpr (std::is_void_v<Result>) {
+                    std::apply(f, args);
+                    promise.set_value();
+                } else {
+                    promise.set_value(std::apply(f, args));
+                }
+            } catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+        });
+        return future;
     }
 
+    /// Queues the task without a future, see TaskGroup to wait for it
+    void Submit(Task task);
+
+    /**
+     * Calls f(chunk_begin, chunk_end) over [begin, end) in chunks of at least grain items, on the
+     * workers and the calling thread, and returns once all are done. Chunks are claimed as the
+     * threads get to them, so a busy worker just takes fewer.
+     */
+    template <typename F>
+    void ParallelFor(std::size_t begin, std::size_t end, std::size_t grain, F&& f);
+
     std::size_t TotalThreads() const {
         return num_threads;
     }
 
 private:
-    class Worker {
-    public:
-        Worker() : thread{[this] { Loop(); }} {}
-
-        ~Worker() {
-            exit_loop = true;
-            std::unique_lock lock{mutex};
-            lock.unlock();
-            cv.notify_one();
-            thread.join();
-        }
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
 
-        template <typename F, typename... Args>
-        std::future<void> Push(F&& f, Args&&... args) {
-            auto task{std::make_shared<std::packaged_task<decltype(f(args...))()>>(
-                std::bind(std::forward<F>(f), std::forward<Args>(args)...))};
-            queue.Push([task] { (*task)(); });
-            if (!spinlock_enabled.load(std::memory_order_relaxed)) {
-                std::unique_lock lock{mutex};
-                lock.unlock();
-                cv.notify_one();
-            }
-            return task->get_future();
+    bool TryPop(std::size_t index, Task& task);
+    bool TrySteal(std::size_t start, Task& task);
+    void Loop(std::size_t index);
+
+    const std::size_t num_threads;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<std::size_t> next_worker{};
+    /// Tasks queued and not taken yet
+    std::atomic<std::size_t> pending{};
+    std::atomic<std::size_t> sleeping{};
+    std::atomic_bool spinlock_enabled{};
+    std::atomic_bool stopping{};
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_cv;
+};
+
+/**
+ * Tasks run through a group can be waited for together, without a future per task. The group
+ * queues its tasks itself and only submits a task taking the next one to the pool, so a thread
+ * waiting for the group only ever runs the group's own tasks, never unrelated long ones.
+ */
+class TaskGroup : NonCopyable {
+public:
+    explicit TaskGroup(ThreadPool& pool) : pool{pool}, state{std::make_shared<State>()} {}
+
+    ~TaskGroup() {
+        WaitForTasks();
+    }
+
+    template <typename F>
+    void Run(F&& f) {
+        state->pending.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard lock{state->mutex};
+            state->tasks.emplace_back(std::forward<F>(f));
         }
+        // Whoever gets there first runs the task, this one may find the queue empty. It keeps the
+        // state alive, as the group may be gone by then.
+        pool.Submit([state = state] { state->RunOne(); });
+    }
 
-        std::atomic_bool spinlock_enabled{};
-        std::mutex mutex;
-        std::condition_variable cv;
-
-    private:
-        void Loop() {
-            for (;;) {
-                std::function<void()> task;
-                while (queue.Pop(task))
-                    task();
-                if (spinlock_enabled)
-                    continue;
-                std::unique_lock lock{mutex};
-                if (!queue.Empty())
-                    continue;
-                if (exit_loop)
-                    break;
-                cv.wait(lock);
+    /// Runs one queued task of the group on the calling thread, returns false if there was none
+    bool RunPendingTask() {
+        return state->RunOne();
+    }
+
+    /**
+     * Waits for the tasks of the group, running its queued ones meanwhile. Rethrows the first
+     * exception one of them threw.
+     */
+    void Wait() {
+        WaitForTasks();
+        if (state->exception)
+            std::rethrow_exception(std::exchange(state->exception, nullptr));
+    }
+
+private:
+    struct State {
+        bool RunOne() {
+            Task task;
+            {
+                std::lock_guard lock{mutex};
+                if (tasks.empty())
+                    return false;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            try {
+                task();
+            } catch (...) {
+                std::lock_guard lock{mutex};
+                if (!exception)
+                    exception = std::current_exception();
             }
+            pending.fetch_sub(1, std::memory_order_release);
+            return true;
         }
 
-        bool exit_loop{};
-        SPSCQueue<std::function<void()>> queue;
-        std::thread thread;
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::exception_ptr exception;
+        /// Tasks queued and not finished yet
+        std::atomic<std::size_t> pending{};
     };
 
-    const std::size_t num_threads;
-    std::size_t next_worker{};
-    std::vector<Worker> workers;
+    void WaitForTasks() {
+        while (state->pending.load(std::memory_order_acquire) != 0)
+            if (!state->RunOne())
+                std::this_thread::yield();
+    }
+
+    ThreadPool& pool;
+    std::shared_ptr<State> state;
 };
 
+template <typename F>
+void ThreadPool::ParallelFor(std::size_t begin, std::size_t end, std::size_t grain, F&& f) {
+    if (begin >= end)
+        return;
+    // A few chunks per thread, so that the threads which finish first take the leftovers
+    const std::size_t count{end - begin};
+    const std::size_t max_chunks{(num_threads + 1) * 4};
+    const std::size_t chunk_size{std::max({grain, std::size_t{1}, count / max_chunks})};
+    const std::size_t num_chunks{(count + chunk_size - 1) / chunk_size};
+    if (num_chunks == 1) {
+        f(begin, end);
+        return;
+    }
+    std::atomic<std::size_t> next{begin};
+    const auto run_chunks{[&] {
+        for (;;) {
+            const std::size_t chunk_begin{next.fetch_add(chunk_size, std::memory_order_relaxed)};
+            if (chunk_begin >= end)
+                return;
+            f(chunk_begin, std::min(chunk_begin + chunk_size, end));
+        }
+    }};
+    TaskGroup group{*this};
+    for (std::size_t i{}; i < std::min(num_threads, num_chunks - 1); ++i)
+        group.Run([&run_chunks] { run_chunks(); });
+    run_chunks();
+    group.Wait();
+}
+
 } // namespace Common
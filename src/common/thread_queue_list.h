@@ -5,156 +5,215 @@
 #pragma once
 
 #include <array>
-#include <deque>
-#include <boost/range/algorithm_ext/erase.hpp>
+#include "common/bit_set.h"
+#include "common/common_types.h"
 
 namespace Common {
 
-template <class T, unsigned int N>
-struct ThreadQueueList {
-    // TODO: If performance proves to be a problem, the std::deques can be replaced with
-    //               (dynamically resizable) circular buffers to remove their overhead when
-    //               inserting and popping.
+/// Links of a queued object, embedded in the object so that queueing never allocates
+template <class T>
+struct ThreadQueueHook {
+    T* prev{};
+    T* next{};
+    unsigned int priority{}; ///< Priority the object was queued with, used by ThreadWaitList
+    bool queued{};
+};
+
+/// Hook accessor for objects with a public ThreadQueueHook<T> member named queue_hook
+template <class T>
+struct QueueHookMember {
+    static ThreadQueueHook<T>& Get(T* object) {
+        return object->queue_hook;
+    }
+};
 
-    typedef unsigned int Priority;
+/**
+ * Intrusive priority queue of threads, the hook of each thread is found through Hook. An object
+ * can only be in one queue per hook at a time. A bitmap of the non-empty priority levels makes
+ * finding the best thread a single bit scan.
+ */
+template <class T, unsigned int N, class Hook = QueueHookMember<T>>
+class ThreadQueueList {
+public:
+    using Priority = unsigned int;
 
     // Number of priority levels. (Valid levels are [0..NUM_QUEUES).)
-    static const Priority NUM_QUEUES{N};
+    static constexpr Priority NUM_QUEUES{N};
+    static_assert(NUM_QUEUES <= 64, "Priority levels must fit in the bitmap");
 
-    ThreadQueueList() {
-        first = nullptr;
+    T* get_first() const {
+        if (!levels)
+            return nullptr;
+        return queues[LeastSignificantSetBit(levels)].head;
     }
 
-    // Only for debugging, returns priority level.
-    Priority contains(const T& uid) {
-        for (Priority i{}; i < NUM_QUEUES; ++i) {
-            Queue& cur{queues[i]};
-            if (std::find(cur.data.cbegin(), cur.data.cend(), uid) != cur.data.cend()) {
-                return i;
-            }
-        }
-
-        return -1;
+    T* pop_first() {
+        if (!levels)
+            return nullptr;
+        return pop(LeastSignificantSetBit(levels));
     }
 
-    T get_first() {
-        Queue* cur{first};
-        while (cur) {
-            if (!cur->data.empty())
-                return cur->data.front();
-            cur = cur->next_nonempty;
-        }
-        return T();
+    /// Pops the first thread with a better priority than the given one, or returns nullptr
+    T* pop_first_better(Priority priority) {
+        const u64 better{levels & (Bit(priority) - 1)};
+        if (!better)
+            return nullptr;
+        return pop(LeastSignificantSetBit(better));
     }
 
-    T pop_first() {
-        Queue* cur{first};
-        while (cur) {
-            if (!cur->data.empty()) {
-                auto tmp{std::move(cur->data.front())};
-                cur->data.pop_front();
-                return tmp;
-            }
-            cur = cur->next_nonempty;
-        }
-        return T();
+    void push_front(Priority priority, T* thread) {
+        auto& hook{Hook::Get(thread)};
+        auto& queue{queues[priority]};
+        hook.prev = nullptr;
+        hook.next = queue.head;
+        hook.queued = true;
+        if (queue.head)
+            Hook::Get(queue.head).prev = thread;
+        else
+            queue.tail = thread;
+        queue.head = thread;
+        levels |= Bit(priority);
     }
 
-    T pop_first_better(Priority priority) {
-        Queue* cur{first};
-        Queue* stop{&queues[priority]};
-        while (cur < stop) {
-            if (!cur->data.empty()) {
-                auto tmp{std::move(cur->data.front())};
-                cur->data.pop_front();
-                return tmp;
-            }
-            cur = cur->next_nonempty;
-        }
-
-        return T();
+    void push_back(Priority priority, T* thread) {
+        auto& hook{Hook::Get(thread)};
+        auto& queue{queues[priority]};
+        hook.prev = queue.tail;
+        hook.next = nullptr;
+        hook.queued = true;
+        if (queue.tail)
+            Hook::Get(queue.tail).next = thread;
+        else
+            queue.head = thread;
+        queue.tail = thread;
+        levels |= Bit(priority);
     }
 
-    void push_front(Priority priority, const T& thread_id) {
-        Queue* cur{&queues[priority]};
-        cur->data.push_front(thread_id);
+    void move(T* thread, Priority old_priority, Priority new_priority) {
+        remove(old_priority, thread);
+        push_back(new_priority, thread);
     }
 
-    void push_back(Priority priority, const T& thread_id) {
-        Queue* cur{&queues[priority]};
-        cur->data.push_back(thread_id);
+    /// Removes the thread from the given level, does nothing if it isn't queued
+    void remove(Priority priority, T* thread) {
+        auto& hook{Hook::Get(thread)};
+        if (!hook.queued)
+            return;
+        auto& queue{queues[priority]};
+        if (hook.prev)
+            Hook::Get(hook.prev).next = hook.next;
+        else
+            queue.head = hook.next;
+        if (hook.next)
+            Hook::Get(hook.next).prev = hook.prev;
+        else
+            queue.tail = hook.prev;
+        hook = {};
+        if (!queue.head)
+            levels &= ~Bit(priority);
     }
 
-    void move(const T& thread_id, Priority old_priority, Priority new_priority) {
-        remove(old_priority, thread_id);
-        prepare(new_priority);
-        push_back(new_priority, thread_id);
+    bool empty(Priority priority) const {
+        return !(levels & Bit(priority));
     }
 
-    void remove(Priority priority, const T& thread_id) {
-        Queue* cur{&queues[priority]};
-        boost::remove_erase(cur->data, thread_id);
+    /// Returns the first thread of a priority level, the rest can be walked via the hook
+    T* front(Priority priority) const {
+        return queues[priority].head;
     }
 
-    void rotate(Priority priority) {
-        Queue* cur{&queues[priority]};
-
-        if (cur->data.size() > 1) {
-            cur->data.push_back(std::move(cur->data.front()));
-            cur->data.pop_front();
-        }
+    T* back(Priority priority) const {
+        return queues[priority].tail;
     }
 
-    void clear() {
-        queues.fill(Queue());
-        first = nullptr;
-    }
+private:
+    struct Queue {
+        T* head{};
+        T* tail{};
+    };
 
-    bool empty(Priority priority) const {
-        const Queue* cur{&queues[priority]};
-        return cur->data.empty();
+    static constexpr u64 Bit(Priority priority) {
+        return u64{1} << priority;
     }
 
-    void prepare(Priority priority) {
-        Queue* cur{&queues[priority]};
-        if (cur->next_nonempty == UnlinkedTag())
-            link(priority);
+    T* pop(Priority priority) {
+        T* thread{queues[priority].head};
+        remove(priority, thread);
+        return thread;
     }
 
-private:
-    struct Queue {
-        // Points to the next active priority, skipping over ones that have never been used.
-        Queue* next_nonempty{UnlinkedTag()};
+    u64 levels{};
 
-        // Double-ended queue of threads in this priority level
-        std::deque<T> data;
-    };
+    // The priority level queues of threads.
+    std::array<Queue, NUM_QUEUES> queues{};
+};
 
-    /// Special tag used to mark priority levels that have never been used.
-    static Queue* UnlinkedTag() {
-        return reinterpret_cast<Queue*>(1);
+/**
+ * Intrusive list of threads sorted by priority, threads with the same priority stay in the order
+ * they were pushed. Popping the best thread is O(1), pushing walks back from the tail past the
+ * threads with a worse priority. Threads mostly start waiting in priority order, as the scheduler
+ * runs the best ones first, and few wait on one address, so this is cheaper than a table of
+ * levels per wait list.
+ */
+template <class T, class Hook = QueueHookMember<T>>
+class ThreadWaitList {
+public:
+    using Priority = unsigned int;
+
+    bool empty() const {
+        return !head;
     }
 
-    void link(Priority priority) {
-        Queue* cur{&queues[priority]};
+    T* front() const {
+        return head;
+    }
 
-        for (int i{static_cast<int>(priority - 1)}; i >= 0; --i) {
-            if (queues[i].next_nonempty != UnlinkedTag()) {
-                cur->next_nonempty = queues[i].next_nonempty;
-                queues[i].next_nonempty = cur;
-                return;
-            }
-        }
+    void push(Priority priority, T* thread) {
+        // Walk from the back, as threads usually wait with the same priority
+        T* prev{tail};
+        while (prev && Hook::Get(prev).priority > priority)
+            prev = Hook::Get(prev).prev;
+        auto& hook{Hook::Get(thread)};
+        hook.prev = prev;
+        hook.next = prev ? Hook::Get(prev).next : head;
+        hook.priority = priority;
+        hook.queued = true;
+        if (hook.next)
+            Hook::Get(hook.next).prev = thread;
+        else
+            tail = thread;
+        if (prev)
+            Hook::Get(prev).next = thread;
+        else
+            head = thread;
+    }
 
-        cur->next_nonempty = first;
-        first = cur;
+    T* pop() {
+        T* thread{head};
+        if (thread)
+            remove(thread);
+        return thread;
     }
 
-    // The first queue that's ever been used.
-    Queue* first;
+    /// Removes the thread, does nothing if it isn't in a list
+    void remove(T* thread) {
+        auto& hook{Hook::Get(thread)};
+        if (!hook.queued)
+            return;
+        if (hook.prev)
+            Hook::Get(hook.prev).next = hook.next;
+        else
+            head = hook.next;
+        if (hook.next)
+            Hook::Get(hook.next).prev = hook.prev;
+        else
+            tail = hook.prev;
+        hook = {};
+    }
 
-    // The priority level queues of thread ids.
-    std::array<Queue, NUM_QUEUES> queues;
+private:
+    T* head{};
+    T* tail{};
 };
 
 } // namespace Common
@@ -0,0 +1,139 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <new>
+#include <vector>
+#include "common/alignment.h"
+#include "common/virtual_buffer.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace Common {
+
+namespace {
+
+std::size_t GetPageSize() {
+#ifdef _WIN32
+    static const std::size_t page_size{[] {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return static_cast<std::size_t>(info.dwPageSize);
+    }()};
+#else
+    static const std::size_t page_size{static_cast<std::size_t>(sysconf(_SC_PAGESIZE))};
+#endif
+    return page_size;
+}
+
+#ifndef _WIN32
+// MAP_NORESERVE keeps the reservation out of the overcommit accounting
+constexpr int MAP_FLAGS{MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE};
+#endif
+
+} // Anonymous namespace
+
+VirtualBuffer::VirtualBuffer(std::size_t size) : length{size} {
+#ifdef _WIN32
+    // Windows charges committed memory against the commit limit, but only makes pages resident
+    // when they're touched
+    pointer = static_cast<u8*>(
+        VirtualAlloc(nullptr, length, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+    if (!pointer)
+        throw std::bad_alloc{};
+#else
+    void* ptr{mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_FLAGS, -1, 0)};
+    if (ptr == MAP_FAILED)
+        throw std::bad_alloc{};
+    pointer = static_cast<u8*>(ptr);
+#endif
+}
+
+VirtualBuffer::~VirtualBuffer() {
+#ifdef _WIN32
+    VirtualFree(pointer, 0, MEM_RELEASE);
+#else
+    munmap(pointer, length);
+#endif
+}
+
+void VirtualBuffer::Zero(std::size_t offset, std::size_t size) {
+#ifdef _WIN32
+    // Windows can't replace pages with zeroed ones in place, decommitting them would make
+    // concurrent accesses fault
+    std::memset(pointer + offset, 0, size);
+#else
+    ReleasePages(offset, size, true);
+#endif
+}
+
+void VirtualBuffer::Discard(std::size_t offset, std::size_t size) {
+    ReleasePages(offset, size, false);
+}
+
+void VirtualBuffer::Reset() {
+#ifdef _WIN32
+    // Decommitted pages read back as zeros once committed again
+    VirtualFree(pointer, length, MEM_DECOMMIT);
+    VirtualAlloc(pointer, length, MEM_COMMIT, PAGE_READWRITE);
+#else
+    ReleasePages(0, length, true);
+#endif
+}
+
+void VirtualBuffer::ReleasePages(std::size_t offset, std::size_t size, bool zero) {
+    const std::size_t page_size{GetPageSize()};
+    const std::size_t end{offset + size};
+    const std::size_t pages_begin{AlignUp(offset, page_size)};
+    const std::size_t pages_end{AlignDown(end, page_size)};
+    if (pages_begin >= pages_end) {
+        if (zero)
+            std::memset(pointer + offset, 0, size);
+        return;
+    }
+    if (zero) {
+        std::memset(pointer + offset, 0, pages_begin - offset);
+        std::memset(pointer + pages_end, 0, end - pages_end);
+    }
+    u8* const pages{pointer + pages_begin};
+    const std::size_t pages_size{pages_end - pages_begin};
+#ifdef _WIN32
+    // The pages stay committed and accessible, but aren't written to the page file anymore and
+    // are the first ones trimmed from the working set
+    VirtualAlloc(pages, pages_size, MEM_RESET, PAGE_READWRITE);
+#elif defined(__linux__)
+    // Private anonymous pages read back as zeros after this
+    madvise(pages, pages_size, MADV_DONTNEED);
+#else
+    // Elsewhere MADV_DONTNEED may keep the contents, replace the pages with fresh ones instead
+    mmap(pages, pages_size, PROT_READ | PROT_WRITE, MAP_FLAGS | MAP_FIXED, -1, 0);
+#endif
+}
+
+std::size_t VirtualBuffer::GetCommittedBytes() const {
+#ifdef _WIN32
+    return length;
+#else
+    const std::size_t page_size{GetPageSize()};
+    const std::size_t num_pages{(length + page_size - 1) / page_size};
+#ifdef __APPLE__
+    std::vector<char> residency(num_pages);
+#else
+    std::vector<unsigned char> residency(num_pages);
+#endif
+    if (mincore(pointer, length, residency.data()) != 0)
+        return length;
+    std::size_t resident_pages{};
+    for (const auto page : residency)
+        resident_pages += page & 1;
+    return resident_pages * page_size;
+#endif
+}
+
+} // namespace Common
@@ -0,0 +1,63 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Zero-initialized memory in reserved address space, whose pages the OS only commits when they're
+ * first written. Zeroing a range hands its pages back, so memory used once doesn't stay resident.
+ */
+class VirtualBuffer : NonCopyable {
+public:
+    /// Reserves the buffer, throws std::bad_alloc if the address space is exhausted
+    explicit VirtualBuffer(std::size_t size);
+    ~VirtualBuffer();
+
+    u8* data() {
+        return pointer;
+    }
+
+    const u8* data() const {
+        return pointer;
+    }
+
+    std::size_t size() const {
+        return length;
+    }
+
+    u8* begin() {
+        return pointer;
+    }
+
+    u8* end() {
+        return pointer + length;
+    }
+
+    /// Zeroes the range, returning the pages it fully covers to the OS where it keeps them zeroed
+    void Zero(std::size_t offset, std::size_t size);
+
+    /// Returns the pages fully covered by the range to the OS, leaving its contents undefined
+    void Discard(std::size_t offset, std::size_t size);
+
+    /// Zeroes the whole buffer, returning all of its memory to the OS. The buffer must not be
+    /// accessed meanwhile.
+    void Reset();
+
+    /// Bytes of the buffer backed by memory of the host
+    std::size_t GetCommittedBytes() const;
+
+private:
+    void ReleasePages(std::size_t offset, std::size_t size, bool zero);
+
+    u8* pointer{};
+    std::size_t length;
+};
+
+} // namespace Common
@@ -15,13 +15,16 @@
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/thread.h"
+#include "core/hle/profiler.h"
 #include "core/hle/service/cfg/cfg.h"
 #include "core/hle/service/fs/archive.h"
 #include "core/hle/service/fs/fs_user.h"
 #include "core/hle/service/service.h"
 #include "core/hle/service/sm/sm.h"
 #include "core/hw/hw.h"
+#include "core/idle_detector.h"
 #include "core/loader/loader.h"
+#include "core/memory.h"
 #include "core/memory_setup.h"
 #include "core/movie.h"
 #include "network/room.h"
@@ -164,6 +167,8 @@ System::ResultStatus System::Init(Frontend& frontend, u32 system_mode) {
     LOG_DEBUG(HW_Memory, "initialized OK");
     m_frontend = &frontend;
     timing = std::make_unique<Core::Timing>();
+    idle_detector = std::make_unique<IdleDetector>(*timing);
+    hle_profiler = std::make_unique<HLE::Profiler>();
     kernel = std::make_unique<Kernel::KernelSystem>(*this);
     // Initialize FS, CFG and memory
     service_manager = std::make_unique<Service::SM::ServiceManager>(*this);
@@ -231,6 +236,20 @@ Timing& System::CoreTiming() {
     return *timing;
 }
 
+IdleDetector& System::GetIdleDetector() {
+    return *idle_detector;
+}
+
+HLE::Profiler& System::GetHLEProfiler() {
+    return *hle_profiler;
+}
+
+#ifdef ENABLE_SCRIPTING
+RPC::RPCServer* System::GetRPCServer() {
+    return rpc_server.get();
+}
+#endif
+
 const Network::Room& System::Room() const {
     return *room;
 }
@@ -270,17 +289,39 @@ void System::Shutdown() {
     VideoCore::Shutdown();
     kernel.reset();
     HW::Shutdown();
+    LOG_INFO(Core, "Guest memory in use at shutdown: {} MiB",
+             Memory::GetCommittedBytes() / 0x100000);
 #ifdef ENABLE_SCRIPTING
     rpc_server.reset();
 #endif
     service_manager.reset();
     dsp_core.reset();
+    // Nothing accesses guest memory anymore
+    Memory::ResetMemory();
+    idle_detector->LogCounters();
+    idle_detector.reset();
+    hle_profiler->LogSummary();
+    if (Settings::values.dump_hle_profile)
+        hle_profiler->Dump();
+    hle_profiler.reset();
     timing.reset();
     program_loader.reset();
     room_member->SendProgram(std::string{});
     LOG_DEBUG(Core, "Shutdown OK");
 }
 
+void System::InitKernel() {
+    timing = std::make_unique<Core::Timing>();
+    kernel = std::make_unique<Kernel::KernelSystem>(*this);
+    cpu_core = std::make_unique<Cpu>(*this);
+}
+
+void System::ShutdownKernel() {
+    cpu_core.reset();
+    kernel.reset();
+    timing.reset();
+}
+
 void System::Restart() {
     SetProgram(m_filepath);
 }
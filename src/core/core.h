@@ -41,6 +41,10 @@ namespace Service::FS {
 class ArchiveManager;
 } // namespace Service::FS
 
+namespace HLE {
+class Profiler;
+} // namespace HLE
+
 namespace Kernel {
 class KernelSystem;
 } // namespace Kernel
@@ -52,6 +56,7 @@ class RoomMember;
 
 namespace Core {
 
+class IdleDetector;
 class Movie;
 class Timing;
 
@@ -104,6 +109,14 @@ public:
     /// Shutdown the emulated system.
     void Shutdown();
 
+    /**
+     * Sets up only the timing, CPU and kernel, without memory regions, services or a program, for
+     * tools that drive kernel objects directly. Undone by ShutdownKernel.
+     */
+    void InitKernel();
+
+    void ShutdownKernel();
+
     /// Restart the running program.
     void Restart();
 
@@ -175,6 +188,17 @@ public:
     /// Gets a reference to the timing system.
     Timing& CoreTiming();
 
+    /// Gets a reference to the idle loop detector.
+    IdleDetector& GetIdleDetector();
+
+    /// Gets a reference to the HLE service call profiler.
+    HLE::Profiler& GetHLEProfiler();
+
+#ifdef ENABLE_SCRIPTING
+    /// Gets a pointer to the RPC server, null while no program is running.
+    RPC::RPCServer* GetRPCServer();
+#endif
+
     /// Gets a const reference to the room.
     const Network::Room& Room() const;
 
@@ -293,6 +317,12 @@ private:
     // Timing system
     std::unique_ptr<Timing> timing;
 
+    // Idle loop detector
+    std::unique_ptr<IdleDetector> idle_detector;
+
+    // HLE service call profiler
+    std::unique_ptr<HLE::Profiler> hle_profiler;
+
     // Movie system
     std::unique_ptr<Movie> movie;
 
@@ -9,6 +9,7 @@
 #include "common/assert.h"
 #include "common/event.h"
 #include "common/logging/log.h"
+#include "common/profiling.h"
 #include "core/core_timing.h"
 
 namespace Core {
@@ -113,6 +114,7 @@ void Timing::MoveEvents() {
 }
 
 void Timing::Advance() {
+    PROFILE_SCOPE("cpu", "Timing::Advance");
     MoveEvents();
     s64 cycles_executed{slice_length - downcount};
     global_timer += cycles_executed;
@@ -137,6 +139,23 @@ void Timing::Idle() {
     downcount = 0;
 }
 
+s64 Timing::SkipToNextEvent() {
+    MoveEvents();
+    if (event_queue.empty())
+        return 0;
+    // Like in Advance, the slice ends at the next event or after MAX_SLICE_LENGTH at most, a
+    // later event is reached by skipping again
+    const s64 target{global_timer + std::min<s64>(event_queue.front().time - global_timer,
+                                                  MAX_SLICE_LENGTH)};
+    const s64 skipped{target - static_cast<s64>(GetTicks())};
+    if (skipped <= 0)
+        return 0;
+    idled_cycles += skipped;
+    slice_length = target - global_timer;
+    downcount = 0;
+    return skipped;
+}
+
 std::chrono::microseconds Timing::GetGlobalTimeUs() const {
     return std::chrono::microseconds{GetTicks() * 1000000 / BASE_CLOCK_RATE_ARM11};
 }
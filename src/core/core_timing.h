@@ -181,6 +181,13 @@ public:
     /// Pretend that the main CPU has executed enough cycles to reach the next event.
     void Idle();
 
+    /**
+     * Ends the current slice right at the next event, or after MAX_SLICE_LENGTH if it's further
+     * away, counting the cycles in between as idle. Used to skip guest spin loops.
+     * @returns the number of cycles skipped
+     */
+    s64 SkipToNextEvent();
+
     void ForceExceptionCheck(s64 cycles);
 
     std::chrono::microseconds GetGlobalTimeUs() const;
@@ -6,6 +6,7 @@
 #include <dynarmic/A32/a32.h>
 #include <dynarmic/A32/context.h>
 #include "common/assert.h"
+#include "common/profiling.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/cpu/cpu.h"
@@ -199,6 +200,7 @@ Cpu::~Cpu() = default;
 
 void Cpu::Run() {
     ASSERT(Memory::GetCurrentPageTable() == current_page_table);
+    PROFILE_SCOPE("cpu", "Cpu::Run");
     jit->Run();
 }
 
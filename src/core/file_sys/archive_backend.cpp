@@ -12,10 +12,10 @@
 
 namespace FileSys {
 
-Path::Path(LowPathType type, const std::vector<u8>& data) : type{type} {
+Path::Path(LowPathType type, Common::Span<const u8> data) : type{type} {
     switch (type) {
     case LowPathType::Binary: {
-        binary = data;
+        binary.assign(data.begin(), data.end());
         break;
     }
 
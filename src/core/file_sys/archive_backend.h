@@ -10,6 +10,7 @@
 #include <vector>
 #include "common/bit_field.h"
 #include "common/common_types.h"
+#include "common/span.h"
 #include "common/swap.h"
 #include "core/file_sys/delay_generator.h"
 #include "core/hle/result.h"
@@ -40,7 +41,7 @@ public:
     Path() : type{LowPathType::Invalid} {}
     Path(const char* path) : type{LowPathType::Char}, string{path} {}
     Path(std::vector<u8> binary_data) : type{LowPathType::Binary}, binary{std::move(binary_data)} {}
-    Path(LowPathType type, const std::vector<u8>& data);
+    Path(LowPathType type, Common::Span<const u8> data);
 
     LowPathType GetType() const {
         return type;
@@ -46,29 +46,35 @@ Loader::ResultStatus CIAContainer::Load(const FileBackend& backend) {
 }
 
 Loader::ResultStatus CIAContainer::Load(const std::string& filepath) {
-    FileUtil::IOFile file{filepath, "rb"};
+    FileUtil::MappedFile file{filepath};
     if (!file.IsOpen())
         return Loader::ResultStatus::Error;
+    // Copies a section out of the mapping, fails if the file is truncated
+    auto read_section{[&file](u64 offset, std::size_t size, std::vector<u8>& data) {
+        const u8* section{file.GetPointer(offset, size)};
+        if (!section)
+            return false;
+        data.assign(section, section + size);
+        return true;
+    }};
     // Load CIA Header
-    std::vector<u8> header_data(sizeof(Header));
-    if (file.ReadBytes(header_data.data(), sizeof(Header)) != sizeof(Header))
+    std::vector<u8> header_data;
+    if (!read_section(0, sizeof(Header), header_data))
         return Loader::ResultStatus::Error;
     auto result{LoadHeader(header_data)};
     if (result != Loader::ResultStatus::Success)
         return result;
     // Load Title Metadata
-    std::vector<u8> tmd_data(cia_header.tmd_size);
-    file.Seek(GetTitleMetadataOffset(), SEEK_SET);
-    if (file.ReadBytes(tmd_data.data(), cia_header.tmd_size) != cia_header.tmd_size)
+    std::vector<u8> tmd_data;
+    if (!read_section(GetTitleMetadataOffset(), cia_header.tmd_size, tmd_data))
         return Loader::ResultStatus::Error;
     result = LoadTitleMetadata(tmd_data);
     if (result != Loader::ResultStatus::Success)
         return result;
     // Load CIA Metadata
     if (cia_header.meta_size) {
-        std::vector<u8> meta_data(sizeof(Metadata));
-        file.Seek(GetMetadataOffset(), SEEK_SET);
-        if (file.ReadBytes(meta_data.data(), sizeof(Metadata)) != sizeof(Metadata))
+        std::vector<u8> meta_data;
+        if (!read_section(GetMetadataOffset(), sizeof(Metadata), meta_data))
             return Loader::ResultStatus::Error;
         result = LoadMetadata(meta_data);
         if (result != Loader::ResultStatus::Success)
@@ -0,0 +1,201 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <type_traits>
+#include <fmt/format.h>
+#include <cryptopp/sha.h>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/file_sys/content_cache.h"
+#include "core/file_sys/ncch_container.h"
+#include "core/settings.h"
+
+namespace FileSys {
+
+constexpr u32 CACHE_VERSION{2};
+
+struct CacheInfo {
+    u32_le magic;
+    u32_le version;
+    u64_le program_id;
+    std::array<u8, 32> key;
+    u64_le last_used; ///< When the title was last booted, in seconds since the epoch
+};
+
+static_assert(std::is_trivially_copyable_v<CacheInfo>, "CacheInfo must be trivially copyable");
+
+constexpr u32 CACHE_MAGIC{0x48434E43}; // "CNCH"
+
+namespace {
+
+/// Bytes the cache may still grow by, updated when a title's cache is opened
+std::atomic<s64> space_left{};
+
+u64 GetTime() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+/// Titles booted since this process started are never evicted by it
+const u64 session_start{GetTime()};
+
+/// Temporary file next to path, unique across the instances sharing the cache
+std::string GetTempPath(const std::string& path) {
+    static const u64 instance_id{(u64{std::random_device{}()} << 32) | std::random_device{}()};
+    static std::atomic<u32> counter{};
+    return fmt::format("{}.{:016X}{:08X}.tmp", path, instance_id, counter++);
+}
+
+/// Moves a complete temporary file into place, losing the race to another instance is fine
+bool Commit(const std::string& temp_path, const std::string& path) {
+    if (FileUtil::Rename(temp_path, path))
+        return true;
+    FileUtil::Delete(temp_path);
+    return FileUtil::Exists(path);
+}
+
+} // Anonymous namespace
+
+ContentCache::ContentCache(const NCCH_Header& header, const std::array<u8, 16>& seed) {
+    CryptoPP::SHA256 sha;
+    sha.Update(reinterpret_cast<const u8*>(&header), sizeof(NCCH_Header));
+    sha.Update(seed.data(), seed.size());
+    sha.Update(reinterpret_cast<const u8*>(&CACHE_VERSION), sizeof(CACHE_VERSION));
+    sha.Final(key.data());
+    // Contents sharing a program ID (e.g. a game and its manual) get separate directories
+    std::string name;
+    for (std::size_t i{}; i < 16; ++i)
+        name += fmt::format("{:02X}", key[i]);
+    directory = fmt::format("{}content/{:016X}/{}/",
+                            FileUtil::GetUserPath(FileUtil::UserPath::CacheDir), header.program_id,
+                            name);
+    // Whatever else is in the directory was written for this key, if the info is missing it's
+    // just written again. Either way its last use time is updated.
+    const bool was_valid{Validate()};
+    if (!was_valid && !FileUtil::CreateFullPath(directory))
+        return;
+    Trim(name);
+    CacheInfo info{CACHE_MAGIC, CACHE_VERSION, header.program_id, key, GetTime()};
+    is_valid = WriteFile("info.bin", reinterpret_cast<const u8*>(&info), sizeof(CacheInfo)) ||
+               was_valid;
+    if (!is_valid)
+        LOG_WARNING(Service_FS, "Couldn't create content cache in {}", directory);
+}
+
+bool ContentCache::Validate() const {
+    FileUtil::IOFile file{directory + "info.bin", "rb"};
+    CacheInfo info;
+    if (file.ReadBytes(&info, sizeof(CacheInfo)) != sizeof(CacheInfo))
+        return false;
+    return info.magic == CACHE_MAGIC && info.version == CACHE_VERSION && info.key == key;
+}
+
+void ContentCache::Trim(const std::string& name) const {
+    struct Entry {
+        std::string path;
+        std::string program_path; ///< Set if this is the only directory of its program ID
+        u64 last_used;
+        u64 size;
+    };
+    FileUtil::FSTEntry tree;
+    FileUtil::ScanDirectoryTree(FileUtil::GetUserPath(FileUtil::UserPath::CacheDir) + "content",
+                                tree, 2);
+    std::vector<Entry> entries;
+    u64 total_size{};
+    for (const auto& program : tree.children) {
+        for (const auto& title : program.children) {
+            if (!title.isDirectory)
+                continue;
+            Entry entry{title.physicalName + '/',
+                        program.children.size() == 1 ? program.physicalName : std::string{}, 0,
+                        0};
+            for (const auto& file : title.children)
+                entry.size += file.size;
+            total_size += entry.size;
+            FileUtil::IOFile file{entry.path + "info.bin", "rb"};
+            CacheInfo info;
+            // Directories of other cache versions go first
+            if (file.ReadBytes(&info, sizeof(CacheInfo)) == sizeof(CacheInfo) &&
+                info.magic == CACHE_MAGIC && info.version == CACHE_VERSION)
+                entry.last_used = info.last_used;
+            if (title.virtualName != name && entry.last_used < session_start)
+                entries.push_back(std::move(entry));
+        }
+    }
+    const u64 budget{u64{Settings::values.content_cache_size_mb} << 20};
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.last_used < b.last_used; });
+    for (const auto& entry : entries) {
+        if (total_size <= budget)
+            break;
+        LOG_INFO(Service_FS, "Evicting {} from content cache", entry.path);
+        if (!FileUtil::DeleteDirRecursively(entry.path))
+            continue;
+        total_size -= entry.size;
+        if (!entry.program_path.empty())
+            FileUtil::DeleteDir(entry.program_path);
+    }
+    space_left = static_cast<s64>(budget) - static_cast<s64>(total_size);
+}
+
+bool ContentCache::WriteFile(const std::string& name, const u8* data, std::size_t size) const {
+    // Once the budget is used up, nothing is added until the next title is opened
+    if (space_left.fetch_sub(static_cast<s64>(size)) < static_cast<s64>(size)) {
+        space_left += static_cast<s64>(size);
+        return false;
+    }
+    // Write to a temporary file first so a crash never leaves a truncated entry behind
+    const std::string path{directory + name};
+    const std::string temp_path{GetTempPath(path)};
+    {
+        FileUtil::IOFile file{temp_path, "wb"};
+        if (file.WriteBytes(data, size) != size) {
+            file.Close();
+            FileUtil::Delete(temp_path);
+            space_left += static_cast<s64>(size);
+            return false;
+        }
+    }
+    return Commit(temp_path, path);
+}
+
+bool ContentCache::LoadSection(const char* name, std::vector<u8>& buffer) const {
+    if (!is_valid)
+        return false;
+    FileUtil::IOFile file{fmt::format("{}exefs_{}.bin", directory, name), "rb"};
+    if (!file.IsOpen())
+        return false;
+    buffer.resize(file.GetSize());
+    if (file.ReadBytes(buffer.data(), buffer.size()) != buffer.size())
+        return false;
+    LOG_DEBUG(Service_FS, "Loaded ExeFS section {} from content cache", name);
+    return true;
+}
+
+void ContentCache::StoreSection(const char* name, const std::vector<u8>& buffer) const {
+    if (is_valid)
+        WriteFile(fmt::format("exefs_{}.bin", name), buffer.data(), buffer.size());
+}
+
+bool ContentCache::LoadRomFSBlock(std::size_t index, std::size_t offset, std::size_t length,
+                                  u8* buffer) const {
+    if (!is_valid)
+        return false;
+    FileUtil::IOFile file{fmt::format("{}romfs_{:08X}.bin", directory, index), "rb"};
+    if (!file.IsOpen() || !file.Seek(offset, SEEK_SET))
+        return false;
+    return file.ReadBytes(buffer, length) == length;
+}
+
+void ContentCache::StoreRomFSBlock(std::size_t index, const u8* data, std::size_t size) const {
+    if (is_valid)
+        WriteFile(fmt::format("romfs_{:08X}.bin", index), data, size);
+}
+
+} // namespace FileSys
@@ -0,0 +1,69 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+
+struct NCCH_Header;
+
+namespace FileSys {
+
+/**
+ * On-disk cache of the decrypted ExeFS sections (with .code decompressed) and the decrypted RomFS
+ * blocks of an NCCH, so the crypto and LZSS work is only done the first time they're read.
+ * Entries live in a directory named after the program ID and a hash of the NCCH header (which
+ * covers the ExeFS and RomFS super block hashes), the seed and the cache version, so a directory
+ * never holds stale entries. Files are only ever replaced by renaming complete ones into place,
+ * which lets several instances share the cache.
+ * The cache is kept within the configured size by deleting the directories of the least recently
+ * booted titles when one is opened, after which it stops growing once the budget is used up.
+ */
+class ContentCache {
+public:
+    /// Size of the RomFS blocks, which are cached as they're read
+    static constexpr std::size_t ROMFS_BLOCK_SIZE{0x40000};
+
+    ContentCache(const NCCH_Header& header, const std::array<u8, 16>& seed);
+
+    /**
+     * Reads a cached ExeFS section
+     * @param name Name of the section (e.g. .code, icon)
+     * @param buffer Vector to read data into
+     * @return Whether the section was cached
+     */
+    bool LoadSection(const char* name, std::vector<u8>& buffer) const;
+
+    /// Stores a decrypted and decompressed ExeFS section
+    void StoreSection(const char* name, const std::vector<u8>& buffer) const;
+
+    /**
+     * Reads part of a cached RomFS block
+     * @param index Index of the block in the RomFS
+     * @param offset Offset in the block
+     * @return Whether the block was cached
+     */
+    bool LoadRomFSBlock(std::size_t index, std::size_t offset, std::size_t length,
+                        u8* buffer) const;
+
+    /// Stores a decrypted RomFS block, only the last one may be shorter than ROMFS_BLOCK_SIZE
+    void StoreRomFSBlock(std::size_t index, const u8* data, std::size_t size) const;
+
+private:
+    bool Validate() const;
+    bool WriteFile(const std::string& name, const u8* data, std::size_t size) const;
+
+    /// Evicts the least recently used titles until the cache fits in its budget
+    void Trim(const std::string& name) const;
+
+    std::string directory;
+    std::array<u8, 32> key;
+    bool is_valid{};
+};
+
+} // namespace FileSys
@@ -5,6 +5,7 @@
 #include <cinttypes>
 #include <cstring>
 #include <memory>
+#include <mutex>
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
 #include <cryptopp/sha.h>
@@ -15,6 +16,7 @@
 #include "core/file_sys/seed_db.h"
 #include "core/hw/aes/key.h"
 #include "core/loader/loader.h"
+#include "core/settings.h"
 
 namespace FileSys {
 
@@ -95,6 +97,7 @@ static bool LZSS_Decompress(const u8* compressed, u32 compressed_size, u8* decom
 NCCHContainer::NCCHContainer(const std::string& filepath, u32 ncch_offset)
     : ncch_offset{ncch_offset}, filepath{filepath} {
     file = FileUtil::IOFile{filepath, "rb"};
+    OpenMapping();
 }
 
 Loader::ResultStatus NCCHContainer::OpenFile(const std::string& filepath, u32 ncch_offset) {
@@ -106,9 +109,20 @@ Loader::ResultStatus NCCHContainer::OpenFile(const std::string& filepath, u32 nc
         return Loader::ResultStatus::Error;
     }
     LOG_DEBUG(Service_FS, "Opened {}", filepath);
+    OpenMapping();
     return Loader::ResultStatus::Success;
 }
 
+void NCCHContainer::OpenMapping() {
+    auto mapping{std::make_shared<FileUtil::MappedFile>(filepath)};
+    if (mapping->IsOpen())
+        mapped_file = std::move(mapping);
+    else {
+        LOG_DEBUG(Service_FS, "Couldn't map {}, falling back to buffered reads", filepath);
+        mapped_file.reset();
+    }
+}
+
 Loader::ResultStatus NCCHContainer::Load() {
     if (is_loaded)
         return Loader::ResultStatus::Success;
@@ -128,7 +142,6 @@ Loader::ResultStatus NCCHContainer::Load() {
         if (Loader::MakeMagic('N', 'C', 'C', 'H') != ncch_header.magic)
             return Loader::ResultStatus::ErrorInvalidFormat;
         has_header = true;
-        bool failed_to_decrypt{};
         if (!ncch_header.no_crypto) {
             is_encrypted = true;
             // Find primary and secondary keys
@@ -139,6 +152,17 @@ Loader::ResultStatus NCCHContainer::Load() {
             } else {
                 using namespace HW::AES;
                 InitKeys();
+                // The normal keys are generated without setting the KeyY of the global slots, as
+                // containers may be loaded from several threads at once
+                const auto generate_key{[this](std::size_t slot_id, const AESKey& key_y,
+                                               const char* name) {
+                    const auto key{GenerateNormalKey(slot_id, key_y)};
+                    if (!key) {
+                        LOG_ERROR(Service_FS, "{} KeyX missing", name);
+                        failed_to_decrypt = true;
+                    }
+                    return key.value_or(AESKey{});
+                }};
                 std::array<u8, 16> key_y_primary, key_y_secondary;
                 std::copy(ncch_header.signature, ncch_header.signature + key_y_primary.size(),
                           key_y_primary.begin());
@@ -151,7 +175,7 @@ Loader::ResultStatus NCCHContainer::Load() {
                                   ncch_header.program_id);
                         failed_to_decrypt = true;
                     } else {
-                        auto seed{*opt};
+                        seed = *opt;
                         std::array<u8, 32> input;
                         std::memcpy(input.data(), key_y_primary.data(), key_y_primary.size());
                         std::memcpy(input.data() + key_y_primary.size(), seed.data(), seed.size());
@@ -160,12 +184,7 @@ Loader::ResultStatus NCCHContainer::Load() {
                         std::memcpy(key_y_secondary.data(), hash.data(), key_y_secondary.size());
                     }
                 }
-                SetKeyY(KeySlotID::NCCHSecure1, key_y_primary);
-                if (!IsNormalKeyAvailable(KeySlotID::NCCHSecure1)) {
-                    LOG_ERROR(Service_FS, "Secure1 KeyX missing");
-                    failed_to_decrypt = true;
-                }
-                primary_key = GetNormalKey(KeySlotID::NCCHSecure1);
+                primary_key = generate_key(KeySlotID::NCCHSecure1, key_y_primary, "Secure1");
                 switch (ncch_header.secondary_key_slot) {
                 case 0:
                     LOG_DEBUG(Service_FS, "Secure1 crypto");
@@ -173,30 +192,18 @@ Loader::ResultStatus NCCHContainer::Load() {
                     break;
                 case 1:
                     LOG_DEBUG(Service_FS, "Secure2 crypto");
-                    SetKeyY(KeySlotID::NCCHSecure2, key_y_secondary);
-                    if (!IsNormalKeyAvailable(KeySlotID::NCCHSecure2)) {
-                        LOG_ERROR(Service_FS, "Secure2 KeyX missing");
-                        failed_to_decrypt = true;
-                    }
-                    secondary_key = GetNormalKey(KeySlotID::NCCHSecure2);
+                    secondary_key =
+                        generate_key(KeySlotID::NCCHSecure2, key_y_secondary, "Secure2");
                     break;
                 case 10:
                     LOG_DEBUG(Service_FS, "Secure3 crypto");
-                    SetKeyY(KeySlotID::NCCHSecure3, key_y_secondary);
-                    if (!IsNormalKeyAvailable(KeySlotID::NCCHSecure3)) {
-                        LOG_ERROR(Service_FS, "Secure3 KeyX missing");
-                        failed_to_decrypt = true;
-                    }
-                    secondary_key = GetNormalKey(KeySlotID::NCCHSecure3);
+                    secondary_key =
+                        generate_key(KeySlotID::NCCHSecure3, key_y_secondary, "Secure3");
                     break;
                 case 11:
                     LOG_DEBUG(Service_FS, "Secure4 crypto");
-                    SetKeyY(KeySlotID::NCCHSecure4, key_y_secondary);
-                    if (!IsNormalKeyAvailable(KeySlotID::NCCHSecure4)) {
-                        LOG_ERROR(Service_FS, "Secure4 KeyX missing");
-                        failed_to_decrypt = true;
-                    }
-                    secondary_key = GetNormalKey(KeySlotID::NCCHSecure4);
+                    secondary_key =
+                        generate_key(KeySlotID::NCCHSecure4, key_y_secondary, "Secure4");
                     break;
                 }
             }
@@ -334,6 +341,7 @@ Loader::ResultStatus NCCHContainer::LoadOverrides() {
             LOG_DEBUG(Service_FS, "Loading ExeFS section from {}", exefs_override);
             exefs_offset = 0;
             is_tainted = true;
+            is_exefs_overridden = true;
             has_exefs = true;
         } else
             exefs_file = FileUtil::IOFile{filepath, "rb"};
@@ -383,7 +391,6 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
                       section.offset, section.size, section.name);
             s64 section_offset{static_cast<s64>(
                 (section.offset + exefs_offset + sizeof(ExeFs_Header) + ncch_offset))};
-            exefs_file.Seek(section_offset, SEEK_SET);
             std::array<u8, 16> key;
             if (std::strcmp(section.name, "icon") == 0 || std::strcmp(section.name, "banner") == 0)
                 key = primary_key;
@@ -392,30 +399,57 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
             CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption dec{key.data(), key.size(),
                                                               exefs_ctr.data()};
             dec.Seek(section.offset + sizeof(ExeFs_Header));
-            if (std::strcmp(section.name, ".code") == 0 && is_compressed) {
-                // Section is compressed, read compressed .code section...
-                std::unique_ptr<u8[]> temp_buffer;
-                try {
-                    temp_buffer.reset(new u8[section.size]);
-                } catch (std::bad_alloc&) {
-                    return Loader::ResultStatus::ErrorMemoryAllocationFailed;
+            // The cache holds the section before any IPS patching
+            bool use_cache{content_cache && !is_exefs_overridden};
+            if (!use_cache || !content_cache->LoadSection(name, buffer)) {
+                // Without an override, the section can be read straight out of the mapping
+                const u8* section_data{!is_exefs_overridden && mapped_file
+                                           ? mapped_file->GetPointer(section_offset, section.size)
+                                           : nullptr};
+                if (std::strcmp(section.name, ".code") == 0 && is_compressed) {
+                    const u8* compressed{section_data};
+                    std::unique_ptr<u8[]> temp_buffer;
+                    if (!section_data || is_encrypted) {
+                        // Section is compressed, read compressed .code section...
+                        try {
+                            temp_buffer.reset(new u8[section.size]);
+                        } catch (std::bad_alloc&) {
+                            return Loader::ResultStatus::ErrorMemoryAllocationFailed;
+                        }
+                        if (section_data)
+                            dec.ProcessData(&temp_buffer[0], section_data, section.size);
+                        else {
+                            exefs_file.Seek(section_offset, SEEK_SET);
+                            if (exefs_file.ReadBytes(&temp_buffer[0], section.size) != section.size)
+                                return Loader::ResultStatus::Error;
+                            if (is_encrypted)
+                                dec.ProcessData(&temp_buffer[0], &temp_buffer[0], section.size);
+                        }
+                        compressed = &temp_buffer[0];
+                    }
+                    // Decompress .code section...
+                    u32 decompressed_size{LZSS_GetDecompressedSize(compressed, section.size)};
+                    buffer.resize(decompressed_size);
+                    if (!LZSS_Decompress(compressed, section.size, &buffer[0], decompressed_size))
+                        return Loader::ResultStatus::ErrorInvalidFormat;
+                } else {
+                    // Section is uncompressed...
+                    buffer.resize(section.size);
+                    if (section_data) {
+                        if (is_encrypted)
+                            dec.ProcessData(&buffer[0], section_data, section.size);
+                        else
+                            std::memcpy(&buffer[0], section_data, section.size);
+                    } else {
+                        exefs_file.Seek(section_offset, SEEK_SET);
+                        if (exefs_file.ReadBytes(&buffer[0], section.size) != section.size)
+                            return Loader::ResultStatus::Error;
+                        if (is_encrypted)
+                            dec.ProcessData(&buffer[0], &buffer[0], section.size);
+                    }
                 }
-                if (exefs_file.ReadBytes(&temp_buffer[0], section.size) != section.size)
-                    return Loader::ResultStatus::Error;
-                if (is_encrypted)
-                    dec.ProcessData(&temp_buffer[0], &temp_buffer[0], section.size);
-                // Decompress .code section...
-                u32 decompressed_size{LZSS_GetDecompressedSize(&temp_buffer[0], section.size)};
-                buffer.resize(decompressed_size);
-                if (!LZSS_Decompress(&temp_buffer[0], section.size, &buffer[0], decompressed_size))
-                    return Loader::ResultStatus::ErrorInvalidFormat;
-            } else {
-                // Section is uncompressed...
-                buffer.resize(section.size);
-                if (exefs_file.ReadBytes(&buffer[0], section.size) != section.size)
-                    return Loader::ResultStatus::Error;
-                if (is_encrypted)
-                    dec.ProcessData(&buffer[0], &buffer[0], section.size);
+                if (use_cache)
+                    content_cache->StoreSection(name, buffer);
             }
             if (std::strcmp(name, ".code") == 0) {
                 std::string override_ips{filepath + ".exefsdir/code.ips"};
@@ -495,6 +529,13 @@ Loader::ResultStatus NCCHContainer::LoadOverrideExeFSSection(const char* name,
     return Loader::ResultStatus::ErrorNotUsed;
 }
 
+void NCCHContainer::EnableContentCache() {
+    if (content_cache || !Settings::values.use_content_cache || !has_header ||
+        failed_to_decrypt || !(is_encrypted || is_compressed))
+        return;
+    content_cache = std::make_shared<ContentCache>(ncch_header, seed);
+}
+
 Loader::ResultStatus NCCHContainer::ReadRomFS(std::shared_ptr<RomFSReader>& romfs_file) {
     auto result{Load()};
     if (result != Loader::ResultStatus::Success)
@@ -513,13 +554,24 @@ Loader::ResultStatus NCCHContainer::ReadRomFS(std::shared_ptr<RomFSReader>& romf
     LOG_DEBUG(Service_FS, "RomFS size:             0x{:08X}", romfs_size);
     if (file.GetSize() < romfs_offset + romfs_size)
         return Loader::ResultStatus::Error;
+    if (mapped_file) {
+        // The mapping is shared, reads through it don't touch any file position
+        if (is_encrypted)
+            romfs_file = std::make_shared<RomFSReader>(mapped_file, romfs_offset, romfs_size,
+                                                       secondary_key, romfs_ctr, 0x1000,
+                                                       content_cache);
+        else
+            romfs_file = std::make_shared<RomFSReader>(mapped_file, romfs_offset, romfs_size);
+        return Loader::ResultStatus::Success;
+    }
     // We reopen the file, to allow its position to be independent from file's
     FileUtil::IOFile romfs_file_inner{filepath, "rb"};
     if (!romfs_file_inner.IsOpen())
         return Loader::ResultStatus::Error;
     if (is_encrypted)
-        romfs_file = std::make_shared<RomFSReader>(std::move(romfs_file_inner), romfs_offset,
-                                                   romfs_size, secondary_key, romfs_ctr, 0x1000);
+        romfs_file =
+            std::make_shared<RomFSReader>(std::move(romfs_file_inner), romfs_offset, romfs_size,
+                                          secondary_key, romfs_ctr, 0x1000, content_cache);
     else
         romfs_file =
             std::make_shared<RomFSReader>(std::move(romfs_file_inner), romfs_offset, romfs_size);
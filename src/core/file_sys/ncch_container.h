@@ -13,6 +13,7 @@
 #include "common/file_util.h"
 #include "common/swap.h"
 #include "core/core.h"
+#include "core/file_sys/content_cache.h"
 #include "core/file_sys/romfs_reader.h"
 
 /// NCCH header (Note: "NCCH" appears to be a publicly unknown acronym)
@@ -200,6 +201,12 @@ public:
      */
     Loader::ResultStatus LoadOverrides();
 
+    /**
+     * Serves the ExeFS sections and RomFS from the content cache when it's enabled, filling it
+     * as they're read. Only meant for booted titles, after Load.
+     */
+    void EnableContentCache();
+
     /**
      * Reads an program ExeFS section of an NCCH file (e.g. .code, .logo, etc.)
      * @param name Name of section to read out of NCCH file
@@ -272,15 +279,20 @@ public:
     ExHeader_Header exheader_header;
 
 private:
+    /// Maps the container file for zero-copy reads, failing to do so isn't an error
+    void OpenMapping();
+
     bool has_header{};
     bool has_exheader{};
     bool has_exefs{};
     bool has_romfs{};
 
     bool is_tainted{}; // Are there parts of this container being overridden?
+    bool is_exefs_overridden{};
     bool is_loaded{};
     bool is_compressed{};
     bool is_encrypted{};
+    bool failed_to_decrypt{};
 
     // for decrypting exheader, exefs header and icon/banner section
     std::array<u8, 16> primary_key{};
@@ -288,6 +300,7 @@ private:
     std::array<u8, 16> exheader_ctr{};
     std::array<u8, 16> exefs_ctr{};
     std::array<u8, 16> romfs_ctr{};
+    std::array<u8, 16> seed{};
 
     u32 ncch_offset{}; // Offset to NCCH header, can be 0 for NCCHs or non-zero for CIAs/NCSDs
     u32 exefs_offset{};
@@ -295,6 +308,13 @@ private:
     std::string filepath;
     FileUtil::IOFile file;
     FileUtil::IOFile exefs_file;
+
+    // Shared with the RomFS readers, sections and RomFS are served from it when available
+    std::shared_ptr<FileUtil::MappedFile> mapped_file;
+
+    // Set when the content cache is enabled and there is crypto or compression to skip, shared
+    // with the RomFS readers
+    std::shared_ptr<ContentCache> content_cache;
 };
 
 } // namespace FileSys
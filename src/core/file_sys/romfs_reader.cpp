@@ -1,6 +1,9 @@
 #include <algorithm>
+#include <cstring>
+#include <vector>
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
+#include "core/file_sys/content_cache.h"
 #include "core/file_sys/romfs_reader.h"
 
 namespace FileSys {
@@ -8,13 +11,57 @@ namespace FileSys {
 std::size_t RomFSReader::ReadFile(std::size_t offset, std::size_t length, u8* buffer) {
     if (length == 0)
         return 0; // Crypto++ doesn't like zero size buffer
-    file.Seek(file_offset + offset, SEEK_SET);
+    if (cache)
+        return ReadCached(offset, length, buffer);
+    return ReadUncached(offset, length, buffer);
+}
+
+std::size_t RomFSReader::ReadCached(std::size_t offset, std::size_t length, u8* buffer) {
+    constexpr std::size_t BLOCK_SIZE{ContentCache::ROMFS_BLOCK_SIZE};
+    const std::size_t read_length{std::min(length, data_size - offset)};
+    std::vector<u8> block;
+    for (std::size_t done{}; done < read_length;) {
+        const std::size_t position{offset + done};
+        const std::size_t index{position / BLOCK_SIZE};
+        const std::size_t block_start{index * BLOCK_SIZE};
+        const std::size_t block_offset{position - block_start};
+        const std::size_t chunk_size{std::min(read_length - done, BLOCK_SIZE - block_offset)};
+        if (!cache->LoadRomFSBlock(index, block_offset, chunk_size, buffer + done)) {
+            // Only the blocks which are read get stored
+            block.resize(std::min(BLOCK_SIZE, data_size - block_start));
+            if (ReadUncached(block_start, block.size(), block.data()) != block.size())
+                return done;
+            cache->StoreRomFSBlock(index, block.data(), block.size());
+            std::memcpy(buffer + done, block.data() + block_offset, chunk_size);
+        }
+        done += chunk_size;
+    }
+    return read_length;
+}
+
+std::size_t RomFSReader::ReadUncached(std::size_t offset, std::size_t length, u8* buffer) {
     std::size_t read_length{std::min(length, data_size - offset)};
-    read_length = file.ReadBytes(buffer, read_length);
+    const u8* source{};
+    if (mapped_file) {
+        u64 position{file_offset + offset};
+        if (position >= mapped_file->GetSize())
+            return 0;
+        read_length = static_cast<std::size_t>(
+            std::min<u64>(read_length, mapped_file->GetSize() - position));
+        source = mapped_file->GetPointer(position, read_length);
+        if (!is_encrypted)
+            std::memcpy(buffer, source, read_length);
+    } else {
+        std::lock_guard lock{file_mutex};
+        file.Seek(file_offset + offset, SEEK_SET);
+        read_length = file.ReadBytes(buffer, read_length);
+        source = buffer;
+    }
     if (is_encrypted) {
         CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption d{key.data(), key.size(), ctr.data()};
         d.Seek(crypto_offset + offset);
-        d.ProcessData(buffer, buffer, read_length);
+        // Decrypt straight out of the mapping when there is one
+        d.ProcessData(buffer, source, read_length);
     }
     return read_length;
 }
@@ -1,11 +1,15 @@
 #pragma once
 
 #include <array>
+#include <memory>
+#include <mutex>
 #include "common/common_types.h"
 #include "common/file_util.h"
 
 namespace FileSys {
 
+class ContentCache;
+
 class RomFSReader {
 public:
     RomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size)
@@ -13,9 +17,21 @@ public:
 
     RomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size,
                 const std::array<u8, 16>& key, const std::array<u8, 16>& ctr,
-                std::size_t crypto_offset)
+                std::size_t crypto_offset, std::shared_ptr<ContentCache> cache = nullptr)
         : is_encrypted{true}, file{std::move(file)}, key{key}, ctr{ctr}, file_offset{file_offset},
-          crypto_offset{crypto_offset}, data_size{data_size} {}
+          crypto_offset{crypto_offset}, data_size{data_size}, cache{std::move(cache)} {}
+
+    RomFSReader(std::shared_ptr<FileUtil::MappedFile> mapped_file, std::size_t file_offset,
+                std::size_t data_size)
+        : mapped_file{std::move(mapped_file)}, file_offset{file_offset}, data_size{data_size} {}
+
+    RomFSReader(std::shared_ptr<FileUtil::MappedFile> mapped_file, std::size_t file_offset,
+                std::size_t data_size, const std::array<u8, 16>& key,
+                const std::array<u8, 16>& ctr, std::size_t crypto_offset,
+                std::shared_ptr<ContentCache> cache = nullptr)
+        : is_encrypted{true}, mapped_file{std::move(mapped_file)}, key{key}, ctr{ctr},
+          file_offset{file_offset}, crypto_offset{crypto_offset}, data_size{data_size},
+          cache{std::move(cache)} {}
 
     std::size_t GetSize() const {
         return data_size;
@@ -24,13 +40,21 @@ public:
     std::size_t ReadFile(std::size_t offset, std::size_t length, u8* buffer);
 
 private:
+    /// Reads through the content cache, decrypting and storing the blocks it doesn't have yet
+    std::size_t ReadCached(std::size_t offset, std::size_t length, u8* buffer);
+
+    std::size_t ReadUncached(std::size_t offset, std::size_t length, u8* buffer);
+
     bool is_encrypted{};
     FileUtil::IOFile file;
+    std::mutex file_mutex; ///< Serializes seek and read on the shared file handle
+    std::shared_ptr<FileUtil::MappedFile> mapped_file;
     std::array<u8, 16> key{};
     std::array<u8, 16> ctr{};
     std::size_t file_offset{};
     std::size_t crypto_offset{};
     std::size_t data_size{};
+    std::shared_ptr<ContentCache> cache;
 };
 
 } // namespace FileSys
@@ -38,12 +38,11 @@ std::optional<std::array<u8, 16>> Ticket::GetTitleKey() const {
     HW::AES::InitKeys();
     std::array<u8, 16> ctr{};
     std::memcpy(ctr.data(), &ticket_body.program_id, sizeof(u64));
-    HW::AES::SelectCommonKeyIndex(ticket_body.common_key_index);
-    if (!HW::AES::IsNormalKeyAvailable(HW::AES::KeySlotID::TicketCommonKey))
+    const auto key{HW::AES::GetCommonKey(ticket_body.common_key_index)};
+    if (!key)
         return {};
-    auto key{HW::AES::GetNormalKey(HW::AES::KeySlotID::TicketCommonKey)};
     auto title_key{ticket_body.title_key};
-    CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption{key.data(), key.size(), ctr.data()}.ProcessData(
+    CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption{key->data(), key->size(), ctr.data()}.ProcessData(
         title_key.data(), title_key.data(), title_key.size());
     return title_key;
 }
@@ -152,6 +152,10 @@ std::array<u8, 16> TitleMetadata::GetContentCTRByIndex(u16 index) const {
     return ctr;
 }
 
+const std::array<u8, 0x20>& TitleMetadata::GetContentHashByIndex(u16 index) const {
+    return tmd_chunks[index].hash;
+}
+
 void TitleMetadata::SetProgramID(u64 program_id) {
     tmd_body.program_id = program_id;
 }
@@ -97,6 +97,7 @@ public:
     u16 GetContentTypeByIndex(u16 index) const;
     u64 GetContentSizeByIndex(u16 index) const;
     std::array<u8, 16> GetContentCTRByIndex(u16 index) const;
+    const std::array<u8, 0x20>& GetContentHashByIndex(u16 index) const;
 
     void SetProgramID(u64 program_id);
     void SetTitleType(u32 type);
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <array>
+#include <cstring>
 #include <tuple>
 #include <type_traits>
 #include <utility>
@@ -95,6 +96,12 @@ public:
 
     void PushStaticBuffer(const std::vector<u8>& buffer, u8 buffer_id);
 
+    /**
+     * Pushes a static buffer of the given size that the caller fills through the returned view,
+     * which avoids building the reply in a vector first.
+     */
+    Common::Span<u8> PushStaticBufferInPlace(std::size_t size, u8 buffer_id);
+
     /// Pushes an HLE MappedBuffer interface back to unmapped the buffer.
     void PushMappedBuffer(const Kernel::MappedBuffer& mapped_buffer);
 
@@ -180,13 +187,19 @@ inline void ResponseBuilder::PushMoveObjects(Kernel::SharedPtr<O>... pointers) {
 }
 
 inline void ResponseBuilder::PushStaticBuffer(const std::vector<u8>& buffer, u8 buffer_id) {
+    const auto dest{PushStaticBufferInPlace(buffer.size(), buffer_id)};
+    if (!buffer.empty())
+        std::memcpy(dest.data(), buffer.data(), buffer.size());
+}
+
+inline Common::Span<u8> ResponseBuilder::PushStaticBufferInPlace(std::size_t size, u8 buffer_id) {
     ASSERT_MSG(buffer_id < MAX_STATIC_BUFFERS, "Invalid static buffer id");
 
-    Push(StaticBufferDesc(buffer.size(), buffer_id));
+    Push(StaticBufferDesc(size, buffer_id));
     // This address will be replaced by the correct static buffer address during IPC translation.
     Push<VAddr>(0xDEADC0DE);
 
-    context->AddStaticBuffer(buffer_id, buffer);
+    return context->ReserveStaticBuffer(buffer_id, size);
 }
 
 inline void ResponseBuilder::PushMappedBuffer(const Kernel::MappedBuffer& mapped_buffer) {
@@ -275,6 +288,9 @@ public:
      */
     const std::vector<u8>& PopStaticBuffer();
 
+    /// Pops a static buffer as a view of the originator's memory, copying it only if needed
+    Common::Span<const u8> PopStaticBufferView();
+
     /// Pops a mapped buffer descriptor with its vaddr and resolves it to an HLE interface
     Kernel::MappedBuffer& PopMappedBuffer();
 
@@ -428,6 +444,15 @@ inline const std::vector<u8>& RequestParser::PopStaticBuffer() {
     return context->GetStaticBuffer(static_cast<u8>(buffer_info.buffer_id));
 }
 
+inline Common::Span<const u8> RequestParser::PopStaticBufferView() {
+    const u32 sbuffer_descriptor{Pop<u32>()};
+    // Pop the address from the incoming request buffer
+    Pop<VAddr>();
+
+    StaticBufferDescInfo buffer_info{sbuffer_descriptor};
+    return context->GetStaticBufferView(static_cast<u8>(buffer_info.buffer_id));
+}
+
 inline Kernel::MappedBuffer& RequestParser::PopMappedBuffer() {
     u32 mapped_buffer_descriptor{Pop<u32>()};
     ASSERT_MSG(GetDescriptorType(mapped_buffer_descriptor) == MappedBuffer,
@@ -2,7 +2,6 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
-#include <algorithm>
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "core/hle/kernel/address_arbiter.h"
@@ -13,51 +12,61 @@
 
 namespace Kernel {
 
+Common::ThreadQueueHook<Thread>& ArbiterHook::Get(Thread* thread) {
+    return thread->arbiter_hook;
+}
+
 void AddressArbiter::WaitThread(SharedPtr<Thread> thread, VAddr wait_address) {
     thread->wait_address = wait_address;
     thread->status = ThreadStatus::WaitArb;
-    waiting_threads.emplace_back(std::move(thread));
+    thread->wait_arbiter = this;
+    const u32 priority{thread->current_priority};
+    waiting_threads[wait_address].push(priority, thread.detach());
 }
 
-void AddressArbiter::ResumeAllThreads(VAddr address) {
-    // Determine which threads are waiting on this address, those should be woken up.
-    auto itr{std::stable_partition(waiting_threads.begin(), waiting_threads.end(),
-                                   [address](const auto& thread) {
-                                       ASSERT_MSG(thread->status == ThreadStatus::WaitArb,
-                                                  "Inconsistent AddressArbiter state");
-                                       return thread->wait_address != address;
-                                   })};
-    // Wake up all the found threads
-    std::for_each(itr, waiting_threads.end(), [](auto& thread) { thread->ResumeFromWait(); });
-    // Remove the woken up threads from the wait list.
-    waiting_threads.erase(itr, waiting_threads.end());
+void AddressArbiter::ResumeThreads(VAddr address, s32 count) {
+    auto itr{waiting_threads.find(address)};
+    if (itr == waiting_threads.end())
+        return;
+    auto& list{itr->second};
+    for (; count != 0 && !list.empty(); --count) {
+        // Adopt the reference held by the list
+        SharedPtr<Thread> thread{list.pop(), false};
+        ASSERT_MSG(thread->status == ThreadStatus::WaitArb, "Inconsistent AddressArbiter state");
+        thread->wait_arbiter = nullptr;
+        thread->ResumeFromWait();
+    }
+    if (list.empty())
+        waiting_threads.erase(itr);
 }
 
-SharedPtr<Thread> AddressArbiter::ResumeHighestPriorityThread(VAddr address) {
-    // Determine which threads are waiting on this address, those should be considered for wakeup.
-    auto matches_start{std::stable_partition(waiting_threads.begin(), waiting_threads.end(),
-                                             [address](const auto& thread) {
-                                                 ASSERT_MSG(thread->status == ThreadStatus::WaitArb,
-                                                            "Inconsistent AddressArbiter state");
-                                                 return thread->wait_address != address;
-                                             })};
-    // Iterate through threads, find highest priority thread that is waiting to be arbitrated.
-    // Note: The real kernel will pick the first thread in the list if more than one have the
-    // same highest priority value. Lower priority values mean higher priority.
-    auto itr{std::min_element(matches_start, waiting_threads.end(),
-                              [](const auto& lhs, const auto& rhs) {
-                                  return lhs->current_priority < rhs->current_priority;
-                              })};
-    if (itr == waiting_threads.end())
-        return nullptr;
-    auto thread{*itr};
-    thread->ResumeFromWait();
-    waiting_threads.erase(itr);
-    return thread;
+void AddressArbiter::RemoveWaitingThread(Thread* thread) {
+    auto itr{waiting_threads.find(thread->wait_address)};
+    if (itr == waiting_threads.end() || !thread->arbiter_hook.queued)
+        return;
+    itr->second.remove(thread);
+    if (itr->second.empty())
+        waiting_threads.erase(itr);
+    thread->wait_arbiter = nullptr;
+    // Drop the reference held by the list
+    intrusive_ptr_release(thread);
+}
+
+void AddressArbiter::UpdateThreadPriority(Thread* thread) {
+    auto& list{waiting_threads.at(thread->wait_address)};
+    list.remove(thread);
+    list.push(thread->current_priority, thread);
 }
 
 AddressArbiter::AddressArbiter(KernelSystem& kernel) : Object{kernel} {}
-AddressArbiter::~AddressArbiter() {}
+AddressArbiter::~AddressArbiter() {
+    for (auto& [address, list] : waiting_threads) {
+        while (!list.empty()) {
+            SharedPtr<Thread> thread{list.pop(), false};
+            thread->wait_arbiter = nullptr;
+        }
+    }
+}
 
 SharedPtr<AddressArbiter> KernelSystem::CreateAddressArbiter(std::string name) {
     SharedPtr<AddressArbiter> address_arbiter{new AddressArbiter(*this)};
@@ -68,23 +77,18 @@ SharedPtr<AddressArbiter> KernelSystem::CreateAddressArbiter(std::string name) {
 ResultCode AddressArbiter::ArbitrateAddress(SharedPtr<Thread> thread, ArbitrationType type,
                                             VAddr address, s32 value, u64 nanoseconds) {
 
-    auto timeout_callback{[this](ThreadWakeupReason reason, SharedPtr<Thread> thread,
-                                 SharedPtr<WaitObject> object) {
+    auto timeout_callback{[](ThreadWakeupReason reason, SharedPtr<Thread> thread,
+                             SharedPtr<WaitObject> object) {
         ASSERT(reason == ThreadWakeupReason::Timeout);
         // Remove the newly-awakened thread from the Arbiter's waiting list.
-        waiting_threads.erase(std::remove(waiting_threads.begin(), waiting_threads.end(), thread),
-                              waiting_threads.end());
+        if (thread->wait_arbiter)
+            thread->wait_arbiter->RemoveWaitingThread(thread.get());
     }};
     switch (type) {
     // Signal thread(s) waiting for arbitrate address...
     case ArbitrationType::Signal:
-        // Negative value means resume all threads
-        if (value < 0)
-            ResumeAllThreads(address);
-        else
-            // Resume first N threads
-            for (int i{}; i < value; i++)
-                ResumeHighestPriorityThread(address);
+        // Resume the first N threads, a negative value means resume all threads
+        ResumeThreads(address, value);
         break;
 
     // Wait current thread (acquire the arbiter)...
@@ -4,8 +4,9 @@
 
 #pragma once
 
-#include <vector>
+#include <unordered_map>
 #include "common/common_types.h"
+#include "common/thread_queue_list.h"
 #include "core/hle/kernel/object.h"
 #include "core/hle/result.h"
 
@@ -26,6 +27,11 @@ enum class ArbitrationType : u32 {
     DecrementAndWaitIfLessThanWithTimeout,
 };
 
+/// Hook accessor for the links of threads waiting on an arbiter
+struct ArbiterHook {
+    static Common::ThreadQueueHook<Thread>& Get(Thread* thread);
+};
+
 class AddressArbiter final : public Object {
 public:
     std::string GetTypeName() const override {
@@ -46,22 +52,31 @@ public:
     ResultCode ArbitrateAddress(SharedPtr<Thread> thread, ArbitrationType type, VAddr address,
                                 s32 value, u64 nanoseconds);
 
+    /// Removes a thread from the wait list of its address without resuming it
+    void RemoveWaitingThread(Thread* thread);
+
+    /// Moves a waiting thread to the position of its new priority
+    void UpdateThreadPriority(Thread* thread);
+
 private:
     explicit AddressArbiter(KernelSystem& kernel);
     ~AddressArbiter() override;
 
+    using WaitList = Common::ThreadWaitList<Thread, ArbiterHook>;
+
     /// Puts the thread to wait on the specified arbitration address under this address arbiter.
     void WaitThread(SharedPtr<Thread> thread, VAddr wait_address);
 
-    /// Resume all threads found to be waiting on the address under this address arbiter
-    void ResumeAllThreads(VAddr address);
-
-    /// Resume one thread found to be waiting on the address under this address arbiter and return
-    /// the resumed thread.
-    SharedPtr<Thread> ResumeHighestPriorityThread(VAddr address);
+    /**
+     * Resumes threads waiting on the address under this address arbiter, in priority order.
+     * Threads with the same priority are resumed in the order they started waiting.
+     * @param count number of threads to resume, negative to resume all of them
+     */
+    void ResumeThreads(VAddr address, s32 count);
 
-    /// Threads waiting for the address arbiter to be signaled.
-    std::vector<SharedPtr<Thread>> waiting_threads;
+    /// Threads waiting for the address arbiter to be signaled, by address. Each waiting thread
+    /// holds a reference that is released when it leaves the list.
+    std::unordered_map<VAddr, WaitList> waiting_threads;
 
     friend class KernelSystem;
 };
@@ -18,9 +18,27 @@ HandleTable::HandleTable(KernelSystem& kernel) : kernel{kernel} {
 
 HandleTable::~HandleTable() = default;
 
-Handle HandleTable::Create(SharedPtr<Object> obj) {
+ResultVal<Handle> HandleTable::Create(SharedPtr<Object> obj) {
     DEBUG_ASSERT(obj);
-    return objects.emplace(++handle_counter, std::move(obj)).first->first;
+    u32 slot{next_free_slot};
+    if (slot != MAX_COUNT) {
+        next_free_slot = next_free_slots[slot];
+    } else {
+        if (objects.size() >= MAX_COUNT) {
+            LOG_ERROR(Kernel, "Unable to allocate handle, too many handles are open");
+            return ERR_OUT_OF_HANDLES;
+        }
+        slot = static_cast<u32>(objects.size());
+        objects.emplace_back();
+        generations.emplace_back();
+        next_free_slots.emplace_back();
+    }
+    const u16 generation{next_generation};
+    // Generation 0 marks free slots
+    next_generation = next_generation == MAX_GENERATION ? 1 : next_generation + 1;
+    generations[slot] = generation;
+    objects[slot] = std::move(obj);
+    return MakeResult<Handle>((static_cast<Handle>(generation) << SLOT_BITS) | slot);
 }
 
 ResultVal<Handle> HandleTable::Duplicate(Handle handle) {
@@ -29,32 +47,55 @@ ResultVal<Handle> HandleTable::Duplicate(Handle handle) {
         LOG_ERROR(Kernel, "Tried to duplicate invalid handle {:08X}", handle);
         return ERR_INVALID_HANDLE;
     }
-    return MakeResult<Handle>(Create(std::move(object)));
+    return Create(std::move(object));
 }
 
 ResultCode HandleTable::Close(Handle handle) {
-    if (!IsValid(handle))
+    const u32 slot{FindSlot(handle)};
+    if (slot == MAX_COUNT)
         return ERR_INVALID_HANDLE;
-    objects.erase(handle);
+    generations[slot] = 0;
+    next_free_slots[slot] = static_cast<u16>(next_free_slot);
+    next_free_slot = slot;
+    // Releasing the object may destroy it, which can close other handles, so this is done last
+    auto object{std::move(objects[slot])};
     return RESULT_SUCCESS;
 }
 
 bool HandleTable::IsValid(Handle handle) const {
-    return objects.find(handle) != objects.end();
+    return FindSlot(handle) != MAX_COUNT;
+}
+
+u32 HandleTable::FindSlot(Handle handle) const {
+    const u16 slot{GetSlot(handle)};
+    const u16 generation{GetGeneration(handle)};
+    if (slot >= generations.size() || generation == 0 || generations[slot] != generation)
+        return MAX_COUNT;
+    return slot;
 }
 
 SharedPtr<Object> HandleTable::GetGeneric(Handle handle) const {
+    return GetGenericPointer(handle);
+}
+
+Object* HandleTable::GetGenericPointer(Handle handle) const {
     if (handle == CurrentThread)
         return kernel.GetThreadManager().GetCurrentThread();
     else if (handle == CurrentProcess)
-        return kernel.GetCurrentProcess();
-    if (!IsValid(handle))
+        return kernel.GetCurrentProcess().get();
+    const u32 slot{FindSlot(handle)};
+    if (slot == MAX_COUNT)
         return nullptr;
-    return objects.find(handle)->second;
+    return objects[slot].get();
 }
 
 void HandleTable::Clear() {
+    // Keep the generation counter so that handles from before the clear stay invalid
+    auto old_objects{std::move(objects)};
     objects.clear();
+    generations.clear();
+    next_free_slots.clear();
+    next_free_slot = MAX_COUNT;
 }
 
 } // namespace Kernel
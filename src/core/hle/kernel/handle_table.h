@@ -4,9 +4,8 @@
 
 #pragma once
 
-#include <atomic>
 #include <cstddef>
-#include <map>
+#include <vector>
 #include "common/common_types.h"
 #include "core/hle/kernel/object.h"
 #include "core/hle/result.h"
@@ -22,6 +21,10 @@ enum KernelHandle : Handle {
  * This class allows the creation of Handles, which are references to objects that can be tested
  * for validity and looked up. Here they are used to pass references to kernel objects to/from the
  * emulated process.
+ *
+ * As in the real kernel, a handle is an index into an array of slots combined with the generation
+ * of the slot, which changes every time the slot is reused so that stale handles don't resolve to
+ * new objects. Lookups are a bounds check and a generation compare.
  */
 class HandleTable final : NonCopyable {
 public:
@@ -30,14 +33,16 @@ public:
 
     /**
      * Allocates a handle for the given object.
-     * @return The created Handle
+     * @return The created Handle or one of the following errors:
+     *           - `ERR_OUT_OF_HANDLES`: the table is full.
      */
-    Handle Create(SharedPtr<Object> obj);
+    ResultVal<Handle> Create(SharedPtr<Object> obj);
 
     /**
      * Returns a new handle that points to the same object as the passed in handle.
      * @return The duplicated Handle or one of the following errors:
      *           - `ERR_INVALID_HANDLE`: an invalid handle was passed in.
+     *           - `ERR_OUT_OF_HANDLES`: the table is full.
      */
     ResultVal<Handle> Duplicate(Handle handle);
 
@@ -67,12 +72,53 @@ public:
         return DynamicObjectCast<T>(GetGeneric(handle));
     }
 
+    /**
+     * Looks up a handle without taking a reference. The pointer stays valid only while the
+     * handle is open, so it's meant for uses that don't outlive the current SVC.
+     * @return Pointer to the looked-up object, or `nullptr` if the handle isn't valid.
+     */
+    Object* GetGenericPointer(Handle handle) const;
+
+    /// Looks up a handle while verifying its type, without taking a reference.
+    template <class T>
+    T* GetPointer(Handle handle) const {
+        return DynamicObjectCast<T>(GetGenericPointer(handle));
+    }
+
     /// Closes all handles held in this table.
     void Clear();
 
 private:
-    std::map<Handle, SharedPtr<Object>> objects{};
-    std::atomic<u32> handle_counter{};
+    /// Number of bits of a handle used for the slot index, the generation is stored above them
+    static constexpr u32 SLOT_BITS{15};
+    static constexpr u32 MAX_COUNT{1U << SLOT_BITS};
+    static constexpr u16 MAX_GENERATION{0x7FFF};
+
+    static constexpr u16 GetSlot(Handle handle) {
+        return static_cast<u16>(handle & (MAX_COUNT - 1));
+    }
+
+    static constexpr u16 GetGeneration(Handle handle) {
+        return static_cast<u16>(handle >> SLOT_BITS);
+    }
+
+    /// Returns the slot of a valid handle, or MAX_COUNT
+    u32 FindSlot(Handle handle) const;
+
+    /// Objects of the slots, nullptr for free slots
+    std::vector<SharedPtr<Object>> objects;
+
+    /// Generation of the handle in each slot, 0 for free slots
+    std::vector<u16> generations;
+
+    /// Next free slot of each free slot, forming the free list
+    std::vector<u16> next_free_slots;
+
+    /// Head of the free list, or MAX_COUNT when all allocated slots are in use
+    u32 next_free_slot{MAX_COUNT};
+
+    /// Generation given to the next handle
+    u16 next_generation{1};
 
     KernelSystem& kernel;
 };
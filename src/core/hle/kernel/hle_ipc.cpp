@@ -6,6 +6,7 @@
 #include <vector>
 #include "common/assert.h"
 #include "common/common_types.h"
+#include "common/logging/log.h"
 #include "core/core.h"
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/handle_table.h"
@@ -15,6 +16,36 @@
 
 namespace Kernel {
 
+namespace {
+
+// Static buffer storage of finished requests, kept to reuse its capacity. There's one pool per
+// thread, so that contexts never need to synchronize on it.
+constexpr std::size_t MAX_POOLED_BUFFERS{32};
+constexpr std::size_t MAX_POOLED_CAPACITY{0x10000};
+thread_local std::vector<std::vector<u8>> buffer_pool;
+
+std::vector<u8> AcquireBuffer(std::size_t size) {
+    if (buffer_pool.empty())
+        return std::vector<u8>(size);
+    std::vector<u8> buffer{std::move(buffer_pool.back())};
+    buffer_pool.pop_back();
+    buffer.resize(size);
+    return buffer;
+}
+
+void ReleaseBuffer(std::vector<u8>& buffer) {
+    if (buffer.capacity() == 0 || buffer.capacity() > MAX_POOLED_CAPACITY ||
+        buffer_pool.size() >= MAX_POOLED_BUFFERS) {
+        buffer = {};
+        return;
+    }
+    buffer.clear();
+    buffer_pool.push_back(std::move(buffer));
+    buffer = {};
+}
+
+} // Anonymous namespace
+
 SessionRequestHandler::SessionInfo::SessionInfo(SharedPtr<ServerSession> session,
                                                 std::unique_ptr<SessionDataBase> data)
     : session{std::move(session)}, data{std::move(data)} {}
@@ -36,6 +67,12 @@ SharedPtr<Event> HLERequestContext::SleepClientThread(SharedPtr<Thread> thread,
                                                       const std::string& reason,
                                                       std::chrono::nanoseconds timeout,
                                                       WakeupCallback&& callback) {
+    ++sleep_count;
+    if (timeout.count() > 0)
+        sleep_time += timeout;
+    // The client's memory may change while it sleeps, so take the request buffers now
+    for (u8 id{}; id < IPC::MAX_STATIC_BUFFERS; ++id)
+        GetStaticBuffer(id);
     // Put the client thread to sleep until the wait event is signaled or the timeout expires.
     thread->wakeup_callback = [context = *this, callback](ThreadWakeupReason reason,
                                                           SharedPtr<Thread> thread,
@@ -49,7 +86,9 @@ SharedPtr<Event> HLERequestContext::SleepClientThread(SharedPtr<Thread> thread,
         std::array<u32_le, IPC::COMMAND_BUFFER_LENGTH + 2 * IPC::MAX_STATIC_BUFFERS> cmd_buff;
         Memory::ReadBlock(*process, thread->GetCommandBufferAddress(), cmd_buff.data(),
                           cmd_buff.size() * sizeof(u32));
-        context.WriteToOutgoingCommandBuffer(cmd_buff.data(), *process);
+        const ResultCode result{context.WriteToOutgoingCommandBuffer(cmd_buff.data(), *process)};
+        if (result.IsError())
+            LOG_ERROR(Kernel, "Failed to translate the reply, replied with {:#010X}", result.raw);
         // Copy the translated command buffer back into the thread's command buffer area.
         Memory::WriteBlock(*process, thread->GetCommandBufferAddress(), cmd_buff.data(),
                            cmd_buff.size() * sizeof(u32));
@@ -69,7 +108,10 @@ HLERequestContext::HLERequestContext(SharedPtr<ServerSession> session)
     cmd_buf[0] = 0;
 }
 
-HLERequestContext::~HLERequestContext() = default;
+HLERequestContext::~HLERequestContext() {
+    for (auto& buffer : static_buffers)
+        ReleaseBuffer(buffer.data);
+}
 
 SharedPtr<Object> HLERequestContext::GetIncomingHandle(u32 id_from_cmdbuf) const {
     ASSERT(id_from_cmdbuf < request_handles.size());
@@ -86,11 +128,52 @@ void HLERequestContext::ClearIncomingObjects() {
 }
 
 const std::vector<u8>& HLERequestContext::GetStaticBuffer(u8 buffer_id) const {
-    return static_buffers[buffer_id];
+    auto& buffer{static_buffers[buffer_id]};
+    if (buffer.location == StaticBuffer::Location::Request) {
+        buffer.data = AcquireBuffer(buffer.size);
+        Memory::ReadBlock(*client_process, buffer.address, buffer.data.data(), buffer.size);
+        buffer.location = StaticBuffer::Location::Host;
+    }
+    return buffer.data;
+}
+
+Common::Span<const u8> HLERequestContext::GetStaticBufferView(u8 buffer_id) const {
+    const auto& buffer{static_buffers[buffer_id]};
+    if (buffer.location != StaticBuffer::Location::Host) {
+        const u8* data{Memory::GetContiguousPointer(*client_process, buffer.address, buffer.size)};
+        if (data)
+            return {data, buffer.size};
+        // Buffers reserved in place were contiguous, unless the client unmapped them meanwhile
+        if (buffer.location == StaticBuffer::Location::Reply)
+            return {};
+    }
+    return GetStaticBuffer(buffer_id);
 }
 
 void HLERequestContext::AddStaticBuffer(u8 buffer_id, std::vector<u8> data) {
-    static_buffers[buffer_id] = std::move(data);
+    auto& buffer{static_buffers[buffer_id]};
+    ReleaseBuffer(buffer.data);
+    buffer.data = std::move(data);
+    buffer.location = StaticBuffer::Location::Host;
+}
+
+Common::Span<u8> HLERequestContext::ReserveStaticBuffer(u8 buffer_id, std::size_t size) {
+    auto& buffer{static_buffers[buffer_id]};
+    ReleaseBuffer(buffer.data);
+    IPC::StaticBufferDescInfo target_descriptor{receive_buffers[2 * buffer_id]};
+    const VAddr target_address{receive_buffers[2 * buffer_id + 1]};
+    u8* target{};
+    if (client_process && size <= target_descriptor.size)
+        target = Memory::GetContiguousPointer(*client_process, target_address, size);
+    if (target) {
+        buffer.address = target_address;
+        buffer.size = static_cast<u32>(size);
+        buffer.location = StaticBuffer::Location::Reply;
+        return {target, size};
+    }
+    buffer.data = AcquireBuffer(size);
+    buffer.location = StaticBuffer::Location::Host;
+    return buffer.data;
 }
 
 ResultCode HLERequestContext::PopulateFromIncomingCommandBuffer(const u32_le* src_cmdbuf,
@@ -100,6 +183,10 @@ ResultCode HLERequestContext::PopulateFromIncomingCommandBuffer(const u32_le* sr
     std::size_t command_size{untranslated_size + header.translate_params_size};
     ASSERT(command_size <= IPC::COMMAND_BUFFER_LENGTH); // TODO: Return error
     std::copy_n(src_cmdbuf, untranslated_size, cmd_buf.begin());
+    client_process = &src_process;
+    // The static buffers area is located right after the command buffer area
+    std::copy_n(src_cmdbuf + IPC::COMMAND_BUFFER_LENGTH, receive_buffers.size(),
+                receive_buffers.begin());
     std::size_t i{untranslated_size};
     while (i < command_size) {
         u32 descriptor{cmd_buf[i] = src_cmdbuf[i]};
@@ -129,10 +216,12 @@ ResultCode HLERequestContext::PopulateFromIncomingCommandBuffer(const u32_le* sr
         case IPC::DescriptorType::StaticBuffer: {
             VAddr source_address{src_cmdbuf[i]};
             IPC::StaticBufferDescInfo buffer_info{descriptor};
-            // Copy the input buffer into our own vector and store it.
-            std::vector<u8> data(buffer_info.size);
-            Memory::ReadBlock(src_process, source_address, data.data(), data.size());
-            AddStaticBuffer(buffer_info.buffer_id, std::move(data));
+            // Only remember where the input buffer is, it's read when the handler asks for it
+            auto& buffer{static_buffers[buffer_info.buffer_id]};
+            ReleaseBuffer(buffer.data);
+            buffer.address = source_address;
+            buffer.size = buffer_info.size;
+            buffer.location = StaticBuffer::Location::Request;
             cmd_buf[i++] = source_address;
             break;
         }
@@ -156,6 +245,7 @@ ResultCode HLERequestContext::WriteToOutgoingCommandBuffer(u32_le* dst_cmdbuf,
     std::size_t command_size{untranslated_size + header.translate_params_size};
     ASSERT(command_size <= IPC::COMMAND_BUFFER_LENGTH);
     std::copy_n(cmd_buf.begin(), untranslated_size, dst_cmdbuf);
+    std::vector<Handle> created_handles;
     std::size_t i{untranslated_size};
     while (i < command_size) {
         u32 descriptor{dst_cmdbuf[i] = cmd_buf[i]};
@@ -169,24 +259,40 @@ ResultCode HLERequestContext::WriteToOutgoingCommandBuffer(u32_le* dst_cmdbuf,
             for (u32 j{}; j < num_handles; ++j) {
                 SharedPtr<Object> object{GetIncomingHandle(cmd_buf[i])};
                 Handle handle{};
-                if (object)
-                    // TODO: Figure out the proper error handling for if this fails
-                    handle = dst_process.handle_table.Create(object);
+                if (object) {
+                    auto result{dst_process.handle_table.Create(object)};
+                    if (result.Failed()) {
+                        // Reply with the error instead, without leaking the handles created so
+                        // far
+                        for (Handle created : created_handles)
+                            dst_process.handle_table.Close(created);
+                        dst_cmdbuf[0] = IPC::MakeHeader(header.command_id, 1, 0);
+                        dst_cmdbuf[1] = result.Code().raw;
+                        return result.Code();
+                    }
+                    handle = *result;
+                    created_handles.push_back(handle);
+                }
                 dst_cmdbuf[i++] = handle;
             }
             break;
         }
         case IPC::DescriptorType::StaticBuffer: {
             IPC::StaticBufferDescInfo buffer_info{descriptor};
-            const auto& data{GetStaticBuffer(buffer_info.buffer_id)};
             // Grab the address that the target thread set up to receive the response static buffer
             // and write our data there. The static buffers area is located right after the command
             // buffer area.
             std::size_t static_buffer_offset{IPC::COMMAND_BUFFER_LENGTH +
                                              2 * buffer_info.buffer_id};
-            IPC::StaticBufferDescInfo target_descriptor{dst_cmdbuf[static_buffer_offset]};
             VAddr target_address{dst_cmdbuf[static_buffer_offset + 1]};
-            Memory::WriteBlock(dst_process, target_address, data.data(), data.size());
+            const auto& buffer{static_buffers[buffer_info.buffer_id]};
+            // Buffers reserved in place already hold the reply, if it goes to another receive
+            // buffer they're copied over from where they were written
+            if (buffer.location != StaticBuffer::Location::Reply ||
+                buffer.address != target_address) {
+                const auto data{GetStaticBufferView(buffer_info.buffer_id)};
+                Memory::WriteBlock(dst_process, target_address, data.data(), data.size());
+            }
             dst_cmdbuf[i++] = target_address;
             break;
         }
@@ -227,4 +333,9 @@ void MappedBuffer::Write(const void* src_buffer, std::size_t offset, std::size_t
     Memory::WriteBlock(*process, address + static_cast<VAddr>(offset), src_buffer, size);
 }
 
+u8* MappedBuffer::GetPointer(std::size_t offset, std::size_t size) {
+    ASSERT(offset + size <= this->size);
+    return Memory::GetContiguousPointer(*process, address + static_cast<VAddr>(offset), size);
+}
+
 } // namespace Kernel
@@ -12,6 +12,7 @@
 #include <vector>
 #include <boost/container/small_vector.hpp>
 #include "common/common_types.h"
+#include "common/span.h"
 #include "common/swap.h"
 #include "core/hle/ipc.h"
 #include "core/hle/kernel/object.h"
@@ -102,6 +103,12 @@ public:
     void Read(void* dest_buffer, std::size_t offset, std::size_t size);
     void Write(const void* src_buffer, std::size_t offset, std::size_t size);
 
+    /**
+     * Gets a host pointer to a range of the buffer for accessing it without copying.
+     * @return Pointer to the range, or nullptr if the guest pages aren't contiguous on the host
+     */
+    u8* GetPointer(std::size_t offset, std::size_t size);
+
     std::size_t GetSize() const {
         return size;
     }
@@ -189,6 +196,16 @@ public:
     SharedPtr<Event> SleepClientThread(SharedPtr<Thread> thread, const std::string& reason,
                                        std::chrono::nanoseconds timeout, WakeupCallback&& callback);
 
+    /// Returns how many times SleepClientThread was called while handling this request
+    u32 GetSleepCount() const {
+        return sleep_count;
+    }
+
+    /// Returns the sum of the timeouts SleepClientThread was called with
+    std::chrono::nanoseconds GetSleepTime() const {
+        return sleep_time;
+    }
+
     /**
      * Resolves a object id from the request command buffer into a pointer to an object. See the
      * "HLE handle protocol" section in the class documentation for more details.
@@ -211,15 +228,30 @@ public:
     /**
      * Retrieves the static buffer identified by the input buffer_id. The static buffer *must* have
      * been created in PopulateFromIncomingCommandBuffer by way of an input StaticBuffer descriptor.
+     * The buffer is copied out of the client's memory on the first call.
      */
     const std::vector<u8>& GetStaticBuffer(u8 buffer_id) const;
 
+    /**
+     * Gets a view of the static buffer identified by the input buffer_id, pointing straight into
+     * the client's memory when its pages are contiguous on the host. The view is valid until the
+     * request is answered, and may alias the buffers reserved with ReserveStaticBuffer.
+     */
+    Common::Span<const u8> GetStaticBufferView(u8 buffer_id) const;
+
     /**
      * Sets up a static buffer that will be copied to the target process when the request is
      * translated.
      */
     void AddStaticBuffer(u8 buffer_id, std::vector<u8> data);
 
+    /**
+     * Sets up a static buffer of the given size for the handler to fill in place. If the target
+     * thread's receive buffer is large enough and contiguous on the host, the returned view points
+     * into it and no copy is made when the request is translated.
+     */
+    Common::Span<u8> ReserveStaticBuffer(u8 buffer_id, std::size_t size);
+
     /**
      * Gets a memory interface by the id from the request command buffer. See the "HLE mapped buffer
      * protocol" section in the class documentation for more details.
@@ -232,14 +264,36 @@ public:
     ResultCode WriteToOutgoingCommandBuffer(u32_le* dst_cmdbuf, Process& dst_process) const;
 
 private:
+    struct StaticBuffer {
+        enum class Location : u8 {
+            Host,    ///< The contents are in data
+            Request, ///< Not copied yet from address in the client's memory
+            Reply,   ///< Written in place to the receive buffer at address
+        };
+
+        // Storage comes from a per-thread pool, so it's usually allocated only once per thread
+        std::vector<u8> data;
+        VAddr address{};
+        u32 size{};
+        Location location{};
+    };
+
     std::array<u32, IPC::COMMAND_BUFFER_LENGTH> cmd_buf;
     SharedPtr<ServerSession> session;
+    Process* client_process{};
 
     // TODO: Check common usage of this and optimize size accordingly
     boost::container::small_vector<SharedPtr<Object>, 8> request_handles;
 
     // The static buffers will be created when the IPC request is translated.
-    std::array<std::vector<u8>, IPC::MAX_STATIC_BUFFERS> static_buffers;
+    mutable std::array<StaticBuffer, IPC::MAX_STATIC_BUFFERS> static_buffers;
+
+    // Receive buffer descriptors the client thread set up, in the same layout as in its TLS
+    std::array<u32, 2 * IPC::MAX_STATIC_BUFFERS> receive_buffers{};
+
+    // Emulated delay of the request, for the HLE profiler
+    u32 sleep_count{};
+    std::chrono::nanoseconds sleep_time{};
 
     // The mapped buffers will be created when the IPC request is translated
     boost::container::small_vector<MappedBuffer, 8> request_mapped_buffers;
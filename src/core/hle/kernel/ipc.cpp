@@ -64,8 +64,7 @@ ResultCode TranslateCommandBuffer(SharedPtr<Thread> src_thread, SharedPtr<Thread
                     cmd_buf[i++] = 0;
                     continue;
                 }
-                auto result{dst_process->handle_table.Create(std::move(object))};
-                cmd_buf[i++] = result;
+                CASCADE_RESULT(cmd_buf[i++], dst_process->handle_table.Create(std::move(object)));
             }
             break;
         }
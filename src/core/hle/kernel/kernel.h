@@ -241,8 +241,12 @@ private:
     // info from their parent processes first. Timer manager is destructed after process list
     // because timers are destructed along with process list and they need to clear info from the
     // timer manager.
+    // Memory regions are destructed after process list because processes free their memory on
+    // destruction.
     // TODO: refactor the cleanup sequence to make this less complicated and sensitive.
 
+    std::array<MemoryRegionInfo, 3> memory_regions;
+
     std::unique_ptr<TimerManager> timer_manager;
 
     u32 next_process_id{};
@@ -257,8 +261,6 @@ private:
     std::unique_ptr<ConfigMem::Handler> config_mem_handler;
     std::unique_ptr<SharedPage::Handler> shared_page_handler;
 
-    std::array<MemoryRegionInfo, 3> memory_regions;
-
     Core::System& system;
 };
 
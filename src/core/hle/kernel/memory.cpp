@@ -9,6 +9,7 @@
 #include <utility>
 #include <vector>
 #include "common/assert.h"
+#include "common/bit_util.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "core/core.h"
@@ -153,69 +154,132 @@ void KernelSystem::MapSharedPages(VMManager& address_space) {
     address_space.Reprotect(shared_page_vma, VMAPermission::Read);
 }
 
+static std::size_t GetSizeClass(u32 size) {
+    return Common::MostSignificantBit32(size);
+}
+
+void MemoryRegionInfo::InsertFreeBlock(u32 offset, u32 end) {
+    free_blocks.emplace(offset, end);
+    size_classes[GetSizeClass(end - offset)].insert(offset);
+}
+
+void MemoryRegionInfo::EraseFreeBlock(std::map<u32, u32>::iterator block) {
+    size_classes[GetSizeClass(block->second - block->first)].erase(block->first);
+    free_blocks.erase(block);
+}
+
 void MemoryRegionInfo::Reset(u32 base, u32 size) {
     this->base = base;
     this->size = size;
     used = 0;
     free_blocks.clear();
+    for (auto& size_class : size_classes)
+        size_class.clear();
     // Mark the entire region as free
-    free_blocks.insert(Interval::right_open(base, base + size));
+    if (size != 0)
+        InsertFreeBlock(base, base + size);
 }
 
 MemoryRegionInfo::IntervalSet MemoryRegionInfo::HeapAllocate(u32 size) {
+    if (size == 0 || size > this->size - used) {
+        // There is no enough free space
+        return {};
+    }
     IntervalSet result;
     u32 rest{size};
-    // Try allocating from the higher address
-    for (auto iter{free_blocks.rbegin()}; iter != free_blocks.rend(); ++iter) {
-        ASSERT(iter->bounds() == boost::icl::interval_bounds::right_open());
-        if (iter->upper() - iter->lower() >= rest) {
+    // Allocate from the higher address
+    while (rest != 0) {
+        auto block{std::prev(free_blocks.end())};
+        const u32 block_offset{block->first};
+        const u32 block_end{block->second};
+        EraseFreeBlock(block);
+        if (block_end - block_offset > rest) {
             // Requested size is fulfilled with this block
-            result += Interval(iter->upper() - rest, iter->upper());
-            rest = 0;
+            InsertFreeBlock(block_offset, block_end - rest);
+            result += Interval(block_end - rest, block_end);
             break;
         }
-        result += *iter;
-        rest -= iter->upper() - iter->lower();
-    }
-    if (rest != 0) {
-        // There is no enough free space
-        return {};
+        result += Interval(block_offset, block_end);
+        rest -= block_end - block_offset;
     }
-    free_blocks -= result;
     used += size;
     return result;
 }
 
 bool MemoryRegionInfo::LinearAllocate(u32 offset, u32 size) {
-    Interval interval{offset, offset + size};
-    if (!boost::icl::contains(free_blocks, interval)) {
+    auto block{free_blocks.upper_bound(offset)};
+    if (block == free_blocks.begin())
+        return false;
+    --block;
+    if (block->second < offset + size) {
         // The requested range is already allocated
         return false;
     }
-    free_blocks -= interval;
+    const u32 block_offset{block->first};
+    const u32 block_end{block->second};
+    EraseFreeBlock(block);
+    if (block_offset != offset)
+        InsertFreeBlock(block_offset, offset);
+    if (offset + size != block_end)
+        InsertFreeBlock(offset + size, block_end);
     used += size;
     return true;
 }
 
 std::optional<u32> MemoryRegionInfo::LinearAllocate(u32 size) {
-    // Find the first sufficient continuous block from the lower address
-    for (const auto& interval : free_blocks) {
-        ASSERT(interval.bounds() == boost::icl::interval_bounds::right_open());
-        if (interval.upper() - interval.lower() >= size) {
-            Interval allocated(interval.lower(), interval.lower() + size);
-            free_blocks -= allocated;
-            used += size;
-            return allocated.lower();
+    if (size == 0)
+        return free_blocks.empty() ? std::nullopt : std::make_optional(free_blocks.begin()->first);
+    // Find the first sufficient continuous block from the lower address. Blocks of the larger
+    // classes always fit, only the ones of the same class need their size checked.
+    const std::size_t size_class{GetSizeClass(size)};
+    std::optional<u32> found;
+    for (std::size_t i{size_class + 1}; i < size_classes.size(); ++i)
+        if (!size_classes[i].empty() && (!found || *size_classes[i].begin() < *found))
+            found = *size_classes[i].begin();
+    for (u32 offset : size_classes[size_class]) {
+        if (found && offset >= *found)
+            break;
+        if (free_blocks.at(offset) - offset >= size) {
+            found = offset;
+            break;
         }
     }
-    // No sufficient block found
-    return {};
+    if (!found) {
+        // No sufficient block found
+        return {};
+    }
+    auto block{free_blocks.find(*found)};
+    const u32 block_end{block->second};
+    EraseFreeBlock(block);
+    if (*found + size != block_end)
+        InsertFreeBlock(*found + size, block_end);
+    used += size;
+    return found;
 }
 
 void MemoryRegionInfo::Free(u32 offset, u32 size) {
-    Interval interval(offset, offset + size);
-    ASSERT(!boost::icl::intersects(free_blocks, interval)); // Must be allocated blocks
-    free_blocks += interval;
+    if (size == 0)
+        return;
+    // Hand the pages back to the host until they're allocated again, which zeroes them
+    Memory::fcram.Discard(offset, size);
+    u32 end{offset + size};
+    auto next{free_blocks.lower_bound(offset)};
+    // Must be allocated blocks
+    ASSERT(next == free_blocks.end() || next->first >= end);
+    if (next != free_blocks.end() && next->first == end) {
+        end = next->second;
+        auto merged{next++};
+        EraseFreeBlock(merged);
+    }
+    if (next != free_blocks.begin()) {
+        auto prev{std::prev(next)};
+        ASSERT(prev->second <= offset);
+        if (prev->second == offset) {
+            offset = prev->first;
+            EraseFreeBlock(prev);
+        }
+    }
+    InsertFreeBlock(offset, end);
     used -= size;
 }
 
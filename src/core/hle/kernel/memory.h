@@ -4,7 +4,10 @@
 
 #pragma once
 
+#include <array>
+#include <map>
 #include <optional>
+#include <set>
 #include <boost/icl/interval_set.hpp>
 #include "common/common_types.h"
 
@@ -22,7 +25,15 @@ struct MemoryRegionInfo {
                                                        /// offsets from start of FCRAM
     using Interval = IntervalSet::interval_type;
 
-    IntervalSet free_blocks;
+    /// Free blocks, from their offset to their end. Adjacent free blocks are always merged.
+    std::map<u32, u32> free_blocks;
+
+    /**
+     * Offsets of the free blocks, segregated by the highest set bit of their size. Every block of
+     * a class above the one of a request fits it, so the lowest fitting block is found without
+     * walking the whole free list.
+     */
+    std::array<std::set<u32>, 32> size_classes;
 
     /**
      * Reset the allocator state
@@ -60,6 +71,10 @@ struct MemoryRegionInfo {
      * @param size the size of the region to free.
      */
     void Free(u32 offset, u32 size);
+
+private:
+    void InsertFreeBlock(u32 offset, u32 end);
+    void EraseFreeBlock(std::map<u32, u32>::iterator block);
 };
 
 void HandleSpecialMapping(VMManager& address_space, const AddressMapping& mapping);
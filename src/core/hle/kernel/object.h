@@ -98,4 +98,12 @@ inline SharedPtr<T> DynamicObjectCast(SharedPtr<Object> object) {
     return nullptr;
 }
 
+/// Raw pointer version of DynamicObjectCast, for lookups that don't take a reference
+template <typename T>
+inline T* DynamicObjectCast(Object* object) {
+    if (object && object->GetHandleType() == T::HANDLE_TYPE)
+        return static_cast<T*>(object);
+    return nullptr;
+}
+
 } // namespace Kernel
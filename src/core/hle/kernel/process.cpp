@@ -171,14 +171,14 @@ ResultVal<VAddr> Process::HeapAllocate(VAddr target, u32 size, VMAPermission per
         u32 interval_size{interval.upper() - interval.lower()};
         LOG_DEBUG(Kernel, "Allocated FCRAM region lower={:08X}, upper={:08X}", interval.lower(),
                   interval.upper());
-        std::fill(Memory::fcram.begin() + interval.lower(),
-                  Memory::fcram.begin() + interval.upper(), 0);
+        Memory::fcram.Zero(interval.lower(), interval_size);
         auto vma{vm_manager.MapBackingMemory(
             interval_target, Memory::fcram.data() + interval.lower(), interval_size, memory_state)};
         ASSERT(vma.Succeeded());
         vm_manager.Reprotect(vma.Unwrap(), perms);
         interval_target += interval_size;
     }
+    holding_memory += allocated_fcram;
     memory_used += size;
     resource_limit->current_commit += size;
     return MakeResult<VAddr>(target);
@@ -195,8 +195,11 @@ ResultCode Process::HeapFree(VAddr target, u32 size) {
         return RESULT_SUCCESS;
     // Free heaps block by block
     CASCADE_RESULT(auto backing_blocks, vm_manager.GetBackingBlocksForRange(target, size));
-    for (const auto [backing_memory, block_size] : backing_blocks)
-        memory_region->Free(Memory::GetFCRAMOffset(backing_memory), block_size);
+    for (const auto [backing_memory, block_size] : backing_blocks) {
+        const u32 offset{Memory::GetFCRAMOffset(backing_memory)};
+        memory_region->Free(offset, block_size);
+        holding_memory -= MemoryRegionInfo::Interval(offset, offset + block_size);
+    }
     auto result{vm_manager.UnmapRange(target, size)};
     ASSERT(result.IsSuccess());
     memory_used -= size;
@@ -233,11 +236,12 @@ ResultVal<VAddr> Process::LinearAllocate(VAddr target, u32 size, VMAPermission p
             return ERR_INVALID_ADDRESS_STATE;
         }
     }
+    Memory::fcram.Zero(physical_offset, size);
     u8* backing_memory{Memory::fcram.data() + physical_offset};
-    std::fill(backing_memory, backing_memory + size, 0);
     auto vma{vm_manager.MapBackingMemory(target, backing_memory, size, MemoryState::Continuous)};
     ASSERT(vma.Succeeded());
     vm_manager.Reprotect(vma.Unwrap(), perms);
+    holding_memory += MemoryRegionInfo::Interval(physical_offset, physical_offset + size);
     memory_used += size;
     resource_limit->current_commit += size;
     LOG_DEBUG(Kernel, "Allocated at target={:08X}", target);
@@ -262,6 +266,7 @@ ResultCode Process::LinearFree(VAddr target, u32 size) {
     resource_limit->current_commit -= size;
     u32 physical_offset{target - GetLinearHeapAreaAddress()}; // Relative to FCRAM
     memory_region->Free(physical_offset, size);
+    holding_memory -= MemoryRegionInfo::Interval(physical_offset, physical_offset + size);
     return RESULT_SUCCESS;
 }
 
@@ -338,7 +343,16 @@ ResultCode Process::Unmap(VAddr target, VAddr source, u32 size, VMAPermission pe
 
 Kernel::Process::Process(KernelSystem& kernel)
     : Object{kernel}, handle_table{kernel}, kernel{kernel} {}
-Kernel::Process::~Process() {}
+Kernel::Process::~Process() {
+    // Return the memory still allocated to the process, which hands its pages back to the host
+    for (const auto& interval : holding_memory)
+        memory_region->Free(interval.lower(), interval.upper() - interval.lower());
+    for (const auto& interval : holding_tls_memory)
+        kernel.GetMemoryRegion(MemoryRegion::Base)
+            ->Free(interval.lower(), interval.upper() - interval.lower());
+    if (resource_limit)
+        resource_limit->current_commit -= static_cast<s32>(boost::icl::length(holding_memory));
+}
 
 SharedPtr<Process> KernelSystem::GetProcessById(u32 process_id) const {
     auto itr{std::find_if(
@@ -14,6 +14,7 @@
 #include "common/bit_field.h"
 #include "common/common_types.h"
 #include "core/hle/kernel/handle_table.h"
+#include "core/hle/kernel/memory.h"
 #include "core/hle/kernel/object.h"
 #include "core/hle/kernel/vm_manager.h"
 
@@ -173,6 +174,12 @@ public:
 
     MemoryRegionInfo* memory_region{};
 
+    /// FCRAM allocated as heap and linear heap, which is freed when the process is destroyed
+    MemoryRegionInfo::IntervalSet holding_memory;
+
+    /// FCRAM of the TLS pages, which are allocated from the Base region
+    MemoryRegionInfo::IntervalSet holding_tls_memory;
+
     /// The Thread Local Storage area is allocated as processes create threads,
     /// each TLS area is 0x200 bytes, so one page (0x1000) is split up in 8 parts, and each part
     /// holds the TLS for a specific thread. This vector contains which parts are in use for each
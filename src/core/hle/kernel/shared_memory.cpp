@@ -37,7 +37,7 @@ ResultVal<SharedPtr<SharedMemory>> KernelSystem::CreateSharedMemory(
         auto memory_region{GetMemoryRegion(region)};
         auto offset{memory_region->LinearAllocate(size)};
         ASSERT_MSG(offset, "Not enough space in region to allocate shared memory!");
-        std::fill(Memory::fcram.data() + *offset, Memory::fcram.data() + *offset + size, 0);
+        Memory::fcram.Zero(*offset, size);
         shared_memory->backing_blocks = {{Memory::fcram.data() + *offset, size}};
         shared_memory->holding_memory += MemoryRegionInfo::Interval(*offset, *offset + size);
         shared_memory->linear_heap_phys_offset = *offset;
@@ -75,8 +75,7 @@ SharedPtr<SharedMemory> KernelSystem::CreateSharedMemoryForApplet(
     for (const auto& interval : backing_blocks) {
         shared_memory->backing_blocks.push_back(
             {Memory::fcram.data() + interval.lower(), interval.upper() - interval.lower()});
-        std::fill(Memory::fcram.data() + interval.lower(), Memory::fcram.data() + interval.upper(),
-                  0);
+        Memory::fcram.Zero(interval.lower(), interval.upper() - interval.lower());
     }
     shared_memory->base_address = Memory::HEAP_VADDR + offset;
     return shared_memory;
@@ -7,6 +7,7 @@
 #include <map>
 #include <fmt/format.h>
 #include "common/logging/log.h"
+#include "common/profiling.h"
 #include "common/scope_exit.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -34,8 +35,10 @@
 #include "core/hle/kernel/vm_manager.h"
 #include "core/hle/kernel/wait_object.h"
 #include "core/hle/lock.h"
+#include "core/hle/profiler.h"
 #include "core/hle/result.h"
 #include "core/hle/service/service.h"
+#include "core/idle_detector.h"
 
 namespace Kernel {
 
@@ -107,6 +110,9 @@ private:
 
     friend class SVCWrapper<SVC>;
 
+    /// Reports a poll of the current thread that didn't block to the idle detector
+    void ReportPoll(Core::PollKind kind);
+
     // ARM interfaces
 
     u32 GetReg(std::size_t n);
@@ -330,7 +336,7 @@ ResultCode SVC::ConnectToPort(Handle* out_handle, VAddr port_name_address) {
     SharedPtr<ClientSession> client_session;
     CASCADE_RESULT(client_session, client_port->Connect());
     // Return the client session
-    *out_handle = kernel.GetCurrentProcess()->handle_table.Create(client_session);
+    CASCADE_RESULT(*out_handle, kernel.GetCurrentProcess()->handle_table.Create(client_session));
     return RESULT_SUCCESS;
 }
 
@@ -359,8 +365,10 @@ ResultCode SVC::WaitSynchronization1(Handle handle, s64 nano_seconds) {
     LOG_TRACE(Kernel_SVC, "handle=0x{:08X}({}:{}), nanoseconds={}", handle, object->GetTypeName(),
               object->GetName(), nano_seconds);
     if (object->ShouldWait(thread)) {
-        if (nano_seconds == 0)
+        if (nano_seconds == 0) {
+            ReportPoll(Core::PollKind::WaitSynchronization);
             return RESULT_TIMEOUT;
+        }
         thread->wait_objects = {object};
         object->AddWaitingThread(thread);
         thread->status = ThreadStatus::WaitSynchAny;
@@ -424,8 +432,10 @@ ResultCode SVC::WaitSynchronizationN(s32* out, VAddr handles_address, s32 handle
         // Not all objects were available right now, prepare to suspend the thread.
         // If a timeout value of 0 was provided, just return the Timeout error code instead of
         // suspending the thread.
-        if (nano_seconds == 0)
+        if (nano_seconds == 0) {
+            ReportPoll(Core::PollKind::WaitSynchronization);
             return RESULT_TIMEOUT;
+        }
         // Put the thread to sleep
         thread->status = ThreadStatus::WaitSynchAll;
         // Add the thread to each of the objects' waiting threads.
@@ -466,8 +476,10 @@ ResultCode SVC::WaitSynchronizationN(s32* out, VAddr handles_address, s32 handle
         // No objects were ready to be acquired, prepare to suspend the thread.
         // If a timeout value of 0 was provided, just return the Timeout error code instead of
         // suspending the thread.
-        if (nano_seconds == 0)
+        if (nano_seconds == 0) {
+            ReportPoll(Core::PollKind::WaitSynchronization);
             return RESULT_TIMEOUT;
+        }
         // Put the thread to sleep
         thread->status = ThreadStatus::WaitSynchAny;
         // Add the thread to each of the objects' waiting threads.
@@ -618,7 +630,8 @@ ResultCode SVC::ReplyAndReceive(s32* index, VAddr handles_address, s32 handle_co
 /// Create an address arbiter (to allocate access to shared resources)
 ResultCode SVC::CreateAddressArbiter(Handle* out_handle) {
     auto arbiter{kernel.CreateAddressArbiter()};
-    *out_handle = kernel.GetCurrentProcess()->handle_table.Create(std::move(arbiter));
+    CASCADE_RESULT(*out_handle,
+                   kernel.GetCurrentProcess()->handle_table.Create(std::move(arbiter)));
     LOG_TRACE(Kernel_SVC, "returned handle: 0x{:08X}", *out_handle);
     return RESULT_SUCCESS;
 }
@@ -627,12 +640,16 @@ ResultCode SVC::CreateAddressArbiter(Handle* out_handle) {
 ResultCode SVC::ArbitrateAddress(Handle handle, u32 address, u32 type, u32 value, s64 nanoseconds) {
     LOG_TRACE(Kernel_SVC, "handle=0x{:08X}, address=0x{:08X}, type=0x{:08X}, value=0x{:08X}",
               handle, address, type, value);
-    auto arbiter{kernel.GetCurrentProcess()->handle_table.Get<AddressArbiter>(handle)};
+    auto arbiter{kernel.GetCurrentProcess()->handle_table.GetPointer<AddressArbiter>(handle)};
     if (!arbiter)
         return ERR_INVALID_HANDLE;
-    auto res{arbiter->ArbitrateAddress(kernel.GetThreadManager().GetCurrentThread(),
-                                       static_cast<ArbitrationType>(type), address, value,
+    auto thread{kernel.GetThreadManager().GetCurrentThread()};
+    auto res{arbiter->ArbitrateAddress(thread, static_cast<ArbitrationType>(type), address, value,
                                        nanoseconds)};
+    // A wait arbitration that didn't put the thread to sleep is a poll
+    if (static_cast<ArbitrationType>(type) != ArbitrationType::Signal &&
+        thread->status == ThreadStatus::Running)
+        ReportPoll(Core::PollKind::ArbitrateAddress);
     // TODO: Identify in which specific cases this call should cause a reschedule.
     system.PrepareReschedule();
     return res;
@@ -674,7 +691,7 @@ ResultCode SVC::GetResourceLimit(Handle* resource_limit, Handle process_handle)
     auto process{current_process->handle_table.Get<Process>(process_handle)};
     if (!process)
         return ERR_INVALID_HANDLE;
-    *resource_limit = current_process->handle_table.Create(process->resource_limit);
+    CASCADE_RESULT(*resource_limit, current_process->handle_table.Create(process->resource_limit));
     return RESULT_SUCCESS;
 }
 
@@ -751,7 +768,13 @@ ResultCode SVC::CreateThread(Handle* out_handle, u32 entry_point, u32 arg, VAddr
                                                     stack_top, *current_process));
     thread->context->SetFpscr(FPSCR_DEFAULT_NAN | FPSCR_FLUSH_TO_ZERO |
                               FPSCR_ROUND_TOZERO); // 0x03C00000
-    *out_handle = current_process->handle_table.Create(std::move(thread));
+    auto handle{current_process->handle_table.Create(thread)};
+    if (handle.Failed()) {
+        // The thread is already scheduled, it mustn't run without a handle to it
+        thread->Stop();
+        return handle.Code();
+    }
+    *out_handle = *handle;
     system.PrepareReschedule();
     LOG_TRACE(Kernel_SVC,
               "entrypoint=0x{:08X} ({}), arg=0x{:08X}, stacktop=0x{:08X}, "
@@ -769,7 +792,7 @@ void SVC::ExitThread() {
 
 /// Gets the priority for the specified thread
 ResultCode SVC::GetThreadPriority(u32* priority, Handle handle) {
-    const auto thread{kernel.GetCurrentProcess()->handle_table.Get<Thread>(handle)};
+    const auto thread{kernel.GetCurrentProcess()->handle_table.GetPointer<Thread>(handle)};
     if (!thread)
         return ERR_INVALID_HANDLE;
     *priority = thread->GetPriority();
@@ -780,7 +803,7 @@ ResultCode SVC::GetThreadPriority(u32* priority, Handle handle) {
 ResultCode SVC::SetThreadPriority(Handle handle, u32 priority) {
     if (priority > ThreadPrioLowest)
         return ERR_OUT_OF_RANGE;
-    auto thread{kernel.GetCurrentProcess()->handle_table.Get<Thread>(handle)};
+    auto thread{kernel.GetCurrentProcess()->handle_table.GetPointer<Thread>(handle)};
     if (!thread)
         return ERR_INVALID_HANDLE;
     // Note: The kernel uses the current process's resource limit instead of
@@ -801,7 +824,7 @@ ResultCode SVC::SetThreadPriority(Handle handle, u32 priority) {
 ResultCode SVC::CreateMutex(Handle* out_handle, u32 initial_locked) {
     auto mutex{kernel.CreateMutex(initial_locked != 0)};
     mutex->name = fmt::format("mutex-{:08x}", system.CPU().GetReg(14));
-    *out_handle = kernel.GetCurrentProcess()->handle_table.Create(std::move(mutex));
+    CASCADE_RESULT(*out_handle, kernel.GetCurrentProcess()->handle_table.Create(std::move(mutex)));
     LOG_TRACE(Kernel_SVC, "initial_locked={}, created handle: 0x{:08X}",
               initial_locked ? "true" : "false", *out_handle);
     return RESULT_SUCCESS;
@@ -810,7 +833,7 @@ ResultCode SVC::CreateMutex(Handle* out_handle, u32 initial_locked) {
 /// Release a mutex
 ResultCode SVC::ReleaseMutex(Handle handle) {
     LOG_TRACE(Kernel_SVC, "handle=0x{:08X}", handle);
-    auto mutex{kernel.GetCurrentProcess()->handle_table.Get<Mutex>(handle)};
+    auto mutex{kernel.GetCurrentProcess()->handle_table.GetPointer<Mutex>(handle)};
     if (!mutex)
         return ERR_INVALID_HANDLE;
     return mutex->Release(kernel.GetThreadManager().GetCurrentThread());
@@ -819,7 +842,8 @@ ResultCode SVC::ReleaseMutex(Handle handle) {
 /// Get the ID of the specified process
 ResultCode SVC::GetProcessId(u32* process_id, Handle process_handle) {
     LOG_TRACE(Kernel_SVC, "process=0x{:08X}", process_handle);
-    const auto process{kernel.GetCurrentProcess()->handle_table.Get<Process>(process_handle)};
+    const auto process{
+        kernel.GetCurrentProcess()->handle_table.GetPointer<Process>(process_handle)};
     if (!process)
         return ERR_INVALID_HANDLE;
     *process_id = process->process_id;
@@ -829,7 +853,7 @@ ResultCode SVC::GetProcessId(u32* process_id, Handle process_handle) {
 /// Get the ID of the process that owns the specified thread
 ResultCode SVC::GetProcessIdOfThread(u32* process_id, Handle thread_handle) {
     LOG_TRACE(Kernel_SVC, "thread=0x{:08X}", thread_handle);
-    const auto thread{kernel.GetCurrentProcess()->handle_table.Get<Thread>(thread_handle)};
+    const auto thread{kernel.GetCurrentProcess()->handle_table.GetPointer<Thread>(thread_handle)};
     if (!thread)
         return ERR_INVALID_HANDLE;
     const auto process{thread->owner_process};
@@ -841,7 +865,7 @@ ResultCode SVC::GetProcessIdOfThread(u32* process_id, Handle thread_handle) {
 /// Get the ID for the specified thread.
 ResultCode SVC::GetThreadId(u32* thread_id, Handle handle) {
     LOG_TRACE(Kernel_SVC, "thread=0x{:08X}", handle);
-    const auto thread{kernel.GetCurrentProcess()->handle_table.Get<Thread>(handle)};
+    const auto thread{kernel.GetCurrentProcess()->handle_table.GetPointer<Thread>(handle)};
     if (!thread)
         return ERR_INVALID_HANDLE;
     *thread_id = thread->GetThreadId();
@@ -852,7 +876,8 @@ ResultCode SVC::GetThreadId(u32* thread_id, Handle handle) {
 ResultCode SVC::CreateSemaphore(Handle* out_handle, s32 initial_count, s32 max_count) {
     CASCADE_RESULT(auto semaphore, kernel.CreateSemaphore(initial_count, max_count));
     semaphore->name = fmt::format("semaphore-{:08x}", system.CPU().GetReg(14));
-    *out_handle = kernel.GetCurrentProcess()->handle_table.Create(std::move(semaphore));
+    CASCADE_RESULT(*out_handle,
+                   kernel.GetCurrentProcess()->handle_table.Create(std::move(semaphore)));
     LOG_TRACE(Kernel_SVC, "initial_count={}, max_count={}, created handle=0x{:08X}", initial_count,
               max_count, *out_handle);
     return RESULT_SUCCESS;
@@ -861,7 +886,7 @@ ResultCode SVC::CreateSemaphore(Handle* out_handle, s32 initial_count, s32 max_c
 /// Releases a certain number of slots in a semaphore
 ResultCode SVC::ReleaseSemaphore(s32* count, Handle handle, s32 release_count) {
     LOG_TRACE(Kernel_SVC, "release_count={}, handle=0x{:08X}", release_count, handle);
-    auto semaphore{kernel.GetCurrentProcess()->handle_table.Get<Semaphore>(handle)};
+    auto semaphore{kernel.GetCurrentProcess()->handle_table.GetPointer<Semaphore>(handle)};
     if (!semaphore)
         return ERR_INVALID_HANDLE;
     CASCADE_RESULT(*count, semaphore->Release(release_count));
@@ -871,7 +896,7 @@ ResultCode SVC::ReleaseSemaphore(s32* count, Handle handle, s32 release_count) {
 /// Query process memory
 ResultCode SVC::QueryProcessMemory(MemoryInfo* memory_info, PageInfo* page_info,
                                    Handle process_handle, u32 addr) {
-    auto process{kernel.GetCurrentProcess()->handle_table.Get<Process>(process_handle)};
+    auto process{kernel.GetCurrentProcess()->handle_table.GetPointer<Process>(process_handle)};
     if (!process)
         return ERR_INVALID_HANDLE;
     auto vma{process->vm_manager.FindVMA(addr)};
@@ -907,7 +932,7 @@ ResultCode SVC::QueryMemory(MemoryInfo* memory_info, PageInfo* page_info, u32 ad
 ResultCode SVC::CreateEvent(Handle* out_handle, u32 reset_type) {
     auto evt{kernel.CreateEvent(static_cast<ResetType>(reset_type),
                                 fmt::format("event-{:08x}", system.CPU().GetReg(14)))};
-    *out_handle = kernel.GetCurrentProcess()->handle_table.Create(std::move(evt));
+    CASCADE_RESULT(*out_handle, kernel.GetCurrentProcess()->handle_table.Create(std::move(evt)));
     LOG_TRACE(Kernel_SVC, "reset_type=0x{:08X}. created handle: 0x{:08X}", reset_type, *out_handle);
     return RESULT_SUCCESS;
 }
@@ -922,7 +947,7 @@ ResultCode SVC::DuplicateHandle(Handle* out, Handle handle) {
 /// Signals an event
 ResultCode SVC::SignalEvent(Handle handle) {
     LOG_TRACE(Kernel_SVC, "event=0x{:08X}", handle);
-    auto evt{kernel.GetCurrentProcess()->handle_table.Get<Event>(handle)};
+    auto evt{kernel.GetCurrentProcess()->handle_table.GetPointer<Event>(handle)};
     if (!evt)
         return ERR_INVALID_HANDLE;
     evt->Signal();
@@ -932,7 +957,7 @@ ResultCode SVC::SignalEvent(Handle handle) {
 /// Clears an event
 ResultCode SVC::ClearEvent(Handle handle) {
     LOG_TRACE(Kernel_SVC, "event=0x{:08X}", handle);
-    auto evt{kernel.GetCurrentProcess()->handle_table.Get<Event>(handle)};
+    auto evt{kernel.GetCurrentProcess()->handle_table.GetPointer<Event>(handle)};
     if (!evt)
         return ERR_INVALID_HANDLE;
     evt->Clear();
@@ -943,7 +968,7 @@ ResultCode SVC::ClearEvent(Handle handle) {
 ResultCode SVC::CreateTimer(Handle* out_handle, u32 reset_type) {
     auto timer{kernel.CreateTimer(static_cast<ResetType>(reset_type),
                                   fmt ::format("timer-{:08x}", system.CPU().GetReg(14)))};
-    *out_handle = kernel.GetCurrentProcess()->handle_table.Create(std::move(timer));
+    CASCADE_RESULT(*out_handle, kernel.GetCurrentProcess()->handle_table.Create(std::move(timer)));
     LOG_TRACE(Kernel_SVC, "reset_type=0x{:08X}, created handle: 0x{:08X}", reset_type, *out_handle);
     return RESULT_SUCCESS;
 }
@@ -951,7 +976,7 @@ ResultCode SVC::CreateTimer(Handle* out_handle, u32 reset_type) {
 /// Clears a timer
 ResultCode SVC::ClearTimer(Handle handle) {
     LOG_TRACE(Kernel_SVC, "timer=0x{:08X}", handle);
-    auto timer{kernel.GetCurrentProcess()->handle_table.Get<Timer>(handle)};
+    auto timer{kernel.GetCurrentProcess()->handle_table.GetPointer<Timer>(handle)};
     if (!timer)
         return ERR_INVALID_HANDLE;
     timer->Clear();
@@ -963,7 +988,7 @@ ResultCode SVC::SetTimer(Handle handle, s64 initial, s64 interval) {
     LOG_TRACE(Kernel_SVC, "timer=0x{:08X}", handle);
     if (initial < 0 || interval < 0)
         return ERR_OUT_OF_RANGE_KERNEL;
-    auto timer{kernel.GetCurrentProcess()->handle_table.Get<Timer>(handle)};
+    auto timer{kernel.GetCurrentProcess()->handle_table.GetPointer<Timer>(handle)};
     if (!timer)
         return ERR_INVALID_HANDLE;
     timer->Set(initial, interval);
@@ -973,7 +998,7 @@ ResultCode SVC::SetTimer(Handle handle, s64 initial, s64 interval) {
 /// Cancels a timer
 ResultCode SVC::CancelTimer(Handle handle) {
     LOG_TRACE(Kernel_SVC, "timer=0x{:08X}", handle);
-    auto timer{kernel.GetCurrentProcess()->handle_table.Get<Timer>(handle)};
+    auto timer{kernel.GetCurrentProcess()->handle_table.GetPointer<Timer>(handle)};
     if (!timer)
         return ERR_INVALID_HANDLE;
     timer->Cancel();
@@ -986,8 +1011,10 @@ void SVC::SleepThread(s64 nanoseconds) {
     auto& thread_manager{kernel.GetThreadManager()};
     // Don't attempt to yield execution if there are no available threads to run,
     // this way we avoid a useless reschedule to the idle thread.
-    if (nanoseconds == 0 && !thread_manager.HaveReadyThreads())
+    if (nanoseconds == 0 && !thread_manager.HaveReadyThreads()) {
+        ReportPoll(Core::PollKind::SleepThread);
         return;
+    }
     // Sleep current thread and check for next thread to schedule
     thread_manager.WaitCurrentThread_Sleep();
     // Create an event to wake the thread up after the specified nanosecond delay has passed
@@ -1002,6 +1029,7 @@ s64 SVC::GetSystemTick() {
     // Advance time to defeat dumb games (like Cubic Ninja) that busy-wait for the frame to end.
     // Measured time between two calls on a 9.2 o3DS with Ninjhax 1.1b
     timing.AddTicks(150);
+    ReportPoll(Core::PollKind::GetSystemTick);
     return result;
 }
 
@@ -1044,7 +1072,7 @@ ResultCode SVC::CreateMemoryBlock(Handle* out_handle, u32 addr, u32 size, u32 my
                    kernel.CreateSharedMemory(
                        current_process.get(), size, static_cast<MemoryPermission>(my_permission),
                        static_cast<MemoryPermission>(other_permission), addr, region));
-    *out_handle = current_process->handle_table.Create(std::move(shared_memory));
+    CASCADE_RESULT(*out_handle, current_process->handle_table.Create(std::move(shared_memory)));
     LOG_WARNING(Kernel_SVC, "called addr=0x{:08X}", addr);
     return RESULT_SUCCESS;
 }
@@ -1055,10 +1083,15 @@ ResultCode SVC::CreatePort(Handle* server_port, Handle* client_port, VAddr name_
     ASSERT_MSG(name_address == 0, "Named ports are currently unimplemented");
     auto current_process{kernel.GetCurrentProcess()};
     auto ports{kernel.CreatePortPair(max_sessions)};
-    *client_port =
-        current_process->handle_table.Create(std::move(std::get<SharedPtr<ClientPort>>(ports)));
-    *server_port =
-        current_process->handle_table.Create(std::move(std::get<SharedPtr<ServerPort>>(ports)));
+    CASCADE_RESULT(*client_port, current_process->handle_table.Create(
+                                     std::move(std::get<SharedPtr<ClientPort>>(ports))));
+    auto server_handle{
+        current_process->handle_table.Create(std::move(std::get<SharedPtr<ServerPort>>(ports)))};
+    if (server_handle.Failed()) {
+        current_process->handle_table.Close(*client_port);
+        return server_handle.Code();
+    }
+    *server_port = *server_handle;
     LOG_TRACE(Kernel_SVC, "max_sessions={}", max_sessions);
     return RESULT_SUCCESS;
 }
@@ -1069,7 +1102,7 @@ ResultCode SVC::CreateSessionToPort(Handle* out_client_session, Handle client_po
     if (!client_port)
         return ERR_INVALID_HANDLE;
     CASCADE_RESULT(auto session, client_port->Connect());
-    *out_client_session = current_process->handle_table.Create(std::move(session));
+    CASCADE_RESULT(*out_client_session, current_process->handle_table.Create(std::move(session)));
     return RESULT_SUCCESS;
 }
 
@@ -1077,9 +1110,14 @@ ResultCode SVC::CreateSession(Handle* server_session, Handle* client_session) {
     auto sessions{kernel.CreateSessionPair()};
     auto current_process{kernel.GetCurrentProcess()};
     auto& server{std::get<SharedPtr<ServerSession>>(sessions)};
-    *server_session = current_process->handle_table.Create(std::move(server));
+    CASCADE_RESULT(*server_session, current_process->handle_table.Create(std::move(server)));
     auto& client{std::get<SharedPtr<ClientSession>>(sessions)};
-    *client_session = current_process->handle_table.Create(std::move(client));
+    auto client_handle{current_process->handle_table.Create(std::move(client))};
+    if (client_handle.Failed()) {
+        current_process->handle_table.Close(*server_session);
+        return client_handle.Code();
+    }
+    *client_session = *client_handle;
     LOG_TRACE(Kernel_SVC, "called");
     return RESULT_SUCCESS;
 }
@@ -1090,7 +1128,7 @@ ResultCode SVC::AcceptSession(Handle* out_server_session, Handle server_port_han
     if (!server_port)
         return ERR_INVALID_HANDLE;
     CASCADE_RESULT(auto session, server_port->Accept());
-    *out_server_session = current_process->handle_table.Create(std::move(session));
+    CASCADE_RESULT(*out_server_session, current_process->handle_table.Create(std::move(session)));
     return RESULT_SUCCESS;
 }
 
@@ -1321,11 +1359,22 @@ void SVC::CallSVC(u32 immediate) {
     DEBUG_ASSERT_MSG(kernel.GetCurrentProcess()->status == ProcessStatus::Running,
                      "Running threads from exiting processes is unimplemented");
     const auto info{GetSVCInfo(immediate)};
+    PROFILE_SCOPE("kernel", info ? info->name : "UnknownSVC");
+    system.GetHLEProfiler().RecordSVC(immediate);
+    auto& idle_detector{system.GetIdleDetector()};
+    idle_detector.BeginSVC();
     if (info)
         if (info->func)
             (this->*(info->func))();
         else
             LOG_ERROR(Kernel_SVC, "unimplemented SVC function {}", info->name);
+    idle_detector.EndSVC();
+}
+
+void SVC::ReportPoll(Core::PollKind kind) {
+    auto& thread_manager{kernel.GetThreadManager()};
+    system.GetIdleDetector().OnPoll(kind, thread_manager.GetCurrentThread()->GetThreadId(),
+                                    thread_manager.HaveReadyThreads());
 }
 
 SVC::SVC(Core::System& system) : system{system}, kernel{system.Kernel()} {}
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
 #include <list>
 #include <unordered_map>
 #include <vector>
@@ -11,6 +12,7 @@
 #include "common/logging/log.h"
 #include "common/math_util.h"
 #include "core/core.h"
+#include "core/hle/kernel/address_arbiter.h"
 #include "core/hle/kernel/errors.h"
 #include "core/hle/kernel/handle_table.h"
 #include "core/hle/kernel/kernel.h"
@@ -53,6 +55,9 @@ void Thread::Stop() {
     // This is only needed when the thread is termintated forcefully (SVC TerminateProcess)
     if (status == ThreadStatus::Ready)
         thread_manager.ready_queue.remove(current_priority, this);
+    // Clean up thread from the wait list of the arbiter it's waiting on
+    if (wait_arbiter)
+        wait_arbiter->RemoveWaitingThread(this);
     status = ThreadStatus::Dead;
     WakeupAllWaitingThreads();
     // Clean up any dangling references in objects that this thread was waiting for
@@ -70,13 +75,27 @@ void Thread::Stop() {
 
 /// Boost low priority threads (temporarily) that have been starved
 void ThreadManager::PriorityBoostStarvedThreads() {
+    const u64 boost_timeout{2000000}; // Boost threads that have been ready for > this long
     u64 current_ticks{system.CoreTiming().GetTicks()};
-    for (auto& thread : thread_list) {
-        const u64 boost_timeout{2000000}; // Boost threads that have been ready for > this long
-        u64 delta{current_ticks - thread->last_running_ticks};
-        if (thread->status == Kernel::ThreadStatus::Ready && delta > boost_timeout) {
-            const u32 priority{std::max(ready_queue.get_first()->current_priority - 1, 40u)};
-            thread->BoostPriority(priority);
+    // Only ready threads can starve. Boosted threads are moved to the back of another level, so
+    // each level is only walked up to its last thread from before the scan.
+    std::array<Thread*, ThreadPrioLowest + 1> last_threads;
+    for (u32 level{}; level <= ThreadPrioLowest; ++level)
+        last_threads[level] = ready_queue.back(level);
+    for (u32 level{}; level <= ThreadPrioLowest; ++level) {
+        if (!last_threads[level])
+            continue;
+        for (Thread* thread{ready_queue.front(level)};;) {
+            Thread* next{thread->queue_hook.next};
+            const bool is_last{thread == last_threads[level]};
+            u64 delta{current_ticks - thread->last_running_ticks};
+            if (delta > boost_timeout) {
+                const u32 priority{std::max(ready_queue.get_first()->current_priority - 1, 40u)};
+                thread->BoostPriority(priority);
+            }
+            if (is_last)
+                break;
+            thread = next;
         }
     }
 }
@@ -268,7 +287,6 @@ ResultVal<SharedPtr<Thread>> KernelSystem::CreateThread(std::string name, VAddr
     }
     SharedPtr<Thread> thread{new Thread(*this)};
     thread_manager->thread_list.push_back(thread);
-    thread_manager->ready_queue.prepare(priority);
     thread->thread_id = thread_manager->NewThreadId();
     thread->status = ThreadStatus::Dormant;
     thread->entry_point = entry_point;
@@ -296,6 +314,8 @@ ResultVal<SharedPtr<Thread>> KernelSystem::CreateThread(std::string name, VAddr
             return ERR_OUT_OF_MEMORY;
         }
         owner_process.memory_used += Memory::PAGE_SIZE;
+        owner_process.holding_tls_memory +=
+            MemoryRegionInfo::Interval(*offset, *offset + Memory::PAGE_SIZE);
         tls_slots.emplace_back(0); // The page is completely available at the start
         available_page = tls_slots.size() - 1;
         available_slot = 0; // Use the first slot in the new page
@@ -324,9 +344,9 @@ void Thread::SetPriority(u32 priority) {
     // If thread was ready, adjust queues
     if (status == ThreadStatus::Ready)
         thread_manager.ready_queue.move(this, current_priority, priority);
-    else
-        thread_manager.ready_queue.prepare(priority);
     nominal_priority = current_priority = priority;
+    if (wait_arbiter)
+        wait_arbiter->UpdateThreadPriority(this);
 }
 
 void Thread::UpdatePriority() {
@@ -341,9 +361,9 @@ void Thread::BoostPriority(u32 priority) {
     // If thread was ready, adjust queues
     if (status == ThreadStatus::Ready)
         thread_manager.ready_queue.move(this, current_priority, priority);
-    else
-        thread_manager.ready_queue.prepare(priority);
     current_priority = priority;
+    if (wait_arbiter)
+        wait_arbiter->UpdateThreadPriority(this);
 }
 
 SharedPtr<Thread> SetupMainThread(KernelSystem& kernel, u32 entry_point, u32 priority,
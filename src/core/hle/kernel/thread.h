@@ -22,6 +22,7 @@ class System;
 
 namespace Kernel {
 
+class AddressArbiter;
 class Mutex;
 class Process;
 
@@ -114,7 +115,7 @@ private:
 
     u32 next_thread_id{1};
     SharedPtr<Thread> current_thread;
-    Common::ThreadQueueList<Thread*, ThreadPrioLowest + 1> ready_queue;
+    Common::ThreadQueueList<Thread, ThreadPrioLowest + 1> ready_queue;
     std::unordered_map<u64, Thread*> wakeup_callback_table;
 
     /// Event type for the thread wake up event
@@ -257,6 +258,8 @@ public:
 
     u64 last_running_ticks; ///< CPU tick when thread was last running
 
+    Common::ThreadQueueHook<Thread> queue_hook; ///< Links in the ready queue while ready
+
     s32 processor_id;
 
     VAddr tls_address; ///< Virtual address of the Thread Local Storage of the thread
@@ -275,6 +278,9 @@ public:
 
     VAddr wait_address; ///< If waiting on an AddressArbiter, this is the arbitration address
 
+    AddressArbiter* wait_arbiter{};                 ///< AddressArbiter the thread is waiting on
+    Common::ThreadQueueHook<Thread> arbiter_hook; ///< Links in the arbiter's wait list
+
     std::string name;
 
     using WakeupCallback = void(ThreadWakeupReason reason, SharedPtr<Thread> thread,
@@ -44,6 +44,7 @@ VMManager::~VMManager() {
 
 void VMManager::Reset() {
     vma_map.clear();
+    last_found_vma = vma_map.end();
     // Initialize the map with a single free region covering the entire managed space.
     VirtualMemoryArea initial_vma{};
     initial_vma.size = MAX_ADDRESS;
@@ -56,14 +57,18 @@ void VMManager::Reset() {
 VMManager::VMAHandle VMManager::FindVMA(VAddr target) const {
     if (target >= MAX_ADDRESS)
         return vma_map.end();
-    else
-        return std::prev(vma_map.upper_bound(target));
+    // Splitting only shrinks the cached VMA in place, so its current bounds are always right
+    if (last_found_vma != vma_map.end() &&
+        target - last_found_vma->second.base < last_found_vma->second.size)
+        return last_found_vma;
+    last_found_vma = std::prev(vma_map.upper_bound(target));
+    return last_found_vma;
 }
 
 ResultVal<VAddr> VMManager::MapBackingMemoryToBase(VAddr base, u32 region_size, u8* memory,
                                                    u32 size, MemoryState state) {
-    // Find the first Free VMA.
-    auto vma_handle{std::find_if(vma_map.begin(), vma_map.end(), [&](const auto& vma) {
+    // Find the first Free VMA. The ones before the VMA containing base all end before it.
+    auto vma_handle{std::find_if(FindVMA(base), vma_map.cend(), [&](const auto& vma) {
         if (vma.second.type != VMAType::Free)
             return false;
         VAddr vma_end = vma.second.base + vma.second.size;
@@ -270,19 +275,25 @@ VMManager::VMAIter VMManager::MergeAdjacent(VMAIter iter) {
     const VMAIter next_vma{std::next(iter)};
     if (next_vma != vma_map.end() && iter->second.CanBeMergedWith(next_vma->second)) {
         iter->second.size += next_vma->second.size;
-        vma_map.erase(next_vma);
+        EraseVMA(next_vma);
     }
     if (iter != vma_map.begin()) {
         auto prev_vma{std::prev(iter)};
         if (prev_vma->second.CanBeMergedWith(iter->second)) {
             prev_vma->second.size += iter->second.size;
-            vma_map.erase(iter);
+            EraseVMA(iter);
             iter = prev_vma;
         }
     }
     return iter;
 }
 
+void VMManager::EraseVMA(VMAIter vma) {
+    if (vma == last_found_vma)
+        last_found_vma = vma_map.end();
+    vma_map.erase(vma);
+}
+
 void VMManager::UpdatePageTableForVMA(const VirtualMemoryArea& vma) {
     switch (vma.type) {
     case VMAType::Free:
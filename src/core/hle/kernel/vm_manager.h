@@ -218,6 +218,12 @@ private:
 
     /// Updates the pages corresponding to this VMA so they match the VMA's attributes.
     void UpdatePageTableForVMA(const VirtualMemoryArea& vma);
+
+    /// Erases a VMA from the map, keeping the FindVMA cache valid
+    void EraseVMA(VMAIter vma);
+
+    /// VMA found by the last FindVMA call, consecutive lookups mostly hit the same one
+    mutable VMAHandle last_found_vma;
 };
 
 } // namespace Kernel
@@ -55,4 +55,11 @@ inline SharedPtr<WaitObject> DynamicObjectCast<WaitObject>(SharedPtr<Object> obj
         return boost::static_pointer_cast<WaitObject>(object);
     return nullptr;
 }
+
+template <>
+inline WaitObject* DynamicObjectCast<WaitObject>(Object* object) {
+    if (object && object->IsWaitable())
+        return static_cast<WaitObject*>(object);
+    return nullptr;
+}
 } // namespace Kernel
@@ -0,0 +1,173 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <fmt/format.h>
+#include <json.hpp>
+#include "common/bit_util.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/hle/profiler.h"
+
+namespace HLE {
+
+namespace {
+
+void UpdateMax(std::atomic<u64>& max, u64 value) {
+    u64 current{max.load(std::memory_order_relaxed)};
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        ;
+}
+
+} // Anonymous namespace
+
+std::size_t Histogram::GetBucket(u64 value) {
+    if (value < SUB_BUCKETS)
+        return static_cast<std::size_t>(value);
+    // The top SUB_BUCKET_BITS + 1 bits select the bucket
+    const u32 shift{Common::MostSignificantBit64(value) - SUB_BUCKET_BITS};
+    const std::size_t bucket{(shift + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1))};
+    return std::min(bucket, NUM_BUCKETS - 1);
+}
+
+u64 Histogram::GetBucketLowerBound(std::size_t bucket) {
+    if (bucket < SUB_BUCKETS)
+        return bucket;
+    const std::size_t shift{bucket / SUB_BUCKETS - 1};
+    return (SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+}
+
+void Histogram::Record(u64 value) {
+    buckets[GetBucket(value)].fetch_add(1, std::memory_order_relaxed);
+}
+
+u64 Histogram::GetPercentile(double fraction) const {
+    u64 total{};
+    for (std::size_t i{}; i < NUM_BUCKETS; ++i)
+        total += GetCount(i);
+    if (total == 0)
+        return 0;
+    const u64 target{std::max<u64>(1, static_cast<u64>(std::ceil(fraction * total)))};
+    u64 seen{};
+    for (std::size_t i{}; i < NUM_BUCKETS; ++i) {
+        seen += GetCount(i);
+        if (seen >= target)
+            return GetBucketLowerBound(i);
+    }
+    return GetBucketLowerBound(NUM_BUCKETS - 1);
+}
+
+void Histogram::Reset() {
+    for (auto& bucket : buckets)
+        bucket.store(0, std::memory_order_relaxed);
+}
+
+void CommandStats::Record(u64 host_time_ns, u32 sleeps, u64 sleep_time_ns) {
+    calls.fetch_add(1, std::memory_order_relaxed);
+    host_time_total.fetch_add(host_time_ns, std::memory_order_relaxed);
+    UpdateMax(host_time_max, host_time_ns);
+    host_time.Record(host_time_ns);
+    if (sleeps == 0)
+        return;
+    this->sleeps.fetch_add(sleeps, std::memory_order_relaxed);
+    emulated_delay.fetch_add(sleep_time_ns, std::memory_order_relaxed);
+}
+
+void CommandStats::Reset() {
+    calls.store(0, std::memory_order_relaxed);
+    host_time_total.store(0, std::memory_order_relaxed);
+    host_time_max.store(0, std::memory_order_relaxed);
+    host_time.Reset();
+    sleeps.store(0, std::memory_order_relaxed);
+    emulated_delay.store(0, std::memory_order_relaxed);
+}
+
+CommandStats& Profiler::GetCommandStats(const std::string& service, u32 header,
+                                        const char* name) {
+    std::lock_guard lock{mutex};
+    return commands.try_emplace({service, header}, name).first->second.stats;
+}
+
+void Profiler::Reset() {
+    std::lock_guard lock{mutex};
+    for (auto& [key, command] : commands)
+        command.stats.Reset();
+    for (auto& calls : svc_calls)
+        calls.store(0, std::memory_order_relaxed);
+}
+
+std::string Profiler::ExportJSON() const {
+    nlohmann::json json_commands = nlohmann::json::array();
+    {
+        std::lock_guard lock{mutex};
+        for (const auto& [key, command] : commands) {
+            const auto& stats{command.stats};
+            const u64 calls{stats.calls.load(std::memory_order_relaxed)};
+            if (calls == 0)
+                continue;
+            // Only the non-empty buckets, as [lower bound, count] pairs
+            nlohmann::json histogram = nlohmann::json::array();
+            for (std::size_t i{}; i < Histogram::NUM_BUCKETS; ++i)
+                if (const u64 count{stats.host_time.GetCount(i)})
+                    histogram.push_back({Histogram::GetBucketLowerBound(i), count});
+            json_commands.push_back({
+                {"service", key.first},
+                {"header", fmt::format("0x{:08X}", key.second)},
+                {"name", command.name},
+                {"calls", calls},
+                {"host_time_total_ns", stats.host_time_total.load(std::memory_order_relaxed)},
+                {"host_time_max_ns", stats.host_time_max.load(std::memory_order_relaxed)},
+                {"host_time_p50_ns", stats.host_time.GetPercentile(0.5)},
+                {"host_time_p90_ns", stats.host_time.GetPercentile(0.9)},
+                {"host_time_p99_ns", stats.host_time.GetPercentile(0.99)},
+                {"host_time_histogram", std::move(histogram)},
+                {"sleeps", stats.sleeps.load(std::memory_order_relaxed)},
+                {"emulated_delay_ns", stats.emulated_delay.load(std::memory_order_relaxed)},
+            });
+        }
+    }
+    nlohmann::json json_svcs = nlohmann::json::object();
+    for (std::size_t i{}; i < NUM_SVCS; ++i)
+        if (const u64 calls{svc_calls[i].load(std::memory_order_relaxed)})
+            json_svcs[fmt::format("0x{:02X}", i)] = calls;
+    return nlohmann::json{{"commands", std::move(json_commands)}, {"svcs", std::move(json_svcs)}}
+        .dump(2);
+}
+
+void Profiler::LogSummary() const {
+    constexpr std::size_t MAX_LOGGED_COMMANDS{10};
+    struct Entry {
+        const std::pair<std::string, u32>* key;
+        const Command* command;
+        u64 host_time;
+    };
+    std::vector<Entry> entries;
+    std::lock_guard lock{mutex};
+    for (const auto& [key, command] : commands)
+        if (const u64 host_time{command.stats.host_time_total.load(std::memory_order_relaxed)})
+            entries.push_back({&key, &command, host_time});
+    const std::size_t count{std::min(entries.size(), MAX_LOGGED_COMMANDS)};
+    std::partial_sort(entries.begin(), entries.begin() + count, entries.end(),
+                      [](const Entry& a, const Entry& b) { return a.host_time > b.host_time; });
+    for (std::size_t i{}; i < count; ++i) {
+        const auto& stats{entries[i].command->stats};
+        LOG_INFO(Service, "HLE profile: {} {} calls={} host={}us p99={}ns emulated_delay={}us",
+                 entries[i].key->first, entries[i].command->name,
+                 stats.calls.load(std::memory_order_relaxed), entries[i].host_time / 1000,
+                 stats.host_time.GetPercentile(0.99),
+                 stats.emulated_delay.load(std::memory_order_relaxed) / 1000);
+    }
+}
+
+void Profiler::Dump() const {
+    const std::string path{FileUtil::GetUserPath(FileUtil::UserPath::UserDir) +
+                           "hle_profile.json"};
+    const std::string json{ExportJSON()};
+    if (FileUtil::WriteStringToFile(true, json, path.c_str()) != json.size())
+        LOG_WARNING(Service, "Failed to write the HLE profile to {}", path);
+}
+
+} // namespace HLE
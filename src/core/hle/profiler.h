@@ -0,0 +1,116 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include "common/common_types.h"
+
+namespace HLE {
+
+/**
+ * Log-linear histogram in the style of HdrHistogram. Every power of two range is split in
+ * SUB_BUCKETS buckets, so a bucket's bounds are within 1 / SUB_BUCKETS of its values.
+ * Recording is lock-free and the counts can be read from any thread.
+ */
+class Histogram {
+public:
+    static constexpr u32 SUB_BUCKET_BITS{4};
+    static constexpr u32 SUB_BUCKETS{1 << SUB_BUCKET_BITS};
+
+    /// Enough buckets for values up to 2^40, larger values go to the last one
+    static constexpr std::size_t NUM_BUCKETS{SUB_BUCKETS * 40};
+
+    void Record(u64 value);
+
+    u64 GetCount(std::size_t bucket) const {
+        return buckets[bucket].load(std::memory_order_relaxed);
+    }
+
+    /// Smallest value that falls in the bucket
+    static u64 GetBucketLowerBound(std::size_t bucket);
+
+    /// Gets an approximation of the value below which the given fraction of values are
+    u64 GetPercentile(double fraction) const;
+
+    void Reset();
+
+private:
+    static std::size_t GetBucket(u64 value);
+
+    std::array<std::atomic<u64>, NUM_BUCKETS> buckets{};
+};
+
+/// Counters of one command of an HLE service
+struct CommandStats {
+    /// Records a handled request
+    void Record(u64 host_time_ns, u32 sleeps, u64 sleep_time_ns);
+
+    void Reset();
+
+    std::atomic<u64> calls{};
+    std::atomic<u64> host_time_total{}; ///< Host time spent in the handler, in nanoseconds
+    std::atomic<u64> host_time_max{};
+    Histogram host_time;
+    std::atomic<u64> sleeps{};         ///< Times the handler put the client thread to sleep
+    std::atomic<u64> emulated_delay{}; ///< Sum of the sleep timeouts, in nanoseconds
+};
+
+/**
+ * Always-on accounting of HLE service commands and SVCs, meant to find the HLE hot spots of a
+ * title. Counters are updated by the emu thread without locking and can be exported as JSON from
+ * any thread.
+ */
+class Profiler {
+public:
+    static constexpr std::size_t NUM_SVCS{0x80};
+
+    /**
+     * Gets the counters of a command, creating them on first use. The returned reference stays
+     * valid for the lifetime of the profiler, so callers should keep it instead of looking it up
+     * on every request.
+     */
+    CommandStats& GetCommandStats(const std::string& service, u32 header, const char* name);
+
+    void RecordSVC(u32 immediate) {
+        svc_calls[immediate % NUM_SVCS].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// Zeroes all counters
+    void Reset();
+
+    /// Serializes all counters as a JSON document
+    std::string ExportJSON() const;
+
+    /// Logs the commands that took the most host time
+    void LogSummary() const;
+
+    /// Writes the JSON document to hle_profile.json in the user directory, done on shutdown if
+    /// the dump_hle_profile setting is enabled
+    void Dump() const;
+
+private:
+    struct Command {
+        explicit Command(const char* name) : name{name} {}
+
+        const char* name;
+        CommandStats stats;
+    };
+
+    // Guards the structure of commands, the counters themselves are atomic
+    mutable std::mutex mutex;
+
+    // Keyed by service name and command header. Nodes of std::map never move, which keeps the
+    // references returned by GetCommandStats valid.
+    std::map<std::pair<std::string, u32>, Command> commands;
+
+    std::array<std::atomic<u64>, NUM_SVCS> svc_calls{};
+};
+
+} // namespace HLE
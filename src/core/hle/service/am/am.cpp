@@ -3,11 +3,17 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <chrono>
 #include <cinttypes>
+#include <condition_variable>
 #include <cstddef>
 #include <cstring>
+#include <future>
+#include <mutex>
+#include <thread>
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
+#include <cryptopp/sha.h>
 #include <fmt/format.h>
 #include "common/file_util.h"
 #include "common/logging/log.h"
@@ -254,11 +260,32 @@ bool CIAFile::Close() const {
         if (content_written[i] < container.GetContentSize(static_cast<u16>(i)))
             complete = false;
     }
-    // Install aborted
+    // Install aborted, remove what it wrote
     if (!complete) {
         LOG_ERROR(Service_AM, "CIAFile closed prematurely, aborting install...");
-        FileUtil::DeleteDir(
-            GetProgramPath(media_type, container.GetTitleMetadata().GetProgramID()));
+        const FileSys::TitleMetadata& new_tmd{container.GetTitleMetadata()};
+        const std::string program_path{GetProgramPath(media_type, new_tmd.GetProgramID())};
+        if (!is_update) {
+            // Only this install wrote contents, the save data next to them is kept
+            FileUtil::DeleteDirRecursively(program_path + "content/");
+            FileUtil::DeleteDir(program_path);
+            return true;
+        }
+        // Keep the contents the installed version shares with the new one
+        FileSys::TitleMetadata old_tmd;
+        old_tmd.Load(GetMetadataPath(media_type, new_tmd.GetProgramID(), false));
+        for (u16 new_index{}; new_index < new_tmd.GetContentCount(); new_index++) {
+            bool shared{};
+            for (u16 old_index{}; old_index < old_tmd.GetContentCount(); old_index++)
+                if (old_tmd.GetContentIDByIndex(old_index) ==
+                    new_tmd.GetContentIDByIndex(new_index))
+                    shared = true;
+            if (!shared)
+                FileUtil::Delete(
+                    GetProgramContentPath(media_type, new_tmd.GetProgramID(), new_index, true));
+        }
+        // The new contents' paths are found through the new TMD, so it goes last
+        FileUtil::Delete(GetMetadataPath(media_type, new_tmd.GetProgramID(), true));
         return true;
     }
     // Clean up older content data if we installed newer content on top
@@ -293,6 +320,165 @@ bool CIAFile::Close() const {
 
 void CIAFile::Flush() const {}
 
+constexpr std::size_t CONTENT_CHUNK_SIZE{0x400000};
+
+/// Writes the chunks of a content on its own thread while the next chunk is being decrypted
+class ContentWriter : NonCopyable {
+public:
+    explicit ContentWriter(FileUtil::IOFile& file) : file{file}, thread{[this] { Loop(); }} {}
+
+    ~ContentWriter() {
+        Finish();
+    }
+
+    /// Gets the buffer for the next chunk, waiting until its previous contents were written
+    std::vector<u8>& NextBuffer() {
+        std::unique_lock lock{mutex};
+        cv.wait(lock, [this] { return !queued[next_buffer]; });
+        return buffers[next_buffer];
+    }
+
+    /// Queues the buffer returned by NextBuffer for writing
+    void Submit() {
+        {
+            std::lock_guard lock{mutex};
+            queued[next_buffer] = true;
+            next_buffer ^= 1;
+        }
+        cv.notify_all();
+    }
+
+    /// Waits until all queued chunks were written, returns whether all writes succeeded
+    bool Finish() {
+        {
+            std::lock_guard lock{mutex};
+            done = true;
+        }
+        cv.notify_all();
+        if (thread.joinable())
+            thread.join();
+        return !failed;
+    }
+
+private:
+    void Loop() {
+        for (std::size_t current{};; current ^= 1) {
+            std::unique_lock lock{mutex};
+            cv.wait(lock, [&] { return queued[current] || done; });
+            if (!queued[current])
+                return;
+            lock.unlock();
+            const auto& buffer{buffers[current]};
+            if (!failed && file.WriteBytes(buffer.data(), buffer.size()) != buffer.size())
+                failed = true;
+            lock.lock();
+            queued[current] = false;
+            lock.unlock();
+            cv.notify_all();
+        }
+    }
+
+    FileUtil::IOFile& file;
+    std::array<std::vector<u8>, 2> buffers;
+    std::array<bool, 2> queued{};
+    std::size_t next_buffer{};
+    bool done{};
+    bool failed{};
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread thread;
+};
+
+ResultCode CIAFile::WriteContent(const FileUtil::MappedFile& cia, u16 index,
+                                 std::atomic<u64>& total_written,
+                                 const std::atomic_bool& aborted) {
+    const FileSys::TitleMetadata& tmd{container.GetTitleMetadata()};
+    const u64 size{container.GetContentSize(index)};
+    // Optional contents may be missing from the CIA
+    if (size == 0)
+        return RESULT_SUCCESS;
+    const u8* source{cia.GetPointer(container.GetContentOffset(index), size)};
+    if (!source) {
+        LOG_ERROR(Service_AM, "Content {} is truncated", index);
+        return ResultCode(ErrCodes::InvalidCIAHeader, ErrorModule::AM,
+                          ErrorSummary::InvalidArgument, ErrorLevel::Permanent);
+    }
+    FileUtil::IOFile file{GetProgramContentPath(media_type, tmd.GetProgramID(), index, is_update),
+                          "wb"};
+    if (!file.IsOpen())
+        return FileSys::ERROR_INSUFFICIENT_SPACE;
+    const bool encrypted{(tmd.GetContentTypeByIndex(index) &
+                          FileSys::TMDContentTypeFlag::Encrypted) != 0};
+    CryptoPP::SHA256 sha;
+    ContentWriter writer{file};
+    for (u64 offset{}; offset < size;) {
+        // Another content failed, the install is going to be rolled back anyway
+        if (aborted)
+            return RESULT_SUCCESS;
+        const auto length{
+            static_cast<std::size_t>(std::min<u64>(CONTENT_CHUNK_SIZE, size - offset))};
+        auto& buffer{writer.NextBuffer()};
+        buffer.resize(length);
+        if (encrypted)
+            decryption_state->content[index].ProcessData(buffer.data(), source + offset, length);
+        else
+            std::memcpy(buffer.data(), source + offset, length);
+        sha.Update(buffer.data(), length);
+        writer.Submit();
+        offset += length;
+        total_written += length;
+    }
+    if (!writer.Finish()) {
+        LOG_ERROR(Service_AM, "Failed to write content {}", index);
+        return FileSys::ERROR_INSUFFICIENT_SPACE;
+    }
+    std::array<u8, CryptoPP::SHA256::DIGESTSIZE> hash;
+    sha.Final(hash.data());
+    if (hash != tmd.GetContentHashByIndex(index)) {
+        LOG_ERROR(Service_AM, "Content {} hash mismatch", index);
+        return ERROR_CONTENT_HASH_MISMATCH;
+    }
+    content_written[index] = size;
+    return RESULT_SUCCESS;
+}
+
+ResultCode CIAFile::WriteContents(const FileUtil::MappedFile& cia,
+                                  const std::function<ProgressCallback>& update_callback) {
+    ASSERT(install_state == CIAInstallState::TMDLoaded);
+    const std::size_t content_count{container.GetTitleMetadata().GetContentCount()};
+    ResultCode result{RESULT_SUCCESS};
+    std::atomic<std::size_t> next_content{};
+    std::atomic<u64> total_written{};
+    std::atomic_bool aborted{};
+    const auto install{[&] {
+        for (std::size_t i{next_content++}; i < content_count && !aborted; i = next_content++) {
+            const auto content_result{
+                WriteContent(cia, static_cast<u16>(i), total_written, aborted)};
+            // Only the first failure is reported
+            if (content_result.IsError() && !aborted.exchange(true))
+                result = content_result;
+        }
+    }};
+    const std::size_t num_threads{std::min<std::size_t>(
+        content_count, std::max(std::thread::hardware_concurrency(), 1U))};
+    std::vector<std::future<void>> workers;
+    for (std::size_t i{}; i < num_threads; ++i)
+        workers.push_back(std::async(std::launch::async, install));
+    // Report progress from the calling thread while the workers run
+    const u64 base{written};
+    for (auto& worker : workers) {
+        while (worker.wait_for(std::chrono::milliseconds{100}) != std::future_status::ready)
+            if (update_callback)
+                update_callback(base + total_written, cia.GetSize());
+        worker.get();
+    }
+    written = base + total_written;
+    if (result.IsError())
+        return result;
+    install_state = CIAInstallState::ContentWritten;
+    return RESULT_SUCCESS;
+}
+
 InstallStatus InstallCIA(const std::string& path,
                          std::function<ProgressCallback>&& update_callback) {
     LOG_INFO(Service_AM, "Installing {}...", path);
@@ -313,24 +499,30 @@ InstallStatus InstallCIA(const std::string& path,
                 return InstallStatus::ErrorEncrypted;
             }
         }
-        FileUtil::IOFile file{path, "rb"};
+        FileUtil::MappedFile file{path};
         if (!file.IsOpen())
             return InstallStatus::ErrorFailedToOpenFile;
-        std::array<u8, 0x10000> buffer;
-        std::size_t total_bytes_read{};
-        while (total_bytes_read != file.GetSize()) {
-            std::size_t bytes_read{file.ReadBytes(buffer.data(), buffer.size())};
-            auto result{installFile.Write(static_cast<u64>(total_bytes_read), bytes_read, true,
-                                          static_cast<u8*>(buffer.data()))};
-            if (update_callback)
-                update_callback(total_bytes_read, file.GetSize());
-            if (result.Failed()) {
-                LOG_ERROR(Service_AM, "CIA file installation aborted with error code {:08x}",
-                          result.Code().raw);
-                return InstallStatus::ErrorAborted;
-            }
-            total_bytes_read += bytes_read;
+        // Everything prior to the contents goes through the regular path, which loads the
+        // ticket and TMD and sets up the program folders and decryption
+        const u64 content_offset{container.GetContentOffset()};
+        const u8* header{file.GetPointer(0, content_offset)};
+        if (!header)
+            return InstallStatus::ErrorInvalid;
+        auto write_result{installFile.Write(0, content_offset, true, header)};
+        if (write_result.Failed()) {
+            LOG_ERROR(Service_AM, "CIA file installation aborted with error code {:08x}",
+                      write_result.Code().raw);
+            return InstallStatus::ErrorAborted;
+        }
+        auto result{installFile.WriteContents(file, update_callback)};
+        if (result.IsError()) {
+            LOG_ERROR(Service_AM, "CIA file installation aborted with error code {:08x}",
+                      result.raw);
+            return result == ERROR_CONTENT_HASH_MISMATCH ? InstallStatus::ErrorHashMismatch
+                                                         : InstallStatus::ErrorAborted;
         }
+        if (update_callback)
+            update_callback(file.GetSize(), file.GetSize());
         installFile.Close();
         LOG_INFO(Service_AM, "Installed {} successfully.", path);
         return InstallStatus::Success;
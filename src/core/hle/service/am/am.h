@@ -5,6 +5,7 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <string>
@@ -20,6 +21,10 @@ namespace Core {
 class System;
 } // namespace Core
 
+namespace FileUtil {
+class MappedFile;
+} // namespace FileUtil
+
 namespace Service::FS {
 enum class MediaType : u32;
 } // namespace Service::FS
@@ -34,9 +39,14 @@ enum {
     TryingToUninstallSystemProgram = 44,
     InvalidTIDInList = 60,
     InvalidCIAHeader = 104,
+    InvalidContentHash = 105,
 };
 } // namespace ErrCodes
 
+constexpr ResultCode ERROR_CONTENT_HASH_MISMATCH(ErrCodes::InvalidContentHash, ErrorModule::AM,
+                                                 ErrorSummary::InvalidArgument,
+                                                 ErrorLevel::Permanent);
+
 enum class CIAInstallState : u32 {
     InstallStarted,
     HeaderLoaded,
@@ -53,6 +63,7 @@ enum class InstallStatus : u32 {
     ErrorAborted,
     ErrorInvalid,
     ErrorEncrypted,
+    ErrorHashMismatch,
 };
 
 // Program ID valid length
@@ -78,7 +89,19 @@ public:
     bool Close() const override;
     void Flush() const override;
 
+    /**
+     * Installs all contents of a complete CIA after the data prior to them was written.
+     * Independent contents are decrypted, verified against the TMD and written concurrently.
+     * @param cia mapping of the whole CIA file
+     * @param update_callback called periodically with the content bytes installed so far
+     */
+    ResultCode WriteContents(const FileUtil::MappedFile& cia,
+                             const std::function<ProgressCallback>& update_callback);
+
 private:
+    ResultCode WriteContent(const FileUtil::MappedFile& cia, u16 index,
+                            std::atomic<u64>& total_written, const std::atomic_bool& aborted);
+
     // Whether it's installing an update, and what step of installation it is at
     bool is_update{};
     CIAInstallState install_state{CIAInstallState::InstallStarted};
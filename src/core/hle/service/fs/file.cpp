@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include "common/logging/log.h"
+#include "common/thread_pool.h"
 #include "core/core.h"
 #include "core/file_sys/errors.h"
 #include "core/file_sys/file_backend.h"
@@ -33,6 +34,15 @@ File::File(Core::System& system, std::unique_ptr<FileSys::FileBackend>&& backend
     RegisterHandlers(functions);
 }
 
+File::~File() {
+    WaitForPendingRead();
+}
+
+void File::WaitForPendingRead() {
+    if (pending_read.valid())
+        pending_read.wait();
+}
+
 void File::Read(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp{ctx, 0x0802, 3, 2};
     u64 offset{rp.Pop<u64>()};
@@ -46,25 +56,73 @@ void File::Read(Kernel::HLERequestContext& ctx) {
     }
     // This file session might have a specific offset from where to start reading, apply it.
     offset += file->offset;
+    WaitForPendingRead();
     if (offset + length > backend->GetSize())
         LOG_ERROR(Service_FS,
                   "Reading from out of bounds offset=0x{:X} length=0x{:08X} file_size=0x{:X}",
                   offset, length, backend->GetSize());
+    std::chrono::nanoseconds read_timeout_ns{backend->GetReadDelayNs(length)};
+    auto thread{system.Kernel().GetThreadManager().GetCurrentThread()};
+    if (length && length <= buffer.GetSize() && read_timeout_ns.count() > 0) {
+        // Run the host read on the I/O pool while the client thread sleeps for the emulated
+        // delay, so slow storage doesn't add up to it or block the emulation thread. The guest
+        // may unmap or reuse its buffer meanwhile, so the pool reads into a host buffer that is
+        // only copied to guest memory on the emulation thread.
+        struct ReadResult {
+            ResultCode code{RESULT_SUCCESS};
+            std::vector<u8> data;
+        };
+        auto result{std::make_shared<ReadResult>()};
+        pending_read =
+            Common::ThreadPool::GetIOPool()
+                .Push([backend = backend.get(), offset, length, result] {
+                    result->data.resize(length);
+                    ResultVal<std::size_t> read{backend->Read(offset, length, result->data.data())};
+                    if (read.Failed()) {
+                        result->code = read.Code();
+                        result->data.clear();
+                    } else {
+                        result->data.resize(*read);
+                    }
+                })
+                .share();
+        ctx.SleepClientThread(thread, "file::read", read_timeout_ns,
+                              [this, buffer, result](Kernel::SharedPtr<Kernel::Thread> thread,
+                                                     Kernel::HLERequestContext& ctx,
+                                                     Kernel::ThreadWakeupReason reason) mutable {
+                                  // The emulated delay is over, the host read usually is too
+                                  WaitForPendingRead();
+                                  if (!result->data.empty())
+                                      buffer.Write(result->data.data(), 0, result->data.size());
+                                  IPC::ResponseBuilder rb{ctx, 0x0802, 2, 2};
+                                  rb.Push(result->code);
+                                  rb.Push<u32>(static_cast<u32>(result->data.size()));
+                                  rb.PushMappedBuffer(buffer);
+                              });
+        return;
+    }
+    // The emulation thread reads straight into the guest buffer when its pages are contiguous
+    u8* destination{length && length <= buffer.GetSize() ? buffer.GetPointer(0, length)
+                                                         : nullptr};
     auto rb{rp.MakeBuilder(2, 2)};
-    std::vector<u8> data(length);
-    ResultVal<std::size_t> read{backend->Read(offset, data.size(), data.data())};
+    ResultVal<std::size_t> read;
+    if (destination)
+        read = backend->Read(offset, length, destination);
+    else {
+        std::vector<u8> data(length);
+        read = backend->Read(offset, data.size(), data.data());
+        if (read.Succeeded())
+            buffer.Write(data.data(), 0, *read);
+    }
     if (read.Failed()) {
         rb.Push(read.Code());
         rb.Push<u32>(0);
     } else {
-        buffer.Write(data.data(), 0, *read);
         rb.Push(RESULT_SUCCESS);
         rb.Push<u32>(static_cast<u32>(*read));
     }
     rb.PushMappedBuffer(buffer);
-    std::chrono::nanoseconds read_timeout_ns{backend->GetReadDelayNs(length)};
-    ctx.SleepClientThread(system.Kernel().GetThreadManager().GetCurrentThread(), "file::read",
-                          read_timeout_ns,
+    ctx.SleepClientThread(thread, "file::read", read_timeout_ns,
                           [](Kernel::SharedPtr<Kernel::Thread> thread,
                              Kernel::HLERequestContext& ctx, Kernel::ThreadWakeupReason reason) {
                               // Nothing to do here
@@ -90,6 +148,7 @@ void File::Write(Kernel::HLERequestContext& ctx) {
     }
     std::vector<u8> data(length);
     buffer.Read(data.data(), 0, data.size());
+    WaitForPendingRead();
     ResultVal<std::size_t> written{backend->Write(offset, data.size(), flush != 0, data.data())};
     if (written.Failed()) {
         rb.Push(written.Code());
@@ -119,6 +178,7 @@ void File::SetSize(Kernel::HLERequestContext& ctx) {
         return;
     }
     file->size = size;
+    WaitForPendingRead();
     backend->SetSize(size);
     rb.Push(RESULT_SUCCESS);
 }
@@ -128,6 +188,7 @@ void File::Close(Kernel::HLERequestContext& ctx) {
     if (connected_sessions.size() > 1)
         LOG_WARNING(Service_FS, "Closing File backend but {} clients still connected",
                     connected_sessions.size());
+    WaitForPendingRead();
     backend->Close();
     IPC::ResponseBuilder rb{ctx, 0x0808, 1, 0};
     rb.Push(RESULT_SUCCESS);
@@ -141,6 +202,7 @@ void File::Flush(Kernel::HLERequestContext& ctx) {
         rb.Push(FileSys::ERROR_UNSUPPORTED_OPEN_FLAGS);
         return;
     }
+    WaitForPendingRead();
     backend->Flush();
     rb.Push(RESULT_SUCCESS);
 }
@@ -171,6 +233,7 @@ void File::OpenLinkFile(Kernel::HLERequestContext& ctx) {
     const FileSessionSlot* original_file{GetSessionData(ctx.Session())};
     slot->priority = original_file->priority;
     slot->offset = 0;
+    WaitForPendingRead();
     slot->size = backend->GetSize();
     slot->subfile = false;
     IPC::ResponseBuilder rb{ctx, 0x080C, 1, 2};
@@ -222,6 +285,7 @@ Kernel::SharedPtr<Kernel::ClientSession> File::Connect() {
     FileSessionSlot* slot{GetSessionData(server)};
     slot->priority = 0;
     slot->offset = 0;
+    WaitForPendingRead();
     slot->size = backend->GetSize();
     slot->subfile = false;
     return std::get<Kernel::SharedPtr<Kernel::ClientSession>>(sessions);
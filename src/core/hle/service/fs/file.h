@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <future>
 #include "core/file_sys/archive_backend.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/service/service.h"
@@ -27,7 +28,7 @@ class File final : public ServiceFramework<File, FileSessionSlot> {
 public:
     File(Core::System& system, std::unique_ptr<FileSys::FileBackend>&& backend,
          const FileSys::Path& path);
-    ~File() = default;
+    ~File();
 
     std::string GetName() const {
         return "Path: " + path.DebugStr();
@@ -59,7 +60,13 @@ private:
     void OpenLinkFile(Kernel::HLERequestContext& ctx);
     void OpenSubFile(Kernel::HLERequestContext& ctx);
 
+    /// Blocks until the host read started by the last Read request has finished
+    void WaitForPendingRead();
+
     Core::System& system;
+
+    // Host read running on the I/O pool, the backend must not be used by anything else meanwhile
+    std::shared_future<void> pending_read;
 };
 
 } // namespace Service::FS
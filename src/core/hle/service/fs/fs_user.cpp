@@ -50,7 +50,7 @@ void FS_USER::OpenFile(Kernel::HLERequestContext& ctx) {
     u32 filename_size{rp.Pop<u32>()};
     FileSys::Mode mode{rp.Pop<u32>()};
     u32 attributes{rp.Pop<u32>()}; // TODO: do something with those attributes.
-    std::vector<u8> filename{rp.PopStaticBuffer()};
+    const auto filename{rp.PopStaticBufferView()};
     ASSERT(filename.size() == filename_size);
     FileSys::Path file_path{filename_type, filename};
     LOG_DEBUG(Service_FS, "path={}, mode={}, attrs={}", file_path.DebugStr(), mode.hex, attributes);
@@ -83,8 +83,8 @@ void FS_USER::OpenFileDirectly(Kernel::HLERequestContext& ctx) {
     u32 filename_size{rp.Pop<u32>()};
     FileSys::Mode mode{rp.Pop<u32>()};
     u32 attributes{rp.Pop<u32>()}; // TODO: do something with those attributes.
-    std::vector<u8> archivename{rp.PopStaticBuffer()};
-    std::vector<u8> filename{rp.PopStaticBuffer()};
+    const auto archivename{rp.PopStaticBufferView()};
+    const auto filename{rp.PopStaticBufferView()};
     ASSERT(archivename.size() == archivename_size);
     ASSERT(filename.size() == filename_size);
     FileSys::Path archive_path{archivename_type, archivename};
@@ -129,7 +129,7 @@ void FS_USER::DeleteFile(Kernel::HLERequestContext& ctx) {
     ArchiveHandle archive_handle{rp.PopRaw<ArchiveHandle>()};
     auto filename_type{rp.PopEnum<FileSys::LowPathType>()};
     u32 filename_size{rp.Pop<u32>()};
-    std::vector<u8> filename{rp.PopStaticBuffer()};
+    const auto filename{rp.PopStaticBufferView()};
     ASSERT(filename.size() == filename_size);
     FileSys::Path file_path{filename_type, filename};
     LOG_DEBUG(Service_FS, "type={}, size={}, data={}", static_cast<u32>(filename_type),
@@ -147,8 +147,8 @@ void FS_USER::RenameFile(Kernel::HLERequestContext& ctx) {
     ArchiveHandle dest_archive_handle{rp.PopRaw<ArchiveHandle>()};
     auto dest_filename_type{rp.PopEnum<FileSys::LowPathType>()};
     u32 dest_filename_size{rp.Pop<u32>()};
-    std::vector<u8> src_filename{rp.PopStaticBuffer()};
-    std::vector<u8> dest_filename{rp.PopStaticBuffer()};
+    const auto src_filename{rp.PopStaticBufferView()};
+    const auto dest_filename{rp.PopStaticBufferView()};
     ASSERT(src_filename.size() == src_filename_size);
     ASSERT(dest_filename.size() == dest_filename_size);
     FileSys::Path src_file_path{src_filename_type, src_filename};
@@ -168,7 +168,7 @@ void FS_USER::DeleteDirectory(Kernel::HLERequestContext& ctx) {
     ArchiveHandle archive_handle{rp.PopRaw<ArchiveHandle>()};
     auto dirname_type{rp.PopEnum<FileSys::LowPathType>()};
     u32 dirname_size{rp.Pop<u32>()};
-    std::vector<u8> dirname{rp.PopStaticBuffer()};
+    const auto dirname{rp.PopStaticBufferView()};
     ASSERT(dirname.size() == dirname_size);
     FileSys::Path dir_path{dirname_type, dirname};
     LOG_DEBUG(Service_FS, "dirname_type={}, dirname_size={}, dir_path={}",
@@ -183,7 +183,7 @@ void FS_USER::DeleteDirectoryRecursively(Kernel::HLERequestContext& ctx) {
     ArchiveHandle archive_handle{rp.PopRaw<ArchiveHandle>()};
     auto dirname_type{rp.PopEnum<FileSys::LowPathType>()};
     u32 dirname_size{rp.Pop<u32>()};
-    std::vector<u8> dirname{rp.PopStaticBuffer()};
+    const auto dirname{rp.PopStaticBufferView()};
     ASSERT(dirname.size() == dirname_size);
     FileSys::Path dir_path{dirname_type, dirname};
     LOG_DEBUG(Service_FS, "type={}, size={}, data={}", static_cast<u32>(dirname_type), dirname_size,
@@ -200,7 +200,7 @@ void FS_USER::CreateFile(Kernel::HLERequestContext& ctx) {
     u32 filename_size{rp.Pop<u32>()};
     u32 attributes{rp.Pop<u32>()};
     u64 file_size{rp.Pop<u64>()};
-    std::vector<u8> filename{rp.PopStaticBuffer()};
+    const auto filename{rp.PopStaticBufferView()};
     ASSERT(filename.size() == filename_size);
     FileSys::Path file_path{filename_type, filename};
     LOG_DEBUG(Service_FS, "type={}, attributes={}, size={:x}, data={}",
@@ -216,7 +216,7 @@ void FS_USER::CreateDirectory(Kernel::HLERequestContext& ctx) {
     auto dirname_type{rp.PopEnum<FileSys::LowPathType>()};
     u32 dirname_size{rp.Pop<u32>()};
     u32 attributes{rp.Pop<u32>()};
-    std::vector<u8> dirname{rp.PopStaticBuffer()};
+    const auto dirname{rp.PopStaticBufferView()};
     ASSERT(dirname.size() == dirname_size);
     FileSys::Path dir_path{dirname_type, dirname};
     LOG_DEBUG(Service_FS, "type={}, size={}, data={}", static_cast<u32>(dirname_type), dirname_size,
@@ -234,8 +234,8 @@ void FS_USER::RenameDirectory(Kernel::HLERequestContext& ctx) {
     ArchiveHandle dest_archive_handle{rp.PopRaw<ArchiveHandle>()};
     auto dest_dirname_type{rp.PopEnum<FileSys::LowPathType>()};
     u32 dest_dirname_size{rp.Pop<u32>()};
-    std::vector<u8> src_dirname{rp.PopStaticBuffer()};
-    std::vector<u8> dest_dirname{rp.PopStaticBuffer()};
+    const auto src_dirname{rp.PopStaticBufferView()};
+    const auto dest_dirname{rp.PopStaticBufferView()};
     ASSERT(src_dirname.size() == src_dirname_size);
     ASSERT(dest_dirname.size() == dest_dirname_size);
     FileSys::Path src_dir_path{src_dirname_type, src_dirname};
@@ -254,7 +254,7 @@ void FS_USER::OpenDirectory(Kernel::HLERequestContext& ctx) {
     auto archive_handle{rp.PopRaw<ArchiveHandle>()};
     auto dirname_type{rp.PopEnum<FileSys::LowPathType>()};
     u32 dirname_size{rp.Pop<u32>()};
-    std::vector<u8> dirname{rp.PopStaticBuffer()};
+    const auto dirname{rp.PopStaticBufferView()};
     ASSERT(dirname.size() == dirname_size);
     FileSys::Path dir_path{dirname_type, dirname};
     LOG_DEBUG(Service_FS, "type={}, size={}, data={}", static_cast<u32>(dirname_type), dirname_size,
@@ -280,7 +280,7 @@ void FS_USER::OpenArchive(Kernel::HLERequestContext& ctx) {
     auto archive_id{rp.PopEnum<FS::ArchiveIdCode>()};
     auto archivename_type{rp.PopEnum<FileSys::LowPathType>()};
     u32 archivename_size{rp.Pop<u32>()};
-    std::vector<u8> archivename{rp.PopStaticBuffer()};
+    const auto archivename{rp.PopStaticBufferView()};
     ASSERT(archivename.size() == archivename_size);
     FileSys::Path archive_path{archivename_type, archivename};
     LOG_DEBUG(Service_FS, "archive_id=0x{:08X}, archive_path={}", static_cast<u32>(archive_id),
@@ -329,7 +329,7 @@ void FS_USER::FormatSaveData(Kernel::HLERequestContext& ctx) {
     u32 directory_buckets{rp.Pop<u32>()};
     u32 file_buckets{rp.Pop<u32>()};
     bool duplicate_data{rp.Pop<bool>()};
-    std::vector<u8> archivename{rp.PopStaticBuffer()};
+    const auto archivename{rp.PopStaticBufferView()};
     ASSERT(archivename.size() == archivename_size);
     FileSys::Path archive_path{archivename_type, archivename};
     LOG_DEBUG(Service_FS, "archive_path={}", archive_path.DebugStr());
@@ -540,7 +540,7 @@ void FS_USER::GetFormatInfo(Kernel::HLERequestContext& ctx) {
     auto archive_id{rp.PopEnum<FS::ArchiveIdCode>()};
     auto archivename_type{rp.PopEnum<FileSys::LowPathType>()};
     u32 archivename_size{rp.Pop<u32>()};
-    std::vector<u8> archivename{rp.PopStaticBuffer()};
+    const auto archivename{rp.PopStaticBufferView()};
     ASSERT(archivename.size() == archivename_size);
     FileSys::Path archive_path{archivename_type, archivename};
     LOG_DEBUG(Service_FS, "archive_path={}", archive_path.DebugStr());
@@ -229,12 +229,11 @@ void GSP_GPU::ReadHWRegs(Kernel::HLERequestContext& ctx) {
         LOG_ERROR(Service_GSP, "Invalid size 0x{:08x}", size);
         return;
     }
-    std::vector<u8> buffer(size);
-    for (u32 offset{}; offset < size; ++offset)
-        HW::Read<u8>(buffer[offset], REGS_BEGIN + reg_addr + offset);
     auto rb{rp.MakeBuilder(1, 2)};
     rb.Push(RESULT_SUCCESS);
-    rb.PushStaticBuffer(std::move(buffer), 0);
+    const auto buffer{rb.PushStaticBufferInPlace(size, 0)};
+    for (u32 offset{}; offset < size; ++offset)
+        HW::Read<u8>(buffer[offset], REGS_BEGIN + reg_addr + offset);
 }
 
 ResultCode GSP_GPU::SetBufferSwapImpl(u32 screen_id, const FrameBufferInfo& info) {
@@ -6,11 +6,15 @@
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
 #include <httplib.h>
+#include "common/thread_pool.h"
 #include "core/core.h"
+#include "core/core_timing.h"
 #include "core/file_sys/archive_ncch.h"
 #include "core/file_sys/file_backend.h"
 #include "core/hle/ipc_helpers.h"
+#include "core/hle/kernel/event.h"
 #include "core/hle/kernel/ipc.h"
+#include "core/hle/kernel/thread.h"
 #include "core/hle/romfs.h"
 #include "core/hle/service/fs/archive.h"
 #include "core/hle/service/http/http_c.h"
@@ -61,6 +65,20 @@ const ResultCode ERROR_NO_NETWORK_CONNECTION{
 const ResultCode RESULT_DOWNLOADPENDING{
     // 0xD840A02B
     ResultCode(43, ErrorModule::HTTP, ErrorSummary::WouldBlock, ErrorLevel::Permanent)};
+const ResultCode ERROR_TIMEOUT{
+    // 0xD820A069
+    ResultCode(105, ErrorModule::HTTP, ErrorSummary::NothingHappened, ErrorLevel::Permanent)};
+
+/// Applies a change to a transfer, then wakes the emu thread if a client thread waits for it
+template <typename Change>
+static void UpdateTransfer(RequestTransfer& transfer, const Context::UpdateCallback& on_update,
+                           Change change) {
+    // Reported under the lock, so the service can't go away in between
+    std::lock_guard lock{transfer.mutex};
+    change(transfer);
+    if (std::exchange(transfer.notify, false))
+        on_update();
+}
 
 u32 Context::GetResponseContentLength() const {
     try {
@@ -71,32 +89,21 @@ u32 Context::GetResponseContentLength() const {
     }
 }
 
-void Context::Send() {
+void Context::Send(UpdateCallback on_update) {
     namespace hl = httplib;
     auto parsed_url{LUrlParser::clParseURL::ParseURL(url)};
-    std::unique_ptr<hl::Client> cli;
     int port;
+    const bool https{parsed_url.m_Scheme == "https"};
     if (parsed_url.m_Scheme == "http") {
         if (!parsed_url.GetPort(&port))
             port = 80;
-        cli = std::make_unique<hl::Client>(parsed_url.m_Host.c_str(), port,
-                                           (timeout == 0) ? 300 : (timeout * std::pow(10, -9)));
-    } else if (parsed_url.m_Scheme == "https") {
+    } else if (https) {
         if (!parsed_url.GetPort(&port))
             port = 443;
-        cli = std::make_unique<hl::SSLClient>(parsed_url.m_Host.c_str(), port,
-                                              (timeout == 0) ? 300 : (timeout * std::pow(10, -9)));
     } else
         UNREACHABLE_MSG("Invalid scheme!");
-    if (ssl_config.enable_client_cert)
-        cli->add_client_cert_ASN1(ssl_config.client_cert_ctx.certificate,
-                                  ssl_config.client_cert_ctx.private_key);
-    if (ssl_config.enable_root_cert_chain)
-        for (const auto& cert : ssl_config.root_ca_chain.certificates)
-            cli->add_cert(cert.certificate);
-    if ((ssl_config.options & 0x200) == 0x200)
-        cli->set_verify(hl::SSLVerifyMode::None);
-    hl::Request request;
+    const time_t timeout_sec = (timeout == 0) ? 300 : (timeout * std::pow(10, -9));
+    auto request{std::make_shared<hl::Request>()};
     static const std::unordered_map<RequestMethod, std::string> method_string_map{{
         {RequestMethod::Get, "GET"},
         {RequestMethod::Post, "POST"},
@@ -115,37 +122,79 @@ void Context::Send() {
         {RequestMethod::PostEmpty, false},
         {RequestMethod::PutEmpty, false},
     }};
-    request.method = method_string_map.find(method)->second;
-    request.path = '/' + parsed_url.m_Path;
-    request.headers = *headers;
+    request->method = method_string_map.find(method)->second;
+    request->path = '/' + parsed_url.m_Path;
+    request->headers = *headers;
     if (method_body_map.find(method)->second) {
         for (const auto& item : post_data) {
             switch (item.type) {
             case PostData::Type::Ascii: {
-                request.body += fmt::format("{}={}\n", item.ascii.name, item.ascii.value);
+                request->body += fmt::format("{}={}\n", item.ascii.name, item.ascii.value);
                 break;
             }
             case PostData::Type::Binary: {
-                request.body += fmt::format(
+                request->body += fmt::format(
                     "{}={}\n", item.binary.name,
                     std::string(reinterpret_cast<const char*>(item.binary.data.data())));
                 break;
             }
             case PostData::Type::Raw: {
-                request.body += fmt::format("{}\n", item.raw.data);
+                request->body += fmt::format("{}\n", item.raw.data);
                 break;
             }
             }
         }
         if (!post_data.empty())
-            request.body.pop_back();
+            request->body.pop_back();
     }
-    hl::detail::parse_query_text(parsed_url.m_Query, request.params);
+    hl::detail::parse_query_text(parsed_url.m_Query, request->params);
     response = std::make_shared<hl::Response>();
-    cli->send(request, *response);
-    if (response)
+    transfer = std::make_shared<RequestTransfer>();
+    // httplib reports every read of a body with a Content-Length, which is written in place into
+    // the already sized response body, so the received part can be handed out while the rest is
+    // still downloading. Other bodies are only available once complete, as are encoded ones,
+    // which httplib only decodes after receiving all of them.
+    request->progress = [transfer = transfer, response = response.get(),
+                         on_update](u64 current, u64 total) {
+        const bool encoded{response->has_header("Content-Encoding") &&
+                           response->get_header_value("Content-Encoding") != "identity"};
+        bool cancelled;
+        UpdateTransfer(*transfer, on_update, [&](RequestTransfer& state) {
+            state.headers_received = true;
+            if (!encoded)
+                state.downloaded = current;
+            cancelled = state.cancelled;
+        });
+        return !cancelled;
+    };
+    // The client is created on the worker as well, setting up an SSL context takes a while
+    Common::ThreadPool::GetNetworkPool().Push([host = parsed_url.m_Host, port, https, timeout_sec,
+                                               ssl_config = ssl_config, request,
+                                               response = response, transfer = transfer,
+                                               on_update] {
+        std::unique_ptr<hl::Client> cli;
+        if (https)
+            cli = std::make_unique<hl::SSLClient>(host.c_str(), port, timeout_sec);
+        else
+            cli = std::make_unique<hl::Client>(host.c_str(), port, timeout_sec);
+        if (ssl_config.enable_client_cert)
+            cli->add_client_cert_ASN1(ssl_config.client_cert_ctx.certificate,
+                                      ssl_config.client_cert_ctx.private_key);
+        if (ssl_config.enable_root_cert_chain)
+            for (const auto& cert : ssl_config.root_ca_chain.certificates)
+                cli->add_cert(cert.certificate);
+        if ((ssl_config.options & 0x200) == 0x200)
+            cli->set_verify(hl::SSLVerifyMode::None);
+        if (!cli->send(*request, *response))
+            LOG_ERROR(Service_HTTP, "Request to {} failed", host);
         LOG_DEBUG(Service_HTTP, "Raw response: {}",
-                  GetRawResponseWithoutBody().append(1, '\n').append(response->body));
+                  GetRawResponseWithoutBody(*response).append(1, '\n').append(response->body));
+        UpdateTransfer(*transfer, on_update, [&](RequestTransfer& state) {
+            state.headers_received = true;
+            state.finished = true;
+            state.downloaded = response->body.size();
+        });
+    });
 }
 
 void Context::SetKeepAlive(bool enable) {
@@ -157,9 +206,9 @@ void Context::SetKeepAlive(bool enable) {
         headers->headers.erase("Connection");
 }
 
-std::string Context::GetRawResponseWithoutBody() const {
-    std::string str{fmt::format("HTTP/1.1 {} ", response->status)};
-    switch (response->status) {
+std::string Context::GetRawResponseWithoutBody(const httplib::Response& response) {
+    std::string str{fmt::format("HTTP/1.1 {} ", response.status)};
+    switch (response.status) {
     case 100:
         str += "Continue";
         break;
@@ -285,7 +334,7 @@ std::string Context::GetRawResponseWithoutBody() const {
         break;
     }
     str += "\r\n";
-    for (const auto& header : response->headers.headers) {
+    for (const auto& header : response.headers.headers) {
         str += header.first;
         str += ": ";
         str += header.second;
@@ -294,6 +343,92 @@ std::string Context::GetRawResponseWithoutBody() const {
     return str;
 }
 
+static bool HeadersReceived(const RequestTransfer& transfer) {
+    return transfer.headers_received;
+}
+
+/// Replies with the value of a response header written to the guest buffer
+static void PushResponseHeader(Kernel::HLERequestContext& ctx, u16 command_id,
+                               const httplib::Response& response, const std::string& name,
+                               u32 value_max_size, u32 value_buffer_id) {
+    if (!response.has_header(name.c_str())) {
+        IPC::ResponseBuilder rb{ctx, command_id, 1, 0};
+        rb.Push(ERROR_HEADER_NOT_FOUND);
+        LOG_ERROR(Service_HTTP, "Header not found (name={})", name);
+        return;
+    }
+    auto& value_buffer{ctx.GetMappedBuffer(value_buffer_id)};
+    std::string value{response.get_header_value(name.c_str())};
+    if (value.length() > value_max_size)
+        value.resize(value_max_size);
+    value_buffer.Write(value.c_str(), 0, value.length());
+    IPC::ResponseBuilder rb{ctx, command_id, 2, 2};
+    rb.Push(RESULT_SUCCESS);
+    rb.Push<u32>(value.length());
+    rb.PushMappedBuffer(value_buffer);
+    LOG_DEBUG(Service_HTTP, "name={}, value={}", name, value);
+}
+
+/// Replies with the status line and headers of the response written to the guest buffer
+static void PushRawResponse(Kernel::HLERequestContext& ctx, u16 command_id,
+                            const httplib::Response& response, u32 max_buffer_size,
+                            u32 buffer_id) {
+    auto& buffer{ctx.GetMappedBuffer(buffer_id)};
+    std::string raw{Context::GetRawResponseWithoutBody(response)};
+    if (raw.length() > max_buffer_size)
+        raw.resize(max_buffer_size);
+    buffer.Write(raw.c_str(), 0, raw.length());
+    IPC::ResponseBuilder rb{ctx, command_id, 2, 2};
+    rb.Push(RESULT_SUCCESS);
+    rb.Push<u32>(raw.length());
+    rb.PushMappedBuffer(buffer);
+}
+
+Context::UpdateCallback HTTP_C::MakeUpdateCallback() {
+    return [this] { system.CoreTiming().ScheduleEventThreadsafe(0, transfer_update_event, 0); };
+}
+
+void HTTP_C::WaitForTransfer(Kernel::HLERequestContext& ctx, const Context& context,
+                             TransferCondition condition, std::chrono::nanoseconds timeout,
+                             ReplyCallback reply) {
+    bool ready;
+    {
+        std::lock_guard lock{context.transfer->mutex};
+        ready = condition(*context.transfer);
+        if (!ready)
+            context.transfer->notify = true;
+    }
+    if (ready) {
+        reply(ctx, false);
+        return;
+    }
+    auto event{ctx.SleepClientThread(
+        system.Kernel().GetThreadManager().GetCurrentThread(), "http::WaitForTransfer", timeout,
+        [reply](Kernel::SharedPtr<Kernel::Thread> thread, Kernel::HLERequestContext& ctx,
+                Kernel::ThreadWakeupReason reason) {
+            reply(ctx, reason == Kernel::ThreadWakeupReason::Timeout);
+        })};
+    transfer_waiters.push_back({context.transfer, std::move(condition), std::move(event)});
+}
+
+void HTTP_C::WakeTransferWaiters() {
+    // Collected first, waking a thread can run a handler that adds waiters
+    std::vector<Kernel::SharedPtr<Kernel::Event>> ready;
+    for (auto itr{transfer_waiters.begin()}; itr != transfer_waiters.end();) {
+        std::lock_guard lock{itr->transfer->mutex};
+        if (!itr->condition(*itr->transfer)) {
+            // Still waiting, have the worker report its next update as well
+            itr->transfer->notify = true;
+            ++itr;
+            continue;
+        }
+        ready.push_back(std::move(itr->event));
+        itr = transfer_waiters.erase(itr);
+    }
+    for (auto& event : ready)
+        event->Signal();
+}
+
 void HTTP_C::Initialize(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp{ctx, 0x1, 1, 4};
     const u32 shmem_size{rp.Pop<u32>()};
@@ -429,6 +564,10 @@ void HTTP_C::CloseContext(Kernel::HLERequestContext& ctx) {
         return;
     }
     // TODO: Make sure that only the session that created the context can close it.
+    if (itr->second.transfer) {
+        std::lock_guard lock{itr->second.transfer->mutex};
+        itr->second.transfer->cancelled = true;
+    }
     contexts.erase(itr);
     --context_counter;
     --session_data->num_http_contexts;
@@ -625,10 +764,16 @@ void HTTP_C::GetRequestState(Kernel::HLERequestContext& ctx) {
     const u32 context_id{rp.Pop<u32>()};
     auto itr{contexts.find(context_id)};
     ASSERT(itr != contexts.end());
+    auto& context{itr->second};
+    if (context.state == RequestState::InProgress) {
+        std::lock_guard lock{context.transfer->mutex};
+        if (context.transfer->headers_received)
+            context.state = RequestState::ReadyToDownloadContent;
+    }
     auto rb{rp.MakeBuilder(2, 0)};
     rb.Push(RESULT_SUCCESS);
-    rb.PushEnum<RequestState>(itr->second.state);
-    LOG_DEBUG(Service_HTTP, "state={}", static_cast<u32>(itr->second.state));
+    rb.PushEnum<RequestState>(context.state);
+    LOG_DEBUG(Service_HTTP, "state={}", static_cast<u32>(context.state));
 }
 
 void HTTP_C::GetDownloadSizeState(Kernel::HLERequestContext& ctx) {
@@ -636,7 +781,12 @@ void HTTP_C::GetDownloadSizeState(Kernel::HLERequestContext& ctx) {
     const u32 context_id{rp.Pop<u32>()};
     auto itr{contexts.find(context_id)};
     ASSERT(itr != contexts.end());
-    u32 content_length{itr->second.GetResponseContentLength()};
+    u32 content_length{};
+    if (itr->second.transfer) {
+        std::lock_guard lock{itr->second.transfer->mutex};
+        if (itr->second.transfer->headers_received)
+            content_length = itr->second.GetResponseContentLength();
+    }
     auto rb{rp.MakeBuilder(3, 0)};
     rb.Push(RESULT_SUCCESS);
     rb.Push<u32>(itr->second.current_offset);
@@ -765,28 +915,18 @@ void HTTP_C::GetResponseHeader(Kernel::HLERequestContext& ctx) {
     const u32 name_size{rp.Pop<u32>()};
     const u32 value_max_size{rp.Pop<u32>()};
     const auto name_buffer{rp.PopStaticBuffer()};
-    auto& value_buffer{rp.PopMappedBuffer()};
+    const u32 value_buffer_id{rp.PopMappedBuffer().GetId()};
     const std::string name(name_buffer.begin(), name_buffer.end() - 1);
     auto itr{contexts.find(context_id)};
     ASSERT(itr != contexts.end());
-    if (itr->second.response->has_header(name.c_str())) {
-        std::string value{itr->second.response->get_header_value(name.c_str())};
-        if (value.length() > value_max_size)
-            value.resize(value_max_size);
-        value_buffer.Write(value.c_str(), 0, value.length());
-        auto rb{rp.MakeBuilder(2, 2)};
-        rb.Push(RESULT_SUCCESS);
-        rb.Push<u32>(value.length());
-        rb.PushMappedBuffer(value_buffer);
-        LOG_DEBUG(Service_HTTP, "name={}, name_size={}, value={}, value_max_size={}, context_id={}",
-                  name, name_size, value, value_max_size, context_id);
-    } else {
-        auto rb{rp.MakeBuilder(1, 0)};
-        rb.Push(ERROR_HEADER_NOT_FOUND);
-        LOG_ERROR(Service_HTTP,
-                  "Header not found (name={}, name_size={}, value_max_size={}, context_id={})",
-                  name, name_size, value_max_size, context_id);
-    }
+    WaitForTransfer(
+        ctx, itr->second, HeadersReceived, std::chrono::nanoseconds{0},
+        [response = itr->second.response, context_id, name, name_size, value_max_size,
+         value_buffer_id](Kernel::HLERequestContext& ctx, bool timed_out) {
+            PushResponseHeader(ctx, 0x1E, *response, name, value_max_size, value_buffer_id);
+            LOG_DEBUG(Service_HTTP, "name={}, name_size={}, value_max_size={}, context_id={}", name,
+                      name_size, value_max_size, context_id);
+        });
 }
 
 void HTTP_C::GetResponseHeaderTimeout(Kernel::HLERequestContext& ctx) {
@@ -796,48 +936,39 @@ void HTTP_C::GetResponseHeaderTimeout(Kernel::HLERequestContext& ctx) {
     const u32 value_max_size{rp.Pop<u32>()};
     const u64 timeout{rp.Pop<u64>()};
     const auto name_buffer{rp.PopStaticBuffer()};
-    auto& value_buffer{rp.PopMappedBuffer()};
+    const u32 value_buffer_id{rp.PopMappedBuffer().GetId()};
     const std::string name(name_buffer.begin(), name_buffer.end() - 1);
     auto itr{contexts.find(context_id)};
     ASSERT(itr != contexts.end());
     itr->second.timeout = timeout;
-    if (itr->second.response->has_header(name.c_str())) {
-        std::string value{itr->second.response->get_header_value(name.c_str())};
-        if (value.length() > value_max_size)
-            value.resize(value_max_size);
-        value_buffer.Write(value.c_str(), 0, value.length());
-        auto rb{rp.MakeBuilder(2, 2)};
-        rb.Push(RESULT_SUCCESS);
-        rb.Push<u32>(value.length());
-        rb.PushMappedBuffer(value_buffer);
-        LOG_DEBUG(Service_HTTP,
-                  "name={}, name_size={}, value={}, value_max_size={}, timeout={}, context_id={}",
-                  name, name_size, value, value_max_size, timeout, context_id);
-    } else {
-        auto rb{rp.MakeBuilder(1, 0)};
-        rb.Push(ERROR_HEADER_NOT_FOUND);
-        LOG_ERROR(Service_HTTP,
-                  "Header not found (name={}, name_size={}, value_max_size={}, timeout={}, "
-                  "context_id={})",
-                  name, name_size, value_max_size, timeout, context_id);
-    }
+    WaitForTransfer(
+        ctx, itr->second, HeadersReceived, std::chrono::nanoseconds{timeout},
+        [response = itr->second.response, context_id, name, name_size, value_max_size, timeout,
+         value_buffer_id](Kernel::HLERequestContext& ctx, bool timed_out) {
+            if (timed_out) {
+                IPC::ResponseBuilder rb{ctx, 0x1F, 1, 0};
+                rb.Push(ERROR_TIMEOUT);
+                return;
+            }
+            PushResponseHeader(ctx, 0x1F, *response, name, value_max_size, value_buffer_id);
+            LOG_DEBUG(Service_HTTP,
+                      "name={}, name_size={}, value_max_size={}, timeout={}, context_id={}", name,
+                      name_size, value_max_size, timeout, context_id);
+        });
 }
 
 void HTTP_C::GetResponseData(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp{ctx, 0x20, 2, 2};
     const u32 context_id{rp.Pop<u32>()};
     const u32 max_buffer_size{rp.Pop<u32>()};
-    auto& buffer{rp.PopMappedBuffer()};
+    const u32 buffer_id{rp.PopMappedBuffer().GetId()};
     auto itr{contexts.find(context_id)};
     ASSERT(itr != contexts.end());
-    std::string raw{itr->second.GetRawResponseWithoutBody()};
-    if (raw.length() > max_buffer_size)
-        raw.resize(max_buffer_size);
-    buffer.Write(raw.c_str(), 0, raw.length());
-    auto rb{rp.MakeBuilder(2, 2)};
-    rb.Push(RESULT_SUCCESS);
-    rb.Push<u32>(raw.length());
-    rb.PushMappedBuffer(buffer);
+    WaitForTransfer(ctx, itr->second, HeadersReceived, std::chrono::nanoseconds{0},
+                    [response = itr->second.response, max_buffer_size,
+                     buffer_id](Kernel::HLERequestContext& ctx, bool timed_out) {
+                        PushRawResponse(ctx, 0x20, *response, max_buffer_size, buffer_id);
+                    });
     LOG_DEBUG(Service_HTTP, "context_id={}, max_buffer_size={}", context_id, max_buffer_size);
 }
 
@@ -846,18 +977,20 @@ void HTTP_C::GetResponseDataTimeout(Kernel::HLERequestContext& ctx) {
     const u32 context_id{rp.Pop<u32>()};
     const u32 max_buffer_size{rp.Pop<u32>()};
     const u64 timeout{rp.Pop<u64>()};
-    auto& buffer{rp.PopMappedBuffer()};
+    const u32 buffer_id{rp.PopMappedBuffer().GetId()};
     auto itr{contexts.find(context_id)};
     ASSERT(itr != contexts.end());
     itr->second.timeout = timeout;
-    std::string raw{itr->second.GetRawResponseWithoutBody()};
-    if (raw.length() > max_buffer_size)
-        raw.resize(max_buffer_size);
-    buffer.Write(raw.c_str(), 0, raw.length());
-    auto rb{rp.MakeBuilder(2, 2)};
-    rb.Push(RESULT_SUCCESS);
-    rb.Push<u32>(raw.length());
-    rb.PushMappedBuffer(buffer);
+    WaitForTransfer(ctx, itr->second, HeadersReceived, std::chrono::nanoseconds{timeout},
+                    [response = itr->second.response, max_buffer_size,
+                     buffer_id](Kernel::HLERequestContext& ctx, bool timed_out) {
+                        if (timed_out) {
+                            IPC::ResponseBuilder rb{ctx, 0x21, 1, 0};
+                            rb.Push(ERROR_TIMEOUT);
+                            return;
+                        }
+                        PushRawResponse(ctx, 0x21, *response, max_buffer_size, buffer_id);
+                    });
     LOG_DEBUG(Service_HTTP, "context_id={}, max_buffer_size={}, timeout={}", context_id,
               max_buffer_size, timeout);
 }
@@ -867,10 +1000,15 @@ void HTTP_C::GetResponseStatusCode(Kernel::HLERequestContext& ctx) {
     const u32 context_id{rp.Pop<u32>()};
     auto itr{contexts.find(context_id)};
     ASSERT(itr != contexts.end());
-    auto rb{rp.MakeBuilder(2, 0)};
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(static_cast<u32>(itr->second.response->status));
-    LOG_DEBUG(Service_HTTP, "context_id={}, status={}", context_id, itr->second.response->status);
+    WaitForTransfer(ctx, itr->second, HeadersReceived, std::chrono::nanoseconds{0},
+                    [response = itr->second.response, context_id](Kernel::HLERequestContext& ctx,
+                                                                  bool timed_out) {
+                        IPC::ResponseBuilder rb{ctx, 0x22, 2, 0};
+                        rb.Push(RESULT_SUCCESS);
+                        rb.Push(static_cast<u32>(response->status));
+                        LOG_DEBUG(Service_HTTP, "context_id={}, status={}", context_id,
+                                  response->status);
+                    });
 }
 
 void HTTP_C::GetResponseStatusCodeTimeout(Kernel::HLERequestContext& ctx) {
@@ -880,11 +1018,20 @@ void HTTP_C::GetResponseStatusCodeTimeout(Kernel::HLERequestContext& ctx) {
     auto itr{contexts.find(context_id)};
     ASSERT(itr != contexts.end());
     itr->second.timeout = timeout;
-    auto rb{rp.MakeBuilder(2, 0)};
-    rb.Push(RESULT_SUCCESS);
-    rb.Push<u32>(static_cast<u32>(itr->second.response->status));
-    LOG_DEBUG(Service_HTTP, "context_id={}, timeout={}, status={}", context_id, timeout,
-              itr->second.response->status);
+    WaitForTransfer(ctx, itr->second, HeadersReceived, std::chrono::nanoseconds{timeout},
+                    [response = itr->second.response, context_id,
+                     timeout](Kernel::HLERequestContext& ctx, bool timed_out) {
+                        if (timed_out) {
+                            IPC::ResponseBuilder rb{ctx, 0x23, 1, 0};
+                            rb.Push(ERROR_TIMEOUT);
+                            return;
+                        }
+                        IPC::ResponseBuilder rb{ctx, 0x23, 2, 0};
+                        rb.Push(RESULT_SUCCESS);
+                        rb.Push<u32>(static_cast<u32>(response->status));
+                        LOG_DEBUG(Service_HTTP, "context_id={}, timeout={}, status={}", context_id,
+                                  timeout, response->status);
+                    });
 }
 
 void HTTP_C::AddTrustedRootCA(Kernel::HLERequestContext& ctx) {
@@ -1025,10 +1172,13 @@ void HTTP_C::BeginRequest(Kernel::HLERequestContext& ctx) {
         itr->second.ssl_config.client_cert_ctx.private_key = ClCertA.private_key;
     }
     itr->second.state = RequestState::InProgress;
-    itr->second.Send();
-    itr->second.state = RequestState::ReadyToDownloadContent;
-    auto rb{rp.MakeBuilder(1, 0)};
-    rb.Push(RESULT_SUCCESS);
+    itr->second.Send(MakeUpdateCallback());
+    // The request runs on a network worker, only the client thread waits for the response
+    WaitForTransfer(ctx, itr->second, HeadersReceived, std::chrono::nanoseconds{0},
+                    [](Kernel::HLERequestContext& ctx, bool timed_out) {
+                        IPC::ResponseBuilder rb{ctx, 0x9, 1, 0};
+                        rb.Push(RESULT_SUCCESS);
+                    });
     LOG_DEBUG(Service_HTTP, "context_id={}", context_id);
 }
 
@@ -1043,52 +1193,71 @@ void HTTP_C::BeginRequestAsync(Kernel::HLERequestContext& ctx) {
         itr->second.ssl_config.client_cert_ctx.private_key = ClCertA.private_key;
     }
     itr->second.state = RequestState::InProgress;
-    itr->second.Send();
-    itr->second.state = RequestState::ReadyToDownloadContent;
+    itr->second.Send(MakeUpdateCallback());
     auto rb{rp.MakeBuilder(1, 0)};
     rb.Push(RESULT_SUCCESS);
     LOG_DEBUG(Service_HTTP, "context_id={}", context_id);
 }
 
 void HTTP_C::ReceiveData(Kernel::HLERequestContext& ctx) {
-    IPC::RequestParser rp{ctx, 0xB, 2, 2};
-    const u32 context_id{rp.Pop<u32>()};
-    const u32 buffer_size{rp.Pop<u32>()};
-    auto& buffer{rp.PopMappedBuffer()};
-    auto itr{contexts.find(context_id)};
-    ASSERT(itr != contexts.end());
-    const u32 size{
-        std::min(buffer_size, itr->second.GetResponseContentLength() - itr->second.current_offset)};
-    buffer.Write(&itr->second.response->body[itr->second.current_offset], 0, size);
-    itr->second.current_offset += size;
-    auto rb{rp.MakeBuilder(1, 2)};
-    rb.Push(itr->second.current_offset < itr->second.GetResponseContentLength()
-                ? RESULT_DOWNLOADPENDING
-                : RESULT_SUCCESS);
-    rb.PushMappedBuffer(buffer);
-    LOG_TRACE(Service_HTTP, "context_id={}, buffer_size={}", context_id, buffer_size);
+    ReceiveDataImpl(ctx, false);
 }
 
 void HTTP_C::ReceiveDataTimeout(Kernel::HLERequestContext& ctx) {
-    IPC::RequestParser rp{ctx, 0xC, 4, 2};
+    ReceiveDataImpl(ctx, true);
+}
+
+void HTTP_C::ReceiveDataImpl(Kernel::HLERequestContext& ctx, bool timeout) {
+    const u16 command_id = timeout ? 0xC : 0xB;
+    IPC::RequestParser rp{ctx, command_id, timeout ? 4u : 2u, 2};
     const u32 context_id{rp.Pop<u32>()};
     const u32 buffer_size{rp.Pop<u32>()};
-    const u64 timeout{rp.Pop<u64>()};
-    auto& buffer{rp.PopMappedBuffer()};
+    const u64 timeout_nanos{timeout ? rp.Pop<u64>() : 0};
+    const u32 buffer_id{rp.PopMappedBuffer().GetId()};
     auto itr{contexts.find(context_id)};
     ASSERT(itr != contexts.end());
-    itr->second.timeout = timeout;
-    const u32 size{
-        std::min(buffer_size, itr->second.GetResponseContentLength() - itr->second.current_offset)};
-    buffer.Write(&itr->second.response->body[itr->second.current_offset], 0, size);
-    itr->second.current_offset += size;
-    auto rb{rp.MakeBuilder(1, 2)};
-    rb.Push(itr->second.current_offset < itr->second.GetResponseContentLength()
-                ? RESULT_DOWNLOADPENDING
-                : RESULT_SUCCESS);
-    rb.PushMappedBuffer(buffer);
-    LOG_TRACE(Service_HTTP, "context_id={}, buffer_size={}, timeout={}", context_id, buffer_size,
-              timeout);
+    if (timeout)
+        itr->second.timeout = timeout_nanos;
+    // Returns whatever part of the body arrived, only waiting while there is none
+    const u32 offset{itr->second.current_offset};
+    WaitForTransfer(
+        ctx, itr->second,
+        [offset](const RequestTransfer& transfer) {
+            return transfer.finished || transfer.downloaded > offset;
+        },
+        std::chrono::nanoseconds{timeout_nanos},
+        [this, command_id, context_id, buffer_size, buffer_id](Kernel::HLERequestContext& ctx,
+                                                               bool timed_out) {
+            auto& buffer{ctx.GetMappedBuffer(buffer_id)};
+            IPC::ResponseBuilder rb{ctx, command_id, 1, 2};
+            auto itr{contexts.find(context_id)};
+            if (itr == contexts.end()) {
+                rb.Push(ResultCode(ErrCodes::ContextNotFound, ErrorModule::HTTP,
+                                   ErrorSummary::InvalidState, ErrorLevel::Permanent));
+                rb.PushMappedBuffer(buffer);
+                return;
+            }
+            auto& context{itr->second};
+            std::size_t downloaded;
+            bool finished;
+            {
+                std::lock_guard lock{context.transfer->mutex};
+                downloaded = context.transfer->downloaded;
+                finished = context.transfer->finished;
+            }
+            const u32 size{static_cast<u32>(
+                std::min<std::size_t>(buffer_size, downloaded - context.current_offset))};
+            buffer.Write(&context.response->body[context.current_offset], 0, size);
+            context.current_offset += size;
+            if (timed_out && size == 0)
+                rb.Push(ERROR_TIMEOUT);
+            else
+                rb.Push(!finished || context.current_offset < downloaded ? RESULT_DOWNLOADPENDING
+                                                                         : RESULT_SUCCESS);
+            rb.PushMappedBuffer(buffer);
+            LOG_TRACE(Service_HTTP, "context_id={}, buffer_size={}, size={}", context_id,
+                      buffer_size, size);
+        });
 }
 
 void HTTP_C::SetProxyDefault(Kernel::HLERequestContext& ctx) {
@@ -1430,7 +1599,7 @@ void HTTP_C::LoadDefaultCerts(Core::System& system) {
     }
 }
 
-HTTP_C::HTTP_C(Core::System& system) : ServiceFramework{"http:C", 32} {
+HTTP_C::HTTP_C(Core::System& system) : ServiceFramework{"http:C", 32}, system{system} {
     static const FunctionInfo functions[]{
         {0x00010044, &HTTP_C::Initialize, "Initialize"},
         {0x00020082, &HTTP_C::CreateContext, "CreateContext"},
@@ -1493,10 +1662,29 @@ HTTP_C::HTTP_C(Core::System& system) : ServiceFramework{"http:C", 32} {
     RegisterHandlers(functions);
     DecryptClCertA(system);
     LoadDefaultCerts(system);
+    transfer_update_event = system.CoreTiming().RegisterEvent(
+        "HTTP_C::WakeTransferWaiters", [this](u64, s64) { WakeTransferWaiters(); });
+}
+
+HTTP_C::~HTTP_C() {
+    // Stop the running transfers, they must not report to the service anymore. Workers only
+    // report to it under the transfer mutex while notify is set, which only transfers with a
+    // waiter have.
+    for (auto& [handle, context] : contexts) {
+        if (!context.transfer)
+            continue;
+        std::lock_guard lock{context.transfer->mutex};
+        context.transfer->cancelled = true;
+        context.transfer->notify = false;
+    }
+    for (auto& waiter : transfer_waiters) {
+        std::lock_guard lock{waiter.transfer->mutex};
+        waiter.transfer->notify = false;
+    }
 }
 
 void InstallInterfaces(Core::System& system) {
     std::make_shared<HTTP_C>(system)->InstallAsService(system.ServiceManager());
 }
 
-} // namespace Service::HTTP
\ No newline at end of file
+} // namespace Service::HTTP
\ No newline at end of file
@@ -5,7 +5,10 @@
 #pragma once
 
 #include <array>
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <unordered_map>
@@ -15,8 +18,13 @@
 
 namespace Core {
 class System;
+struct TimingEventType;
 } // namespace Core
 
+namespace Kernel {
+class Event;
+} // namespace Kernel
+
 namespace httplib {
 struct Response;
 struct Headers;
@@ -83,6 +91,16 @@ struct DefaultRootCert {
     std::size_t size;
 };
 
+/// Progress of a request running on a network worker, shared with the emu thread
+struct RequestTransfer {
+    std::mutex mutex;
+    bool headers_received{};  ///< The response status and headers can be read
+    bool finished{};          ///< The worker is done with the response, it's complete or failed
+    bool cancelled{};         ///< The context was closed, the worker stops downloading
+    bool notify{};            ///< A client thread waits, the worker must report its next update
+    std::size_t downloaded{}; ///< Bytes at the start of the response body that can be read
+};
+
 /// Represents an HTTP context.
 class Context final {
 public:
@@ -156,10 +174,15 @@ public:
     bool proxy_default;
     u32 ssl_error{};
 
+    /// Called from a worker thread when a transfer that has notify set makes progress
+    using UpdateCallback = std::function<void()>;
+
+    std::shared_ptr<RequestTransfer> transfer;
+
     u32 GetResponseContentLength() const;
-    void Send();
+    void Send(UpdateCallback on_update);
     void SetKeepAlive(bool);
-    std::string GetRawResponseWithoutBody() const;
+    static std::string GetRawResponseWithoutBody(const httplib::Response& response);
 };
 
 struct SessionData : public Kernel::SessionRequestHandler::SessionDataBase {
@@ -186,6 +209,7 @@ struct SessionData : public Kernel::SessionRequestHandler::SessionDataBase {
 class HTTP_C final : public ServiceFramework<HTTP_C, SessionData> {
 public:
     explicit HTTP_C(Core::System& system);
+    ~HTTP_C();
 
 private:
     void Initialize(Kernel::HLERequestContext& ctx);
@@ -198,6 +222,7 @@ private:
     void BeginRequestAsync(Kernel::HLERequestContext& ctx);
     void ReceiveData(Kernel::HLERequestContext& ctx);
     void ReceiveDataTimeout(Kernel::HLERequestContext& ctx);
+    void ReceiveDataImpl(Kernel::HLERequestContext& ctx, bool timeout);
     void SetProxyDefault(Kernel::HLERequestContext& ctx);
     void SetSocketBufferSize(Kernel::HLERequestContext& ctx);
     void AddRequestHeader(Kernel::HLERequestContext& ctx);
@@ -238,6 +263,25 @@ private:
     void DecryptClCertA(Core::System& system);
     void LoadDefaultCerts(Core::System& system);
 
+    using TransferCondition = std::function<bool(const RequestTransfer& transfer)>;
+    using ReplyCallback = std::function<void(Kernel::HLERequestContext& ctx, bool timed_out)>;
+
+    /**
+     * Replies once the condition holds for the transfer of the context, putting the client thread
+     * to sleep until then. A timeout of 0 waits forever.
+     */
+    void WaitForTransfer(Kernel::HLERequestContext& ctx, const Context& context,
+                         TransferCondition condition, std::chrono::nanoseconds timeout,
+                         ReplyCallback reply);
+
+    /// Wakes the client threads whose transfer condition now holds, on the emu thread
+    void WakeTransferWaiters();
+
+    /// Makes the callback the workers use to schedule WakeTransferWaiters
+    Context::UpdateCallback MakeUpdateCallback();
+
+    Core::System& system;
+
     Kernel::SharedPtr<Kernel::SharedMemory> shared_memory{};
 
     /// The next number to use when a new HTTP session is initalized.
@@ -268,6 +312,18 @@ private:
     } ClCertA;
 
     std::array<DefaultRootCert, 11> default_root_certs;
+
+    struct TransferWaiter {
+        std::shared_ptr<RequestTransfer> transfer;
+        TransferCondition condition;
+        Kernel::SharedPtr<Kernel::Event> event;
+    };
+
+    /// Client threads waiting for a request running on a network worker
+    std::vector<TransferWaiter> transfer_waiters;
+
+    /// Scheduled from the workers to check the waiters on the emu thread
+    Core::TimingEventType* transfer_update_event;
 };
 
 void InstallInterfaces(Core::System& system);
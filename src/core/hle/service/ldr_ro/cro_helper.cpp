@@ -2,6 +2,10 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
 #include "common/alignment.h"
 #include "common/logging/log.h"
 #include "common/scope_exit.h"
@@ -48,6 +52,127 @@ const std::array<CROHelper::HeaderField, 4> CROHelper::FIX_BARRIERS{{
     Fix3Barrier,
 }};
 
+const ExportSymbolIndex::SymbolMap& ExportSymbolIndex::GetSymbols(const CROHelper& module) {
+    auto [itr, inserted]{modules.try_emplace(module.GetAddress())};
+    if (inserted)
+        itr->second = module.ReadExportNamedSymbols();
+    return itr->second;
+}
+
+void ExportSymbolIndex::Forget(VAddr module_address) {
+    modules.erase(module_address);
+}
+
+void ExportSymbolIndex::Clear() {
+    modules.clear();
+}
+
+void CROHelper::MapBuffer(u32 mapped_size) {
+    if (module_address == 0)
+        return;
+    // The sizes in the header aren't verified yet when loading, only map what is mapped for the
+    // module, which is the run of code alias areas starting at it unless the caller knows better
+    if (mapped_size == 0) {
+        const auto& vma_map{process.vm_manager.vma_map};
+        for (auto vma{process.vm_manager.FindVMA(module_address)};
+             vma != vma_map.end() && vma->second.type == Kernel::VMAType::BackingMemory &&
+             vma->second.meminfo_state == Kernel::MemoryState::AliasCode;
+             ++vma) {
+            mapped_size = vma->second.base + vma->second.size - module_address;
+        }
+    }
+    if (mapped_size < CRO_HEADER_SIZE)
+        return;
+    buffer = Memory::GetContiguousPointer(process, module_address, CRO_HEADER_SIZE);
+    if (!buffer)
+        return;
+    buffer_size = CRO_HEADER_SIZE;
+    // Fixing the module unmaps everything past the fixed size
+    u32 size{GetField(FixedSize)};
+    if (size == 0)
+        size = GetField(FileSize);
+    if (size > CRO_HEADER_SIZE && size <= mapped_size &&
+        Memory::GetContiguousPointer(process, module_address, size))
+        buffer_size = size;
+}
+
+u8* CROHelper::GetBufferPointer(VAddr address, std::size_t size) const {
+    if (!buffer || address < module_address)
+        return nullptr;
+    const u32 offset{address - module_address};
+    if (offset > buffer_size || size > buffer_size - offset)
+        return nullptr;
+    return buffer + offset;
+}
+
+u32 CROHelper::Read32(VAddr address) const {
+    if (const u8* pointer{GetBufferPointer(address, sizeof(u32))}) {
+        u32_le value;
+        std::memcpy(&value, pointer, sizeof(u32));
+        return value;
+    }
+    return Memory::Read32(address);
+}
+
+void CROHelper::Write32(VAddr address, u32 value) {
+    if (u8* pointer{GetBufferPointer(address, sizeof(u32))}) {
+        const u32_le value_le{value};
+        std::memcpy(pointer, &value_le, sizeof(u32));
+        return;
+    }
+    Memory::Write32(address, value);
+}
+
+void CROHelper::ReadBlock(VAddr address, void* data, std::size_t size) const {
+    if (const u8* pointer{GetBufferPointer(address, size)})
+        std::memcpy(data, pointer, size);
+    else
+        Memory::ReadBlock(process, address, data, size);
+}
+
+void CROHelper::WriteBlock(VAddr address, const void* data, std::size_t size) {
+    if (u8* pointer{GetBufferPointer(address, size)})
+        std::memcpy(pointer, data, size);
+    else
+        Memory::WriteBlock(process, address, data, size);
+}
+
+std::string CROHelper::ReadCString(VAddr address, std::size_t max_length) const {
+    if (const u8* pointer{GetBufferPointer(address, 1)}) {
+        const auto* begin{reinterpret_cast<const char*>(pointer)};
+        const std::size_t length{
+            std::min<std::size_t>(max_length, buffer_size - (address - module_address))};
+        const auto* end{std::find(begin, begin + length, '\0')};
+        // Strings running past the end of the buffer are read from guest memory
+        if (end != begin + length || length == max_length)
+            return {begin, end};
+    }
+    return Memory::ReadCString(address, max_length);
+}
+
+void CROHelper::WriteRelocation(VAddr target_address, u32 value) {
+    Write32(target_address, value);
+    // Coalesces nearby targets, a batch usually patches a few neighbouring words
+    const VAddr end{target_address + static_cast<VAddr>(sizeof(u32))};
+    if (modified_begin != modified_end && (end + Memory::PAGE_SIZE < modified_begin ||
+                                           target_address > modified_end + Memory::PAGE_SIZE))
+        FlushModifiedRange();
+    if (modified_begin == modified_end) {
+        modified_begin = target_address;
+        modified_end = end;
+        return;
+    }
+    modified_begin = std::min(modified_begin, target_address);
+    modified_end = std::max(modified_end, end);
+}
+
+void CROHelper::FlushModifiedRange() {
+    if (modified_begin == modified_end)
+        return;
+    process.system.CPU().InvalidateCacheRange(modified_begin, modified_end - modified_begin);
+    modified_begin = modified_end = 0;
+}
+
 VAddr CROHelper::SegmentTagToAddress(SegmentTag segment_tag) const {
     u32 segment_num{GetField(SegmentNum)};
     if (segment_tag.segment_index >= segment_num)
@@ -67,12 +192,10 @@ ResultCode CROHelper::ApplyRelocation(VAddr target_address, RelocationType reloc
         break;
     case RelocationType::AbsoluteAddress:
     case RelocationType::AbsoluteAddress2:
-        Memory::Write32(target_address, symbol_address + addend);
-        process.system.CPU().InvalidateCacheRange(target_address, sizeof(u32));
+        WriteRelocation(target_address, symbol_address + addend);
         break;
     case RelocationType::RelativeAddress:
-        Memory::Write32(target_address, symbol_address + addend - target_future_address);
-        process.system.CPU().InvalidateCacheRange(target_address, sizeof(u32));
+        WriteRelocation(target_address, symbol_address + addend - target_future_address);
         break;
     case RelocationType::ThumbBranch:
     case RelocationType::ArmBranch:
@@ -94,8 +217,7 @@ ResultCode CROHelper::ClearRelocation(VAddr target_address, RelocationType reloc
     case RelocationType::AbsoluteAddress:
     case RelocationType::AbsoluteAddress2:
     case RelocationType::RelativeAddress:
-        Memory::Write32(target_address, 0);
-        process.system.CPU().InvalidateCacheRange(target_address, sizeof(u32));
+        WriteRelocation(target_address, 0);
         break;
     case RelocationType::ThumbBranch:
     case RelocationType::ArmBranch:
@@ -113,10 +235,11 @@ ResultCode CROHelper::ClearRelocation(VAddr target_address, RelocationType reloc
 ResultCode CROHelper::ApplyRelocationBatch(VAddr batch, u32 symbol_address, bool reset) {
     if (symbol_address == 0 && !reset)
         return CROFormatError(0x10);
+    SCOPE_EXIT({ FlushModifiedRange(); });
     auto relocation_address{batch};
     for (;;) {
         RelocationEntry relocation;
-        Memory::ReadBlock(process, relocation_address, &relocation, sizeof(RelocationEntry));
+        ReadBlock(relocation_address, &relocation, sizeof(RelocationEntry));
         auto relocation_target{SegmentTagToAddress(relocation.target_position)};
         if (relocation_target == 0)
             return CROFormatError(0x12);
@@ -131,9 +254,9 @@ ResultCode CROHelper::ApplyRelocationBatch(VAddr batch, u32 symbol_address, bool
         relocation_address += sizeof(RelocationEntry);
     }
     RelocationEntry relocation;
-    Memory::ReadBlock(process, batch, &relocation, sizeof(RelocationEntry));
+    ReadBlock(batch, &relocation, sizeof(RelocationEntry));
     relocation.is_batch_resolved = reset ? 0 : 1;
-    Memory::WriteBlock(process, batch, &relocation, sizeof(RelocationEntry));
+    WriteBlock(batch, &relocation, sizeof(RelocationEntry));
     return RESULT_SUCCESS;
 }
 
@@ -167,11 +290,32 @@ VAddr CROHelper::FindExportNamedSymbol(const std::string& name) const {
     u32 export_strings_size{GetField(ExportStringsSize)};
     ExportNamedSymbolEntry symbol_entry;
     GetEntry(found_id, symbol_entry);
-    if (Memory::ReadCString(symbol_entry.name_offset, export_strings_size) != name)
+    if (ReadCString(symbol_entry.name_offset, export_strings_size) != name)
         return 0;
     return SegmentTagToAddress(symbol_entry.symbol_position);
 }
 
+ExportSymbolIndex::SymbolMap CROHelper::ReadExportNamedSymbols() const {
+    ExportSymbolIndex::SymbolMap symbols;
+    // Symbols can only be found through the export tree
+    if (!GetField(ExportTreeNum))
+        return symbols;
+    u32 export_strings_size{GetField(ExportStringsSize)};
+    u32 export_named_symbol_num{GetField(ExportNamedSymbolNum)};
+    symbols.reserve(export_named_symbol_num);
+    for (u32 i{}; i < export_named_symbol_num; ++i) {
+        ExportNamedSymbolEntry entry;
+        GetEntry(i, entry);
+        if (entry.name_offset == 0)
+            continue;
+        VAddr symbol_address{SegmentTagToAddress(entry.symbol_position)};
+        if (symbol_address != 0)
+            symbols.try_emplace(ReadCString(entry.name_offset, export_strings_size),
+                                symbol_address);
+    }
+    return symbols;
+}
+
 ResultCode CROHelper::RebaseHeader(u32 cro_size) {
     ResultCode error{CROFormatError(0x11)};
     // Verifies magic
@@ -418,6 +562,7 @@ VAddr CROHelper::GetOnUnresolvedAddress() {
 }
 
 ResultCode CROHelper::ResetExternalRelocations() {
+    SCOPE_EXIT({ FlushModifiedRange(); });
     u32 unresolved_symbol{static_cast<u32>(GetOnUnresolvedAddress())};
     u32 external_relocation_num{GetField(ExternalRelocationNum)};
     ExternalRelocationEntry relocation;
@@ -449,6 +594,7 @@ ResultCode CROHelper::ResetExternalRelocations() {
 }
 
 ResultCode CROHelper::ClearExternalRelocations() {
+    SCOPE_EXIT({ FlushModifiedRange(); });
     u32 external_relocation_num{GetField(ExternalRelocationNum)};
     ExternalRelocationEntry relocation;
     bool batch_begin{true};
@@ -502,6 +648,7 @@ ResultCode CROHelper::ApplyStaticAnonymousSymbolToCRS(VAddr crs_address) {
 }
 
 ResultCode CROHelper::ApplyInternalRelocations(u32 old_data_segment_address) {
+    SCOPE_EXIT({ FlushModifiedRange(); });
     u32 segment_num{GetField(SegmentNum)};
     u32 internal_relocation_num{GetField(InternalRelocationNum)};
     for (u32 i{}; i < internal_relocation_num; ++i) {
@@ -536,6 +683,7 @@ ResultCode CROHelper::ApplyInternalRelocations(u32 old_data_segment_address) {
 }
 
 ResultCode CROHelper::ClearInternalRelocations() {
+    SCOPE_EXIT({ FlushModifiedRange(); });
     u32 internal_relocation_num{GetField(InternalRelocationNum)};
     for (u32 i{}; i < internal_relocation_num; ++i) {
         InternalRelocationEntry relocation;
@@ -638,37 +786,38 @@ void CROHelper::UnrebaseHeader() {
     }
 }
 
-ResultCode CROHelper::ApplyImportNamedSymbol(VAddr crs_address) {
+ResultCode CROHelper::ApplyImportNamedSymbol(VAddr crs_address, ExportSymbolIndex& export_index) {
     u32 import_strings_size{GetField(ImportStringsSize)};
     u32 symbol_import_num{GetField(ImportNamedSymbolNum)};
+    if (symbol_import_num == 0)
+        return RESULT_SUCCESS;
+    // Gathers the symbols of all auto-link modules once, in lookup order
+    std::vector<std::pair<VAddr, const ExportSymbolIndex::SymbolMap*>> sources;
+    ForEachAutoLinkCRO(process, crs_address, [&](CROHelper source) -> ResultVal<bool> {
+        sources.emplace_back(source.module_address, &export_index.GetSymbols(source));
+        return MakeResult<bool>(true);
+    });
     for (u32 i{}; i < symbol_import_num; ++i) {
         ImportNamedSymbolEntry entry;
         GetEntry(i, entry);
         auto relocation_addr{static_cast<VAddr>(entry.relocation_batch_offset)};
         ExternalRelocationEntry relocation_entry;
-        Memory::ReadBlock(process, relocation_addr, &relocation_entry,
-                          sizeof(ExternalRelocationEntry));
-        if (!relocation_entry.is_batch_resolved) {
-            auto result{
-                ForEachAutoLinkCRO(process, crs_address, [&](CROHelper source) -> ResultVal<bool> {
-                    std::string symbol_name{
-                        Memory::ReadCString(entry.name_offset, import_strings_size)};
-                    u32 symbol_address{source.FindExportNamedSymbol(symbol_name)};
-                    if (symbol_address != 0) {
-                        LOG_TRACE(Service_LDR, "CRO {} imports {} from {}", ModuleName(),
-                                  symbol_name, source.ModuleName());
-                        auto result{ApplyRelocationBatch(relocation_addr, symbol_address)};
-                        if (result.IsError()) {
-                            LOG_ERROR(Service_LDR, "Error applying relocation batch {:08X}",
-                                      result.raw);
-                            return result;
-                        }
-                        return MakeResult<bool>(false);
-                    }
-                    return MakeResult<bool>(true);
-                })};
-            if (result.IsError())
+        ReadBlock(relocation_addr, &relocation_entry, sizeof(ExternalRelocationEntry));
+        if (relocation_entry.is_batch_resolved)
+            continue;
+        std::string symbol_name{ReadCString(entry.name_offset, import_strings_size)};
+        for (const auto& [source_address, symbols] : sources) {
+            auto symbol{symbols->find(symbol_name)};
+            if (symbol == symbols->end())
+                continue;
+            LOG_TRACE(Service_LDR, "CRO {} imports {} from {}", ModuleName(), symbol_name,
+                      CROHelper(source_address, process).ModuleName());
+            auto result{ApplyRelocationBatch(relocation_addr, symbol->second)};
+            if (result.IsError()) {
+                LOG_ERROR(Service_LDR, "Error applying relocation batch {:08X}", result.raw);
                 return result;
+            }
+            break;
         }
     }
     return RESULT_SUCCESS;
@@ -682,8 +831,7 @@ ResultCode CROHelper::ResetImportNamedSymbol() {
         GetEntry(i, entry);
         auto relocation_addr{static_cast<VAddr>(entry.relocation_batch_offset)};
         ExternalRelocationEntry relocation_entry;
-        Memory::ReadBlock(process, relocation_addr, &relocation_entry,
-                          sizeof(ExternalRelocationEntry));
+        ReadBlock(relocation_addr, &relocation_entry, sizeof(ExternalRelocationEntry));
         auto result{ApplyRelocationBatch(relocation_addr, unresolved_symbol, true)};
         if (result.IsError()) {
             LOG_ERROR(Service_LDR, "Error reseting relocation batch {:08X}", result.raw);
@@ -701,8 +849,7 @@ ResultCode CROHelper::ResetImportIndexedSymbol() {
         GetEntry(i, entry);
         auto relocation_addr{static_cast<VAddr>(entry.relocation_batch_offset)};
         ExternalRelocationEntry relocation_entry;
-        Memory::ReadBlock(process, relocation_addr, &relocation_entry,
-                          sizeof(ExternalRelocationEntry));
+        ReadBlock(relocation_addr, &relocation_entry, sizeof(ExternalRelocationEntry));
         auto result{ApplyRelocationBatch(relocation_addr, unresolved_symbol, true)};
         if (result.IsError()) {
             LOG_ERROR(Service_LDR, "Error reseting relocation batch {:08X}", result.raw);
@@ -720,8 +867,7 @@ ResultCode CROHelper::ResetImportAnonymousSymbol() {
         GetEntry(i, entry);
         VAddr relocation_addr{static_cast<VAddr>(entry.relocation_batch_offset)};
         ExternalRelocationEntry relocation_entry;
-        Memory::ReadBlock(process, relocation_addr, &relocation_entry,
-                          sizeof(ExternalRelocationEntry));
+        ReadBlock(relocation_addr, &relocation_entry, sizeof(ExternalRelocationEntry));
         ResultCode result = ApplyRelocationBatch(relocation_addr, unresolved_symbol, true);
         if (result.IsError()) {
             LOG_ERROR(Service_LDR, "Error reseting relocation batch {:08X}", result.raw);
@@ -737,7 +883,7 @@ ResultCode CROHelper::ApplyModuleImport(VAddr crs_address) {
     for (u32 i{}; i < import_module_num; ++i) {
         ImportModuleEntry entry;
         GetEntry(i, entry);
-        auto want_cro_name{Memory::ReadCString(entry.name_offset, import_strings_size)};
+        auto want_cro_name{ReadCString(entry.name_offset, import_strings_size)};
         auto result{
             ForEachAutoLinkCRO(process, crs_address, [&](CROHelper source) -> ResultVal<bool> {
                 if (want_cro_name == source.ModuleName()) {
@@ -745,7 +891,7 @@ ResultCode CROHelper::ApplyModuleImport(VAddr crs_address) {
                              entry.import_indexed_symbol_num, source.ModuleName());
                     for (u32 j{}; j < entry.import_indexed_symbol_num; ++j) {
                         ImportIndexedSymbolEntry im;
-                        entry.GetImportIndexedSymbolEntry(process, j, im);
+                        entry.GetImportIndexedSymbolEntry(*this, j, im);
                         ExportIndexedSymbolEntry ex;
                         source.GetEntry(im.index, ex);
                         u32 symbol_address{
@@ -763,7 +909,7 @@ ResultCode CROHelper::ApplyModuleImport(VAddr crs_address) {
                              ModuleName(), entry.import_anonymous_symbol_num, source.ModuleName());
                     for (u32 j{}; j < entry.import_anonymous_symbol_num; ++j) {
                         ImportAnonymousSymbolEntry im;
-                        entry.GetImportAnonymousSymbolEntry(process, j, im);
+                        entry.GetImportAnonymousSymbolEntry(*this, j, im);
                         u32 symbol_address{source.SegmentTagToAddress(im.symbol_position)};
                         LOG_TRACE(Service_LDR, "    Imports 0x{:08X}", symbol_address);
                         ResultCode result{
@@ -784,8 +930,9 @@ ResultCode CROHelper::ApplyModuleImport(VAddr crs_address) {
     return RESULT_SUCCESS;
 }
 
-ResultCode CROHelper::ApplyExportNamedSymbol(CROHelper target) {
+ResultCode CROHelper::ApplyExportNamedSymbol(CROHelper target, ExportSymbolIndex& export_index) {
     LOG_DEBUG(Service_LDR, "CRO {} exports named symbols to {}", ModuleName(), target.ModuleName());
+    const auto& symbols{export_index.GetSymbols(*this)};
     u32 target_import_strings_size{target.GetField(ImportStringsSize)};
     u32 target_symbol_import_num{target.GetField(ImportNamedSymbolNum)};
     for (u32 i{}; i < target_symbol_import_num; ++i) {
@@ -793,14 +940,13 @@ ResultCode CROHelper::ApplyExportNamedSymbol(CROHelper target) {
         target.GetEntry(i, entry);
         auto relocation_addr{static_cast<VAddr>(entry.relocation_batch_offset)};
         ExternalRelocationEntry relocation_entry;
-        Memory::ReadBlock(process, relocation_addr, &relocation_entry,
-                          sizeof(ExternalRelocationEntry));
+        ReadBlock(relocation_addr, &relocation_entry, sizeof(ExternalRelocationEntry));
         if (!relocation_entry.is_batch_resolved) {
-            auto symbol_name{Memory::ReadCString(entry.name_offset, target_import_strings_size)};
-            u32 symbol_address{FindExportNamedSymbol(symbol_name)};
-            if (symbol_address != 0) {
+            auto symbol_name{target.ReadCString(entry.name_offset, target_import_strings_size)};
+            auto symbol{symbols.find(symbol_name)};
+            if (symbol != symbols.end()) {
                 LOG_TRACE(Service_LDR, "exports symbol {}", symbol_name);
-                auto result{target.ApplyRelocationBatch(relocation_addr, symbol_address)};
+                auto result{target.ApplyRelocationBatch(relocation_addr, symbol->second)};
                 if (result.IsError()) {
                     LOG_ERROR(Service_LDR, "Error applying relocation batch {:08X}", result.raw);
                     return result;
@@ -811,9 +957,10 @@ ResultCode CROHelper::ApplyExportNamedSymbol(CROHelper target) {
     return RESULT_SUCCESS;
 }
 
-ResultCode CROHelper::ResetExportNamedSymbol(CROHelper target) {
+ResultCode CROHelper::ResetExportNamedSymbol(CROHelper target, ExportSymbolIndex& export_index) {
     LOG_DEBUG(Service_LDR, "CRO {} unexports named symbols to {}", ModuleName(),
               target.ModuleName());
+    const auto& symbols{export_index.GetSymbols(*this)};
     u32 unresolved_symbol{static_cast<u32>(target.GetOnUnresolvedAddress())};
     u32 target_import_strings_size{target.GetField(ImportStringsSize)};
     u32 target_symbol_import_num{target.GetField(ImportNamedSymbolNum)};
@@ -822,12 +969,10 @@ ResultCode CROHelper::ResetExportNamedSymbol(CROHelper target) {
         target.GetEntry(i, entry);
         auto relocation_addr{static_cast<VAddr>(entry.relocation_batch_offset)};
         ExternalRelocationEntry relocation_entry;
-        Memory::ReadBlock(process, relocation_addr, &relocation_entry,
-                          sizeof(ExternalRelocationEntry));
+        ReadBlock(relocation_addr, &relocation_entry, sizeof(ExternalRelocationEntry));
         if (relocation_entry.is_batch_resolved) {
-            auto symbol_name{Memory::ReadCString(entry.name_offset, target_import_strings_size)};
-            u32 symbol_address{FindExportNamedSymbol(symbol_name)};
-            if (symbol_address != 0) {
+            auto symbol_name{target.ReadCString(entry.name_offset, target_import_strings_size)};
+            if (symbols.count(symbol_name)) {
                 LOG_TRACE(Service_LDR, "unexports symbol {}", symbol_name);
                 auto result{target.ApplyRelocationBatch(relocation_addr, unresolved_symbol, true)};
                 if (result.IsError()) {
@@ -847,13 +992,13 @@ ResultCode CROHelper::ApplyModuleExport(CROHelper target) {
     for (u32 i{}; i < target_import_module_num; ++i) {
         ImportModuleEntry entry;
         target.GetEntry(i, entry);
-        if (Memory::ReadCString(entry.name_offset, target_import_string_size) != module_name)
+        if (target.ReadCString(entry.name_offset, target_import_string_size) != module_name)
             continue;
         LOG_INFO(Service_LDR, "CRO {} exports {} indexed symbols to {}", module_name,
                  entry.import_indexed_symbol_num, target.ModuleName());
         for (u32 j{}; j < entry.import_indexed_symbol_num; ++j) {
             ImportIndexedSymbolEntry im;
-            entry.GetImportIndexedSymbolEntry(process, j, im);
+            entry.GetImportIndexedSymbolEntry(target, j, im);
             ExportIndexedSymbolEntry ex;
             GetEntry(im.index, ex);
             u32 symbol_address{static_cast<u32>(SegmentTagToAddress(ex.symbol_position))};
@@ -868,7 +1013,7 @@ ResultCode CROHelper::ApplyModuleExport(CROHelper target) {
                  entry.import_anonymous_symbol_num, target.ModuleName());
         for (u32 j{}; j < entry.import_anonymous_symbol_num; ++j) {
             ImportAnonymousSymbolEntry im;
-            entry.GetImportAnonymousSymbolEntry(process, j, im);
+            entry.GetImportAnonymousSymbolEntry(target, j, im);
             u32 symbol_address{SegmentTagToAddress(im.symbol_position)};
             LOG_TRACE(Service_LDR, "    exports symbol 0x{:08X}", symbol_address);
             auto result{target.ApplyRelocationBatch(im.relocation_batch_offset, symbol_address)};
@@ -889,13 +1034,13 @@ ResultCode CROHelper::ResetModuleExport(CROHelper target) {
     for (u32 i{}; i < target_import_module_num; ++i) {
         ImportModuleEntry entry;
         target.GetEntry(i, entry);
-        if (Memory::ReadCString(entry.name_offset, target_import_string_size) != module_name)
+        if (target.ReadCString(entry.name_offset, target_import_string_size) != module_name)
             continue;
         LOG_DEBUG(Service_LDR, "CRO {} unexports indexed symbols to {}", module_name,
                   target.ModuleName());
         for (u32 j{}; j < entry.import_indexed_symbol_num; ++j) {
             ImportIndexedSymbolEntry im;
-            entry.GetImportIndexedSymbolEntry(process, j, im);
+            entry.GetImportIndexedSymbolEntry(target, j, im);
             auto result{
                 target.ApplyRelocationBatch(im.relocation_batch_offset, unresolved_symbol, true)};
             if (result.IsError()) {
@@ -907,7 +1052,7 @@ ResultCode CROHelper::ResetModuleExport(CROHelper target) {
                   target.ModuleName());
         for (u32 j{}; j < entry.import_anonymous_symbol_num; ++j) {
             ImportAnonymousSymbolEntry im;
-            entry.GetImportAnonymousSymbolEntry(process, j, im);
+            entry.GetImportAnonymousSymbolEntry(target, j, im);
             auto result{
                 target.ApplyRelocationBatch(im.relocation_batch_offset, unresolved_symbol, true)};
             if (result.IsError()) {
@@ -927,9 +1072,8 @@ ResultCode CROHelper::ApplyExitRelocations(VAddr crs_address) {
         GetEntry(i, entry);
         VAddr relocation_addr{static_cast<VAddr>(entry.relocation_batch_offset)};
         ExternalRelocationEntry relocation_entry;
-        Memory::ReadBlock(process, relocation_addr, &relocation_entry,
-                          sizeof(ExternalRelocationEntry));
-        if (Memory::ReadCString(entry.name_offset, import_strings_size) == "__aeabi_atexit") {
+        ReadBlock(relocation_addr, &relocation_entry, sizeof(ExternalRelocationEntry));
+        if (ReadCString(entry.name_offset, import_strings_size) == "__aeabi_atexit") {
             auto result{
                 ForEachAutoLinkCRO(process, crs_address, [&](CROHelper source) -> ResultVal<bool> {
                     u32 symbol_address{source.FindExportNamedSymbol("nnroAeabiAtexit_")};
@@ -1080,7 +1224,8 @@ ResultCode CROHelper::VerifyHash(u32 cro_size, VAddr crr) const {
     return RESULT_SUCCESS;
 }
 
-ResultCode CROHelper::Link(VAddr crs_address, bool link_on_load_bug_fix) {
+ResultCode CROHelper::Link(VAddr crs_address, bool link_on_load_bug_fix,
+                           ExportSymbolIndex& export_index) {
     auto result{RESULT_SUCCESS};
     {
         VAddr data_segment_address;
@@ -1116,21 +1261,23 @@ ResultCode CROHelper::Link(VAddr crs_address, bool link_on_load_bug_fix) {
             }
         });
         // Imports named symbols from other modules
-        result = ApplyImportNamedSymbol(crs_address);
+        result = ApplyImportNamedSymbol(crs_address, export_index);
         if (result.IsError()) {
             LOG_ERROR(Service_LDR, "Error applying symbol import {:08X}", result.raw);
+            export_index.Forget(module_address);
             return result;
         }
         // Imports indexed and anonymous symbols from other modules
         result = ApplyModuleImport(crs_address);
         if (result.IsError()) {
             LOG_ERROR(Service_LDR, "Error applying module import {:08X}", result.raw);
+            export_index.Forget(module_address);
             return result;
         }
     }
     // Exports symbols to other modules
-    result = ForEachAutoLinkCRO(process, crs_address, [this](CROHelper target) -> ResultVal<bool> {
-        auto result{ApplyExportNamedSymbol(target)};
+    result = ForEachAutoLinkCRO(process, crs_address, [&](CROHelper target) -> ResultVal<bool> {
+        auto result{ApplyExportNamedSymbol(target, export_index)};
         if (result.IsError())
             return result;
         result = ApplyModuleExport(target);
@@ -1140,12 +1287,14 @@ ResultCode CROHelper::Link(VAddr crs_address, bool link_on_load_bug_fix) {
     });
     if (result.IsError()) {
         LOG_ERROR(Service_LDR, "Error applying export {:08X}", result.raw);
+        // Other modules may have indexed the exports of this one, which won't be rebased for long
+        export_index.Forget(module_address);
         return result;
     }
     return RESULT_SUCCESS;
 }
 
-ResultCode CROHelper::Unlink(VAddr crs_address) {
+ResultCode CROHelper::Unlink(VAddr crs_address, ExportSymbolIndex& export_index) {
     // Resets all imported named symbols
     auto result{ResetImportNamedSymbol()};
     if (result.IsError()) {
@@ -1166,8 +1315,8 @@ ResultCode CROHelper::Unlink(VAddr crs_address) {
     }
     // Resets all symbols in other modules imported from this module
     // Note: the RO service seems only searching in auto-link modules
-    result = ForEachAutoLinkCRO(process, crs_address, [this](CROHelper target) -> ResultVal<bool> {
-        auto result{ResetExportNamedSymbol(target)};
+    result = ForEachAutoLinkCRO(process, crs_address, [&](CROHelper target) -> ResultVal<bool> {
+        auto result{ResetExportNamedSymbol(target, export_index)};
         if (result.IsError())
             return result;
         result = ResetModuleExport(target);
@@ -1294,6 +1443,8 @@ u32 CROHelper::Fix(u32 fix_level) {
     fix_end = Common::AlignUp(fix_end, Memory::PAGE_SIZE);
     u32 fixed_size{fix_end - module_address};
     SetField(FixedSize, fixed_size);
+    // The caller unmaps everything past the fixed size
+    buffer_size = std::min(buffer_size, fixed_size);
     return fixed_size;
 }
 
@@ -5,7 +5,9 @@
 #pragma once
 
 #include <array>
+#include <string>
 #include <tuple>
+#include <unordered_map>
 #include "common/common_types.h"
 #include "common/swap.h"
 #include "core/hle/result.h"
@@ -36,14 +38,54 @@ namespace Service::LDR {
 constexpr u32 CRO_HEADER_SIZE{0x138};
 constexpr u32 CRO_HASH_SIZE{0x80};
 
-/// Represents a loaded module (CRO) with interfaces manipulating it.
+class CROHelper;
+
+/**
+ * Host index of the named symbols exported by loaded modules, keyed by module address. Imports are
+ * resolved with hash lookups in it instead of walking export trees in guest memory. A module must
+ * be forgotten when it's unloaded, as its symbols are only valid while it's rebased.
+ */
+class ExportSymbolIndex {
+public:
+    using SymbolMap = std::unordered_map<std::string, VAddr>;
+
+    /// Gets the named symbols exported by a rebased module, indexing them on first use
+    const SymbolMap& GetSymbols(const CROHelper& module);
+
+    void Forget(VAddr module_address);
+
+    void Clear();
+
+private:
+    std::unordered_map<VAddr, SymbolMap> modules;
+};
+
+/**
+ * Represents a loaded module (CRO) with interfaces manipulating it.
+ * The module buffer is mapped once on construction, and header fields, tables and relocation
+ * targets inside of it are accessed through the host pointer. Accesses outside of the buffer (such
+ * as the .data and .bss segments) and modules that aren't contiguous on the host go through the
+ * guest memory functions instead.
+ */
 class CROHelper final {
 public:
-    explicit CROHelper(VAddr cro_address, Kernel::Process& process)
-        : module_address{cro_address}, process{process} {}
+    /**
+     * @param cro_address the virtual address of the module
+     * @param process the owner process of the module
+     * @param mapped_size the size of the memory mapped for the module if known, which bounds the
+     *        buffer accessed through the host pointer
+     */
+    explicit CROHelper(VAddr cro_address, Kernel::Process& process, u32 mapped_size = 0)
+        : module_address{cro_address}, process{process} {
+        MapBuffer(mapped_size);
+    }
+
+    VAddr GetAddress() const {
+        return module_address;
+    }
 
     std::string ModuleName() const {
-        return Memory::ReadCString(GetField(ModuleNameOffset), GetField(ModuleNameSize));
+        return ReadCString(GetField(ModuleNameOffset), GetField(ModuleNameSize));
     }
 
     u32 GetFileSize() const {
@@ -83,16 +125,18 @@ public:
      * Links this module with all registered auto-link module.
      * @param crs_address the virtual address of the static module
      * @param link_on_load_bug_fix true if links when loading and fixes the bug
+     * @param export_index the index of the symbols exported by loaded modules
      * @returns ResultCode RESULT_SUCCESS on success, otherwise error code.
      */
-    ResultCode Link(VAddr crs_address, bool link_on_load_bug_fix);
+    ResultCode Link(VAddr crs_address, bool link_on_load_bug_fix, ExportSymbolIndex& export_index);
 
     /**
      * Unlinks this module with other modules.
      * @param crs_address the virtual address of the static module
+     * @param export_index the index of the symbols exported by loaded modules
      * @returns ResultCode RESULT_SUCCESS on success, otherwise error code.
      */
-    ResultCode Unlink(VAddr crs_address);
+    ResultCode Unlink(VAddr crs_address, ExportSymbolIndex& export_index);
 
     /**
      * Clears all relocations to zero.
@@ -146,10 +190,23 @@ public:
      */
     std::tuple<VAddr, u32> GetExecutablePages() const;
 
+    /**
+     * Reads all named symbols exported by this module.
+     * @returns a map from symbol names to their virtual addresses.
+     */
+    ExportSymbolIndex::SymbolMap ReadExportNamedSymbols() const;
+
 private:
     const VAddr module_address; ///< The virtual address of this module
     Kernel::Process& process;   ///< The owner process of this module
 
+    u8* buffer{};      ///< Host pointer to the module buffer, null if it can't be mapped
+    u32 buffer_size{}; ///< Size of the buffer accessible through the host pointer
+
+    // Range of relocation targets written since the JIT cache was last invalidated
+    VAddr modified_begin{};
+    VAddr modified_end{};
+
     /**
      * Each item in this enum represents a u32 field in the header begin from address+0x80,
      * successively. We don't directly use a struct here, to avoid GetPointer, reinterpret_cast, or
@@ -316,20 +373,18 @@ private:
 
         static constexpr HeaderField TABLE_OFFSET_FIELD = ImportModuleTableOffset;
 
-        void GetImportIndexedSymbolEntry(Kernel::Process& process, u32 index,
-                                         ImportIndexedSymbolEntry& entry) {
-            Memory::ReadBlock(process,
-                              import_indexed_symbol_table_offset +
-                                  index * sizeof(ImportIndexedSymbolEntry),
-                              &entry, sizeof(ImportIndexedSymbolEntry));
+        void GetImportIndexedSymbolEntry(const CROHelper& module, u32 index,
+                                         ImportIndexedSymbolEntry& entry) const {
+            module.ReadBlock(import_indexed_symbol_table_offset +
+                                 index * sizeof(ImportIndexedSymbolEntry),
+                             &entry, sizeof(ImportIndexedSymbolEntry));
         }
 
-        void GetImportAnonymousSymbolEntry(Kernel::Process& process, u32 index,
-                                           ImportAnonymousSymbolEntry& entry) {
-            Memory::ReadBlock(process,
-                              import_anonymous_symbol_table_offset +
-                                  index * sizeof(ImportAnonymousSymbolEntry),
-                              &entry, sizeof(ImportAnonymousSymbolEntry));
+        void GetImportAnonymousSymbolEntry(const CROHelper& module, u32 index,
+                                           ImportAnonymousSymbolEntry& entry) const {
+            module.ReadBlock(import_anonymous_symbol_table_offset +
+                                 index * sizeof(ImportAnonymousSymbolEntry),
+                             &entry, sizeof(ImportAnonymousSymbolEntry));
         }
     };
     ASSERT_CRO_STRUCT(ImportModuleEntry, 20);
@@ -405,12 +460,33 @@ private:
         return module_address + CRO_HASH_SIZE + field * 4;
     }
 
+    /// Maps the module buffer, called on construction
+    void MapBuffer(u32 mapped_size);
+
+    /**
+     * Gets a host pointer to a range of the module buffer.
+     * @returns the pointer, or nullptr if the range isn't entirely inside of the mapped buffer.
+     */
+    u8* GetBufferPointer(VAddr address, std::size_t size) const;
+
+    u32 Read32(VAddr address) const;
+    void Write32(VAddr address, u32 value);
+    void ReadBlock(VAddr address, void* data, std::size_t size) const;
+    void WriteBlock(VAddr address, const void* data, std::size_t size);
+    std::string ReadCString(VAddr address, std::size_t max_length) const;
+
+    /// Writes a relocated word and records that the JIT cache must be invalidated for it
+    void WriteRelocation(VAddr target_address, u32 value);
+
+    /// Invalidates the JIT cache for the relocation targets written so far
+    void FlushModifiedRange();
+
     u32 GetField(HeaderField field) const {
-        return Memory::Read32(Field(field));
+        return Read32(Field(field));
     }
 
     void SetField(HeaderField field, u32 value) {
-        Memory::Write32(Field(field), value);
+        Write32(Field(field), value);
     }
 
     /**
@@ -422,9 +498,8 @@ private:
      */
     template <typename T>
     void GetEntry(std::size_t index, T& data) const {
-        Memory::ReadBlock(process,
-                          GetField(T::TABLE_OFFSET_FIELD) + static_cast<u32>(index * sizeof(T)),
-                          &data, sizeof(T));
+        ReadBlock(GetField(T::TABLE_OFFSET_FIELD) + static_cast<u32>(index * sizeof(T)), &data,
+                  sizeof(T));
     }
 
     /**
@@ -436,9 +511,8 @@ private:
      */
     template <typename T>
     void SetEntry(std::size_t index, const T& data) {
-        Memory::WriteBlock(process,
-                           GetField(T::TABLE_OFFSET_FIELD) + static_cast<u32>(index * sizeof(T)),
-                           &data, sizeof(T));
+        WriteBlock(GetField(T::TABLE_OFFSET_FIELD) + static_cast<u32>(index * sizeof(T)), &data,
+                   sizeof(T));
     }
 
     /**
@@ -655,9 +729,10 @@ private:
      * Looks up all imported named symbols of this module in all registered auto-link modules, and
      * resolves them if found.
      * @param crs_address the virtual address of the static module
+     * @param export_index the index of the symbols exported by loaded modules
      * @returns ResultCode RESULT_SUCCESS on success, otherwise error code.
      */
-    ResultCode ApplyImportNamedSymbol(VAddr crs_address);
+    ResultCode ApplyImportNamedSymbol(VAddr crs_address, ExportSymbolIndex& export_index);
 
     /**
      * Resets all imported named symbols of this module to unresolved state.
@@ -688,16 +763,18 @@ private:
     /**
      * Resolves target module's imported named symbols that exported by this module.
      * @param target the module to resolve.
+     * @param export_index the index of the symbols exported by loaded modules
      * @returns ResultCode RESULT_SUCCESS on success, otherwise error code.
      */
-    ResultCode ApplyExportNamedSymbol(CROHelper target);
+    ResultCode ApplyExportNamedSymbol(CROHelper target, ExportSymbolIndex& export_index);
 
     /**
      * Resets target's named symbols imported from this module to unresolved state.
      * @param target the module to reset.
+     * @param export_index the index of the symbols exported by loaded modules
      * @returns ResultCode RESULT_SUCCESS on success, otherwise error code.
      */
-    ResultCode ResetExportNamedSymbol(CROHelper target);
+    ResultCode ResetExportNamedSymbol(CROHelper target, ExportSymbolIndex& export_index);
 
     /**
      * Resolves imported indexed and anonymous symbols in the target module which imports this
@@ -111,7 +111,8 @@ void RO::Initialize(Kernel::HLERequestContext& ctx) {
         rb.Push(result);
         return;
     }
-    CROHelper crs{crs_address, *process};
+    slot->export_index.Clear();
+    CROHelper crs{crs_address, *process, crs_size};
     crs.InitCRS();
     result = crs.Rebase(0, crs_size, 0, 0, 0, 0, true);
     if (result.IsError()) {
@@ -225,7 +226,9 @@ void RO::LoadCRO(Kernel::HLERequestContext& ctx, bool link_on_load_bug_fix) {
         rb.Push<u32>(0);
         return;
     }
-    CROHelper cro{cro_address, *process};
+    // Drops what is left from a module that failed to load at the same address
+    slot->export_index.Forget(cro_address);
+    CROHelper cro{cro_address, *process, cro_size};
     result = cro.VerifyHash(cro_size, crr_address);
     if (result.IsError()) {
         LOG_ERROR(Service_LDR, "Error verifying CRO in CRR {:08X}", result.raw);
@@ -245,7 +248,7 @@ void RO::LoadCRO(Kernel::HLERequestContext& ctx, bool link_on_load_bug_fix) {
         rb.Push<u32>(0);
         return;
     }
-    result = cro.Link(slot->loaded_crs, link_on_load_bug_fix);
+    result = cro.Link(slot->loaded_crs, link_on_load_bug_fix, slot->export_index);
     if (result.IsError()) {
         LOG_ERROR(Service_LDR, "Error linking CRO {:08X}", result.raw);
         process->Unmap(cro_address, cro_buffer_ptr, cro_size, Kernel::VMAPermission::ReadWrite,
@@ -316,7 +319,8 @@ void RO::UnloadCRO(Kernel::HLERequestContext& ctx) {
     LOG_INFO(Service_LDR, "Unloading CRO \"{}\"", cro.ModuleName());
     u32 fixed_size{cro.GetFixedSize()};
     cro.Unregister(slot->loaded_crs);
-    auto result{cro.Unlink(slot->loaded_crs)};
+    auto result{cro.Unlink(slot->loaded_crs, slot->export_index)};
+    slot->export_index.Forget(cro_address);
     if (result.IsError()) {
         LOG_ERROR(Service_LDR, "Error unlinking CRO {:08X}", result.raw);
         rb.Push(result);
@@ -365,7 +369,7 @@ void RO::LinkCRO(Kernel::HLERequestContext& ctx) {
         return;
     }
     LOG_INFO(Service_LDR, "Linking CRO \"{}\"", cro.ModuleName());
-    auto result{cro.Link(slot->loaded_crs, false)};
+    auto result{cro.Link(slot->loaded_crs, false, slot->export_index)};
     if (result.IsError())
         LOG_ERROR(Service_LDR, "Error linking CRO {:08X}", result.raw);
     rb.Push(result);
@@ -395,7 +399,7 @@ void RO::UnlinkCRO(Kernel::HLERequestContext& ctx) {
         return;
     }
     LOG_INFO(Service_LDR, "Unlinking CRO \"{}\"", cro.ModuleName());
-    auto result{cro.Unlink(slot->loaded_crs)};
+    auto result{cro.Unlink(slot->loaded_crs, slot->export_index)};
     if (result.IsError())
         LOG_ERROR(Service_LDR, "Error unlinking CRO {:08X}", result.raw);
     rb.Push(result);
@@ -420,6 +424,7 @@ void RO::Shutdown(Kernel::HLERequestContext& ctx) {
     if (result.IsError())
         LOG_ERROR(Service_LDR, "Error unmapping CRS {:08X}", result.raw);
     slot->loaded_crs = 0;
+    slot->export_index.Clear();
     rb.Push(result);
 }
 
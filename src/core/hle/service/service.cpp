@@ -3,9 +3,11 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <chrono>
 #include <fmt/format.h>
 #include "common/assert.h"
 #include "common/logging/log.h"
+#include "common/profiling.h"
 #include "core/core.h"
 #include "core/hle/ipc.h"
 #include "core/hle/kernel/client_port.h"
@@ -13,6 +15,7 @@
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/server_port.h"
 #include "core/hle/kernel/server_session.h"
+#include "core/hle/profiler.h"
 #include "core/hle/service/ac/ac.h"
 #include "core/hle/service/act/act.h"
 #include "core/hle/service/am/am.h"
@@ -153,7 +156,8 @@ void ServiceFrameworkBase::RegisterHandlersBase(const FunctionInfoBase* function
     handlers.reserve(handlers.size() + n);
     for (std::size_t i{}; i < n; ++i)
         // Usually this array is sorted by id already, so hint to insert at the end
-        handlers.emplace_hint(handlers.cend(), functions[i].expected_header, functions[i]);
+        handlers.emplace_hint(handlers.cend(), functions[i].expected_header,
+                              Handler{functions[i]});
 }
 
 void ServiceFrameworkBase::ReportUnimplementedFunction(u32* cmd_buf, const FunctionInfoBase* info) {
@@ -163,7 +167,8 @@ void ServiceFrameworkBase::ReportUnimplementedFunction(u32* cmd_buf, const Funct
 }
 
 void ServiceFrameworkBase::HandleSyncRequest(SharedPtr<ServerSession> server_session) {
-    auto& kernel{server_session->system.Kernel()};
+    auto& system{server_session->system};
+    auto& kernel{system.Kernel()};
     auto thread{kernel.GetThreadManager().GetCurrentThread()};
     // TODO: avoid GetPointer
     u32* cmd_buf{reinterpret_cast<u32*>(Memory::GetPointer(thread->GetCommandBufferAddress()))};
@@ -178,14 +183,26 @@ void ServiceFrameworkBase::HandleSyncRequest(SharedPtr<ServerSession> server_ses
     Kernel::HLERequestContext context{std::move(server_session)};
     context.PopulateFromIncomingCommandBuffer(cmd_buf, *current_process);
     LOG_TRACE(Service, "{}", MakeFunctionString(info->name, GetServiceName().c_str(), cmd_buf));
+    PROFILE_SCOPE("service", info->name);
+    const auto start{std::chrono::steady_clock::now()};
     handler_invoker(this, info->handler_callback, context);
+    const auto host_time{std::chrono::steady_clock::now() - start};
+    if (!info->stats)
+        info->stats =
+            &system.GetHLEProfiler().GetCommandStats(service_name, header_code, info->name);
+    info->stats->Record(std::chrono::duration_cast<std::chrono::nanoseconds>(host_time).count(),
+                        context.GetSleepCount(), context.GetSleepTime().count());
     ASSERT(thread->status == Kernel::ThreadStatus::Running ||
            thread->status == Kernel::ThreadStatus::WaitHleEvent);
     // Only write the response immediately if the thread is still running. If the HLE handler put
     // the thread to sleep then the writing of the command buffer will be deferred to the wakeup
     // callback.
-    if (thread->status == Kernel::ThreadStatus::Running)
-        context.WriteToOutgoingCommandBuffer(cmd_buf, *current_process);
+    if (thread->status != Kernel::ThreadStatus::Running)
+        return;
+    const ResultCode result{context.WriteToOutgoingCommandBuffer(cmd_buf, *current_process)};
+    if (result.IsError())
+        LOG_ERROR(Service, "{}: failed to translate the reply of {}, replied with {:#010X}",
+                  GetServiceName(), info->name, result.raw);
 }
 
 static bool AttemptLLE(Core::System& system, const ServiceModuleInfo& service_module) {
@@ -18,6 +18,10 @@ namespace Core {
 class System;
 } // namespace Core
 
+namespace HLE {
+struct CommandStats;
+} // namespace HLE
+
 namespace Kernel {
 class KernelSystem;
 class ClientPort;
@@ -81,6 +85,11 @@ private:
         const char* name;
     };
 
+    struct Handler : FunctionInfoBase {
+        /// Profiler counters of the command, looked up on its first call
+        HLE::CommandStats* stats{};
+    };
+
     using InvokerFn = void(ServiceFrameworkBase* object, HandlerFnP<ServiceFrameworkBase> member,
                            Kernel::HLERequestContext& ctx);
 
@@ -104,7 +113,7 @@ private:
 
     /// Function used to safely up-cast pointers to the derived class before invoking a handler.
     InvokerFn* handler_invoker;
-    boost::container::flat_map<u32, FunctionInfoBase> handlers;
+    boost::container::flat_map<u32, Handler> handlers;
 };
 
 /**
@@ -11,8 +11,11 @@
 #include "common/logging/log.h"
 #include "common/scope_exit.h"
 #include "core/core.h"
+#include "core/core_timing.h"
 #include "core/hle/ipc_helpers.h"
+#include "core/hle/kernel/event.h"
 #include "core/hle/kernel/shared_memory.h"
+#include "core/hle/kernel/thread.h"
 #include "core/hle/result.h"
 #include "core/hle/service/soc/soc.h"
 #include "core/hle/service/soc/soc_p.h"
@@ -156,6 +159,21 @@ static int TranslateError(int error) {
     return error;
 }
 
+/// Returns whether a failed call on a non-blocking socket would have blocked
+static bool WouldBlock(int error) {
+    return error == ERRNO(EAGAIN) || error == ERRNO(EWOULDBLOCK) || error == ERRNO(EINPROGRESS);
+}
+
+/// Makes host calls on the socket return instead of blocking, blocking is emulated by the poller
+static void SetNonBlocking(u32 socket_fd) {
+#ifdef _WIN32
+    unsigned long non_blocking{1};
+    ioctlsocket(socket_fd, FIONBIO, &non_blocking);
+#else
+    ::fcntl(socket_fd, F_SETFL, ::fcntl(socket_fd, F_GETFL, 0) | O_NONBLOCK);
+#endif
+}
+
 /// Holds the translation from system network socket options to console network socket options
 /// Note: -1 = No effect/unavailable
 static const std::unordered_map<int, int> sockopt_map{{
@@ -323,18 +341,86 @@ union CTRSockAddr {
     }
 };
 
-Module::Module() = default;
+Module::Module(Core::System& system) : system{system} {
+    wakeup_event = system.CoreTiming().RegisterEvent(
+        "SOC::WakeCompletedClients", [this](u64, s64) { WakeCompletedClients(); });
+    poller = std::make_unique<SocketPoller>([this](u64 id) {
+        {
+            std::lock_guard lock{completed_mutex};
+            completed_requests.push_back(id);
+        }
+        this->system.CoreTiming().ScheduleEventThreadsafe(0, wakeup_event, 0);
+    });
+}
+
 Module::~Module() = default;
 
+bool Module::IsBlocking(u32 socket_fd) const {
+    auto itr{open_sockets.find(socket_fd)};
+    return itr != open_sockets.end() && itr->second.blocking;
+}
+
+template <typename Result, typename Attempt, typename Reply>
+void Module::RunBlocking(Kernel::HLERequestContext& ctx, u32 socket_fd, short events,
+                         Attempt attempt, Reply reply) {
+    auto result{std::make_shared<Result>()};
+    if (attempt(*result) || !IsBlocking(socket_fd)) {
+        reply(ctx, *result);
+        return;
+    }
+    WaitForSockets(ctx, {{socket_fd, events}}, std::nullopt,
+                   [result, attempt](SocketPoller::Status status) {
+                       if (status == SocketPoller::Status::Ready)
+                           return attempt(*result);
+                       result->ret = TranslateError(ERRNO(EBADF));
+                       return true;
+                   },
+                   [result, reply](Kernel::HLERequestContext& ctx) { reply(ctx, *result); });
+}
+
+void Module::WaitForSockets(Kernel::HLERequestContext& ctx,
+                            std::vector<SocketPoller::Watch> watches,
+                            std::optional<std::chrono::steady_clock::time_point> deadline,
+                            SocketPoller::Attempt attempt, ReplyCallback reply) {
+    const u64 id{next_request_id++};
+    waiting_clients.emplace(
+        id, ctx.SleepClientThread(system.Kernel().GetThreadManager().GetCurrentThread(),
+                                  "soc::WaitForSockets", std::chrono::nanoseconds{0},
+                                  [reply](Kernel::SharedPtr<Kernel::Thread> thread,
+                                          Kernel::HLERequestContext& ctx,
+                                          Kernel::ThreadWakeupReason reason) { reply(ctx); }));
+    poller->Submit(id, std::move(watches), deadline, std::move(attempt));
+}
+
+void Module::WakeCompletedClients() {
+    std::vector<u64> completed;
+    {
+        std::lock_guard lock{completed_mutex};
+        completed.swap(completed_requests);
+    }
+    for (u64 id : completed) {
+        auto itr{waiting_clients.find(id)};
+        if (itr == waiting_clients.end())
+            continue;
+        itr->second->Signal();
+        waiting_clients.erase(itr);
+    }
+}
+
+s32 Module::CloseSocket(u32 socket_fd) {
+    poller->Cancel(socket_fd);
+    open_sockets.erase(socket_fd);
+    return closesocket(socket_fd);
+}
+
 Module::Interface::Interface(std::shared_ptr<Module> soc, const char* name)
     : ServiceFramework{name}, soc{std::move(soc)} {}
 
 Module::Interface::~Interface() = default;
 
 void Module::Interface::CleanupSockets() {
-    for (auto sock : soc->open_sockets)
-        closesocket(sock.second.socket_fd);
-    soc->open_sockets.clear();
+    while (!soc->open_sockets.empty())
+        soc->CloseSocket(soc->open_sockets.begin()->first);
 }
 
 void Module::Interface::Socket(Kernel::HLERequestContext& ctx) {
@@ -367,8 +453,10 @@ void Module::Interface::Socket(Kernel::HLERequestContext& ctx) {
 
     u32 ret{static_cast<u32>(::socket(domain, type, protocol))};
 
-    if ((s32)ret != SOCKET_ERROR_VALUE)
+    if ((s32)ret != SOCKET_ERROR_VALUE) {
+        SetNonBlocking(ret);
         soc->open_sockets[ret] = {ret, true};
+    }
 
     if ((s32)ret == SOCKET_ERROR_VALUE)
         ret = TranslateError(GET_ERRNO);
@@ -413,50 +501,18 @@ void Module::Interface::Fcntl(Kernel::HLERequestContext& ctx) {
         rb.Push(posix_ret);
     });
 
+    // Host sockets are always non-blocking, only the flag the guest sees changes
+    auto iter{soc->open_sockets.find(socket_handle)};
+    if (iter == soc->open_sockets.end()) {
+        posix_ret = TranslateError(ERRNO(EBADF));
+        return;
+    }
     if (ctr_cmd == 3) { // F_GETFL
-#ifdef _WIN32
-        posix_ret = 0;
-        auto iter{soc->open_sockets.find(socket_handle)};
-        if (iter != soc->open_sockets.end() && iter->second.blocking == false)
-            posix_ret |= 4; // O_NONBLOCK
-#else
-        int ret{::fcntl(socket_handle, F_GETFL, 0)};
-        if (ret == SOCKET_ERROR_VALUE) {
-            posix_ret = TranslateError(GET_ERRNO);
-            return;
-        }
         posix_ret = 0;
-        if (ret & O_NONBLOCK)
+        if (!iter->second.blocking)
             posix_ret |= 4; // O_NONBLOCK
-#endif
     } else if (ctr_cmd == 4) { // F_SETFL
-#ifdef _WIN32
-        unsigned long tmp{static_cast<unsigned long>((ctr_arg & 4 /* O_NONBLOCK */) ? 1 : 0)};
-        int ret{ioctlsocket(socket_handle, FIONBIO, &tmp)};
-        if (ret == SOCKET_ERROR_VALUE) {
-            posix_ret = TranslateError(GET_ERRNO);
-            return;
-        }
-        auto iter = soc->open_sockets.find(socket_handle);
-        if (iter != soc->open_sockets.end())
-            iter->second.blocking = (tmp == 0);
-#else
-        int flags{::fcntl(socket_handle, F_GETFL, 0)};
-        if (flags == SOCKET_ERROR_VALUE) {
-            posix_ret = TranslateError(GET_ERRNO);
-            return;
-        }
-
-        flags &= ~O_NONBLOCK;
-        if (ctr_arg & 4) // O_NONBLOCK
-            flags |= O_NONBLOCK;
-
-        int ret{::fcntl(socket_handle, F_SETFL, flags)};
-        if (ret == SOCKET_ERROR_VALUE) {
-            posix_ret = TranslateError(GET_ERRNO);
-            return;
-        }
-#endif
+        iter->second.blocking = !(ctr_arg & 4); // O_NONBLOCK
     } else {
         LOG_ERROR(Service_SOC, "Unsupported command ({}) in fcntl call", ctr_cmd);
         posix_ret = TranslateError(EINVAL); // TODO: Find the correct error
@@ -480,33 +536,41 @@ void Module::Interface::Listen(Kernel::HLERequestContext& ctx) {
 }
 
 void Module::Interface::Accept(Kernel::HLERequestContext& ctx) {
-    // TODO: Calling this function on a blocking socket will block the emu thread,
-    // preventing graceful shutdown when closing the emulator, this can be fixed by always
-    // performing nonblocking operations and spinlock until the data is available
     IPC::RequestParser rp{ctx, 0x04, 2, 2};
     u32 socket_handle{rp.Pop<u32>()};
     socklen_t max_addr_len{static_cast<socklen_t>(rp.Pop<u32>())};
     rp.PopPID();
-    sockaddr addr{};
-    socklen_t addr_len{sizeof(addr)};
-    u32 ret = static_cast<u32>(::accept(socket_handle, &addr, &addr_len));
-
-    if ((s32)ret != SOCKET_ERROR_VALUE)
-        soc->open_sockets[ret] = {ret, true};
-
-    CTRSockAddr ctr_addr{};
-    std::vector<u8> ctr_addr_buf(sizeof(ctr_addr));
-    if ((s32)ret == SOCKET_ERROR_VALUE) {
-        ret = TranslateError(GET_ERRNO);
-    } else {
-        ctr_addr = CTRSockAddr::FromPlatform(addr);
-        std::memcpy(ctr_addr_buf.data(), &ctr_addr, sizeof(ctr_addr));
-    }
 
-    auto rb{rp.MakeBuilder(2, 2)};
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
-    rb.PushStaticBuffer(ctr_addr_buf, 0);
+    struct Result {
+        u32 ret{};
+        std::vector<u8> addr_buf;
+    };
+    soc->RunBlocking<Result>(
+        ctx, socket_handle, POLLIN,
+        [socket_handle](Result& result) {
+            sockaddr addr{};
+            socklen_t addr_len{sizeof(addr)};
+            result.ret = static_cast<u32>(::accept(socket_handle, &addr, &addr_len));
+            result.addr_buf.assign(sizeof(CTRSockAddr), 0);
+            if ((s32)result.ret == SOCKET_ERROR_VALUE) {
+                const int error{GET_ERRNO};
+                result.ret = TranslateError(error);
+                return !WouldBlock(error);
+            }
+            const CTRSockAddr ctr_addr{CTRSockAddr::FromPlatform(addr)};
+            std::memcpy(result.addr_buf.data(), &ctr_addr, sizeof(ctr_addr));
+            return true;
+        },
+        [soc = soc](Kernel::HLERequestContext& ctx, const Result& result) {
+            if ((s32)result.ret >= 0) {
+                SetNonBlocking(result.ret);
+                soc->open_sockets[result.ret] = {result.ret, true};
+            }
+            IPC::ResponseBuilder rb{ctx, 0x04, 2, 2};
+            rb.Push(RESULT_SUCCESS);
+            rb.Push(result.ret);
+            rb.PushStaticBuffer(result.addr_buf, 0);
+        });
 }
 
 void Module::Interface::GetHostId(Kernel::HLERequestContext& ctx) {
@@ -531,10 +595,7 @@ void Module::Interface::Close(Kernel::HLERequestContext& ctx) {
     u32 socket_handle{rp.Pop<u32>()};
     rp.PopPID();
 
-    s32 ret{};
-    soc->open_sockets.erase(socket_handle);
-
-    ret = closesocket(socket_handle);
+    s32 ret{soc->CloseSocket(socket_handle)};
 
     if (ret != 0)
         ret = TranslateError(GET_ERRNO);
@@ -554,24 +615,35 @@ void Module::Interface::SendTo(Kernel::HLERequestContext& ctx) {
     auto input_buff{rp.PopStaticBuffer()};
     auto dest_addr_buff{rp.PopStaticBuffer()};
 
-    s32 ret{-1};
+    std::optional<sockaddr> dest_addr;
     if (addr_len > 0) {
         CTRSockAddr ctr_dest_addr{};
         std::memcpy(&ctr_dest_addr, dest_addr_buff.data(), sizeof(ctr_dest_addr));
-        sockaddr dest_addr{CTRSockAddr::ToPlatform(ctr_dest_addr)};
-        ret = ::sendto(socket_handle, reinterpret_cast<const char*>(input_buff.data()), len, flags,
-                       &dest_addr, sizeof(dest_addr));
-    } else {
-        ret = ::sendto(socket_handle, reinterpret_cast<const char*>(input_buff.data()), len, flags,
-                       nullptr, 0);
+        dest_addr = CTRSockAddr::ToPlatform(ctr_dest_addr);
     }
 
-    if (ret == SOCKET_ERROR_VALUE)
-        ret = TranslateError(GET_ERRNO);
-
-    auto rb{rp.MakeBuilder(2, 0)};
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
+    struct Result {
+        s32 ret{-1};
+    };
+    // The attempt may run after the static buffer was reused, so it owns the data
+    soc->RunBlocking<Result>(
+        ctx, socket_handle, POLLOUT,
+        [socket_handle, len, flags, dest_addr,
+         input_buff = std::make_shared<std::vector<u8>>(std::move(input_buff))](Result& result) {
+            result.ret = ::sendto(socket_handle, reinterpret_cast<const char*>(input_buff->data()),
+                                  len, flags, dest_addr ? &*dest_addr : nullptr,
+                                  dest_addr ? sizeof(*dest_addr) : 0);
+            if (result.ret != SOCKET_ERROR_VALUE)
+                return true;
+            const int error{GET_ERRNO};
+            result.ret = TranslateError(error);
+            return !WouldBlock(error);
+        },
+        [](Kernel::HLERequestContext& ctx, const Result& result) {
+            IPC::ResponseBuilder rb{ctx, 0x0A, 2, 0};
+            rb.Push(RESULT_SUCCESS);
+            rb.Push(result.ret);
+        });
 }
 
 void Module::Interface::RecvFromOther(Kernel::HLERequestContext& ctx) {
@@ -581,41 +653,52 @@ void Module::Interface::RecvFromOther(Kernel::HLERequestContext& ctx) {
     u32 flags{rp.Pop<u32>()};
     u32 addr_len{rp.Pop<u32>()};
     rp.PopPID();
-    auto& buffer{rp.PopMappedBuffer()};
-    CTRSockAddr ctr_src_addr{};
-    std::vector<u8> output_buff(len);
-    std::vector<u8> addr_buff(sizeof(ctr_src_addr));
-    sockaddr src_addr{};
-    socklen_t src_addr_len{sizeof(src_addr)};
-    s32 ret{-1};
-    if (addr_len > 0) {
-        ret = ::recvfrom(socket_handle, reinterpret_cast<char*>(output_buff.data()), len, flags,
-                         &src_addr, &src_addr_len);
-        if (ret >= 0 && src_addr_len > 0) {
-            ctr_src_addr = CTRSockAddr::FromPlatform(src_addr);
-            std::memcpy(addr_buff.data(), &ctr_src_addr, sizeof(ctr_src_addr));
-        }
-    } else {
-        ret = ::recvfrom(socket_handle, reinterpret_cast<char*>(output_buff.data()), len, flags,
-                         NULL, 0);
-        addr_buff.resize(0);
-    }
-    if (ret == SOCKET_ERROR_VALUE) {
-        ret = TranslateError(GET_ERRNO);
-    } else {
-        buffer.Write(output_buff.data(), 0, ret);
-    }
-    auto rb{rp.MakeBuilder(2, 4)};
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
-    rb.PushStaticBuffer(addr_buff, 0);
-    rb.PushMappedBuffer(buffer);
+    const u32 buffer_id{rp.PopMappedBuffer().GetId()};
+
+    struct Result {
+        s32 ret{-1};
+        std::vector<u8> output_buff;
+        std::vector<u8> addr_buff;
+    };
+    soc->RunBlocking<Result>(
+        ctx, socket_handle, POLLIN,
+        [socket_handle, len, flags, addr_len](Result& result) {
+            result.output_buff.resize(len);
+            result.addr_buff.assign(addr_len > 0 ? sizeof(CTRSockAddr) : 0, 0);
+            sockaddr src_addr{};
+            socklen_t src_addr_len{sizeof(src_addr)};
+            if (addr_len > 0) {
+                result.ret = ::recvfrom(socket_handle,
+                                        reinterpret_cast<char*>(result.output_buff.data()), len,
+                                        flags, &src_addr, &src_addr_len);
+                if (result.ret >= 0 && src_addr_len > 0) {
+                    const CTRSockAddr ctr_src_addr{CTRSockAddr::FromPlatform(src_addr)};
+                    std::memcpy(result.addr_buff.data(), &ctr_src_addr, sizeof(ctr_src_addr));
+                }
+            } else {
+                result.ret = ::recvfrom(socket_handle,
+                                        reinterpret_cast<char*>(result.output_buff.data()), len,
+                                        flags, NULL, 0);
+            }
+            if (result.ret != SOCKET_ERROR_VALUE)
+                return true;
+            const int error{GET_ERRNO};
+            result.ret = TranslateError(error);
+            return !WouldBlock(error);
+        },
+        [buffer_id](Kernel::HLERequestContext& ctx, const Result& result) {
+            auto& buffer{ctx.GetMappedBuffer(buffer_id)};
+            if (result.ret > 0)
+                buffer.Write(result.output_buff.data(), 0, result.ret);
+            IPC::ResponseBuilder rb{ctx, 0x07, 2, 4};
+            rb.Push(RESULT_SUCCESS);
+            rb.Push(result.ret);
+            rb.PushStaticBuffer(result.addr_buff, 0);
+            rb.PushMappedBuffer(buffer);
+        });
 }
 
 void Module::Interface::RecvFrom(Kernel::HLERequestContext& ctx) {
-    // TODO: Calling this function on a blocking socket will block the emu thread,
-    // preventing graceful shutdown when closing the emulator, this can be fixed by always
-    // performing nonblocking operations and spinlock until the data is available
     IPC::RequestParser rp{ctx, 0x08, 4, 2};
     u32 socket_handle{rp.Pop<u32>()};
     u32 len{rp.Pop<u32>()};
@@ -623,42 +706,55 @@ void Module::Interface::RecvFrom(Kernel::HLERequestContext& ctx) {
     u32 addr_len{rp.Pop<u32>()};
     rp.PopPID();
 
-    CTRSockAddr ctr_src_addr{};
-    std::vector<u8> output_buff(len);
-    std::vector<u8> addr_buff(sizeof(ctr_src_addr));
-    sockaddr src_addr{};
-    socklen_t src_addr_len{sizeof(src_addr)};
-
-    s32 ret{-1};
-    if (addr_len > 0) {
-        // Only get src addr if input addr available
-        ret = ::recvfrom(socket_handle, reinterpret_cast<char*>(output_buff.data()), len, flags,
-                         &src_addr, &src_addr_len);
-        if (ret >= 0 && src_addr_len > 0) {
-            ctr_src_addr = CTRSockAddr::FromPlatform(src_addr);
-            std::memcpy(addr_buff.data(), &ctr_src_addr, sizeof(ctr_src_addr));
-        }
-    } else {
-        ret = ::recvfrom(socket_handle, reinterpret_cast<char*>(output_buff.data()), len, flags,
-                         NULL, 0);
-        addr_buff.resize(0);
-    }
-
-    s32 total_received{ret};
-    if (ret == SOCKET_ERROR_VALUE) {
-        ret = TranslateError(GET_ERRNO);
-        total_received = 0;
-    }
-
-    // Write only the data we received to avoid overwriting parts of the buffer with zeros
-    output_buff.resize(total_received);
-
-    auto rb{rp.MakeBuilder(3, 4)};
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
-    rb.Push(total_received);
-    rb.PushStaticBuffer(output_buff, 0);
-    rb.PushStaticBuffer(addr_buff, 1);
+    struct Result {
+        s32 ret{-1};
+        s32 total_received{};
+        std::vector<u8> output_buff;
+        std::vector<u8> addr_buff;
+    };
+    soc->RunBlocking<Result>(
+        ctx, socket_handle, POLLIN,
+        [socket_handle, len, flags, addr_len](Result& result) {
+            result.output_buff.resize(len);
+            result.addr_buff.assign(addr_len > 0 ? sizeof(CTRSockAddr) : 0, 0);
+            sockaddr src_addr{};
+            socklen_t src_addr_len{sizeof(src_addr)};
+            if (addr_len > 0) {
+                // Only get src addr if input addr available
+                result.ret = ::recvfrom(socket_handle,
+                                        reinterpret_cast<char*>(result.output_buff.data()), len,
+                                        flags, &src_addr, &src_addr_len);
+                if (result.ret >= 0 && src_addr_len > 0) {
+                    const CTRSockAddr ctr_src_addr{CTRSockAddr::FromPlatform(src_addr)};
+                    std::memcpy(result.addr_buff.data(), &ctr_src_addr, sizeof(ctr_src_addr));
+                }
+            } else {
+                result.ret = ::recvfrom(socket_handle,
+                                        reinterpret_cast<char*>(result.output_buff.data()), len,
+                                        flags, NULL, 0);
+            }
+
+            result.total_received = result.ret;
+            bool completed{true};
+            if (result.ret == SOCKET_ERROR_VALUE) {
+                const int error{GET_ERRNO};
+                result.ret = TranslateError(error);
+                result.total_received = 0;
+                completed = !WouldBlock(error);
+            }
+
+            // Write only the data we received to avoid overwriting parts of the buffer with zeros
+            result.output_buff.resize(result.total_received);
+            return completed;
+        },
+        [](Kernel::HLERequestContext& ctx, const Result& result) {
+            IPC::ResponseBuilder rb{ctx, 0x08, 3, 4};
+            rb.Push(RESULT_SUCCESS);
+            rb.Push(result.ret);
+            rb.Push(result.total_received);
+            rb.PushStaticBuffer(result.output_buff, 0);
+            rb.PushStaticBuffer(result.addr_buff, 1);
+        });
 }
 
 void Module::Interface::Poll(Kernel::HLERequestContext& ctx) {
@@ -674,25 +770,53 @@ void Module::Interface::Poll(Kernel::HLERequestContext& ctx) {
     // The 3ds_pollfd and the pollfd structures may be different (Windows/Linux have different
     // sizes)
     // so we have to copy the data
-    std::vector<pollfd> platform_pollfd(nfds);
-    std::transform(ctr_fds.begin(), ctr_fds.end(), platform_pollfd.begin(), CTRPollFD::ToPlatform);
+    auto platform_pollfd{std::make_shared<std::vector<pollfd>>(nfds)};
+    std::transform(ctr_fds.begin(), ctr_fds.end(), platform_pollfd->begin(),
+                   CTRPollFD::ToPlatform);
 
-    s32 ret{::poll(platform_pollfd.data(), nfds, timeout)};
+    auto ret{std::make_shared<s32>(::poll(platform_pollfd->data(), nfds, 0))};
 
-    // Now update the output pollfd structure
-    std::transform(platform_pollfd.begin(), platform_pollfd.end(), ctr_fds.begin(),
-                   CTRPollFD::FromPlatform);
+    auto reply{[platform_pollfd, ret](Kernel::HLERequestContext& ctx) {
+        // Now update the output pollfd structure
+        std::vector<CTRPollFD> ctr_fds(platform_pollfd->size());
+        std::transform(platform_pollfd->begin(), platform_pollfd->end(), ctr_fds.begin(),
+                       CTRPollFD::FromPlatform);
 
-    std::vector<u8> output_fds(nfds * sizeof(CTRPollFD));
-    std::memcpy(output_fds.data(), ctr_fds.data(), nfds * sizeof(CTRPollFD));
+        std::vector<u8> output_fds(ctr_fds.size() * sizeof(CTRPollFD));
+        std::memcpy(output_fds.data(), ctr_fds.data(), output_fds.size());
 
-    if (ret == SOCKET_ERROR_VALUE)
-        ret = TranslateError(GET_ERRNO);
+        IPC::ResponseBuilder rb{ctx, 0x14, 2, 2};
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(*ret);
+        rb.PushStaticBuffer(output_fds, 0);
+    }};
+
+    if (*ret == SOCKET_ERROR_VALUE)
+        *ret = TranslateError(GET_ERRNO);
+    if (*ret != 0 || timeout == 0) {
+        reply(ctx);
+        return;
+    }
 
-    auto rb{rp.MakeBuilder(2, 2)};
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
-    rb.PushStaticBuffer(output_fds, 0);
+    // Nothing is ready yet, wait on the poller thread instead of blocking in poll
+    std::vector<SocketPoller::Watch> watches;
+    watches.reserve(nfds);
+    for (const auto& fd : *platform_pollfd)
+        watches.push_back({static_cast<u32>(fd.fd), fd.events});
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+    if (timeout > 0)
+        deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds{timeout};
+    soc->WaitForSockets(ctx, std::move(watches), deadline,
+                        [platform_pollfd, ret](SocketPoller::Status status) {
+                            for (auto& fd : *platform_pollfd)
+                                fd.revents = 0;
+                            *ret = ::poll(platform_pollfd->data(),
+                                          static_cast<u32>(platform_pollfd->size()), 0);
+                            if (*ret == SOCKET_ERROR_VALUE)
+                                *ret = TranslateError(GET_ERRNO);
+                            return *ret != 0 || status != SocketPoller::Status::Ready;
+                        },
+                        reply);
 }
 
 void Module::Interface::GetSockName(Kernel::HLERequestContext& ctx) {
@@ -756,9 +880,6 @@ void Module::Interface::GetPeerName(Kernel::HLERequestContext& ctx) {
 }
 
 void Module::Interface::Connect(Kernel::HLERequestContext& ctx) {
-    // TODO: Calling this function on a blocking socket will block the emu thread,
-    // preventing graceful shutdown when closing the emulator, this can be fixed by always
-    // performing nonblocking operations and spinlock until the data is available
     IPC::RequestParser rp{ctx, 0x06, 2, 4};
     u32 socket_handle{rp.Pop<u32>()};
     u32 input_addr_len{rp.Pop<u32>()};
@@ -769,13 +890,35 @@ void Module::Interface::Connect(Kernel::HLERequestContext& ctx) {
     std::memcpy(&ctr_input_addr, input_addr_buf.data(), sizeof(ctr_input_addr));
 
     sockaddr input_addr{CTRSockAddr::ToPlatform(ctr_input_addr)};
-    s32 ret{::connect(socket_handle, &input_addr, sizeof(input_addr))};
-    if (ret != 0)
-        ret = TranslateError(GET_ERRNO);
-
-    auto rb{rp.MakeBuilder(2, 0)};
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
+    struct Result {
+        s32 ret{};
+        bool started{};
+    };
+    soc->RunBlocking<Result>(
+        ctx, socket_handle, POLLOUT,
+        [socket_handle, input_addr](Result& result) {
+            if (result.started) {
+                // The socket became writable, the connection attempt finished
+                int error{};
+                socklen_t error_len{sizeof(error)};
+                ::getsockopt(socket_handle, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error),
+                             &error_len);
+                result.ret = error != 0 ? TranslateError(error) : 0;
+                return true;
+            }
+            result.started = true;
+            result.ret = ::connect(socket_handle, &input_addr, sizeof(input_addr));
+            if (result.ret == 0)
+                return true;
+            const int error{GET_ERRNO};
+            result.ret = TranslateError(error);
+            return !WouldBlock(error);
+        },
+        [](Kernel::HLERequestContext& ctx, const Result& result) {
+            IPC::ResponseBuilder rb{ctx, 0x06, 2, 0};
+            rb.Push(RESULT_SUCCESS);
+            rb.Push(result.ret);
+        });
 }
 
 void Module::Interface::InitializeSockets(Kernel::HLERequestContext& ctx) {
@@ -872,7 +1015,7 @@ void Module::Interface::SetSockOpt(Kernel::HLERequestContext& ctx) {
 
 void InstallInterfaces(Core::System& system) {
     auto& service_manager{system.ServiceManager()};
-    auto soc{std::make_shared<Module>()};
+    auto soc{std::make_shared<Module>(system)};
     std::make_shared<SOC_U>(soc)->InstallAsService(service_manager);
     std::make_shared<SOC_P>(soc)->InstallAsService(service_manager);
 }
@@ -4,25 +4,36 @@
 
 #pragma once
 
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <unordered_map>
+#include <vector>
 #include "core/hle/service/service.h"
+#include "core/hle/service/soc/socket_poller.h"
 
 namespace Core {
 class System;
+struct TimingEventType;
 } // namespace Core
 
+namespace Kernel {
+class Event;
+} // namespace Kernel
+
 namespace Service::SOC {
 
 /// Holds information about a particular socket
 struct SocketHolder {
     u32 socket_fd; ///< The socket descriptor
-    bool blocking; ///< Whether the socket is blocking or not, it's only read on Windows.
+    bool blocking; ///< Whether the guest sees the socket as blocking, host sockets never block
 };
 
 class Module final {
 public:
-    Module();
+    explicit Module(Core::System& system);
     ~Module();
 
     class Interface : public ServiceFramework<Interface> {
@@ -58,8 +69,48 @@ public:
     };
 
 private:
+    using ReplyCallback = std::function<void(Kernel::HLERequestContext& ctx)>;
+
+    /// Returns whether the guest expects calls on the socket to block
+    bool IsBlocking(u32 socket_fd) const;
+
+    /**
+     * Runs a socket operation without blocking the emu thread. attempt(Result&) tries the
+     * operation once and returns false if it would block. In that case, if the guest socket is
+     * blocking, the client thread sleeps until the poller completed the operation. Then
+     * reply(ctx, Result&) writes the response.
+     */
+    template <typename Result, typename Attempt, typename Reply>
+    void RunBlocking(Kernel::HLERequestContext& ctx, u32 socket_fd, short events, Attempt attempt,
+                     Reply reply);
+
+    /// Puts the client thread to sleep until the poller completed the request
+    void WaitForSockets(Kernel::HLERequestContext& ctx, std::vector<SocketPoller::Watch> watches,
+                        std::optional<std::chrono::steady_clock::time_point> deadline,
+                        SocketPoller::Attempt attempt, ReplyCallback reply);
+
+    /// Wakes the client threads of the requests the poller completed, on the emu thread
+    void WakeCompletedClients();
+
+    /// Closes a socket, failing the operations waiting for it
+    s32 CloseSocket(u32 socket_fd);
+
+    Core::System& system;
+
     /// Holds info about the currently open sockets
     std::unordered_map<u32, SocketHolder> open_sockets;
+
+    /// Events that wake the client threads waiting for the poller, by request id
+    std::unordered_map<u64, Kernel::SharedPtr<Kernel::Event>> waiting_clients;
+    u64 next_request_id{};
+
+    // Requests completed by the poller thread, handed to the emu thread with a timing event
+    std::mutex completed_mutex;
+    std::vector<u64> completed_requests;
+    Core::TimingEventType* wakeup_event;
+
+    // Declared last, so that the poller thread stops first
+    std::unique_ptr<SocketPoller> poller;
 };
 
 void InstallInterfaces(Core::System& system);
@@ -0,0 +1,176 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/logging/log.h"
+#include "core/hle/service/soc/socket_poller.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define closesocket(x) close(x)
+#endif
+
+namespace Service::SOC {
+
+namespace {
+
+u32 CreateWakeupSocket() {
+    const auto fd{::socket(AF_INET, SOCK_DGRAM, 0)};
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len{sizeof(addr)};
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &addr_len) != 0 ||
+        ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+        LOG_ERROR(Service_SOC, "Failed to set up the socket poller wakeup socket");
+#ifdef _WIN32
+    unsigned long non_blocking{1};
+    ioctlsocket(fd, FIONBIO, &non_blocking);
+#else
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    return static_cast<u32>(fd);
+}
+
+} // Anonymous namespace
+
+SocketPoller::SocketPoller(CompletionCallback on_complete)
+    : on_complete{std::move(on_complete)}, wakeup_socket{CreateWakeupSocket()} {
+    thread = std::thread{&SocketPoller::Loop, this};
+}
+
+SocketPoller::~SocketPoller() {
+    {
+        std::lock_guard lock{mutex};
+        stopping = true;
+    }
+    Wake();
+    thread.join();
+    closesocket(wakeup_socket);
+}
+
+void SocketPoller::Submit(u64 id, std::vector<Watch> watches,
+                          std::optional<std::chrono::steady_clock::time_point> deadline,
+                          Attempt attempt) {
+    {
+        std::lock_guard lock{mutex};
+        requests.emplace(id, Request{std::move(watches), deadline, std::move(attempt)});
+    }
+    Wake();
+}
+
+void SocketPoller::Cancel(u32 socket) {
+    std::vector<u64> cancelled;
+    {
+        std::lock_guard lock{mutex};
+        for (auto itr{requests.begin()}; itr != requests.end();) {
+            const auto& watches{itr->second.watches};
+            if (std::none_of(watches.begin(), watches.end(),
+                             [socket](const Watch& watch) { return watch.socket == socket; })) {
+                ++itr;
+                continue;
+            }
+            itr->second.attempt(Status::Cancelled);
+            cancelled.push_back(itr->first);
+            itr = requests.erase(itr);
+        }
+    }
+    for (u64 id : cancelled)
+        on_complete(id);
+}
+
+void SocketPoller::Wake() {
+    const char byte{};
+    ::send(wakeup_socket, &byte, 1, 0);
+}
+
+void SocketPoller::Loop() {
+    struct Polled {
+        u64 id;
+        std::size_t first;
+        std::size_t count;
+    };
+    std::vector<pollfd> fds;
+    std::vector<Polled> polled;
+    std::vector<u64> completed;
+    for (;;) {
+        int timeout{-1};
+        {
+            std::lock_guard lock{mutex};
+            if (stopping)
+                return;
+            // The wakeup socket always comes first
+            fds.resize(1);
+            fds[0] = {};
+            fds[0].fd = wakeup_socket;
+            fds[0].events = POLLIN;
+            polled.clear();
+            const auto now{std::chrono::steady_clock::now()};
+            for (const auto& [id, request] : requests) {
+                polled.push_back({id, fds.size(), request.watches.size()});
+                for (const auto& watch : request.watches) {
+                    pollfd fd{};
+                    fd.fd = watch.socket;
+                    fd.events = watch.events;
+                    fds.push_back(fd);
+                }
+                if (!request.deadline)
+                    continue;
+                const auto left{
+                    std::chrono::ceil<std::chrono::milliseconds>(*request.deadline - now).count()};
+                const int left_ms{static_cast<int>(std::max<s64>(left, 0))};
+                timeout = timeout < 0 ? left_ms : std::min(timeout, left_ms);
+            }
+        }
+#ifdef _WIN32
+        WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), timeout);
+#else
+        ::poll(fds.data(), static_cast<nfds_t>(fds.size()), timeout);
+#endif
+        if (fds[0].revents & POLLIN) {
+            char buffer[64];
+            while (::recv(wakeup_socket, buffer, sizeof(buffer), 0) > 0)
+                ;
+        }
+        completed.clear();
+        {
+            std::lock_guard lock{mutex};
+            if (stopping)
+                return;
+            const auto now{std::chrono::steady_clock::now()};
+            for (const auto& entry : polled) {
+                // Cancelled while polling
+                auto itr{requests.find(entry.id)};
+                if (itr == requests.end())
+                    continue;
+                auto& request{itr->second};
+                const bool ready{std::any_of(fds.begin() + entry.first,
+                                             fds.begin() + entry.first + entry.count,
+                                             [](const pollfd& fd) { return fd.revents != 0; })};
+                Status status;
+                if (ready)
+                    status = Status::Ready;
+                else if (request.deadline && now >= *request.deadline)
+                    status = Status::TimedOut;
+                else
+                    continue;
+                if (request.attempt(status)) {
+                    completed.push_back(entry.id);
+                    requests.erase(itr);
+                }
+            }
+        }
+        for (u64 id : completed)
+            on_complete(id);
+    }
+}
+
+} // namespace Service::SOC
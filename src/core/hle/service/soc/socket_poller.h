@@ -0,0 +1,80 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Service::SOC {
+
+/**
+ * Waits for host sockets to become ready on its own thread, and retries the socket operations of
+ * blocked guest threads there, so that a guest blocking call never blocks the emu thread. Host
+ * sockets are non-blocking, operations are only ever attempted when poll reported them ready.
+ */
+class SocketPoller {
+public:
+    /// A socket to wait for, events are the platform's POLLIN/POLLOUT flags
+    struct Watch {
+        u32 socket;
+        short events;
+    };
+
+    enum class Status {
+        Ready,     ///< One of the sockets is ready
+        TimedOut,  ///< The deadline passed
+        Cancelled, ///< The request was cancelled, usually because a socket was closed
+    };
+
+    /**
+     * Attempts the operation without blocking, on the poller thread. Returns whether it completed,
+     * otherwise the poller waits again. It must complete when the status isn't Ready.
+     */
+    using Attempt = std::function<bool(Status status)>;
+
+    /// Called on the poller thread with the id of a completed request
+    using CompletionCallback = std::function<void(u64 id)>;
+
+    explicit SocketPoller(CompletionCallback on_complete);
+    ~SocketPoller();
+
+    /// Queues a request, the attempt runs every time one of the sockets is ready
+    void Submit(u64 id, std::vector<Watch> watches,
+                std::optional<std::chrono::steady_clock::time_point> deadline, Attempt attempt);
+
+    /// Completes the requests waiting for the socket as cancelled, before it's closed
+    void Cancel(u32 socket);
+
+private:
+    struct Request {
+        std::vector<Watch> watches;
+        std::optional<std::chrono::steady_clock::time_point> deadline;
+        Attempt attempt;
+    };
+
+    void Loop();
+    void Wake();
+
+    CompletionCallback on_complete;
+
+    // Guards requests and stopping. Attempts run with it held, so that Cancel returns only after
+    // the socket is no longer used by the poller thread.
+    std::mutex mutex;
+    std::unordered_map<u64, Request> requests;
+    bool stopping{};
+
+    // Loopback UDP socket connected to itself, sending to it interrupts poll
+    u32 wakeup_socket{};
+
+    std::thread thread;
+};
+
+} // namespace Service::SOC
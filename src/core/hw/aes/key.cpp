@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <exception>
+#include <mutex>
 #include <optional>
 #include <sstream>
 #include <cryptopp/aes.h>
@@ -69,11 +70,15 @@ struct KeySlot {
 
     void GenerateNormalKey() {
         if (x && y)
-            normal = Lrot128(Add128(Xor128(Lrot128(*x, 2), *y), generator_constant), 87);
+            normal = ScrambleKeys(*x, *y);
         else
             normal.reset();
     }
 
+    static AESKey ScrambleKeys(const AESKey& x, const AESKey& y) {
+        return Lrot128(Add128(Xor128(Lrot128(x, 2), y), generator_constant), 87);
+    }
+
     void Clear() {
         x.reset();
         y.reset();
@@ -81,6 +86,7 @@ struct KeySlot {
     }
 };
 
+std::mutex key_slots_mutex; ///< Guards key_slots and common_key_y_slots
 std::array<KeySlot, KeySlotID::MaxKeySlotID> key_slots;
 std::array<std::optional<AESKey>, 6> common_key_y_slots;
 
@@ -218,6 +224,7 @@ void LoadPresetKeys() {
 } // namespace
 
 void InitKeys() {
+    std::lock_guard lock{key_slots_mutex};
     static bool initialized{};
     if (initialized)
         return;
@@ -227,27 +234,45 @@ void InitKeys() {
 }
 
 void SetKeyX(std::size_t slot_id, const AESKey& key) {
+    std::lock_guard lock{key_slots_mutex};
     key_slots.at(slot_id).SetKeyX(key);
 }
 
 void SetKeyY(std::size_t slot_id, const AESKey& key) {
+    std::lock_guard lock{key_slots_mutex};
     key_slots.at(slot_id).SetKeyY(key);
 }
 
 void SetNormalKey(std::size_t slot_id, const AESKey& key) {
+    std::lock_guard lock{key_slots_mutex};
     key_slots.at(slot_id).SetNormalKey(key);
 }
 
 bool IsNormalKeyAvailable(std::size_t slot_id) {
+    std::lock_guard lock{key_slots_mutex};
     return key_slots.at(slot_id).normal.has_value();
 }
 
 AESKey GetNormalKey(std::size_t slot_id) {
+    std::lock_guard lock{key_slots_mutex};
     return key_slots.at(slot_id).normal.value_or(AESKey{});
 }
 
-void SelectCommonKeyIndex(u8 index) {
-    key_slots[KeySlotID::TicketCommonKey].SetKeyY(common_key_y_slots.at(index));
+std::optional<AESKey> GenerateNormalKey(std::size_t slot_id, const AESKey& key_y) {
+    std::lock_guard lock{key_slots_mutex};
+    const auto& x{key_slots.at(slot_id).x};
+    if (!x)
+        return {};
+    return KeySlot::ScrambleKeys(*x, key_y);
+}
+
+std::optional<AESKey> GetCommonKey(u8 index) {
+    std::lock_guard lock{key_slots_mutex};
+    const auto& x{key_slots[KeySlotID::TicketCommonKey].x};
+    const auto& y{common_key_y_slots.at(index)};
+    if (!x || !y)
+        return {};
+    return KeySlot::ScrambleKeys(*x, *y);
 }
 
 } // namespace HW::AES
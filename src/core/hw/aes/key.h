@@ -6,6 +6,7 @@
 
 #include <array>
 #include <cstddef>
+#include <optional>
 #include "common/common_types.h"
 
 namespace HW::AES {
@@ -36,6 +37,9 @@ constexpr std::size_t AES_BLOCK_SIZE{16};
 
 using AESKey = std::array<u8, AES_BLOCK_SIZE>;
 
+// The key slots are global and used from several threads (e.g. when the program list is scanned
+// or a CIA is installed), all of these functions are thread-safe.
+
 void InitKeys();
 
 void SetGeneratorConstant(const AESKey& key);
@@ -46,6 +50,13 @@ void SetNormalKey(std::size_t slot_id, const AESKey& key);
 bool IsNormalKeyAvailable(std::size_t slot_id);
 AESKey GetNormalKey(std::size_t slot_id);
 
-void SelectCommonKeyIndex(u8 index);
+/**
+ * Generates the normal key a slot would have with the given KeyY, without changing the slot
+ * @return The normal key, or nullopt if the slot's KeyX is missing
+ */
+std::optional<AESKey> GenerateNormalKey(std::size_t slot_id, const AESKey& key_y);
+
+/// Returns the normal key of the ticket common key with the given index, if it's available
+std::optional<AESKey> GetCommonKey(u8 index);
 
 } // namespace HW::AES
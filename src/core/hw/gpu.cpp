@@ -10,11 +10,15 @@
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/vector_math.h"
+#include "core/core.h"
 #include "core/core_timing.h"
 #include "core/hle/service/gsp/gsp.h"
 #include "core/hw/gpu.h"
 #include "core/hw/hw.h"
 #include "core/memory.h"
+#ifdef ENABLE_SCRIPTING
+#include "core/rpc/rpc_server.h"
+#endif
 #include "core/settings.h"
 #include "video_core/command_processor.h"
 #include "video_core/renderer/renderer.h"
@@ -154,6 +158,15 @@ static void DisplayTransfer(const Regs::DisplayTransferConfig& config) {
     u32 output_size{output_width * output_height * GPU::Regs::BytesPerPixel(config.output_format)};
     Memory::RasterizerFlushRegion(config.GetPhysicalInputAddress(), input_size);
     Memory::RasterizerInvalidateRegion(config.GetPhysicalOutputAddress(), output_size);
+    PerformDisplayTransfer(config, src_pointer, dst_pointer);
+}
+
+void PerformDisplayTransfer(const Regs::DisplayTransferConfig& config, const u8* src_pointer,
+                            u8* dst_pointer) {
+    int horizontal_scale{config.scaling != config.NoScale ? 1 : 0};
+    int vertical_scale{config.scaling == config.ScaleXY ? 1 : 0};
+    u32 output_width{config.output_width >> horizontal_scale};
+    u32 output_height{config.output_height >> vertical_scale};
     for (u32 y{}; y < output_height; ++y) {
         for (u32 x{}; x < output_width; ++x) {
             Math::Vec4<u8> src_color;
@@ -399,6 +412,11 @@ template void Write<u8>(u32 addr, const u8 data);
 /// Update hardware
 static void VBlankCallback(u64 userdata, s64 cycles_late) {
     VideoCore::g_renderer->SwapBuffers();
+#ifdef ENABLE_SCRIPTING
+    // RPC requests are applied between frames, once the frame is out
+    if (auto rpc_server{Core::System::GetInstance().GetRPCServer()})
+        rpc_server->FrameCallback();
+#endif
     // Signal to GSP that GPU interrupt has occurred
     // TODO: hwtest to determine if PDC0 is for the Top screen and PDC1 for the Sub
     // screen, or if both use the same interrupts and these two instead determine the
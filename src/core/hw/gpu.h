@@ -326,4 +326,8 @@ void Write(u32 addr, const T data);
 /// Initialize hardware
 void Init();
 
+/// Converts the pixels of a display transfer in software, between already validated buffers
+void PerformDisplayTransfer(const Regs::DisplayTransferConfig& config, const u8* src_pointer,
+                            u8* dst_pointer);
+
 } // namespace GPU
@@ -0,0 +1,62 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/logging/log.h"
+#include "core/core_timing.h"
+#include "core/idle_detector.h"
+#include "core/settings.h"
+
+namespace Core {
+
+IdleDetector::IdleDetector(Timing& timing) : timing{timing} {}
+
+void IdleDetector::BeginSVC() {
+    polled = false;
+}
+
+void IdleDetector::EndSVC() {
+    if (!polled)
+        streak_length = 0;
+}
+
+void IdleDetector::OnPoll(PollKind kind, u32 thread_id, bool other_threads_ready) {
+    polled = true;
+    ++counters.polls[static_cast<std::size_t>(kind)];
+    const u64 ticks{timing.GetTicks()};
+    if (thread_id != streak_thread_id || ticks - last_poll_ticks > POLL_WINDOW) {
+        streak_thread_id = thread_id;
+        streak_length = 0;
+    }
+    last_poll_ticks = ticks;
+    if (++streak_length < STREAK_THRESHOLD)
+        return;
+    if (streak_length == STREAK_THRESHOLD)
+        ++counters.streaks;
+    if (!Settings::values.skip_idle_loops || other_threads_ready)
+        return;
+    const s64 skipped{timing.SkipToNextEvent()};
+    if (skipped > 0) {
+        ++counters.skips;
+        counters.skipped_cycles += skipped;
+    }
+    // The thread's next poll happens after the skip
+    last_poll_ticks = timing.GetTicks();
+}
+
+void IdleDetector::ResetCounters() {
+    counters = {};
+}
+
+void IdleDetector::LogCounters() const {
+    LOG_INFO(Core,
+             "Idle detection: polls (sleep={}, wait={}, arbitrate={}, tick={}), streaks={}, "
+             "skips={}, skipped {} cycles",
+             counters.polls[static_cast<std::size_t>(PollKind::SleepThread)],
+             counters.polls[static_cast<std::size_t>(PollKind::WaitSynchronization)],
+             counters.polls[static_cast<std::size_t>(PollKind::ArbitrateAddress)],
+             counters.polls[static_cast<std::size_t>(PollKind::GetSystemTick)], counters.streaks,
+             counters.skips, counters.skipped_cycles);
+}
+
+} // namespace Core
@@ -0,0 +1,77 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include "common/common_types.h"
+
+namespace Core {
+
+class Timing;
+
+/// Ways a guest thread can poll without blocking
+enum class PollKind : u32 {
+    SleepThread,         ///< SleepThread(0) with no other thread to yield to
+    WaitSynchronization, ///< WaitSynchronization1/N with a zero timeout that timed out
+    ArbitrateAddress,    ///< A wait arbitration that returned without waiting
+    GetSystemTick,       ///< Reading the tick counter in a loop
+    Count,
+};
+
+/**
+ * Detects guest threads spinning on polls while no other thread can run, and fast-forwards
+ * Core::Timing to the next scheduled event instead of emulating the spin.
+ * A streak of polls by one thread, with no other SVC and little guest time between them, counts
+ * as spinning. Only used on the emu thread.
+ */
+class IdleDetector {
+public:
+    /// Consecutive polls needed before time is skipped
+    static constexpr u32 STREAK_THRESHOLD{32};
+
+    /// Maximum guest cycles between two polls of a streak
+    static constexpr u64 POLL_WINDOW{20000};
+
+    struct Counters {
+        std::array<u64, static_cast<std::size_t>(PollKind::Count)> polls{};
+        u64 streaks{};        ///< Streaks that reached the threshold
+        u64 skips{};          ///< Times the timer was fast-forwarded
+        u64 skipped_cycles{}; ///< Guest cycles skipped in total
+    };
+
+    explicit IdleDetector(Timing& timing);
+
+    /// Called before an SVC is handled
+    void BeginSVC();
+
+    /// Called after an SVC was handled, ends the streak if the SVC didn't poll
+    void EndSVC();
+
+    /**
+     * Reports a poll that didn't block by the current thread
+     * @param other_threads_ready whether another thread could run, which makes skipping unsafe
+     */
+    void OnPoll(PollKind kind, u32 thread_id, bool other_threads_ready);
+
+    const Counters& GetCounters() const {
+        return counters;
+    }
+
+    void ResetCounters();
+
+    /// Logs the counters, for tuning the heuristics
+    void LogCounters() const;
+
+private:
+    Timing& timing;
+    Counters counters;
+
+    bool polled{};
+    u32 streak_thread_id{};
+    u32 streak_length{};
+    u64 last_poll_ticks{};
+};
+
+} // namespace Core
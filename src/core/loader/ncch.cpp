@@ -144,6 +144,8 @@ ResultStatus ProgramLoader_NCCH::Load(Kernel::SharedPtr<Kernel::Process>& proces
     result = update_ncch.Load();
     if (result == ResultStatus::Success)
         overlay_ncch = &update_ncch;
+    base_ncch.EnableContentCache();
+    update_ncch.EnableContentCache();
     std::string program;
     ReadShortTitle(program);
     system.RoomMember().SendProgram(program);
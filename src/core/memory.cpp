@@ -4,6 +4,7 @@
 
 #include <array>
 #include <cstring>
+#include <boost/container/static_vector.hpp>
 #include "audio_core/hle/hle.h"
 #include "common/assert.h"
 #include "common/common_types.h"
@@ -21,11 +22,11 @@
 
 namespace Memory {
 
-static std::array<u8, Memory::VRAM_SIZE> vram;
-static std::array<u8, Memory::N3DS_EXTRA_RAM_SIZE> n3ds_extra_ram;
+static Common::VirtualBuffer vram{Memory::VRAM_SIZE};
+static Common::VirtualBuffer n3ds_extra_ram{Memory::N3DS_EXTRA_RAM_SIZE};
 static std::array<u8, Memory::L2C_SIZE> l2cache;
 static PageTable* current_page_table{};
-std::array<u8, Memory::FCRAM_N3DS_SIZE> fcram;
+Common::VirtualBuffer fcram{Memory::FCRAM_N3DS_SIZE};
 
 void SetCurrentPageTable(PageTable* page_table) {
     current_page_table = page_table;
@@ -199,6 +200,21 @@ u8* GetPointer(const VAddr vaddr) {
     return nullptr;
 }
 
+u8* GetContiguousPointer(const Kernel::Process& process, const VAddr vaddr,
+                         const std::size_t size) {
+    if (size == 0 || size > (u64{1} << 32) - vaddr)
+        return nullptr;
+    auto& page_table{process.vm_manager.page_table};
+    const std::size_t first_page{vaddr >> PAGE_BITS};
+    const std::size_t last_page{(vaddr + size - 1) >> PAGE_BITS};
+    u8* const base{page_table.pointers[first_page]};
+    for (std::size_t page{first_page}; page <= last_page; ++page)
+        if (page_table.attributes[page] != PageType::Memory ||
+            page_table.pointers[page] != base + (page - first_page) * PAGE_SIZE)
+            return nullptr;
+    return base + (vaddr & PAGE_MASK);
+}
+
 std::string ReadCString(VAddr vaddr, std::size_t max_length) {
     std::string string;
     string.reserve(max_length);
@@ -257,8 +273,10 @@ u8* GetPhysicalPointer(PAddr address) {
     return target_pointer;
 }
 
-/// For a rasterizer-accessible PAddr, gets a list of all possible VAddr
-static std::vector<VAddr> PhysicalToVirtualAddressForRasterizer(PAddr addr) {
+/// For a rasterizer-accessible PAddr, gets a list of all possible VAddr. Called for every page
+/// the rasterizer caches or flushes, so the list lives on the stack.
+static boost::container::static_vector<VAddr, 2> PhysicalToVirtualAddressForRasterizer(
+    PAddr addr) {
     if (addr >= VRAM_PADDR && addr < VRAM_PADDR_END)
         return {addr - VRAM_PADDR + VRAM_VADDR};
     else if (addr >= FCRAM_PADDR && addr < FCRAM_PADDR_END)
@@ -659,4 +677,15 @@ u32 GetFCRAMOffset(u8* pointer) {
     return pointer - fcram.data();
 }
 
+void ResetMemory() {
+    fcram.Reset();
+    vram.Reset();
+    n3ds_extra_ram.Reset();
+}
+
+std::size_t GetCommittedBytes() {
+    return fcram.GetCommittedBytes() + vram.GetCommittedBytes() +
+           n3ds_extra_ram.GetCommittedBytes();
+}
+
 } // namespace Memory
@@ -9,6 +9,7 @@
 #include <string>
 #include <vector>
 #include "common/common_types.h"
+#include "common/virtual_buffer.h"
 #include "core/mmio.h"
 
 namespace Kernel {
@@ -186,7 +187,8 @@ enum : VAddr {
     NEW_LINEAR_HEAP_VADDR_END = NEW_LINEAR_HEAP_VADDR + NEW_LINEAR_HEAP_SIZE,
 };
 
-extern std::array<u8, Memory::FCRAM_N3DS_SIZE> fcram;
+/// The pages of FCRAM are only backed by host memory once written
+extern Common::VirtualBuffer fcram;
 
 /// Currently active page table
 void SetCurrentPageTable(PageTable* page_table);
@@ -220,6 +222,13 @@ void CopyBlock(const Kernel::Process& src_process, const Kernel::Process& dest_p
 
 u8* GetPointer(VAddr vaddr);
 
+/**
+ * Gets a host pointer to a virtual range of a process, if the whole range is plain memory that is
+ * contiguous on the host and not cached by the rasterizer.
+ * @return Pointer to the start of the range, or nullptr if it can't be accessed directly
+ */
+u8* GetContiguousPointer(const Kernel::Process& process, VAddr vaddr, std::size_t size);
+
 std::string ReadCString(VAddr vaddr, std::size_t max_length);
 
 /// Gets a pointer to the memory region beginning at the specified physical address.
@@ -257,4 +266,10 @@ void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode);
 /// Gets offset in FCRAM from a pointer inside FCRAM range
 u32 GetFCRAMOffset(u8* pointer);
 
+/// Zeroes FCRAM, VRAM and the New 3DS memory, returning their pages to the host
+void ResetMemory();
+
+/// Gets the bytes of FCRAM, VRAM and the New 3DS memory backed by host memory
+std::size_t GetCommittedBytes();
+
 } // namespace Memory
@@ -8,9 +8,9 @@
 
 namespace RPC {
 
-Packet::Packet(const PacketHeader& header, u8* data,
+Packet::Packet(const PacketHeader& header, u8* data, std::string peer,
                std::function<void(Packet&)> send_reply_callback)
-    : header{header}, send_reply_callback{std::move(send_reply_callback)} {
+    : header{header}, peer{std::move(peer)}, send_reply_callback{std::move(send_reply_callback)} {
     packet_data.resize(header.packet_size);
     std::memcpy(packet_data.data(), data, header.packet_size);
 }
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <functional>
+#include <string>
 #include <vector>
 #include "common/common_types.h"
 
@@ -31,6 +32,15 @@ enum class PacketType {
     SetFrameAdvancing,
     AdvanceFrame,
     GetCurrentFrame,
+    GetHLEProfile,
+    ResetHLEProfile,
+    Batch,
+    Subscribe,
+    Unsubscribe,
+    EnableSharedMemory,
+    DisableSharedMemory,
+    StartFrameProfile,
+    StopFrameProfile,
 };
 
 struct PacketHeader {
@@ -44,9 +54,57 @@ constexpr u32 CURRENT_VERSION{1};
 constexpr u32 MIN_PACKET_SIZE{sizeof(PacketHeader)};
 constexpr u32 MAX_READ_WRITE_SIZE{32};
 
+/**
+ * The data of a Batch request starts with the operation count and a zero word, followed by the
+ * operations. Each one is a BatchOperationHeader, followed by data_size bytes of data for writes
+ * and input states. All operations of a batch are applied together on the emu thread at the next
+ * frame boundary, and the reply data is the data of the reads, in order.
+ */
+struct BatchOperationHeader {
+    PacketType type; ///< ReadMemory, WriteMemory, PadState, TouchState, MotionState or CircleState
+    u32 address;     ///< Unused for input states
+    u32 data_size;
+};
+
+/**
+ * The data of a Subscribe request starts with the range count and a zero word, followed by the
+ * ranges. The reply data is the subscription id. The ranges are then read at every frame boundary
+ * and sent as Subscribe packets with the id of the request, whose data is the subscription id, the
+ * number of frames since the subscription and the data of the ranges, in order. Subscriptions are
+ * only available when the server runs in router mode. Unsubscribe takes the subscription id as
+ * its address.
+ */
+struct SubscriptionRange {
+    u32 address;
+    u32 data_size;
+};
+
+constexpr u32 MAX_BATCH_READ_WRITE_SIZE{0x1000};
+constexpr u32 MAX_BATCH_REPLY_SIZE{0x100000};
+
+/**
+ * The data of an EnableSharedMemory request starts with the region count and a zero word, followed
+ * by a SharedMemoryConfig and the regions as SubscriptionRanges. Frames and regions are then
+ * published to a shared memory object, laid out as described in shared_memory.h, and the reply
+ * data is its name, empty on failure. In router mode, an EnableSharedMemory packet with the id of
+ * the request is also sent after every region update, whose data is the frame and region sequences
+ * as two u64s. Enabling again replaces the previous export, DisableSharedMemory stops it.
+ */
+struct SharedMemoryConfig {
+    u32 frame_width; ///< Zero to only export regions
+    u32 frame_height;
+};
+
+constexpr u32 MAX_SHARED_MEMORY_FRAME_SIZE{4096};
+constexpr u32 MAX_SHARED_MEMORY_REGIONS{64};
+constexpr u32 MAX_SHARED_MEMORY_REGION_SIZE{0x1000000};
+/// All regions are copied every frame, so their total size is limited too
+constexpr u32 MAX_SHARED_MEMORY_REGIONS_SIZE{0x1000000};
+
 class Packet {
 public:
-    Packet(const PacketHeader& header, u8* data, std::function<void(Packet&)> send_reply_callback);
+    Packet(const PacketHeader& header, u8* data, std::string peer,
+           std::function<void(Packet&)> send_reply_callback);
 
     u32 GetVersion() const {
         return header.version;
@@ -68,6 +126,11 @@ public:
         return header;
     }
 
+    /// Routing id of the client in router mode, empty otherwise
+    const std::string& GetPeer() const {
+        return peer;
+    }
+
     std::vector<u8>& GetPacketData() {
         return packet_data;
     }
@@ -83,6 +146,7 @@ public:
 private:
     struct PacketHeader header;
     std::vector<u8> packet_data;
+    std::string peer;
 
     std::function<void(Packet&)> send_reply_callback;
 };
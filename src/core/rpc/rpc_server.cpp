@@ -2,11 +2,15 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cstring>
 #include "common/logging/log.h"
+#include "common/profiling.h"
 #include "core/core.h"
 #include "core/cpu/cpu.h"
 #include "core/frontend.h"
 #include "core/hle/kernel/process.h"
+#include "core/hle/profiler.h"
 #include "core/hle/service/hid/hid.h"
 #include "core/memory.h"
 #include "core/rpc/packet.h"
@@ -15,13 +19,40 @@
 
 namespace RPC {
 
+namespace {
+
+struct TouchState {
+    s16 x;
+    s16 y;
+    bool valid;
+};
+
+struct MotionState {
+    s16 x;
+    s16 y;
+    s16 z;
+    s16 roll;
+    s16 pitch;
+    s16 yaw;
+};
+
+struct CircleState {
+    s16 x;
+    s16 y;
+};
+
+} // Anonymous namespace
+
 RPCServer::RPCServer(Core::System& system) : server{*this}, system{system} {
+    // Created before the video core, which only uses the exporter once initialized
+    VideoCore::g_frame_exporter = &shared_memory;
     Start();
     LOG_INFO(RPC, "RPC started.");
 }
 
 RPCServer::~RPCServer() {
     Stop();
+    VideoCore::g_frame_exporter = nullptr;
     LOG_INFO(RPC, "RPC stopped.");
 }
 
@@ -184,6 +215,305 @@ void RPCServer::HandleGetCurrentFrame(Packet& packet) {
     packet.SendReply();
 }
 
+void RPCServer::HandleGetHLEProfile(Packet& packet) {
+    const std::string json{system.GetHLEProfiler().ExportJSON()};
+    packet.GetPacketData().assign(json.begin(), json.end());
+    packet.SetPacketDataSize(static_cast<u32>(json.size()));
+    packet.SendReply();
+}
+
+void RPCServer::HandleResetHLEProfile(Packet& packet) {
+    system.GetHLEProfiler().Reset();
+    packet.SetPacketDataSize(0);
+    packet.SendReply();
+}
+
+void RPCServer::HandleStartFrameProfile(Packet& packet) {
+    Common::Profiling::Start();
+    packet.SetPacketDataSize(0);
+    packet.SendReply();
+}
+
+void RPCServer::HandleStopFrameProfile(Packet& packet) {
+    Common::Profiling::Stop();
+    const std::string json{Common::Profiling::ExportChromeTrace()};
+    packet.GetPacketData().assign(json.begin(), json.end());
+    packet.SetPacketDataSize(static_cast<u32>(json.size()));
+    packet.SendReply();
+}
+
+void RPCServer::HandleUnsubscribe(Packet& packet, u32 id) {
+    {
+        std::lock_guard lock{frame_mutex};
+        subscriptions.erase(std::remove_if(subscriptions.begin(), subscriptions.end(),
+                                           [id](const Subscription& subscription) {
+                                               return subscription.id == id;
+                                           }),
+                            subscriptions.end());
+    }
+    packet.SetPacketDataSize(0);
+    packet.SendReply();
+}
+
+void RPCServer::HandleDisableSharedMemory(Packet& packet) {
+    {
+        std::lock_guard lock{frame_mutex};
+        shared_memory_packet.reset();
+        shared_memory.Disable();
+    }
+    packet.SetPacketDataSize(0);
+    packet.SendReply();
+}
+
+bool RPCServer::QueueBatch(std::unique_ptr<Packet>& packet, u32 operation_count) {
+    const auto& data{packet->GetPacketData()};
+    std::size_t offset{sizeof(u32) * 2};
+    if (operation_count > (data.size() - offset) / sizeof(BatchOperationHeader))
+        return false;
+    Batch batch;
+    batch.operations.reserve(operation_count);
+    std::size_t reply_size{};
+    for (u32 i{}; i < operation_count; ++i) {
+        BatchOperationHeader header;
+        if (data.size() - offset < sizeof(header))
+            return false;
+        std::memcpy(&header, data.data() + offset, sizeof(header));
+        offset += sizeof(header);
+        // Size of the data following the operation header
+        std::size_t operation_data_size{header.data_size};
+        switch (header.type) {
+        case PacketType::ReadMemory:
+            if (header.data_size == 0 || header.data_size > MAX_BATCH_READ_WRITE_SIZE)
+                return false;
+            reply_size += header.data_size;
+            if (reply_size > MAX_BATCH_REPLY_SIZE)
+                return false;
+            operation_data_size = 0;
+            break;
+        case PacketType::WriteMemory:
+            if (header.data_size == 0 || header.data_size > MAX_BATCH_READ_WRITE_SIZE)
+                return false;
+            break;
+        case PacketType::PadState:
+            if (header.data_size != sizeof(u32))
+                return false;
+            break;
+        case PacketType::TouchState:
+            if (header.data_size != sizeof(TouchState))
+                return false;
+            break;
+        case PacketType::MotionState:
+            if (header.data_size != sizeof(MotionState))
+                return false;
+            break;
+        case PacketType::CircleState:
+            if (header.data_size != sizeof(CircleState))
+                return false;
+            break;
+        default:
+            return false;
+        }
+        if (data.size() - offset < operation_data_size)
+            return false;
+        batch.operations.push_back({header.type, header.address, header.data_size, offset});
+        offset += operation_data_size;
+    }
+    batch.packet = std::move(packet);
+    std::lock_guard lock{frame_mutex};
+    pending_batches.push_back(std::move(batch));
+    return true;
+}
+
+bool RPCServer::Subscribe(std::unique_ptr<Packet>& packet, u32 range_count) {
+    // Updates can't be sent to REP sockets without a request
+    if (!server.IsRouterMode())
+        return false;
+    const auto& data{packet->GetPacketData()};
+    const std::size_t offset{sizeof(u32) * 2};
+    if (range_count == 0 || range_count > (data.size() - offset) / sizeof(SubscriptionRange) ||
+        data.size() != offset + range_count * sizeof(SubscriptionRange))
+        return false;
+    Subscription subscription{};
+    subscription.ranges.resize(range_count);
+    std::memcpy(subscription.ranges.data(), data.data() + offset,
+                range_count * sizeof(SubscriptionRange));
+    std::size_t update_size{sizeof(u32) * 2};
+    for (const auto& range : subscription.ranges) {
+        if (range.data_size == 0 || range.data_size > MAX_BATCH_READ_WRITE_SIZE)
+            return false;
+        update_size += range.data_size;
+    }
+    if (update_size > MAX_BATCH_REPLY_SIZE)
+        return false;
+    // Replying with the lock held makes sure that the reply comes before the first update
+    std::lock_guard lock{frame_mutex};
+    subscription.id = next_subscription_id++;
+    packet->GetPacketData().resize(sizeof(u32));
+    std::memcpy(packet->GetPacketData().data(), &subscription.id, sizeof(u32));
+    packet->SetPacketDataSize(sizeof(u32));
+    packet->SendReply();
+    packet->GetPacketData().resize(update_size);
+    packet->SetPacketDataSize(static_cast<u32>(update_size));
+    subscription.packet = std::move(packet);
+    subscriptions.push_back(std::move(subscription));
+    return true;
+}
+
+bool RPCServer::EnableSharedMemory(std::unique_ptr<Packet>& packet, u32 region_count) {
+    const auto& data{packet->GetPacketData()};
+    const std::size_t offset{sizeof(u32) * 2 + sizeof(SharedMemoryConfig)};
+    if (region_count > MAX_SHARED_MEMORY_REGIONS ||
+        data.size() != offset + region_count * sizeof(SubscriptionRange))
+        return false;
+    SharedMemoryConfig config;
+    std::memcpy(&config, data.data() + sizeof(u32) * 2, sizeof(config));
+    if (config.frame_width > MAX_SHARED_MEMORY_FRAME_SIZE ||
+        config.frame_height > MAX_SHARED_MEMORY_FRAME_SIZE ||
+        (config.frame_width == 0) != (config.frame_height == 0))
+        return false;
+    std::vector<SubscriptionRange> regions(region_count);
+    std::memcpy(regions.data(), data.data() + offset, region_count * sizeof(SubscriptionRange));
+    std::size_t regions_size{};
+    for (const auto& region : regions) {
+        if (region.data_size == 0 || region.data_size > MAX_SHARED_MEMORY_REGION_SIZE)
+            return false;
+        regions_size += region.data_size;
+    }
+    if (regions_size > MAX_SHARED_MEMORY_REGIONS_SIZE)
+        return false;
+    // Replying with the lock held makes sure that the reply comes before the first update
+    std::lock_guard lock{frame_mutex};
+    shared_memory_packet.reset();
+    const std::string name{shared_memory.Enable(config.frame_width, config.frame_height, regions)};
+    packet->GetPacketData().assign(name.begin(), name.end());
+    packet->SetPacketDataSize(static_cast<u32>(name.size()));
+    packet->SendReply();
+    if (!name.empty() && server.IsRouterMode()) {
+        packet->GetPacketData().resize(sizeof(u64) * 2);
+        packet->SetPacketDataSize(sizeof(u64) * 2);
+        shared_memory_packet = std::move(packet);
+    }
+    return true;
+}
+
+void RPCServer::ApplyBatch(Batch& batch) {
+    auto& process{*system.Kernel().GetCurrentProcess()};
+    auto hid{system.ServiceManager()
+                 .GetService<Service::HID::Module::Interface>("hid:USER")
+                 ->GetModule()};
+    const auto& data{batch.packet->GetPacketData()};
+    std::vector<u8> reply;
+    for (const auto& operation : batch.operations) {
+        const u8* operation_data{data.data() + operation.data_offset};
+        switch (operation.type) {
+        case PacketType::ReadMemory: {
+            const std::size_t offset{reply.size()};
+            reply.resize(offset + operation.data_size);
+            Memory::ReadBlock(process, operation.address, reply.data() + offset,
+                              operation.data_size);
+            break;
+        }
+        case PacketType::WriteMemory:
+            Memory::WriteBlock(process, operation.address, operation_data, operation.data_size);
+            system.CPU().InvalidateCacheRange(operation.address, operation.data_size);
+            break;
+        case PacketType::PadState: {
+            u32 raw;
+            std::memcpy(&raw, operation_data, sizeof(u32));
+            hid->SetPadState(raw);
+            break;
+        }
+        case PacketType::TouchState: {
+            TouchState state;
+            std::memcpy(&state, operation_data, sizeof(state));
+            hid->SetTouchState(state.x, state.y, state.valid);
+            break;
+        }
+        case PacketType::MotionState: {
+            MotionState state;
+            std::memcpy(&state, operation_data, sizeof(state));
+            hid->SetMotionState(state.x, state.y, state.z, state.roll, state.pitch, state.yaw);
+            break;
+        }
+        case PacketType::CircleState: {
+            CircleState state;
+            std::memcpy(&state, operation_data, sizeof(state));
+            hid->SetCircleState(state.x, state.y);
+            break;
+        }
+        default:
+            UNREACHABLE();
+        }
+    }
+    const auto reply_size{static_cast<u32>(reply.size())};
+    batch.packet->GetPacketData() = std::move(reply);
+    batch.packet->SetPacketDataSize(reply_size);
+    batch.packet->SendReply();
+}
+
+void RPCServer::SendSubscriptionUpdate(Subscription& subscription) {
+    auto& process{*system.Kernel().GetCurrentProcess()};
+    u8* data{subscription.packet->GetPacketData().data()};
+    ++subscription.frames;
+    std::memcpy(data, &subscription.id, sizeof(u32));
+    std::memcpy(data + sizeof(u32), &subscription.frames, sizeof(u32));
+    std::size_t offset{sizeof(u32) * 2};
+    for (const auto& range : subscription.ranges) {
+        Memory::ReadBlock(process, range.address, data + offset, range.data_size);
+        offset += range.data_size;
+    }
+    subscription.packet->SendReply();
+}
+
+void RPCServer::SendSharedMemoryUpdate() {
+    const u64 sequences[2]{shared_memory.GetFrameSequence(), shared_memory.GetRegionSequence()};
+    std::memcpy(shared_memory_packet->GetPacketData().data(), sequences, sizeof(sequences));
+    shared_memory_packet->SendReply();
+}
+
+void RPCServer::FrameCallback() {
+    std::vector<Batch> batches;
+    std::vector<std::string> peers;
+    {
+        std::lock_guard lock{gone_peers_mutex};
+        peers.swap(gone_peers);
+    }
+    {
+        std::lock_guard lock{frame_mutex};
+        for (const auto& peer : peers)
+            DropPeer(peer);
+        batches.swap(pending_batches);
+        // Nothing runs on the emu thread in between, so that every batch is applied atomically
+        // with respect to the guest
+        for (auto& batch : batches)
+            ApplyBatch(batch);
+        for (auto& subscription : subscriptions)
+            SendSubscriptionUpdate(subscription);
+        shared_memory.ExportRegions(*system.Kernel().GetCurrentProcess());
+        if (shared_memory_packet)
+            SendSharedMemoryUpdate();
+    }
+}
+
+void RPCServer::RemovePeer(const std::string& peer) {
+    // The ZeroMQ worker can't take frame_mutex, as it may be held while a reply is queued for it
+    std::lock_guard lock{gone_peers_mutex};
+    gone_peers.push_back(peer);
+}
+
+void RPCServer::DropPeer(const std::string& peer) {
+    subscriptions.erase(std::remove_if(subscriptions.begin(), subscriptions.end(),
+                                       [&peer](const Subscription& subscription) {
+                                           return subscription.packet->GetPeer() == peer;
+                                       }),
+                        subscriptions.end());
+    // The export is only useful to the client which enabled it
+    if (shared_memory_packet && shared_memory_packet->GetPeer() == peer) {
+        shared_memory_packet.reset();
+        shared_memory.Disable();
+    }
+}
+
 bool RPCServer::ValidatePacket(const PacketHeader& packet_header) {
     if (packet_header.version <= CURRENT_VERSION) {
         switch (packet_header.packet_type) {
@@ -206,6 +536,15 @@ bool RPCServer::ValidatePacket(const PacketHeader& packet_header) {
         case PacketType::SetFrameAdvancing:
         case PacketType::AdvanceFrame:
         case PacketType::GetCurrentFrame:
+        case PacketType::GetHLEProfile:
+        case PacketType::ResetHLEProfile:
+        case PacketType::Batch:
+        case PacketType::Subscribe:
+        case PacketType::Unsubscribe:
+        case PacketType::EnableSharedMemory:
+        case PacketType::DisableSharedMemory:
+        case PacketType::StartFrameProfile:
+        case PacketType::StopFrameProfile:
             if (packet_header.packet_size >= (sizeof(u32) * 2))
                 return true;
             break;
@@ -250,11 +589,7 @@ void RPCServer::HandleSingleRequest(std::unique_ptr<Packet> request_packet) {
         }
         case PacketType::TouchState: {
             const u8* data{request_packet->GetPacketData().data() + (sizeof(u32) * 2)};
-            struct {
-                s16 x;
-                s16 y;
-                bool valid;
-            } state;
+            TouchState state;
             std::memcpy(&state, data, sizeof(state));
             HandleTouchState(*request_packet, state.x, state.y, state.valid);
             success = true;
@@ -262,14 +597,7 @@ void RPCServer::HandleSingleRequest(std::unique_ptr<Packet> request_packet) {
         }
         case PacketType::MotionState: {
             const u8* data{request_packet->GetPacketData().data() + (sizeof(u32) * 2)};
-            struct {
-                s16 x;
-                s16 y;
-                s16 z;
-                s16 roll;
-                s16 pitch;
-                s16 yaw;
-            } state;
+            MotionState state;
             std::memcpy(&state, data, sizeof(state));
             HandleMotionState(*request_packet, state.x, state.y, state.z, state.roll, state.pitch,
                               state.yaw);
@@ -278,10 +606,7 @@ void RPCServer::HandleSingleRequest(std::unique_ptr<Packet> request_packet) {
         }
         case PacketType::CircleState: {
             const u8* data{request_packet->GetPacketData().data() + (sizeof(u32) * 2)};
-            struct {
-                s16 x;
-                s16 y;
-            } state;
+            CircleState state;
             std::memcpy(&state, data, sizeof(state));
             HandleCircleState(*request_packet, state.x, state.y);
             success = true;
@@ -382,6 +707,43 @@ void RPCServer::HandleSingleRequest(std::unique_ptr<Packet> request_packet) {
             HandleGetCurrentFrame(*request_packet);
             success = true;
             break;
+        case PacketType::GetHLEProfile:
+            HandleGetHLEProfile(*request_packet);
+            success = true;
+            break;
+        case PacketType::ResetHLEProfile:
+            HandleResetHLEProfile(*request_packet);
+            success = true;
+            break;
+        case PacketType::Batch:
+            // Replied to at the next frame boundary
+            if (QueueBatch(request_packet, address))
+                return;
+            break;
+        case PacketType::Subscribe:
+            if (Subscribe(request_packet, address))
+                return;
+            break;
+        case PacketType::Unsubscribe:
+            HandleUnsubscribe(*request_packet, address);
+            success = true;
+            break;
+        case PacketType::EnableSharedMemory:
+            if (EnableSharedMemory(request_packet, address))
+                return;
+            break;
+        case PacketType::DisableSharedMemory:
+            HandleDisableSharedMemory(*request_packet);
+            success = true;
+            break;
+        case PacketType::StartFrameProfile:
+            HandleStartFrameProfile(*request_packet);
+            success = true;
+            break;
+        case PacketType::StopFrameProfile:
+            HandleStopFrameProfile(*request_packet);
+            success = true;
+            break;
         default:
             break;
         }
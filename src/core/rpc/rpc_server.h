@@ -6,9 +6,14 @@
 
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <thread>
+#include <vector>
 #include "common/threadsafe_queue.h"
+#include "core/rpc/packet.h"
 #include "core/rpc/server.h"
+#include "core/rpc/shared_memory.h"
 
 namespace Core {
 class System;
@@ -16,8 +21,6 @@ class System;
 
 namespace RPC {
 
-class PacketHeader;
-
 class RPCServer {
 public:
     explicit RPCServer(Core::System& system);
@@ -25,6 +28,12 @@ public:
 
     void QueueRequest(std::unique_ptr<RPC::Packet> request);
 
+    /// Applies the queued batches and sends the subscription updates, on every VBlank
+    void FrameCallback();
+
+    /// Queues dropping the subscriptions and shared memory export of a client which disconnected
+    void RemovePeer(const std::string& peer);
+
 private:
     void Start();
     void Stop();
@@ -47,14 +56,65 @@ private:
     void HandleSetFrameAdvancing(Packet& packet, bool enable);
     void HandleAdvanceFrame(Packet& packet);
     void HandleGetCurrentFrame(Packet& packet);
+    void HandleGetHLEProfile(Packet& packet);
+    void HandleResetHLEProfile(Packet& packet);
+    void HandleStartFrameProfile(Packet& packet);
+    void HandleStopFrameProfile(Packet& packet);
+    void HandleUnsubscribe(Packet& packet, u32 id);
+    void HandleDisableSharedMemory(Packet& packet);
     bool ValidatePacket(const PacketHeader& packet_header);
     void HandleSingleRequest(std::unique_ptr<Packet> request);
     void HandleRequestsLoop();
 
+    struct BatchOperation {
+        PacketType type;
+        u32 address;
+        u32 data_size;
+        std::size_t data_offset; ///< Offset of the operation data in the request data
+    };
+
+    struct Batch {
+        std::unique_ptr<Packet> packet;
+        std::vector<BatchOperation> operations;
+    };
+
+    struct Subscription {
+        u32 id;
+        u32 frames;
+        std::unique_ptr<Packet> packet; ///< The Subscribe request, reused for the updates
+        std::vector<SubscriptionRange> ranges;
+    };
+
+    /// Validates a batch and queues it for the next frame, taking the packet on success
+    bool QueueBatch(std::unique_ptr<Packet>& packet, u32 operation_count);
+
+    /// Validates and adds a subscription, taking the packet on success
+    bool Subscribe(std::unique_ptr<Packet>& packet, u32 range_count);
+
+    /// Validates the request, starts exporting and replies, taking the packet in router mode
+    bool EnableSharedMemory(std::unique_ptr<Packet>& packet, u32 region_count);
+
+    void ApplyBatch(Batch& batch);
+    void SendSubscriptionUpdate(Subscription& subscription);
+    void SendSharedMemoryUpdate();
+    void DropPeer(const std::string& peer);
+
     Server server;
     Common::SPSCQueue<std::unique_ptr<Packet>> request_queue;
     std::thread request_handler_thread;
 
+    // Guards pending_batches, subscriptions, next_subscription_id and shared_memory_packet
+    std::mutex frame_mutex;
+    std::vector<Batch> pending_batches;
+    std::vector<Subscription> subscriptions;
+    u32 next_subscription_id{1};
+    std::unique_ptr<Packet> shared_memory_packet; ///< The EnableSharedMemory request in router mode
+    SharedMemoryExport shared_memory;
+
+    // Clients found disconnected by the ZeroMQ worker, dropped on the next frame
+    std::mutex gone_peers_mutex;
+    std::vector<std::string> gone_peers;
+
     Core::System& system;
 };
 
@@ -3,41 +3,74 @@
 // Refer to the license.txt file included.
 
 #include <atomic>
+#include <cerrno>
 #include <functional>
+#include <mutex>
+#include <string>
 #include <thread>
+#include <vector>
+#include <fmt/format.h>
 #define ZMQ_STATIC
 #include <zmq.hpp>
 #include "core/core.h"
 #include "core/rpc/packet.h"
 #include "core/rpc/rpc_server.h"
 #include "core/rpc/server.h"
+#include "core/settings.h"
 
 namespace RPC {
 
+constexpr char REPLY_QUEUE_ENDPOINT[]{"inproc://rpc-replies"};
+
 struct Server::Impl {
-    Impl(std::function<void(std::unique_ptr<Packet>)> callback);
+    Impl(std::function<void(std::unique_ptr<Packet>)> callback,
+         std::function<void(const std::string&)> peer_gone_callback, u16 port, bool router_mode);
     ~Impl();
 
     void WorkerLoop();
-    void SendReply(Packet& request);
+    void ReceiveRequest();
+    void ForwardReply();
+    void SendReply(const std::vector<std::string>& envelope, Packet& reply_packet);
 
     std::thread worker_thread;
     std::atomic_bool running{true};
+    const bool router_mode;
 
     std::unique_ptr<zmq::context_t> zmq_context;
     std::unique_ptr<zmq::socket_t> zmq_socket;
 
+    // Replies are sent from the request handler and emu threads, but ZeroMQ sockets can only be
+    // used by one thread at a time. They are queued through an inproc socket pair instead, and
+    // the worker thread forwards them to the main socket.
+    std::mutex reply_mutex;
+    std::unique_ptr<zmq::socket_t> reply_push_socket;
+    std::unique_ptr<zmq::socket_t> reply_pull_socket;
+
     std::function<void(std::unique_ptr<Packet>)> new_request_callback;
+    std::function<void(const std::string&)> peer_gone_callback;
 };
 
-Server::Impl::Impl(std::function<void(std::unique_ptr<Packet>)> callback) {
+Server::Impl::Impl(std::function<void(std::unique_ptr<Packet>)> callback,
+                   std::function<void(const std::string&)> peer_gone_callback, u16 port,
+                   bool router_mode)
+    : router_mode{router_mode}, peer_gone_callback{std::move(peer_gone_callback)} {
     zmq_context = std::make_unique<zmq::context_t>(1);
-    zmq_socket = std::make_unique<zmq::socket_t>(*zmq_context, ZMQ_REP),
+    zmq_socket = std::make_unique<zmq::socket_t>(*zmq_context, router_mode ? ZMQ_ROUTER : ZMQ_REP);
+    reply_pull_socket = std::make_unique<zmq::socket_t>(*zmq_context, ZMQ_PULL);
+    reply_push_socket = std::make_unique<zmq::socket_t>(*zmq_context, ZMQ_PUSH);
+    const int linger{};
+    for (auto* socket : {zmq_socket.get(), reply_pull_socket.get(), reply_push_socket.get()})
+        socket->setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+    if (router_mode) {
+        // Makes sending to a client which disconnected fail, rather than silently drop the message
+        const int mandatory{1};
+        zmq_socket->setsockopt(ZMQ_ROUTER_MANDATORY, &mandatory, sizeof(mandatory));
+    }
     new_request_callback = std::move(callback);
-    // Use a random high port
-    // TODO: Make configurable or increment port number on failure
-    zmq_socket->bind("tcp://127.0.0.1:45987");
-    LOG_INFO(RPC, "ZeroMQ listening on port 45987");
+    reply_pull_socket->bind(REPLY_QUEUE_ENDPOINT);
+    reply_push_socket->connect(REPLY_QUEUE_ENDPOINT);
+    zmq_socket->bind(fmt::format("tcp://127.0.0.1:{}", port));
+    LOG_INFO(RPC, "ZeroMQ listening on port {} ({} mode)", port, router_mode ? "router" : "reply");
     worker_thread = std::thread(&Server::Impl::WorkerLoop, this);
 }
 
@@ -45,52 +78,132 @@ Server::Impl::~Impl() {
     // Triggering the zmq_context destructor will cancel
     // any blocking calls to zmq_socket->recv()
     running = false;
+    {
+        std::lock_guard lock{reply_mutex};
+        reply_push_socket.reset();
+    }
     zmq_context.reset();
     worker_thread.join();
 }
 
 void Server::Impl::WorkerLoop() {
-    zmq::message_t request;
     while (running) {
         try {
-            if (zmq_socket->recv(&request, 0)) {
-                if (request.size() >= MIN_PACKET_SIZE) {
-                    u8* request_buffer{static_cast<u8*>(request.data())};
-                    PacketHeader header;
-                    std::memcpy(&header, request_buffer, sizeof(header));
-                    if ((request.size() - MIN_PACKET_SIZE) == header.packet_size) {
-                        u8* data{request_buffer + MIN_PACKET_SIZE};
-                        std::function<void(Packet&)> send_reply_callback{
-                            std::bind(&Server::Impl::SendReply, this, std::placeholders::_1)};
-                        std::unique_ptr<Packet> new_packet{
-                            std::make_unique<Packet>(header, data, send_reply_callback)};
-                        // Send the request to the upper layer for handling
-                        new_request_callback(std::move(new_packet));
-                    }
-                }
-            }
+            zmq::pollitem_t items[]{
+                {static_cast<void*>(*zmq_socket), 0, ZMQ_POLLIN, 0},
+                {static_cast<void*>(*reply_pull_socket), 0, ZMQ_POLLIN, 0},
+            };
+            zmq::poll(items, 2, -1);
+            if (items[1].revents & ZMQ_POLLIN)
+                ForwardReply();
+            if (items[0].revents & ZMQ_POLLIN)
+                ReceiveRequest();
         } catch (...) {
             LOG_WARNING(RPC, "Failed to receive data on ZeroMQ socket");
         }
     }
     new_request_callback({});
-    // Destroying the socket must be done by this thread.
+    // Destroying the sockets must be done by this thread.
+    reply_pull_socket.reset();
     zmq_socket.reset();
 }
 
-void Server::Impl::SendReply(Packet& reply_packet) {
-    if (running) {
-        auto reply_buffer{
-            std::make_unique<u8[]>(MIN_PACKET_SIZE + reply_packet.GetPacketDataSize())};
-        auto reply_header{reply_packet.GetHeader()};
-        std::memcpy(reply_buffer.get(), &reply_header, sizeof(reply_header));
-        std::memcpy(reply_buffer.get() + (4 * sizeof(u32)), reply_packet.GetPacketData().data(),
-                    reply_packet.GetPacketDataSize());
-        zmq_socket->send(reply_buffer.get(), MIN_PACKET_SIZE + reply_packet.GetPacketDataSize());
-        LOG_INFO(RPC, "Sent reply version({}) id=({}) type=({}) size=({})",
-                 reply_packet.GetVersion(), reply_packet.GetId(),
-                 static_cast<u32>(reply_packet.GetPacketType()), reply_packet.GetPacketDataSize());
+void Server::Impl::ReceiveRequest() {
+    // In router mode, the request is preceded by the routing envelope of the client
+    std::vector<std::string> envelope;
+    zmq::message_t request;
+    for (;;) {
+        if (!zmq_socket->recv(&request, 0))
+            return;
+        if (!request.more())
+            break;
+        envelope.emplace_back(static_cast<const char*>(request.data()), request.size());
+    }
+    if (request.size() < MIN_PACKET_SIZE)
+        return;
+    u8* request_buffer{static_cast<u8*>(request.data())};
+    PacketHeader header;
+    std::memcpy(&header, request_buffer, sizeof(header));
+    if ((request.size() - MIN_PACKET_SIZE) != header.packet_size)
+        return;
+    u8* data{request_buffer + MIN_PACKET_SIZE};
+    // The first frame of the envelope identifies the client
+    std::string peer{envelope.empty() ? std::string{} : envelope.front()};
+    std::function<void(Packet&)> send_reply_callback{
+        [this, envelope{std::move(envelope)}](Packet& reply) { SendReply(envelope, reply); }};
+    std::unique_ptr<Packet> new_packet{
+        std::make_unique<Packet>(header, data, std::move(peer), std::move(send_reply_callback))};
+    // Send the request to the upper layer for handling
+    new_request_callback(std::move(new_packet));
+}
+
+void Server::Impl::ForwardReply() {
+    zmq::message_t part;
+    std::string peer;
+    bool is_first{true};
+    bool dropped{};
+    bool peer_gone{};
+    bool more;
+    do {
+        if (!reply_pull_socket->recv(&part, 0))
+            return;
+        more = part.more();
+        if (is_first && router_mode)
+            peer.assign(static_cast<const char*>(part.data()), part.size());
+        is_first = false;
+        // The rest of a dropped message is still taken off the queue
+        if (dropped)
+            continue;
+        try {
+            // A client which doesn't keep up loses messages rather than holding up the others
+            dropped = !zmq_socket->send(part, (more ? ZMQ_SNDMORE : 0) | ZMQ_DONTWAIT);
+        } catch (const zmq::error_t& error) {
+            if (error.num() != EHOSTUNREACH)
+                throw;
+            dropped = peer_gone = true;
+        }
+    } while (more);
+    if (peer_gone) {
+        LOG_INFO(RPC, "Client disconnected");
+        peer_gone_callback(peer);
+    }
+}
+
+void Server::Impl::SendReply(const std::vector<std::string>& envelope, Packet& reply_packet) {
+    if (!running)
+        return;
+    const std::size_t reply_size{MIN_PACKET_SIZE + reply_packet.GetPacketDataSize()};
+    zmq::message_t reply{reply_size};
+    auto reply_header{reply_packet.GetHeader()};
+    std::memcpy(reply.data(), &reply_header, sizeof(reply_header));
+    std::memcpy(static_cast<u8*>(reply.data()) + MIN_PACKET_SIZE,
+                reply_packet.GetPacketData().data(), reply_packet.GetPacketDataSize());
+    {
+        std::lock_guard lock{reply_mutex};
+        if (!reply_push_socket)
+            return;
+        try {
+            // Never block while the worker is behind, the caller may hold locks it needs. Once the
+            // first part of a message is queued, the others are too.
+            for (const auto& frame : envelope) {
+                if (!reply_push_socket->send(frame.data(), frame.size(),
+                                             ZMQ_SNDMORE | ZMQ_DONTWAIT)) {
+                    LOG_WARNING(RPC, "Reply queue is full, dropping reply");
+                    return;
+                }
+            }
+            if (!reply_push_socket->send(reply, ZMQ_DONTWAIT)) {
+                LOG_WARNING(RPC, "Reply queue is full, dropping reply");
+                return;
+            }
+        } catch (...) {
+            LOG_WARNING(RPC, "Failed to send data on ZeroMQ socket");
+            return;
+        }
     }
+    LOG_DEBUG(RPC, "Sent reply version({}) id=({}) type=({}) size=({})",
+              reply_packet.GetVersion(), reply_packet.GetId(),
+              static_cast<u32>(reply_packet.GetPacketType()), reply_packet.GetPacketDataSize());
 }
 
 Server::Server(RPCServer& rpc_server) : rpc_server{rpc_server} {}
@@ -99,8 +212,11 @@ void Server::Start() {
     const auto callback{[this](std::unique_ptr<RPC::Packet> new_request) {
         NewRequestCallback(std::move(new_request));
     }};
+    const auto peer_gone_callback{
+        [this](const std::string& peer) { rpc_server.RemovePeer(peer); }};
     try {
-        impl = std::make_unique<Impl>(callback);
+        impl = std::make_unique<Impl>(callback, peer_gone_callback, Settings::values.rpc_port,
+                                      Settings::values.rpc_router_mode);
     } catch (...) {
         LOG_ERROR(RPC, "Error starting ZeroMQ server");
     }
@@ -113,10 +229,14 @@ void Server::Stop() {
 
 void Server::NewRequestCallback(std::unique_ptr<RPC::Packet> new_request) {
     if (new_request)
-        LOG_INFO(RPC, "Received request (version={}, id={}, type={}, size={})",
-                 new_request->GetVersion(), new_request->GetId(),
-                 static_cast<u32>(new_request->GetPacketType()), new_request->GetPacketDataSize());
+        LOG_DEBUG(RPC, "Received request (version={}, id={}, type={}, size={})",
+                  new_request->GetVersion(), new_request->GetId(),
+                  static_cast<u32>(new_request->GetPacketType()), new_request->GetPacketDataSize());
     rpc_server.QueueRequest(std::move(new_request));
 }
 
+bool Server::IsRouterMode() const {
+    return impl && impl->router_mode;
+}
+
 } // namespace RPC
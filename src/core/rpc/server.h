@@ -19,6 +19,9 @@ public:
     void Stop();
     void NewRequestCallback(std::unique_ptr<RPC::Packet> new_request);
 
+    /// Whether packets can be sent at any time, rather than only as a reply to each request
+    bool IsRouterMode() const;
+
 private:
     struct Impl;
     std::shared_ptr<Impl> impl;
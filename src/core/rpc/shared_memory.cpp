@@ -0,0 +1,170 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <new>
+#include <fmt/format.h>
+#include "common/alignment.h"
+#include "common/common_funcs.h"
+#include "common/logging/log.h"
+#include "core/memory.h"
+#include "core/rpc/shared_memory.h"
+#include "core/settings.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace RPC {
+
+namespace {
+
+constexpr std::size_t SHARED_MEMORY_ALIGNMENT{0x1000};
+
+/// Writes the data guarded by sequence, bumping it before and after like a seqlock
+template <typename Function>
+void WriteSequenced(std::atomic<u64>& sequence, Function&& write) {
+    const u64 value{sequence.load(std::memory_order_relaxed)};
+    sequence.store(value + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    write();
+    sequence.store(value + 2, std::memory_order_release);
+}
+
+} // Anonymous namespace
+
+SharedMemoryExport::~SharedMemoryExport() {
+    Disable();
+}
+
+std::string SharedMemoryExport::Enable(u32 frame_width, u32 frame_height,
+                                       const std::vector<SubscriptionRange>& regions) {
+    std::lock_guard lock{mutex};
+    Unmap();
+#ifdef _WIN32
+    LOG_ERROR(RPC, "Shared memory export is only available on POSIX systems");
+    return {};
+#else
+    // Header, region table, both frame slots, then the regions
+    std::size_t offset{sizeof(SharedMemoryHeader)};
+    const std::size_t region_table_offset{offset};
+    offset += regions.size() * sizeof(SharedMemoryRegion);
+    const std::size_t frame_size{std::size_t{frame_width} * frame_height * sizeof(u32)};
+    u32 frame_offsets[2]{};
+    for (auto& frame_offset : frame_offsets) {
+        offset = Common::AlignUp(offset, SHARED_MEMORY_ALIGNMENT);
+        frame_offset = static_cast<u32>(offset);
+        offset += frame_size;
+    }
+    std::vector<SharedMemoryRegion> table;
+    for (const auto& region : regions) {
+        offset = Common::AlignUp(offset, sizeof(u64));
+        table.push_back({region.address, region.data_size, static_cast<u32>(offset), 0});
+        offset += region.data_size;
+    }
+    const std::size_t new_size{Common::AlignUp(offset, SHARED_MEMORY_ALIGNMENT)};
+    const std::string new_name{fmt::format("/citra-rpc-{}", getpid())};
+    const int fd{shm_open(new_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600)};
+    if (fd == -1) {
+        LOG_ERROR(RPC, "Failed to create shared memory {}: {}", new_name, GetLastErrorMsg());
+        return {};
+    }
+    void* ptr{MAP_FAILED};
+    if (ftruncate(fd, static_cast<off_t>(new_size)) == 0)
+        ptr = mmap(nullptr, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    // The mapping keeps the object alive
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        LOG_ERROR(RPC, "Failed to map shared memory {}: {}", new_name, GetLastErrorMsg());
+        shm_unlink(new_name.c_str());
+        return {};
+    }
+    name = new_name;
+    base = static_cast<u8*>(ptr);
+    size = new_size;
+    header = new (base) SharedMemoryHeader{};
+    header->version = SHARED_MEMORY_VERSION;
+    header->frame_width = frame_width;
+    header->frame_height = frame_height;
+    header->frame_offsets[0] = frame_offsets[0];
+    header->frame_offsets[1] = frame_offsets[1];
+    header->region_count = static_cast<u32>(table.size());
+    header->region_table_offset = static_cast<u32>(region_table_offset);
+    std::memcpy(base + region_table_offset, table.data(), table.size() * sizeof(table[0]));
+    if (frame_size != 0)
+        layout = Layout::DefaultFrameLayout(frame_width, frame_height,
+                                            Settings::values.swap_screens);
+    // Written last, so that clients which see the magic see a complete header
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = SHARED_MEMORY_MAGIC;
+    LOG_INFO(RPC, "Exporting to shared memory {} ({} bytes)", name, size);
+    return name;
+#endif
+}
+
+void SharedMemoryExport::Disable() {
+    std::lock_guard lock{mutex};
+    Unmap();
+}
+
+void SharedMemoryExport::Unmap() {
+#ifndef _WIN32
+    if (!base)
+        return;
+    munmap(base, size);
+    shm_unlink(name.c_str());
+    name.clear();
+    base = nullptr;
+    size = 0;
+    header = nullptr;
+#endif
+}
+
+void SharedMemoryExport::ExportRegions(const Kernel::Process& process) {
+    std::lock_guard lock{mutex};
+    if (!header || header->region_count == 0)
+        return;
+    const auto* table{
+        reinterpret_cast<const SharedMemoryRegion*>(base + header->region_table_offset)};
+    WriteSequenced(header->region_sequence, [&] {
+        for (u32 i{}; i < header->region_count; ++i)
+            Memory::ReadBlock(process, table[i].address, base + table[i].offset, table[i].size);
+    });
+}
+
+Layout::FramebufferLayout SharedMemoryExport::GetFrameLayout() {
+    std::lock_guard lock{mutex};
+    return header ? layout : Layout::FramebufferLayout{};
+}
+
+void SharedMemoryExport::ExportFrame(const Layout::FramebufferLayout& frame_layout,
+                                     const void* data) {
+    std::lock_guard lock{mutex};
+    // Frames captured before the export was enabled again may have another size
+    if (!header || header->frame_width == 0 || frame_layout.width != header->frame_width ||
+        frame_layout.height != header->frame_height)
+        return;
+    // Only this thread writes the sequences, clients keep reading the other slot meanwhile
+    const u64 sequence{header->frame_sequence.load(std::memory_order_relaxed) + 1};
+    const std::size_t slot{sequence % 2};
+    const std::size_t frame_size{std::size_t{frame_layout.width} * frame_layout.height * 4};
+    WriteSequenced(header->frame_slot_sequences[slot], [&] {
+        std::memcpy(base + header->frame_offsets[slot], data, frame_size);
+    });
+    header->frame_sequence.store(sequence, std::memory_order_release);
+}
+
+u64 SharedMemoryExport::GetFrameSequence() const {
+    std::lock_guard lock{mutex};
+    return header ? header->frame_sequence.load(std::memory_order_relaxed) : 0;
+}
+
+u64 SharedMemoryExport::GetRegionSequence() const {
+    std::lock_guard lock{mutex};
+    return header ? header->region_sequence.load(std::memory_order_relaxed) : 0;
+}
+
+} // namespace RPC
@@ -0,0 +1,94 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+#include "core/framebuffer_layout.h"
+#include "core/rpc/packet.h"
+#include "video_core/video_core.h"
+
+namespace Kernel {
+class Process;
+} // namespace Kernel
+
+namespace RPC {
+
+constexpr u32 SHARED_MEMORY_MAGIC{0x4D485352}; // "RSHM"
+constexpr u32 SHARED_MEMORY_VERSION{1};
+
+/**
+ * Start of the shared memory object, all offsets are from its start. Readers use the sequence
+ * counters as seqlocks: a counter is odd while the data it guards is being written, so a copy is
+ * consistent if the counter was even and unchanged before and after copying it.
+ */
+struct SharedMemoryHeader {
+    u32 magic;
+    u32 version;
+    u32 frame_width; ///< Zero when frames aren't exported
+    u32 frame_height;
+    u32 frame_offsets[2]; ///< Frames are BGRA8, with rows from the bottom up
+    u32 region_count;
+    u32 region_table_offset; ///< Offset of region_count SharedMemoryRegions
+    /// Number of published frames, the latest is in frame_offsets[frame_sequence % 2]
+    std::atomic<u64> frame_sequence;
+    /// Odd while the frame in the slot is written
+    std::atomic<u64> frame_slot_sequences[2];
+    /// Twice the number of region updates, plus one while they're written
+    std::atomic<u64> region_sequence;
+};
+
+struct SharedMemoryRegion {
+    u32 address;
+    u32 size;
+    u32 offset; ///< Offset of the copy of the guest memory
+    u32 padding;
+};
+
+static_assert(std::atomic<u64>::is_always_lock_free, "The sequences are shared between processes");
+
+/**
+ * Publishes frames and guest memory regions to a POSIX shared memory object that local RPC
+ * clients map, so that they only go through the RPC socket for control messages. Unavailable on
+ * Windows.
+ */
+class SharedMemoryExport final : public VideoCore::FrameExporter {
+public:
+    ~SharedMemoryExport() override;
+
+    /**
+     * (Re)creates the shared memory object. Frames are drawn with the default layout of the given
+     * size, none if it's zero. Returns the name of the object, or an empty string on failure.
+     */
+    std::string Enable(u32 frame_width, u32 frame_height,
+                       const std::vector<SubscriptionRange>& regions);
+
+    void Disable();
+
+    /// Copies the regions from guest memory, on the emu thread
+    void ExportRegions(const Kernel::Process& process);
+
+    Layout::FramebufferLayout GetFrameLayout() override;
+    void ExportFrame(const Layout::FramebufferLayout& frame_layout, const void* data) override;
+
+    u64 GetFrameSequence() const;
+    u64 GetRegionSequence() const;
+
+private:
+    void Unmap();
+
+    // Guards everything, Enable and Disable run on the RPC request thread
+    mutable std::mutex mutex;
+    std::string name;
+    u8* base{};
+    std::size_t size{};
+    SharedMemoryHeader* header{};
+    Layout::FramebufferLayout layout{};
+};
+
+} // namespace RPC
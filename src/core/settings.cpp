@@ -88,8 +88,13 @@ void LogSettings() {
     LogSetting("Camera_OuterLeftConfig", values.camera_config[OuterLeftCamera]);
     LogSetting("Camera_OuterLeftFlip", values.camera_flip[OuterLeftCamera]);
     LogSetting("DataStorage_UseVirtualSd", values.use_virtual_sd);
+    LogSetting("DataStorage_UseContentCache", values.use_content_cache);
+    LogSetting("DataStorage_ContentCacheSizeMb", values.content_cache_size_mb);
     LogSetting("System_RegionValue", values.region_value);
+    LogSetting("Scripting_RPCPort", values.rpc_port);
+    LogSetting("Scripting_RPCRouterMode", values.rpc_router_mode);
     LogSetting("Hacks_PriorityBoost", values.priority_boost);
+    LogSetting("Hacks_SkipIdleLoops", values.skip_idle_loops);
     LogSetting("Hacks_Ticks", values.ticks);
     LogSetting("Hacks_TicksMode", static_cast<int>(values.ticks_mode));
     LogSetting("Hacks_IgnoreFormatReinterpretation", values.ignore_format_reinterpretation);
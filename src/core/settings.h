@@ -148,6 +148,8 @@ struct Values {
     bool use_virtual_sd;
     std::string nand_dir;
     std::string sdmc_dir;
+    bool use_content_cache;
+    u32 content_cache_size_mb;
 
     // System
     int region_value;
@@ -184,6 +186,12 @@ struct Values {
 
     // Logging
     std::string log_filter;
+    bool log_binary;
+    bool dump_hle_profile;
+
+    // Scripting
+    u16 rpc_port;
+    bool rpc_router_mode;
 
     // Audio
     bool enable_audio_stretching;
@@ -196,6 +204,7 @@ struct Values {
 
     // Hacks
     bool priority_boost;
+    bool skip_idle_loops;
     TicksMode ticks_mode;
     u64 ticks;
     bool ignore_format_reinterpretation;
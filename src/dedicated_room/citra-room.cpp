@@ -2,15 +2,21 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <chrono>
+#include <condition_variable>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <regex>
 #include <string>
 #include <thread>
+#include <vector>
 #include <getopt.h>
 #include <glad/glad.h>
+#include <json.hpp>
 
 #ifndef _MSC_VER
 #include <unistd.h>
@@ -30,6 +36,17 @@
 #include "core/core.h"
 #include "core/settings.h"
 #include "network/room.h"
+#include "network/room_pool.h"
+
+struct RoomConfig {
+    std::string name;
+    std::string description;
+    std::string creator;
+    std::string password;
+    u32 port{Network::DefaultRoomPort};
+    u32 max_members{16};
+    bool announce{};
+};
 
 static void PrintHelp(const char* argv0) {
     std::cout << "Usage: " << argv0
@@ -42,6 +59,14 @@ static void PrintHelp(const char* argv0) {
                  "--password          The password for the room\n"
                  "--creator           The creator of the room\n"
                  "--ban-list-file     The file for storing the room ban list\n"
+                 "--room              Host another room, as <name>:<port>[:<max members>], with\n"
+                 "                    the same description, password, creator and announce flag\n"
+                 "--rooms-file        JSON file of the rooms to host, as {\"threads\": n,\n"
+                 "                    \"rooms\": [{\"name\", \"port\", \"max_members\",\n"
+                 "                    \"description\", \"password\", \"creator\", \"announce\"}]}\n"
+                 "--threads           The number of threads running the rooms\n"
+                 "--stats-interval    Print the traffic of each room and member every that many\n"
+                 "                    seconds\n"
                  "-h, --help          Display this help and exit\n"
                  "-v, --version       Output version information and exit\n";
 }
@@ -82,15 +107,160 @@ static void SaveBanList(const Network::Room::BanList& ban_list, const std::strin
     file.flush();
 }
 
+static bool ParseRoomArgument(const std::string& argument, RoomConfig& config) {
+    // name:port[:max_members], the name can't contain a colon
+    const std::regex room_regex{"^([^:]+):([0-9]{1,5})(?::([0-9]{1,9}))?$"};
+    std::smatch match;
+    if (!std::regex_match(argument, match, room_regex))
+        return false;
+    const u32 port{static_cast<u32>(std::stoul(match[2]))};
+    if (port == 0 || port > 65535)
+        return false;
+    config.name = match[1];
+    config.port = port;
+    if (match[3].matched)
+        config.max_members = static_cast<u32>(std::stoul(match[3]));
+    return true;
+}
+
+static bool LoadRoomsFile(const std::string& path, std::vector<RoomConfig>& rooms, u32& threads) {
+    std::ifstream file;
+    OpenFStream(file, path, std::ios_base::in);
+    if (!file) {
+        std::cout << "Couldn't open the rooms file!\n\n";
+        return false;
+    }
+    try {
+        const auto json{nlohmann::json::parse(file)};
+        threads = json.value("threads", threads);
+        for (const auto& room : json.at("rooms")) {
+            RoomConfig config;
+            config.name = room.at("name").get<std::string>();
+            config.port = room.value("port", config.port);
+            config.max_members = room.value("max_members", config.max_members);
+            config.description = room.value("description", config.description);
+            config.password = room.value("password", config.password);
+            config.creator = room.value("creator", config.creator);
+            config.announce = room.value("announce", config.announce);
+            rooms.push_back(std::move(config));
+        }
+    } catch (const nlohmann::json::exception& exception) {
+        std::cout << fmt::format("Invalid rooms file: {}\n\n", exception.what());
+        return false;
+    }
+    return true;
+}
+
+static bool ValidateRooms(const std::vector<RoomConfig>& rooms) {
+    if (rooms.empty()) {
+        std::cout << "Room name is empty!\n\n";
+        return false;
+    }
+    for (const auto& room : rooms) {
+        if (room.name.empty()) {
+            std::cout << "Room name is empty!\n\n";
+            return false;
+        }
+        if (room.max_members >= Network::MaxConcurrentConnections || room.max_members < 2) {
+            std::cout << "max-members needs to be in the range 2 - "
+                      << Network::MaxConcurrentConnections << "!\n\n";
+            return false;
+        }
+        if (room.port > 65535) {
+            std::cout << "port needs to be in the range 0 - 65535!\n\n";
+            return false;
+        }
+        if (std::count_if(rooms.begin(), rooms.end(), [&room](const RoomConfig& other) {
+                return other.port == room.port;
+            }) > 1) {
+            std::cout << fmt::format("Port {} is used by more than one room!\n\n", room.port);
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Formats the rates of the traffic since the previous counters
+static std::string FormatRates(const Network::Room::Traffic& current,
+                               const Network::Room::Traffic& previous, double seconds) {
+    return fmt::format("in {:.0f} packets/s {:.1f} KiB/s, out {:.0f} packets/s {:.1f} KiB/s",
+                       (current.packets_received - previous.packets_received) / seconds,
+                       (current.bytes_received - previous.bytes_received) / seconds / 1024,
+                       (current.packets_sent - previous.packets_sent) / seconds,
+                       (current.bytes_sent - previous.bytes_sent) / seconds / 1024);
+}
+
+/// Prints the traffic of the rooms and their members every interval, until stopped
+class StatsPrinter {
+public:
+    StatsPrinter(const std::vector<std::unique_ptr<Network::Room>>& rooms, u32 interval)
+        : rooms{rooms}, interval{interval} {
+        if (interval != 0)
+            thread = std::thread{&StatsPrinter::Loop, this};
+    }
+
+    ~StatsPrinter() {
+        {
+            std::lock_guard lock{mutex};
+            stopping = true;
+        }
+        stop_requested.notify_one();
+        if (thread.joinable())
+            thread.join();
+    }
+
+private:
+    void Loop() {
+        std::vector<Network::Room::Traffic> last_rooms(rooms.size());
+        // Keyed by room index and nickname
+        std::map<std::pair<std::size_t, std::string>, Network::Room::Traffic> last_members;
+        std::unique_lock lock{mutex};
+        while (!stop_requested.wait_for(lock, std::chrono::seconds{interval},
+                                        [this] { return stopping; })) {
+            std::map<std::pair<std::size_t, std::string>, Network::Room::Traffic> members;
+            for (std::size_t i{}; i < rooms.size(); ++i) {
+                const auto& info{rooms[i]->GetRoomInformation()};
+                const auto traffic{rooms[i]->GetTraffic()};
+                const auto member_list{rooms[i]->GetRoomMemberList()};
+                std::cout << fmt::format("{} (port {}, {} members): {}\n", info.name, info.port,
+                                         member_list.size(),
+                                         FormatRates(traffic, last_rooms[i], interval));
+                last_rooms[i] = traffic;
+                for (const auto& member : member_list) {
+                    const auto key{std::make_pair(i, member.nickname)};
+                    const auto last{last_members.find(key)};
+                    std::cout << fmt::format(
+                        "  {}: {}\n", member.nickname,
+                        FormatRates(member.traffic,
+                                    last != last_members.end() ? last->second
+                                                               : Network::Room::Traffic{},
+                                    interval));
+                    members.emplace(key, member.traffic);
+                }
+            }
+            last_members = std::move(members);
+            std::cout.flush();
+        }
+    }
+
+    const std::vector<std::unique_ptr<Network::Room>>& rooms;
+    const u32 interval;
+    std::mutex mutex;
+    std::condition_variable stop_requested;
+    bool stopping{};
+    std::thread thread;
+};
+
 /// Application entry point
 int main(int argc, char** argv) {
     int option_index{};
     char* endarg;
     // This is just to be able to link against core
     gladLoadGL();
-    std::string room_name, room_description, creator, password, ban_list_file;
-    u32 port{Network::DefaultRoomPort}, max_members{16};
-    bool announce{};
+    RoomConfig main_room;
+    std::vector<std::string> extra_rooms;
+    std::string ban_list_file, rooms_file;
+    u32 threads{}, stats_interval{};
     static struct option long_options[]{
         {"room-name", required_argument, 0, 'n'},
         {"room-description", required_argument, 0, 'd'},
@@ -100,37 +270,54 @@ int main(int argc, char** argv) {
         {"creator", required_argument, 0, 'c'},
         {"ban-list-file", required_argument, 0, 'b'},
         {"announce", no_argument, 0, 'a'},
+        {"room", required_argument, 0, 'r'},
+        {"rooms-file", required_argument, 0, 'f'},
+        {"threads", required_argument, 0, 't'},
+        {"stats-interval", required_argument, 0, 's'},
         {"help", no_argument, 0, 'h'},
         {"version", no_argument, 0, 'v'},
         {0, 0, 0, 0},
     };
     while (optind < argc) {
-        int arg{getopt_long(argc, argv, "n:d:p:m:w:c:b:a:hv", long_options, &option_index)};
+        int arg{getopt_long(argc, argv, "n:d:p:m:w:c:b:a:r:f:t:s:hv", long_options,
+                            &option_index)};
         if (arg != -1) {
             switch (arg) {
             case 'n':
-                room_name.assign(optarg);
+                main_room.name.assign(optarg);
                 break;
             case 'd':
-                room_description.assign(optarg);
+                main_room.description.assign(optarg);
                 break;
             case 'p':
-                port = strtoul(optarg, &endarg, 0);
+                main_room.port = strtoul(optarg, &endarg, 0);
                 break;
             case 'm':
-                max_members = strtoul(optarg, &endarg, 0);
+                main_room.max_members = strtoul(optarg, &endarg, 0);
                 break;
             case 'w':
-                password.assign(optarg);
+                main_room.password.assign(optarg);
                 break;
             case 'c':
-                creator.assign(optarg);
+                main_room.creator.assign(optarg);
                 break;
             case 'b':
                 ban_list_file.assign(optarg);
                 break;
             case 'a':
-                announce = true;
+                main_room.announce = true;
+                break;
+            case 'r':
+                extra_rooms.emplace_back(optarg);
+                break;
+            case 'f':
+                rooms_file.assign(optarg);
+                break;
+            case 't':
+                threads = strtoul(optarg, &endarg, 0);
+                break;
+            case 's':
+                stats_interval = strtoul(optarg, &endarg, 0);
                 break;
             case 'h':
                 PrintHelp(argv[0]);
@@ -141,60 +328,75 @@ int main(int argc, char** argv) {
             }
         }
     }
-    if (room_name.empty()) {
-        std::cout << "Room name is empty!\n\n";
-        PrintHelp(argv[0]);
-        return -1;
+    std::vector<RoomConfig> room_configs;
+    if (!main_room.name.empty())
+        room_configs.push_back(main_room);
+    for (const auto& argument : extra_rooms) {
+        RoomConfig config{main_room};
+        if (!ParseRoomArgument(argument, config)) {
+            std::cout << fmt::format("Invalid room {}!\n\n", argument);
+            PrintHelp(argv[0]);
+            return -1;
+        }
+        room_configs.push_back(std::move(config));
     }
-    if (max_members >= Network::MaxConcurrentConnections || max_members < 2) {
-        std::cout << "max-members needs to be in the range 2 - "
-                  << Network::MaxConcurrentConnections << "!\n\n";
-        PrintHelp(argv[0]);
+    if (!rooms_file.empty() && !LoadRoomsFile(rooms_file, room_configs, threads))
         return -1;
-    }
-    if (port > 65535) {
-        std::cout << "port needs to be in the range 0 - 65535!\n\n";
+    if (!ValidateRooms(room_configs)) {
         PrintHelp(argv[0]);
         return -1;
     }
     if (ban_list_file.empty())
         std::cout << "Ban list file not set!\nThis should get set to load and save room ban "
                      "list.\nSet with --ban-list-file <file>\n\n";
-    // Load the ban list
+    // Load the ban list, shared by all rooms
     Network::Room::BanList ban_list;
     if (!ban_list_file.empty())
         ban_list = LoadBanList(ban_list_file);
-    Network::Room room;
-    if (!room.Create(room_name, room_description, creator, port, password, max_members, ban_list)) {
-        std::cout << "Failed to create room!\n\n";
-        return -1;
+    const auto shared_ban_list{std::make_shared<Network::SharedBanList>(std::move(ban_list))};
+    std::vector<std::unique_ptr<Network::Room>> rooms;
+    for (const auto& config : room_configs) {
+        auto room{std::make_unique<Network::Room>()};
+        if (!room->Create(config.name, config.description, config.creator,
+                          static_cast<u16>(config.port), config.password, config.max_members,
+                          shared_ban_list, false)) {
+            std::cout << fmt::format("Failed to create room {}!\n\n", config.name);
+            for (auto& created_room : rooms)
+                created_room->Destroy();
+            return -1;
+        }
+        rooms.push_back(std::move(room));
+    }
+    if (threads == 0)
+        threads = std::min<u32>(static_cast<u32>(rooms.size()),
+                                std::max(std::thread::hardware_concurrency(), 1u));
+    auto pool{std::make_unique<Network::RoomPool>(threads)};
+    for (auto& room : rooms)
+        pool->Add(*room);
+    std::vector<std::unique_ptr<Core::AnnounceMultiplayerSession>> announce_sessions;
+    for (std::size_t i{}; i < rooms.size(); ++i) {
+        if (!room_configs[i].announce)
+            continue;
+        announce_sessions.push_back(std::make_unique<Core::AnnounceMultiplayerSession>(*rooms[i]));
+        announce_sessions.back()->Start();
     }
-    std::cout << fmt::format("Hosting a {} room\nRoom is open. Close with Q+Enter...\n\n",
-                             announce ? "public" : "private");
-    auto announce_session{std::make_unique<Core::AnnounceMultiplayerSession>(room)};
-    if (announce)
-        announce_session->Start();
-    while (room.IsOpen()) {
+    std::cout << fmt::format("Hosting {} room(s) on {} thread(s)\nRooms are open. Close with "
+                             "Q+Enter...\n\n",
+                             rooms.size(), threads);
+    {
+        StatsPrinter stats_printer{rooms, stats_interval};
         std::string in;
-        std::cin >> in;
-        if (in.size() > 0) {
-            if (announce)
-                announce_session->Stop();
-            announce_session.reset();
-            // Save the ban list
-            if (!ban_list_file.empty())
-                SaveBanList(room.GetBanList(), ban_list_file);
-            room.Destroy();
-            return 0;
-        }
-        std::this_thread::sleep_for(std::chrono::milliseconds{100});
+        while (in.empty() && std::cin >> in)
+            ;
     }
-    if (announce)
-        announce_session->Stop();
-    announce_session.reset();
+    for (auto& session : announce_sessions)
+        session->Stop();
+    announce_sessions.clear();
     // Save the ban list
     if (!ban_list_file.empty())
-        SaveBanList(room.GetBanList(), ban_list_file);
-    room.Destroy();
+        SaveBanList(shared_ban_list->Get(), ban_list_file);
+    pool.reset();
+    for (auto& room : rooms)
+        room->Destroy();
     return 0;
 }
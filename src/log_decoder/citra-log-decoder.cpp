@@ -0,0 +1,46 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstdio>
+#include <iostream>
+#include "common/logging/backend.h"
+#include "common/logging/binary_log.h"
+#include "common/logging/filter.h"
+#include "common/logging/text_formatter.h"
+
+namespace {
+
+void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0
+              << " <log.bin> [filter]\n"
+                 "Prints a binary log written with log_binary as text.\n"
+                 "filter    Only print the messages passing this filter, as in log_filter "
+                 "(default *:Trace)\n";
+}
+
+} // Anonymous namespace
+
+/// Application entry point
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        PrintHelp(argv[0]);
+        return -1;
+    }
+    Log::BinaryLogReader reader{argv[1]};
+    if (!reader.IsValid()) {
+        std::cerr << argv[1] << " isn't a binary log of this version\n";
+        return -1;
+    }
+    Log::Filter filter{Log::Level::Trace};
+    if (argc == 3)
+        filter.ParseFilterString(argv[2]);
+    Log::Entry entry;
+    while (reader.Read(entry)) {
+        if (!filter.CheckMessage(entry.log_class, entry.log_level))
+            continue;
+        const std::string line{Log::FormatLogMessage(entry).append(1, '\n')};
+        std::fwrite(line.data(), 1, line.size(), stdout);
+    }
+    return 0;
+}
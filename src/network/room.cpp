@@ -4,13 +4,22 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <cstring>
 #include <iomanip>
 #include <mutex>
 #include <random>
 #include <regex>
+#include <shared_mutex>
 #include <sstream>
 #include <thread>
+#include <unordered_map>
 #include <enet/enet.h>
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <poll.h>
+#endif
 #include "common/logging/log.h"
 #include "network/packet.h"
 #include "network/room.h"
@@ -27,20 +36,66 @@ struct Room::RoomImpl {
 
     std::string password; ///< The password required to connect to this room.
 
+    /// Counters updated by the room thread, which can be read from any thread
+    struct TrafficCounters {
+        std::atomic<u64> packets_received{};
+        std::atomic<u64> bytes_received{};
+        std::atomic<u64> packets_sent{};
+        std::atomic<u64> bytes_sent{};
+
+        void CountReceived(std::size_t size) {
+            packets_received.fetch_add(1, std::memory_order_relaxed);
+            bytes_received.fetch_add(size, std::memory_order_relaxed);
+        }
+
+        void CountSent(std::size_t size) {
+            packets_sent.fetch_add(1, std::memory_order_relaxed);
+            bytes_sent.fetch_add(size, std::memory_order_relaxed);
+        }
+
+        void Reset() {
+            packets_received.store(0, std::memory_order_relaxed);
+            bytes_received.store(0, std::memory_order_relaxed);
+            packets_sent.store(0, std::memory_order_relaxed);
+            bytes_sent.store(0, std::memory_order_relaxed);
+        }
+
+        Traffic Get() const {
+            return {packets_received.load(std::memory_order_relaxed),
+                    bytes_received.load(std::memory_order_relaxed),
+                    packets_sent.load(std::memory_order_relaxed),
+                    bytes_sent.load(std::memory_order_relaxed)};
+        }
+    };
+
     struct Member {
         std::string nickname; ///< The nickname of the member.
         u64 console_id;
         std::string program;    ///< The current program of the member.
         MACAddress mac_address; ///< The assigned MAC address of the member.
-        ENetPeer* peer;         ///< The remote peer.
+        ENetPeer* peer;         ///< The remote peer, whose data points to traffic.
+        std::unique_ptr<TrafficCounters> traffic{std::make_unique<TrafficCounters>()};
+    };
+
+    struct MACAddressHash {
+        std::size_t operator()(const MACAddress& address) const {
+            u64 value{};
+            std::memcpy(&value, address.data(), address.size());
+            return std::hash<u64>{}(value);
+        }
     };
 
     using MemberList = std::vector<Member>;
-    MemberList members;              ///< Information about the members of this room
-    mutable std::mutex member_mutex; ///< Mutex for locking the members list
+    MemberList members; ///< Information about the members of this room
+    /// Peers of the members by MAC address, kept in sync with members
+    std::unordered_map<MACAddress, ENetPeer*, MACAddressHash> member_peers;
+    /// Guards members and member_peers. Only the room thread changes them, and it takes the
+    /// exclusive lock only to do so, so that relaying packets never waits for other readers.
+    mutable std::shared_mutex member_mutex;
 
-    BanList ban_list;                  ///< List of banned IP addresses
-    mutable std::mutex ban_list_mutex; ///< Mutex for locking the ban list
+    std::shared_ptr<SharedBanList> ban_list; ///< List of banned IP addresses
+
+    TrafficCounters traffic; ///< Traffic of the whole room
 
     RoomImpl() : random_gen{std::random_device{}()} {}
 
@@ -51,6 +106,15 @@ struct Room::RoomImpl {
                        ///< is destroyed.
     void StartLoop();
 
+    /// Handles the pending network events without blocking, for rooms without a thread.
+    void Service();
+
+    /// Dispatches a network event to its handler.
+    void HandleEvent(const ENetEvent& event);
+
+    /// Sends a relayed packet to a member, counting it.
+    void Relay(ENetPeer* peer, ENetPacket* packet);
+
     /**
      * Parses and answers a room join request from a client.
      * Validates the uniqueness of the nicknamename and assigns the MAC address
@@ -192,64 +256,88 @@ struct Room::RoomImpl {
      * to all other clients.
      */
     void HandleClientDisconnection(ENetPeer* client);
+
+    /// Removes a member from members and member_peers, with member_mutex held exclusively
+    void EraseMember(MemberList::iterator member);
 };
 
 // RoomImpl
 void Room::RoomImpl::ServerLoop() {
     while (is_open.load(std::memory_order_relaxed)) {
         ENetEvent event;
-        if (enet_host_service(server, &event, 50) > 0) {
-            switch (event.type) {
-            case ENET_EVENT_TYPE_RECEIVE:
-                switch (event.packet->data[0]) {
-                case IdJoinRequest:
-                    HandleJoinRequest(&event);
-                    break;
-                case IdSetProgram:
-                    HandleProgramPacket(&event);
-                    break;
-                case IdWiFiPacket:
-                    HandleWiFiPacket(&event);
-                    break;
-                case IdChatMessage:
-                    HandleChatPacket(&event);
-                    break;
-                // Moderation
-                case IdModKick:
-                    HandleModKickPacket(&event);
-                    break;
-                case IdModBan:
-                    HandleModBanPacket(&event);
-                    break;
-                case IdModUnban:
-                    HandleModUnbanPacket(&event);
-                    break;
-                case IdModGetBanList:
-                    HandleModGetBanListPacket(&event);
-                    break;
-                }
-                enet_packet_destroy(event.packet);
-                break;
-            case ENET_EVENT_TYPE_DISCONNECT:
-                HandleClientDisconnection(event.peer);
-                break;
-            case ENET_EVENT_TYPE_NONE:
-            case ENET_EVENT_TYPE_CONNECT:
-                break;
-            }
-        }
+        if (enet_host_service(server, &event, 50) > 0)
+            HandleEvent(event);
     }
     // Close the connection to all members:
     SendCloseMessage();
 }
 
+void Room::RoomImpl::Service() {
+    ENetEvent event;
+    while (is_open.load(std::memory_order_relaxed) && enet_host_service(server, &event, 0) > 0)
+        HandleEvent(event);
+}
+
+void Room::RoomImpl::HandleEvent(const ENetEvent& event) {
+    switch (event.type) {
+    case ENET_EVENT_TYPE_RECEIVE:
+        traffic.CountReceived(event.packet->dataLength);
+        if (auto member_traffic{static_cast<TrafficCounters*>(event.peer->data)})
+            member_traffic->CountReceived(event.packet->dataLength);
+        switch (event.packet->data[0]) {
+        case IdJoinRequest:
+            HandleJoinRequest(&event);
+            break;
+        case IdSetProgram:
+            HandleProgramPacket(&event);
+            break;
+        case IdWiFiPacket:
+            HandleWiFiPacket(&event);
+            break;
+        case IdChatMessage:
+            HandleChatPacket(&event);
+            break;
+        // Moderation
+        case IdModKick:
+            HandleModKickPacket(&event);
+            break;
+        case IdModBan:
+            HandleModBanPacket(&event);
+            break;
+        case IdModUnban:
+            HandleModUnbanPacket(&event);
+            break;
+        case IdModGetBanList:
+            HandleModGetBanListPacket(&event);
+            break;
+        }
+        // Relayed packets are freed by ENet once sent to every destination
+        if (event.packet->referenceCount == 0)
+            enet_packet_destroy(event.packet);
+        break;
+    case ENET_EVENT_TYPE_DISCONNECT:
+        HandleClientDisconnection(event.peer);
+        break;
+    case ENET_EVENT_TYPE_NONE:
+    case ENET_EVENT_TYPE_CONNECT:
+        break;
+    }
+}
+
+void Room::RoomImpl::Relay(ENetPeer* peer, ENetPacket* packet) {
+    traffic.CountSent(packet->dataLength);
+    if (auto member_traffic{static_cast<TrafficCounters*>(peer->data)})
+        member_traffic->CountSent(packet->dataLength);
+    enet_peer_send(peer, 0, packet);
+}
+
 void Room::RoomImpl::StartLoop() {
     room_thread = std::make_unique<std::thread>(&Room::RoomImpl::ServerLoop, this);
 }
 
 void Room::RoomImpl::HandleJoinRequest(const ENetEvent* event) {
     {
-        std::lock_guard lock{member_mutex};
+        std::shared_lock lock{member_mutex};
         if (members.size() >= room_information.member_slots) {
             SendRoomIsFull(event->peer);
             return;
@@ -299,21 +387,19 @@ void Room::RoomImpl::HandleJoinRequest(const ENetEvent* event) {
     member.console_id = console_id;
     member.nickname = nickname;
     member.peer = event->peer;
-    {
-        std::lock_guard lock{ban_list_mutex};
-        // Check IP ban
-        char ip_raw[256];
-        enet_address_get_host_ip(&event->peer->address, ip_raw, 256);
-        std::string ip{ip_raw};
-        if (std::find(ban_list.begin(), ban_list.end(), ip) != ban_list.end()) {
-            SendUserBanned(event->peer);
-            return;
-        }
+    // Check IP ban
+    char ip_raw[256];
+    enet_address_get_host_ip(&event->peer->address, ip_raw, 256);
+    if (ban_list->Contains(ip_raw)) {
+        SendUserBanned(event->peer);
+        return;
     }
     // Notify everyone that the user has joined.
     SendStatusMessage(IdMemberJoin, member.nickname);
     {
         std::lock_guard lock{member_mutex};
+        member_peers.emplace(member.mac_address, member.peer);
+        member.peer->data = member.traffic.get();
         members.push_back(std::move(member));
     }
     // Notify everyone that the room information has changed.
@@ -343,7 +429,7 @@ void Room::RoomImpl::HandleModKickPacket(const ENetEvent* event) {
         // Notify the kicked member
         SendUserKicked(target_member->peer);
         enet_peer_disconnect(target_member->peer, 0);
-        members.erase(target_member);
+        EraseMember(target_member);
     }
     // Announce the change to all clients.
     SendStatusMessage(IdMemberKicked, nickname);
@@ -377,14 +463,10 @@ void Room::RoomImpl::HandleModBanPacket(const ENetEvent* event) {
         enet_address_get_host_ip(&target_member->peer->address, ip_raw, 256);
         ip = ip_raw;
         enet_peer_disconnect(target_member->peer, 0);
-        members.erase(target_member);
-    }
-    {
-        std::lock_guard lock{ban_list_mutex};
-        // Ban the member's IP
-        if (std::find(ban_list.begin(), ban_list.end(), ip) == ban_list.end())
-            ban_list.push_back(ip);
+        EraseMember(target_member);
     }
+    // Ban the member's IP
+    ban_list->Add(ip);
     // Announce the change to all clients.
     SendStatusMessage(IdMemberBanned, nickname);
     BroadcastRoomInformation();
@@ -400,16 +482,7 @@ void Room::RoomImpl::HandleModUnbanPacket(const ENetEvent* event) {
     packet.IgnoreBytes(sizeof(u8)); // Ignore the message type
     std::string address;
     packet >> address;
-    bool unbanned{};
-    {
-        std::lock_guard lock{ban_list_mutex};
-        auto it = std::find(ban_list.begin(), ban_list.end(), address);
-        if (it != ban_list.end()) {
-            unbanned = true;
-            ban_list.erase(it);
-        }
-    }
-    if (unbanned)
+    if (ban_list->Remove(address))
         SendStatusMessage(IdAddressUnbanned, address);
     else
         SendModNoSuchUser(event->peer);
@@ -429,21 +502,20 @@ bool Room::RoomImpl::IsValidNickname(const std::string& nickname) const {
     const std::regex nickname_regex{"^[ a-zA-Z0-9._-]{4,20}$"};
     if (!std::regex_match(nickname, nickname_regex))
         return false;
-    std::lock_guard lock{member_mutex};
+    std::shared_lock lock{member_mutex};
     return std::all_of(members.begin(), members.end(),
                        [&nickname](const auto& member) { return member.nickname != nickname; });
 }
 
 bool Room::RoomImpl::IsValidMACAddress(const MACAddress& address) const {
     // A MAC address is valid if it isn't already taken by anybody else in the room.
-    std::lock_guard lock{member_mutex};
-    return std::all_of(members.begin(), members.end(),
-                       [&address](const auto& member) { return member.mac_address != address; });
+    std::shared_lock lock{member_mutex};
+    return member_peers.count(address) == 0;
 }
 
 bool Room::RoomImpl::IsValidConsoleId(u64 console_id) const {
     // A Console ID is valid if it isn't already taken by anybody else in the room.
-    std::lock_guard lock{member_mutex};
+    std::shared_lock lock{member_mutex};
     return std::all_of(members.begin(), members.end(), [&console_id](const auto& member) {
         return member.console_id != console_id;
     });
@@ -452,7 +524,7 @@ bool Room::RoomImpl::IsValidConsoleId(u64 console_id) const {
 bool Room::RoomImpl::HasModPermission(const ENetPeer* client) const {
     if (room_information.creator.empty())
         return false; // This room doesn't support moderation
-    std::lock_guard lock{member_mutex};
+    std::shared_lock lock{member_mutex};
     const auto sending_member{
         std::find_if(members.begin(), members.end(),
                      [client](const auto& member) { return member.peer == client; })};
@@ -567,10 +639,7 @@ void Room::RoomImpl::SendModNoSuchUser(ENetPeer* client) {
 void Room::RoomImpl::SendModBanListResponse(ENetPeer* client) {
     Packet packet;
     packet << static_cast<u8>(IdModBanListResponse);
-    {
-        std::lock_guard lock{ban_list_mutex};
-        packet << ban_list;
-    }
+    packet << ban_list->Get();
     auto enet_packet{
         enet_packet_create(packet.GetData(), packet.GetDataSize(), ENET_PACKET_FLAG_RELIABLE)};
     enet_peer_send(client, 0, enet_packet);
@@ -580,7 +649,7 @@ void Room::RoomImpl::SendModBanListResponse(ENetPeer* client) {
 void Room::RoomImpl::SendCloseMessage() {
     Packet packet;
     packet << static_cast<u8>(IdCloseRoom);
-    std::lock_guard lock{member_mutex};
+    std::shared_lock lock{member_mutex};
     if (!members.empty()) {
         auto enet_packet{
             enet_packet_create(packet.GetData(), packet.GetDataSize(), ENET_PACKET_FLAG_RELIABLE)};
@@ -597,7 +666,7 @@ void Room::RoomImpl::SendStatusMessage(StatusMessageTypes type, const std::strin
     packet << static_cast<u8>(IdStatusMessage);
     packet << static_cast<u8>(type);
     packet << nickname;
-    std::lock_guard lock{member_mutex};
+    std::shared_lock lock{member_mutex};
     if (!members.empty()) {
         auto enet_packet{
             enet_packet_create(packet.GetData(), packet.GetDataSize(), ENET_PACKET_FLAG_RELIABLE)};
@@ -615,9 +684,9 @@ void Room::RoomImpl::BroadcastRoomInformation() {
     packet << room_information.member_slots;
     packet << room_information.port;
     packet << room_information.creator;
-    packet << static_cast<u32>(members.size());
     {
-        std::lock_guard lock{member_mutex};
+        std::shared_lock lock{member_mutex};
+        packet << static_cast<u32>(members.size());
         for (const auto& member : members) {
             packet << member.nickname;
             packet << member.mac_address;
@@ -642,46 +711,33 @@ MACAddress Room::RoomImpl::GenerateMACAddress() {
 }
 
 void Room::RoomImpl::HandleWiFiPacket(const ENetEvent* event) {
-    Packet in_packet;
-    in_packet.Append(event->packet->data, event->packet->dataLength);
-    in_packet.IgnoreBytes(sizeof(u8));         // Message type
-    in_packet.IgnoreBytes(sizeof(u8));         // WiFiPacket Type
-    in_packet.IgnoreBytes(sizeof(u8));         // WiFiPacket Channel
-    in_packet.IgnoreBytes(sizeof(MACAddress)); // WiFiPacket Transmitter Address
+    // Message type, WiFiPacket type, channel and transmitter address
+    constexpr std::size_t DestinationAddressOffset{sizeof(u8) * 3 + sizeof(MACAddress)};
+    ENetPacket* enet_packet{event->packet};
+    if (enet_packet->dataLength < DestinationAddressOffset + sizeof(MACAddress))
+        return;
     MACAddress destination_address;
-    in_packet >> destination_address;
-    Packet out_packet;
-    out_packet.Append(event->packet->data, event->packet->dataLength);
-    auto enet_packet{enet_packet_create(out_packet.GetData(), out_packet.GetDataSize(),
-                                        ENET_PACKET_FLAG_RELIABLE)};
+    std::memcpy(destination_address.data(), enet_packet->data + DestinationAddressOffset,
+                sizeof(MACAddress));
+    // The received packet is forwarded as is, ENet counts its references
+    enet_packet->flags |= ENET_PACKET_FLAG_RELIABLE;
+    std::shared_lock lock{member_mutex};
     if (destination_address == BroadcastMac) { // Send the data to everyone except the sender
-        std::lock_guard lock{member_mutex};
-        bool sent_packet{};
-        for (const auto& member : members) {
-            if (member.peer != event->peer) {
-                sent_packet = true;
-                enet_peer_send(member.peer, 0, enet_packet);
-            }
-        }
-        if (!sent_packet)
-            enet_packet_destroy(enet_packet);
+        for (const auto& member : members)
+            if (member.peer != event->peer)
+                Relay(member.peer, enet_packet);
     } else { // Send the data only to the destination client
-        std::lock_guard lock{member_mutex};
-        auto member{std::find_if(members.begin(), members.end(),
-                                 [destination_address](const Member& member) -> bool {
-                                     return member.mac_address == destination_address;
-                                 })};
-        if (member != members.end())
-            enet_peer_send(member->peer, 0, enet_packet);
-        else {
+        const auto member_peer{member_peers.find(destination_address)};
+        if (member_peer != member_peers.end())
+            Relay(member_peer->second, enet_packet);
+        else
             LOG_ERROR(Network,
                       "Attempting to send to unknown MAC address: "
                       "{:02X}:{:02X}:{:02X}:{:02X}:{:02X}:{:02X}",
                       destination_address[0], destination_address[1], destination_address[2],
                       destination_address[3], destination_address[4], destination_address[5]);
-            enet_packet_destroy(enet_packet);
-        }
     }
+    lock.unlock();
     enet_host_flush(server);
 }
 
@@ -693,8 +749,8 @@ void Room::RoomImpl::HandleChatPacket(const ENetEvent* event) {
     std::string message;
     in_packet >> message;
     auto CompareNetworkAddress{
-        [event](const Member member) -> bool { return member.peer == event->peer; }};
-    std::lock_guard lock{member_mutex};
+        [event](const Member& member) -> bool { return member.peer == event->peer; }};
+    std::shared_lock lock{member_mutex};
     const auto sending_member{std::find_if(members.begin(), members.end(), CompareNetworkAddress)};
     if (sending_member == members.end())
         return; // Received a chat message from a unknown sender
@@ -745,7 +801,7 @@ void Room::RoomImpl::HandleClientDisconnection(ENetPeer* client) {
                                  [client](const Member& member) { return member.peer == client; })};
         if (member != members.end()) {
             nickname = member->nickname;
-            members.erase(member);
+            EraseMember(member);
         }
     }
     // Announce the change to all clients.
@@ -755,6 +811,43 @@ void Room::RoomImpl::HandleClientDisconnection(ENetPeer* client) {
     BroadcastRoomInformation();
 }
 
+void Room::RoomImpl::EraseMember(MemberList::iterator member) {
+    member->peer->data = nullptr;
+    member_peers.erase(member->mac_address);
+    members.erase(member);
+}
+
+// SharedBanList
+SharedBanList::SharedBanList(std::vector<std::string> addresses)
+    : addresses{std::move(addresses)} {}
+
+bool SharedBanList::Contains(const std::string& address) const {
+    std::lock_guard lock{mutex};
+    return std::find(addresses.begin(), addresses.end(), address) != addresses.end();
+}
+
+bool SharedBanList::Add(const std::string& address) {
+    std::lock_guard lock{mutex};
+    if (std::find(addresses.begin(), addresses.end(), address) != addresses.end())
+        return false;
+    addresses.push_back(address);
+    return true;
+}
+
+bool SharedBanList::Remove(const std::string& address) {
+    std::lock_guard lock{mutex};
+    const auto itr{std::find(addresses.begin(), addresses.end(), address)};
+    if (itr == addresses.end())
+        return false;
+    addresses.erase(itr);
+    return true;
+}
+
+std::vector<std::string> SharedBanList::Get() const {
+    std::lock_guard lock{mutex};
+    return addresses;
+}
+
 // Room
 Room::Room() : room_impl{std::make_unique<RoomImpl>()} {}
 Room::~Room() = default;
@@ -762,6 +855,14 @@ Room::~Room() = default;
 bool Room::Create(const std::string& name, const std::string& description,
                   const std::string& creator, u16 port, const std::string& password,
                   const u32 max_connections, const Room::BanList& ban_list) {
+    return Create(name, description, creator, port, password, max_connections,
+                  std::make_shared<SharedBanList>(ban_list), true);
+}
+
+bool Room::Create(const std::string& name, const std::string& description,
+                  const std::string& creator, u16 port, const std::string& password,
+                  u32 max_connections, std::shared_ptr<SharedBanList> ban_list,
+                  bool start_thread) {
     ENetAddress address;
     address.host = ENET_HOST_ANY;
     address.port = port;
@@ -777,8 +878,10 @@ bool Room::Create(const std::string& name, const std::string& description,
     room_impl->room_information.member_slots = max_connections;
     room_impl->room_information.port = port;
     room_impl->password = password;
-    room_impl->ban_list = ban_list;
-    room_impl->StartLoop();
+    room_impl->ban_list = std::move(ban_list);
+    room_impl->traffic.Reset();
+    if (start_thread)
+        room_impl->StartLoop();
     return true;
 }
 
@@ -791,18 +894,43 @@ const RoomInformation& Room::GetRoomInformation() const {
 }
 
 Room::BanList Room::GetBanList() const {
-    std::lock_guard lock{room_impl->ban_list_mutex};
-    return room_impl->ban_list;
+    return room_impl->ban_list->Get();
+}
+
+Room::Traffic Room::GetTraffic() const {
+    return room_impl->traffic.Get();
+}
+
+void Room::ServiceRooms(const std::vector<Room*>& rooms, u32 timeout_ms) {
+    if (rooms.empty()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{timeout_ms});
+        return;
+    }
+    // poll has no limit on the number or the value of the sockets, unlike select's fd_set
+    std::vector<pollfd> sockets(rooms.size());
+    for (std::size_t i{}; i < rooms.size(); ++i) {
+        sockets[i].fd = rooms[i]->room_impl->server->socket;
+        sockets[i].events = POLLIN;
+    }
+#ifdef _WIN32
+    WSAPoll(sockets.data(), static_cast<ULONG>(sockets.size()), static_cast<INT>(timeout_ms));
+#else
+    poll(sockets.data(), static_cast<nfds_t>(sockets.size()), static_cast<int>(timeout_ms));
+#endif
+    // Hosts are serviced even without a readable socket, to handle their timeouts
+    for (Room* room : rooms)
+        room->room_impl->Service();
 }
 
 std::vector<Room::Member> Room::GetRoomMemberList() const {
     std::vector<Room::Member> member_list;
-    std::lock_guard lock{room_impl->member_mutex};
+    std::shared_lock lock{room_impl->member_mutex};
     for (const auto& member_impl : room_impl->members) {
         Member member;
         member.nickname = member_impl.nickname;
         member.mac_address = member_impl.mac_address;
         member.program = member_impl.program;
+        member.traffic = member_impl.traffic->Get();
         member_list.push_back(member);
     }
     return member_list;
@@ -814,8 +942,12 @@ bool Room::HasPassword() const {
 
 void Room::Destroy() {
     room_impl->is_open.store(false, std::memory_order_relaxed);
-    room_impl->room_thread->join();
-    room_impl->room_thread.reset();
+    if (room_impl->room_thread) {
+        room_impl->room_thread->join();
+        room_impl->room_thread.reset();
+    } else if (room_impl->server) {
+        room_impl->SendCloseMessage();
+    }
     if (room_impl->server)
         enet_host_destroy(room_impl->server);
     room_impl->room_information = {};
@@ -823,6 +955,7 @@ void Room::Destroy() {
     {
         std::lock_guard lock{room_impl->member_mutex};
         room_impl->members.clear();
+        room_impl->member_peers.clear();
     }
     room_impl->room_information.member_slots = 0;
     room_impl->room_information.name.clear();
@@ -6,6 +6,7 @@
 
 #include <array>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include "common/common_types.h"
@@ -65,13 +66,42 @@ enum StatusMessageTypes : u8 {
     IdAddressUnbanned, ///< A ip address is unbanned from the room
 };
 
+/// Banned IP addresses, which can be shared by the rooms of a process.
+class SharedBanList {
+public:
+    explicit SharedBanList(std::vector<std::string> addresses = {});
+
+    bool Contains(const std::string& address) const;
+
+    /// Bans the address, returns false if it was already banned.
+    bool Add(const std::string& address);
+
+    /// Unbans the address, returns false if it wasn't banned.
+    bool Remove(const std::string& address);
+
+    std::vector<std::string> Get() const;
+
+private:
+    mutable std::mutex mutex;
+    std::vector<std::string> addresses;
+};
+
 /// This is what a server [person creating a server] would use.
 class Room final {
 public:
+    /// Traffic counters, since the room was created or the member joined.
+    struct Traffic {
+        u64 packets_received; ///< Packets received from the members.
+        u64 bytes_received;
+        u64 packets_sent; ///< WiFi packets relayed to the members.
+        u64 bytes_sent;
+    };
+
     struct Member {
         std::string nickname;   ///< The nickname of the member.
         std::string program;    ///< The current program of the member.
         MACAddress mac_address; ///< The assigned MAC address of the member.
+        Traffic traffic;        ///< Traffic from and to the member.
     };
 
     using BanList = std::vector<std::string>;
@@ -96,11 +126,29 @@ public:
                 u16 port = DefaultRoomPort, const std::string& password = "",
                 const u32 max_connections = MaxConcurrentConnections, const BanList& ban_list = {});
 
+    /**
+     * Creates the socket for this room, with a ban list that may be shared with other rooms.
+     * Without a thread, the room only handles network events in ServiceRooms, such as when it's
+     * run by a RoomPool.
+     */
+    bool Create(const std::string& name, const std::string& description, const std::string& creator,
+                u16 port, const std::string& password, u32 max_connections,
+                std::shared_ptr<SharedBanList> ban_list, bool start_thread);
+
     /// Gets the banned IPs of the room.
     BanList GetBanList() const;
 
+    /// Gets the traffic counters of the room.
+    Traffic GetTraffic() const;
+
+    /**
+     * Waits up to timeout_ms for network events on any of the rooms, which must have been
+     * created without a thread, then handles the events of all of them.
+     */
+    static void ServiceRooms(const std::vector<Room*>& rooms, u32 timeout_ms);
+
     /**
-     * Destroys the socket
+     * Destroys the socket. A room without a thread must no longer be serviced.
      */
     void Destroy();
 
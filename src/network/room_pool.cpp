@@ -0,0 +1,77 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "network/room.h"
+#include "network/room_pool.h"
+
+namespace Network {
+
+namespace {
+
+/// How long a thread waits for network events before handling the timeouts of its rooms
+constexpr u32 PollTimeoutMs{50};
+
+} // Anonymous namespace
+
+RoomPool::RoomPool(std::size_t num_threads) {
+    for (std::size_t i{}; i < std::max<std::size_t>(num_threads, 1); ++i)
+        workers.push_back(std::make_unique<Worker>());
+    for (auto& worker : workers)
+        worker->thread = std::thread{&RoomPool::Loop, this, std::ref(*worker)};
+}
+
+RoomPool::~RoomPool() {
+    stopping = true;
+    for (auto& worker : workers) {
+        worker->thread.join();
+        // Wake up any Remove
+        std::lock_guard lock{worker->mutex};
+        worker->serviced.notify_all();
+    }
+}
+
+void RoomPool::Add(Room& room) {
+    Worker* least_loaded{};
+    std::size_t least_rooms{};
+    for (auto& worker : workers) {
+        std::lock_guard lock{worker->mutex};
+        if (!least_loaded || worker->rooms.size() < least_rooms) {
+            least_loaded = worker.get();
+            least_rooms = worker->rooms.size();
+        }
+    }
+    std::lock_guard lock{least_loaded->mutex};
+    least_loaded->rooms.push_back(&room);
+}
+
+void RoomPool::Remove(Room& room) {
+    for (auto& worker : workers) {
+        std::unique_lock lock{worker->mutex};
+        const auto itr{std::find(worker->rooms.begin(), worker->rooms.end(), &room)};
+        if (itr == worker->rooms.end())
+            continue;
+        worker->rooms.erase(itr);
+        // The thread may be servicing a copy of the list that still has the room
+        const u64 target{worker->iterations + 1};
+        worker->serviced.wait(lock, [&] { return worker->iterations >= target || stopping; });
+        return;
+    }
+}
+
+void RoomPool::Loop(Worker& worker) {
+    std::vector<Room*> rooms;
+    while (!stopping) {
+        {
+            std::lock_guard lock{worker.mutex};
+            rooms = worker.rooms;
+        }
+        Room::ServiceRooms(rooms, PollTimeoutMs);
+        std::lock_guard lock{worker.mutex};
+        ++worker.iterations;
+        worker.serviced.notify_all();
+    }
+}
+
+} // namespace Network
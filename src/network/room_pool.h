@@ -0,0 +1,50 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Network {
+
+class Room;
+
+/**
+ * Runs the network events of many rooms on a fixed number of threads. Each room is serviced by a
+ * single thread, so that a room's handlers never run concurrently. Rooms must be created without
+ * a thread.
+ */
+class RoomPool {
+public:
+    explicit RoomPool(std::size_t num_threads);
+    ~RoomPool();
+
+    /// Services the room on the thread with the fewest rooms
+    void Add(Room& room);
+
+    /// Stops servicing the room, it can be destroyed once this returns
+    void Remove(Room& room);
+
+private:
+    struct Worker {
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable serviced;
+        std::vector<Room*> rooms;
+        u64 iterations{}; ///< Number of finished ServiceRooms calls
+    };
+
+    void Loop(Worker& worker);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic_bool stopping{};
+};
+
+} // namespace Network
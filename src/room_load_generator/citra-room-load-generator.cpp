@@ -0,0 +1,214 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <enet/enet.h>
+#include <fmt/format.h>
+#include <getopt.h>
+#include "common/common_types.h"
+#include "network/room.h"
+#include "network/room_member.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// Counters updated by the member threads
+struct Stats {
+    std::atomic<u64> received{};
+    std::atomic<u64> received_bytes{};
+    std::atomic<u64> latency_total{}; ///< In nanoseconds
+    std::atomic<u64> latency_max{};
+};
+
+u64 GetTimestamp() {
+    return static_cast<u64>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch())
+            .count());
+}
+
+void UpdateMax(std::atomic<u64>& max, u64 value) {
+    u64 current{max.load(std::memory_order_relaxed)};
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        ;
+}
+
+void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0
+              << " [options]\n"
+                 "Simulates clients sending WiFi packets through a room and reports the "
+                 "throughput and latency.\n"
+                 "--server      The address of the room (default 127.0.0.1)\n"
+                 "--port        The port of the room\n"
+                 "--host        Host the room in this process\n"
+                 "--password    The password of the room\n"
+                 "--clients     The number of simulated clients (default 8)\n"
+                 "--rate        Packets sent per second by each client (default 60)\n"
+                 "--size        Size of the packet data in bytes (default 512)\n"
+                 "--duration    Duration of the run in seconds (default 10)\n"
+                 "--broadcast   Broadcast every packet, instead of sending it to the next client\n"
+                 "-h, --help    Display this help and exit\n";
+}
+
+} // Anonymous namespace
+
+/// Application entry point
+int main(int argc, char** argv) {
+    int option_index{};
+    std::string server{"127.0.0.1"}, password;
+    u32 port{Network::DefaultRoomPort}, clients{8}, rate{60}, size{512}, duration{10};
+    bool host{}, broadcast{};
+    static struct option long_options[]{
+        {"server", required_argument, 0, 's'},
+        {"port", required_argument, 0, 'p'},
+        {"host", no_argument, 0, 'o'},
+        {"password", required_argument, 0, 'w'},
+        {"clients", required_argument, 0, 'c'},
+        {"rate", required_argument, 0, 'r'},
+        {"size", required_argument, 0, 'z'},
+        {"duration", required_argument, 0, 'd'},
+        {"broadcast", no_argument, 0, 'b'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0},
+    };
+    while (optind < argc) {
+        int arg{getopt_long(argc, argv, "s:p:ow:c:r:z:d:bh", long_options, &option_index)};
+        if (arg == -1)
+            break;
+        switch (arg) {
+        case 's':
+            server.assign(optarg);
+            break;
+        case 'p':
+            port = std::strtoul(optarg, nullptr, 0);
+            break;
+        case 'o':
+            host = true;
+            break;
+        case 'w':
+            password.assign(optarg);
+            break;
+        case 'c':
+            clients = std::strtoul(optarg, nullptr, 0);
+            break;
+        case 'r':
+            rate = std::strtoul(optarg, nullptr, 0);
+            break;
+        case 'z':
+            size = std::strtoul(optarg, nullptr, 0);
+            break;
+        case 'd':
+            duration = std::strtoul(optarg, nullptr, 0);
+            break;
+        case 'b':
+            broadcast = true;
+            break;
+        case 'h':
+            PrintHelp(argv[0]);
+            return 0;
+        default:
+            PrintHelp(argv[0]);
+            return -1;
+        }
+    }
+    if (clients < 2 || clients >= Network::MaxConcurrentConnections || rate == 0 ||
+        size < sizeof(u64) || port > 65535) {
+        PrintHelp(argv[0]);
+        return -1;
+    }
+    if (enet_initialize() != 0) {
+        std::cout << "Failed to initialize ENet!\n";
+        return -1;
+    }
+    std::unique_ptr<Network::Room> room;
+    if (host) {
+        room = std::make_unique<Network::Room>();
+        if (!room->Create("Load generator", "", "", static_cast<u16>(port), password, clients)) {
+            std::cout << "Failed to create room!\n";
+            return -1;
+        }
+    }
+    Stats stats;
+    std::vector<std::unique_ptr<Network::RoomMember>> members;
+    for (u32 i{}; i < clients; ++i) {
+        auto member{std::make_unique<Network::RoomMember>()};
+        member->BindOnWiFiPacketReceived([&stats](const Network::WiFiPacket& packet) {
+            const u64 now{GetTimestamp()};
+            if (packet.data.size() < sizeof(u64))
+                return;
+            u64 sent;
+            std::memcpy(&sent, packet.data.data(), sizeof(sent));
+            stats.received.fetch_add(1, std::memory_order_relaxed);
+            stats.received_bytes.fetch_add(packet.data.size(), std::memory_order_relaxed);
+            stats.latency_total.fetch_add(now - sent, std::memory_order_relaxed);
+            UpdateMax(stats.latency_max, now - sent);
+        });
+        member->Join(fmt::format("loadgen-{:04}", i), i + 1, server.c_str(),
+                     static_cast<u16>(port), BroadcastMac, password);
+        members.push_back(std::move(member));
+    }
+    const auto join_deadline{Clock::now() + std::chrono::seconds{10}};
+    for (const auto& member : members) {
+        while (member->GetState() != Network::RoomMember::State::Joined &&
+               Clock::now() < join_deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        if (member->GetState() != Network::RoomMember::State::Joined) {
+            std::cout << fmt::format("{} failed to join the room!\n", member->GetNickname());
+            return -1;
+        }
+    }
+    std::cout << fmt::format("{} clients joined, sending {} byte {} packets at {}/s each for {}s\n",
+                             clients, size, broadcast ? "broadcast" : "unicast", rate, duration);
+    Network::WiFiPacket packet{};
+    packet.type = Network::WiFiPacket::PacketType::Data;
+    packet.channel = 1;
+    packet.data.resize(size);
+    u64 sent{};
+    const auto interval{std::chrono::nanoseconds{std::chrono::seconds{1}} / rate};
+    const auto start{Clock::now()};
+    const auto end{start + std::chrono::seconds{duration}};
+    for (auto next{start}; next < end; next += interval) {
+        std::this_thread::sleep_until(next);
+        for (u32 i{}; i < clients; ++i) {
+            packet.transmitter_address = members[i]->GetMACAddress();
+            packet.destination_address =
+                broadcast ? BroadcastMac : members[(i + 1) % clients]->GetMACAddress();
+            const u64 timestamp{GetTimestamp()};
+            std::memcpy(packet.data.data(), &timestamp, sizeof(timestamp));
+            members[i]->SendWiFiPacket(packet);
+            ++sent;
+        }
+    }
+    // Let the packets in flight arrive
+    std::this_thread::sleep_for(std::chrono::seconds{1});
+    const double seconds{std::chrono::duration<double>(Clock::now() - start).count()};
+    const u64 expected{broadcast ? sent * (clients - 1) : sent};
+    const u64 received{stats.received.load()};
+    std::cout << fmt::format("Sent: {} packets, received: {} of {} ({:.2f}% lost)\n", sent,
+                             received, expected,
+                             expected ? 100.0 * (expected - std::min(received, expected)) / expected
+                                      : 0.0);
+    std::cout << fmt::format("Delivered: {:.0f} packets/s, {:.2f} MiB/s\n", received / seconds,
+                             stats.received_bytes.load() / seconds / (1024 * 1024));
+    if (received != 0)
+        std::cout << fmt::format("Latency: {:.3f}ms average, {:.3f}ms max\n",
+                                 stats.latency_total.load() / 1e6 / received,
+                                 stats.latency_max.load() / 1e6);
+    for (auto& member : members)
+        member->Leave();
+    members.clear();
+    if (room)
+        room->Destroy();
+    enet_deinitialize();
+    return 0;
+}
@@ -0,0 +1,264 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <fmt/format.h>
+#include <getopt.h>
+#include "common/common_types.h"
+#include "common/thread_pool.h"
+#include "common/threadsafe_queue.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// The previous pool, handing tasks round-robin to per-worker queues, as the baseline
+class RoundRobinPool : NonCopyable {
+public:
+    explicit RoundRobinPool(std::size_t num_threads) : workers(num_threads) {}
+
+    template <typename F>
+    std::future<void> Push(F&& f) {
+        auto future{workers[next_worker].Push(std::forward<F>(f))};
+        next_worker = (next_worker + 1) % workers.size();
+        return future;
+    }
+
+private:
+    class Worker {
+    public:
+        Worker() : thread{[this] { Loop(); }} {}
+
+        ~Worker() {
+            {
+                std::lock_guard lock{mutex};
+                exit_loop = true;
+            }
+            cv.notify_one();
+            thread.join();
+        }
+
+        template <typename F>
+        std::future<void> Push(F&& f) {
+            auto task{std::make_shared<std::packaged_task<void()>>(std::forward<F>(f))};
+            queue.Push([task] { (*task)(); });
+            {
+                std::lock_guard lock{mutex};
+            }
+            cv.notify_one();
+            return task->get_future();
+        }
+
+    private:
+        void Loop() {
+            for (;;) {
+                std::function<void()> task;
+                while (queue.Pop(task))
+                    task();
+                std::unique_lock lock{mutex};
+                if (!queue.Empty())
+                    continue;
+                if (exit_loop)
+                    break;
+                cv.wait(lock);
+            }
+        }
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool exit_loop{};
+        Common::SPSCQueue<std::function<void()>> queue;
+        std::thread thread;
+    };
+
+    std::size_t next_worker{};
+    std::vector<Worker> workers;
+};
+
+/// Busy work of roughly the given number of iterations, that the compiler can't remove
+void Spin(u32 iterations) {
+    volatile u32 sink{};
+    for (u32 i{}; i < iterations; ++i)
+        sink = sink + i;
+}
+
+template <typename F>
+double Measure(F&& f) {
+    const auto start{Clock::now()};
+    f();
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void Report(const char* name, double round_robin_ms, double stealing_ms) {
+    std::cout << fmt::format("{:<24} round-robin {:>9.2f}ms  work-stealing {:>9.2f}ms  {:>5.2f}x\n",
+                             name, round_robin_ms, stealing_ms, round_robin_ms / stealing_ms);
+}
+
+void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0
+              << " [options]\n"
+                 "Compares the work-stealing thread pool with the previous round-robin one.\n"
+                 "--threads     Number of workers (default: the number of cores)\n"
+                 "--scale       Multiplies the amount of work of each benchmark (default 1)\n"
+                 "--pin         Pin the work-stealing workers to cores\n"
+                 "-h, --help    Display this help and exit\n";
+}
+
+} // Anonymous namespace
+
+/// Application entry point
+int main(int argc, char** argv) {
+    int option_index{};
+    std::size_t threads{std::max(std::thread::hardware_concurrency(), 1u)};
+    u32 scale{1};
+    bool pin{};
+    static struct option long_options[]{
+        {"threads", required_argument, 0, 't'},
+        {"scale", required_argument, 0, 's'},
+        {"pin", no_argument, 0, 'p'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0},
+    };
+    while (optind < argc) {
+        int arg{getopt_long(argc, argv, "t:s:ph", long_options, &option_index)};
+        if (arg == -1)
+            break;
+        switch (arg) {
+        case 't':
+            threads = std::strtoul(optarg, nullptr, 0);
+            break;
+        case 's':
+            scale = std::strtoul(optarg, nullptr, 0);
+            break;
+        case 'p':
+            pin = true;
+            break;
+        case 'h':
+            PrintHelp(argv[0]);
+            return 0;
+        default:
+            PrintHelp(argv[0]);
+            return -1;
+        }
+    }
+    if (threads == 0 || scale == 0) {
+        PrintHelp(argv[0]);
+        return -1;
+    }
+    RoundRobinPool round_robin{threads};
+    Common::ThreadPool stealing{threads};
+    stealing.SetPinning(pin);
+    std::cout << fmt::format("{} workers{}\n", threads, pin ? ", pinned" : "");
+
+    // Many tiny tasks, where the per-task overhead dominates
+    {
+        const u32 count{100000 * scale};
+        const double round_robin_ms{Measure([&] {
+            std::vector<std::future<void>> futures;
+            futures.reserve(count);
+            for (u32 i{}; i < count; ++i)
+                futures.push_back(round_robin.Push([] { Spin(100); }));
+            for (auto& future : futures)
+                future.get();
+        })};
+        const double stealing_ms{Measure([&] {
+            Common::TaskGroup group{stealing};
+            for (u32 i{}; i < count; ++i)
+                group.Run([] { Spin(100); });
+            group.Wait();
+        })};
+        Report("tiny tasks", round_robin_ms, stealing_ms);
+    }
+
+    // Batches of one task per worker, like the vertex shader threads of each draw
+    {
+        const u32 batches{2000 * scale};
+        const double round_robin_ms{Measure([&] {
+            std::vector<std::future<void>> futures;
+            for (u32 batch{}; batch < batches; ++batch) {
+                futures.clear();
+                for (std::size_t i{}; i < threads; ++i)
+                    futures.push_back(round_robin.Push([] { Spin(20000); }));
+                for (auto& future : futures)
+                    future.get();
+            }
+        })};
+        const double stealing_ms{Measure([&] {
+            for (u32 batch{}; batch < batches; ++batch) {
+                Common::TaskGroup group{stealing};
+                for (std::size_t i{}; i < threads; ++i)
+                    group.Run([] { Spin(20000); });
+                group.Wait();
+            }
+        })};
+        Report("batches", round_robin_ms, stealing_ms);
+    }
+
+    // A slow task queued ahead of short ones, which round-robin leaves waiting behind it
+    {
+        const u32 rounds{20 * scale};
+        const std::size_t short_tasks{threads * 16};
+        const auto slow{[] { std::this_thread::sleep_for(std::chrono::milliseconds{20}); }};
+        const auto fast{[] { Spin(50000); }};
+        double round_robin_ms{}, stealing_ms{};
+        for (u32 round{}; round < rounds; ++round) {
+            auto slow_future{round_robin.Push(slow)};
+            round_robin_ms += Measure([&] {
+                std::vector<std::future<void>> futures;
+                for (std::size_t i{}; i < short_tasks; ++i)
+                    futures.push_back(round_robin.Push(fast));
+                for (auto& future : futures)
+                    future.get();
+            });
+            slow_future.get();
+            Common::TaskGroup slow_group{stealing};
+            slow_group.Run(slow);
+            stealing_ms += Measure([&] {
+                Common::TaskGroup group{stealing};
+                for (std::size_t i{}; i < short_tasks; ++i)
+                    group.Run(fast);
+                group.Wait();
+            });
+            slow_group.Wait();
+        }
+        Report("behind a slow task", round_robin_ms, stealing_ms);
+    }
+
+    // A loop over an array, split evenly for round-robin and in chunks by ParallelFor
+    {
+        const std::size_t size{std::size_t{1} << 24};
+        std::vector<float> data(size);
+        for (std::size_t i{}; i < size; ++i)
+            data[i] = static_cast<float>(i % 1000);
+        const auto work{[&data](std::size_t begin, std::size_t end) {
+            for (std::size_t i{begin}; i < end; ++i)
+                data[i] = std::sqrt(data[i] * data[i] + 1.0f);
+        }};
+        double round_robin_ms{}, stealing_ms{};
+        for (u32 i{}; i < scale; ++i) {
+            round_robin_ms += Measure([&] {
+                std::vector<std::future<void>> futures;
+                const std::size_t slice{(size + threads - 1) / threads};
+                for (std::size_t begin{}; begin < size; begin += slice)
+                    futures.push_back(round_robin.Push(
+                        [&work, begin, end = std::min(begin + slice, size)] { work(begin, end); }));
+                for (auto& future : futures)
+                    future.get();
+            });
+            stealing_ms += Measure([&] { stealing.ParallelFor(0, size, 4096, work); });
+        }
+        Report("parallel for", round_robin_ms, stealing_ms);
+    }
+    return 0;
+}
@@ -4,11 +4,11 @@
 
 #include <array>
 #include <cstddef>
-#include <future>
 #include <memory>
 #include <utility>
 #include "common/assert.h"
 #include "common/logging/log.h"
+#include "common/profiling.h"
 #include "common/thread_pool.h"
 #include "common/vector_math.h"
 #include "core/hle/service/gsp/gsp.h"
@@ -328,14 +328,16 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
             }
         }};
         auto& thread_pool{Common::ThreadPool::GetPool()};
-        std::vector<std::future<void>> futures;
+        Common::TaskGroup vs_tasks{thread_pool};
         u32 vs_threads{regs.pipeline.num_vertices / Settings::values.min_vertices_per_thread};
         vs_threads = std::min(vs_threads, std::thread::hardware_concurrency() - 1);
         if (!vs_threads)
             VSUnitLoop(0, std::integral_constant<u32, 1>{});
         else
             for (unsigned int thread_id{}; thread_id < vs_threads; ++thread_id)
-                futures.emplace_back(thread_pool.Push(VSUnitLoop, thread_id, vs_threads));
+                vs_tasks.Run([&VSUnitLoop, thread_id, vs_threads] {
+                    VSUnitLoop(thread_id, vs_threads);
+                });
         g_state.geometry_pipeline.Reconfigure();
         g_state.geometry_pipeline.Setup(shader_engine);
         if (g_state.geometry_pipeline.NeedIndexInput())
@@ -347,18 +349,18 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                 g_state.geometry_pipeline.SubmitIndex(vertex);
                 continue;
             }
-            // Synchronize threads
+            // Synchronize threads, running the shader tasks no worker took yet meanwhile
             if (vs_threads)
                 while (batch_id != cached_vertex.batch.load(std::memory_order_acquire))
-                    std::this_thread::yield();
+                    if (!vs_tasks.RunPendingTask())
+                        std::this_thread::yield();
             if (use_gs)
                 // Send to geometry pipeline
                 g_state.geometry_pipeline.SubmitVertex(cached_vertex.output_attr);
             else
                 primitive_assembler.SubmitVertex(cached_vertex.output_vertex);
         }
-        for (auto& future : futures)
-            future.get();
+        vs_tasks.Wait();
         VideoCore::g_renderer->GetRasterizer()->DrawTriangles();
         break;
     }
@@ -400,7 +402,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
             LOG_ERROR(HW_GPU, "Invalid GS program offset {}", offset);
         else {
             g_state.gs.program_code[offset] = value;
-            g_state.gs.MarkProgramCodeDirty();
+            g_state.gs.MarkProgramCodeDirty(offset);
             offset++;
         }
         break;
@@ -418,7 +420,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
             LOG_ERROR(HW_GPU, "Invalid GS swizzle pattern offset {}", offset);
         else {
             g_state.gs.swizzle_data[offset] = value;
-            g_state.gs.MarkSwizzleDataDirty();
+            g_state.gs.MarkSwizzleDataDirty(offset);
             offset++;
         }
         break;
@@ -464,10 +466,10 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
             LOG_ERROR(HW_GPU, "Invalid VS program offset {}", offset);
         else {
             g_state.vs.program_code[offset] = value;
-            g_state.vs.MarkProgramCodeDirty();
+            g_state.vs.MarkProgramCodeDirty(offset);
             if (!g_state.regs.pipeline.gs_unit_exclusive_configuration) {
                 g_state.gs.program_code[offset] = value;
-                g_state.gs.MarkProgramCodeDirty();
+                g_state.gs.MarkProgramCodeDirty(offset);
             }
             offset++;
         }
@@ -486,10 +488,10 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
             LOG_ERROR(HW_GPU, "Invalid VS swizzle pattern offset {}", offset);
         else {
             g_state.vs.swizzle_data[offset] = value;
-            g_state.vs.MarkSwizzleDataDirty();
+            g_state.vs.MarkSwizzleDataDirty(offset);
             if (!g_state.regs.pipeline.gs_unit_exclusive_configuration) {
                 g_state.gs.swizzle_data[offset] = value;
-                g_state.gs.MarkSwizzleDataDirty();
+                g_state.gs.MarkSwizzleDataDirty(offset);
             }
             offset++;
         }
@@ -558,6 +560,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 }
 
 void ProcessCommandList(const u32* list, u32 size) {
+    PROFILE_SCOPE("gpu", "ProcessCommandList");
     g_state.cmd_list.head_ptr = g_state.cmd_list.current_ptr = list;
     g_state.cmd_list.length = size / sizeof(u32);
     while (g_state.cmd_list.current_ptr < g_state.cmd_list.head_ptr + g_state.cmd_list.length) {
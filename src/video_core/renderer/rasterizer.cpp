@@ -11,6 +11,7 @@
 #include "common/assert.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
+#include "common/profiling.h"
 #include "common/scope_exit.h"
 #include "common/vector_math.h"
 #include "core/core_timing.h"
@@ -439,6 +440,7 @@ void Rasterizer::DrawTriangles() {
 }
 
 bool Rasterizer::Draw(bool accelerate, bool is_indexed) {
+    PROFILE_SCOPE("gpu", "Rasterizer::Draw");
     const auto& regs{Pica::g_state.regs};
     bool shadow_rendering{regs.framebuffer.output_merger.fragment_operation_mode ==
                           Pica::FramebufferRegs::FragmentOperationMode::Shadow};
@@ -17,7 +17,9 @@
 #include "common/color.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
+#include "common/profiling.h"
 #include "common/scope_exit.h"
+#include "common/thread_pool.h"
 #include "common/vector_math.h"
 #include "core/memory.h"
 #include "core/settings.h"
@@ -170,6 +172,16 @@ static constexpr std::array<void (*)(u32, u32, u8*, PAddr, PAddr, PAddr), 18> gl
     MortonCopy<false, PixelFormat::D24S8> // 17
 }};
 
+CachedSurface::MortonCopyFn CachedSurface::GetMortonToGLFunction(PixelFormat format) {
+    const auto index{static_cast<std::size_t>(format)};
+    return index < morton_to_gl_fns.size() ? morton_to_gl_fns[index] : nullptr;
+}
+
+CachedSurface::MortonCopyFn CachedSurface::GetGLToMortonFunction(PixelFormat format) {
+    const auto index{static_cast<std::size_t>(format)};
+    return index < gl_to_morton_fns.size() ? gl_to_morton_fns[index] : nullptr;
+}
+
 // Allocate an uninitialized texture of appropriate size and format for the surface
 static void AllocateSurfaceTexture(GLuint texture, const FormatTuple& format_tuple, u32 width,
                                    u32 height) {
@@ -532,7 +544,11 @@ void RasterizerCache::CopySurface(const Surface& src_surface, const Surface& dst
     UNREACHABLE();
 }
 
+// Rows of a texture decoded per task, small textures are decoded on the calling thread
+constexpr std::size_t TEXTURE_DECODE_GRAIN{16};
+
 void CachedSurface::LoadGLBuffer(PAddr load_start, PAddr load_end) {
+    PROFILE_SCOPE("gpu", "CachedSurface::LoadGLBuffer");
     ASSERT(type != SurfaceType::Fill);
     const u8* texture_src_data{Memory::GetPhysicalPointer(addr)};
     if (!texture_src_data)
@@ -563,14 +579,19 @@ void CachedSurface::LoadGLBuffer(PAddr load_start, PAddr load_end) {
             const SurfaceInterval load_interval{load_start, load_end};
             const auto rect{GetSubRect(FromInterval(load_interval))};
             ASSERT(FromInterval(load_interval).GetInterval() == load_interval);
-            for (unsigned y{rect.bottom}; y < rect.top; ++y) {
-                for (unsigned x{rect.left}; x < rect.right; ++x) {
-                    auto vec4{Pica::Texture::LookupTexture(texture_src_data, x, height - 1 - y,
-                                                           tex_info)};
-                    const std::size_t offset{(x + (width * y)) * 4};
-                    std::memcpy(&gl_buffer[offset], vec4.AsArray(), 4);
+            // Decoding texel by texel is slow, rows are spread over the pool
+            const auto decode_rows{[&](std::size_t begin, std::size_t end) {
+                for (std::size_t y{begin}; y < end; ++y) {
+                    for (unsigned x{rect.left}; x < rect.right; ++x) {
+                        auto vec4{Pica::Texture::LookupTexture(
+                            texture_src_data, x, height - 1 - static_cast<unsigned>(y), tex_info)};
+                        const std::size_t offset{(x + (width * y)) * 4};
+                        std::memcpy(&gl_buffer[offset], vec4.AsArray(), 4);
+                    }
                 }
-            }
+            }};
+            Common::ThreadPool::GetPool().ParallelFor(rect.bottom, rect.top, TEXTURE_DECODE_GRAIN,
+                                                      decode_rows);
         } else
             morton_to_gl_fns[static_cast<std::size_t>(pixel_format)](stride, height, &gl_buffer[0],
                                                                      addr, load_start, load_end);
@@ -578,6 +599,7 @@ void CachedSurface::LoadGLBuffer(PAddr load_start, PAddr load_end) {
 }
 
 void CachedSurface::FlushGLBuffer(PAddr flush_start, PAddr flush_end) {
+    PROFILE_SCOPE("gpu", "CachedSurface::FlushGLBuffer");
     u8* dst_buffer{Memory::GetPhysicalPointer(addr)};
     if (!dst_buffer)
         return;
@@ -612,6 +634,7 @@ void CachedSurface::FlushGLBuffer(PAddr flush_start, PAddr flush_end) {
 
 void CachedSurface::UploadGLTexture(const MathUtil::Rectangle<u32>& rect, GLuint read_fb_handle,
                                     GLuint draw_fb_handle) {
+    PROFILE_SCOPE("gpu", "CachedSurface::UploadGLTexture");
     if (type == SurfaceType::Fill)
         return;
     if (!(gl_buffer_size == width * height * GetGLBytesPerPixel(pixel_format)))
@@ -660,6 +683,7 @@ void CachedSurface::UploadGLTexture(const MathUtil::Rectangle<u32>& rect, GLuint
 
 void CachedSurface::DownloadGLTexture(const MathUtil::Rectangle<u32>& rect, GLuint read_fb_handle,
                                       GLuint draw_fb_handle) {
+    PROFILE_SCOPE("gpu", "CachedSurface::DownloadGLTexture");
     if (type == SurfaceType::Fill)
         return;
     if (!gl_buffer) {
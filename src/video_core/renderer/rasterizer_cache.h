@@ -301,6 +301,15 @@ struct CachedSurface : SurfaceParams, std::enable_shared_from_this<CachedSurface
                          : SurfaceParams::GetFormatBpp(format) / 8;
     }
 
+    using MortonCopyFn = void (*)(u32 stride, u32 height, u8* gl_buffer, PAddr base, PAddr start,
+                                  PAddr end);
+
+    /// Gets the copy from tiled guest memory to the gl_buffer layout, nullptr if not tiled
+    static MortonCopyFn GetMortonToGLFunction(PixelFormat format);
+
+    /// Gets the copy from the gl_buffer layout to tiled guest memory, nullptr if not tiled
+    static MortonCopyFn GetGLToMortonFunction(PixelFormat format);
+
     std::unique_ptr<u8[]> gl_buffer;
     std::size_t gl_buffer_size;
 
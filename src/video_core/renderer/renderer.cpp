@@ -9,6 +9,7 @@
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/logging/log.h"
+#include "common/profiling.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/frontend.h"
@@ -95,6 +96,8 @@ Renderer::~Renderer() = default;
 
 /// Swap buffers (render frame)
 void Renderer::SwapBuffers() {
+    PROFILE_SCOPE("gpu", "Renderer::SwapBuffers");
+    PROFILE_MARK_FRAME();
     // Maintain the rasterizer's OpenGLState as a priority
     auto prev_state{OpenGLState::GetCurState()};
     state.Apply();
@@ -129,30 +132,12 @@ void Renderer::SwapBuffers() {
         }
     }
     if (VideoCore::g_screenshot_requested) {
-        // Draw this frame to the screenshot framebuffer
-        screenshot_framebuffer.Create();
-        GLuint old_read_fb{state.draw.read_framebuffer};
-        GLuint old_draw_fb{state.draw.draw_framebuffer};
-        state.draw.read_framebuffer = state.draw.draw_framebuffer = screenshot_framebuffer.handle;
-        state.Apply();
-        Layout::FramebufferLayout layout{VideoCore::g_screenshot_framebuffer_layout};
-        GLuint renderbuffer;
-        glGenRenderbuffers(1, &renderbuffer);
-        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGB8, layout.width, layout.height);
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER,
-                                  renderbuffer);
-        DrawScreens(layout);
-        glReadPixels(0, 0, layout.width, layout.height, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV,
-                     VideoCore::g_screenshot_bits);
-        screenshot_framebuffer.Release();
-        state.draw.read_framebuffer = old_read_fb;
-        state.draw.draw_framebuffer = old_draw_fb;
-        state.Apply();
-        glDeleteRenderbuffers(1, &renderbuffer);
+        CaptureScreens(VideoCore::g_screenshot_framebuffer_layout, VideoCore::g_screenshot_bits);
         VideoCore::g_screenshot_complete_callback();
         VideoCore::g_screenshot_requested = false;
     }
+    if (VideoCore::g_frame_exporter)
+        ExportFrame(*VideoCore::g_frame_exporter);
     auto& frontend{system.GetFrontend()};
     DrawScreens(frontend.GetFramebufferLayout());
     system.perf_stats.EndSystemFrame();
@@ -163,6 +148,69 @@ void Renderer::SwapBuffers() {
     prev_state.Apply();
 }
 
+/// Draws the screens to data through an offscreen framebuffer, or to the bound pixel pack buffer
+void Renderer::CaptureScreens(const Layout::FramebufferLayout& layout, void* data) {
+    capture_framebuffer.Create();
+    GLuint old_read_fb{state.draw.read_framebuffer};
+    GLuint old_draw_fb{state.draw.draw_framebuffer};
+    state.draw.read_framebuffer = state.draw.draw_framebuffer = capture_framebuffer.handle;
+    state.Apply();
+    // The renderbuffer is kept between captures, and only reallocated when the size changes
+    if (layout.width != capture_width || layout.height != capture_height) {
+        capture_renderbuffer.Create();
+        glBindRenderbuffer(GL_RENDERBUFFER, capture_renderbuffer.handle);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGB8, layout.width, layout.height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER,
+                                  capture_renderbuffer.handle);
+        capture_width = layout.width;
+        capture_height = layout.height;
+    }
+    DrawScreens(layout);
+    glReadPixels(0, 0, layout.width, layout.height, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, data);
+    state.draw.read_framebuffer = old_read_fb;
+    state.draw.draw_framebuffer = old_draw_fb;
+    state.Apply();
+}
+
+/// Hands the frames read back since the last swap to the exporter, then captures this one
+void Renderer::ExportFrame(VideoCore::FrameExporter& exporter) {
+    // The slot written now holds the frame from two swaps ago if it wasn't exported yet, mapping
+    // it waits for the read back, which is long done by now
+    auto& slot{capture_slots[next_capture_slot]};
+    auto& previous{capture_slots[next_capture_slot ^ 1]};
+    if (slot.fence.handle)
+        ExportCapture(exporter, slot);
+    if (previous.fence.handle &&
+        glClientWaitSync(previous.fence.handle, 0, 0) == GL_ALREADY_SIGNALED)
+        ExportCapture(exporter, previous);
+    const auto layout{exporter.GetFrameLayout()};
+    if (layout.width == 0 || layout.height == 0)
+        return;
+    const std::size_t size{std::size_t{layout.width} * layout.height * sizeof(u32)};
+    slot.pixel_buffer.Create();
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pixel_buffer.handle);
+    if (slot.size != size) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+        slot.size = size;
+    }
+    CaptureScreens(layout, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence.Create();
+    slot.layout = layout;
+    next_capture_slot ^= 1;
+}
+
+void Renderer::ExportCapture(VideoCore::FrameExporter& exporter, CaptureSlot& slot) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pixel_buffer.handle);
+    const void* data{glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.size, GL_MAP_READ_BIT)};
+    if (data) {
+        exporter.ExportFrame(slot.layout, data);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence.Release();
+}
+
 /// Loads framebuffer from emulated memory into the active OpenGL texture.
 void Renderer::LoadFBToScreenInfo(const GPU::Regs::FramebufferConfig& framebuffer,
                                   ScreenInfo& screen_info, bool right_eye) {
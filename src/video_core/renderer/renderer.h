@@ -5,22 +5,24 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 #include <glad/glad.h>
 #include "common/common_types.h"
 #include "common/math_util.h"
+#include "core/framebuffer_layout.h"
 #include "core/hw/gpu.h"
 #include "video_core/renderer/rasterizer.h"
 #include "video_core/renderer/resource_manager.h"
 #include "video_core/renderer/state.h"
 
-namespace Layout {
-struct FramebufferLayout;
-} // namespace Layout
-
 namespace Core {
 class System;
 } // namespace Core
 
+namespace VideoCore {
+class FrameExporter;
+} // namespace VideoCore
+
 /// Structure used for storing information about the textures for each console screen
 struct TextureInfo {
     Texture resource;
@@ -58,6 +60,8 @@ private:
     void ConfigureFramebufferTexture(TextureInfo& texture,
                                      const GPU::Regs::FramebufferConfig& framebuffer);
     void DrawScreens(const Layout::FramebufferLayout& layout);
+    void CaptureScreens(const Layout::FramebufferLayout& layout, void* data);
+    void ExportFrame(VideoCore::FrameExporter& exporter);
     void DrawSingleScreenRotated(const ScreenInfo& screen_info, float x, float y, float w, float h);
 
     // Loads framebuffer from emulated memory into the display information structure
@@ -72,7 +76,23 @@ private:
     VertexArray vertex_array;
     Buffer vertex_buffer;
     Program shader;
-    Framebuffer screenshot_framebuffer;
+    Framebuffer capture_framebuffer;
+    Renderbuffer capture_renderbuffer;
+    u32 capture_width{};
+    u32 capture_height{};
+
+    /// Frame read back for the frame exporter, mapped once its fence is signaled
+    struct CaptureSlot {
+        Buffer pixel_buffer;
+        Sync fence;
+        Layout::FramebufferLayout layout{};
+        std::size_t size{};
+    };
+
+    void ExportCapture(VideoCore::FrameExporter& exporter, CaptureSlot& slot);
+
+    std::array<CaptureSlot, 2> capture_slots;
+    std::size_t next_capture_slot{};
 
     /// Display information for top and bottom screens respectively
     std::array<ScreenInfo, 3> screen_infos;
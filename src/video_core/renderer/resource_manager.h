@@ -227,6 +227,40 @@ public:
     GLuint handle{};
 };
 
+class Renderbuffer : private NonCopyable {
+public:
+    Renderbuffer() = default;
+
+    Renderbuffer(Renderbuffer&& o) : handle{std::exchange(o.handle, 0)} {}
+
+    ~Renderbuffer() {
+        Release();
+    }
+
+    Renderbuffer& operator=(Renderbuffer&& o) {
+        Release();
+        handle = std::exchange(o.handle, 0);
+        return *this;
+    }
+
+    /// Creates a new internal OpenGL resource and stores the handle
+    void Create() {
+        if (handle != 0)
+            return;
+        glGenRenderbuffers(1, &handle);
+    }
+
+    /// Deletes the internal OpenGL resource
+    void Release() {
+        if (handle == 0)
+            return;
+        glDeleteRenderbuffers(1, &handle);
+        handle = 0;
+    }
+
+    GLuint handle{};
+};
+
 class Sync : private NonCopyable {
 public:
     Sync() = default;
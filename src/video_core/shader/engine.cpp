@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include "video_core/shader/compiler.h"
 #include "video_core/shader/engine.h"
 #include "video_core/shader/shader.h"
@@ -15,18 +16,37 @@ ShaderEngine::~ShaderEngine() = default;
 void ShaderEngine::SetupBatch(ShaderSetup& setup, unsigned int entry_point) {
     ASSERT(entry_point < MAX_PROGRAM_CODE_LENGTH);
     setup.engine_data.entry_point = entry_point;
-    u64 code_hash{setup.GetProgramCodeHash()};
-    u64 swizzle_hash{setup.GetSwizzleDataHash()};
-    u64 cache_key{code_hash ^ swizzle_hash};
-    auto iter{cache.find(cache_key)};
-    if (iter != cache.end())
-        setup.engine_data.cached_shader = iter->second.get();
-    else {
-        auto shader{std::make_unique<Shader>()};
-        shader->Compile(&setup.program_code, &setup.swizzle_data);
-        setup.engine_data.cached_shader = shader.get();
-        cache.emplace_hint(iter, cache_key, std::move(shader));
+    // Still valid unless the program or swizzle data were written since the last batch
+    if (setup.engine_data.cached_shader)
+        return;
+    const u64 code_hash{setup.GetProgramCodeHash()};
+    const u64 swizzle_hash{setup.GetSwizzleDataHash()};
+    // Unlike a xor, this doesn't map equal or swapped hashes to the same key
+    const u64 cache_key{code_hash ^
+                        (swizzle_hash + 0x9E3779B97F4A7C15 + (code_hash << 6) + (code_hash >> 2))};
+    const auto code_begin{setup.program_code.begin()};
+    const auto code_end{code_begin + setup.GetProgramCodeLength()};
+    const auto swizzle_begin{setup.swizzle_data.begin()};
+    const auto swizzle_end{swizzle_begin + setup.GetSwizzleDataLength()};
+    // The key only narrows the search down, a hit must have the same contents
+    const auto [begin, end]{cache.equal_range(cache_key)};
+    const auto iter{std::find_if(begin, end, [&](const auto& entry) {
+        const CachedShader& cached{entry.second};
+        return std::equal(cached.program_code.begin(), cached.program_code.end(), code_begin,
+                          code_end) &&
+               std::equal(cached.swizzle_data.begin(), cached.swizzle_data.end(), swizzle_begin,
+                          swizzle_end);
+    })};
+    if (iter != end) {
+        setup.engine_data.cached_shader = iter->second.shader.get();
+        return;
     }
+    auto shader{std::make_unique<Shader>()};
+    shader->Compile(&setup.program_code, &setup.swizzle_data);
+    setup.engine_data.cached_shader = shader.get();
+    cache.emplace(cache_key, CachedShader{{code_begin, code_end},
+                                          {swizzle_begin, swizzle_end},
+                                          std::move(shader)});
 }
 
 void ShaderEngine::Run(const ShaderSetup& setup, UnitState& state) const {
@@ -6,6 +6,7 @@
 
 #include <memory>
 #include <unordered_map>
+#include <vector>
 #include "common/common_types.h"
 
 namespace Pica::Shader {
@@ -34,7 +35,15 @@ public:
     void Run(const ShaderSetup& setup, UnitState& state) const;
 
 private:
-    std::unordered_map<u64, std::unique_ptr<Shader>> cache;
+    struct CachedShader {
+        /// What the shader was compiled from, up to the last words written
+        std::vector<u32> program_code;
+        std::vector<u32> swizzle_data;
+        std::unique_ptr<Shader> shader;
+    };
+
+    /// Compiled shaders by the hash of their program and swizzle data
+    std::unordered_multimap<u64, CachedShader> cache;
 };
 
 } // namespace Pica::Shader
@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <bitset>
 #include <cstddef>
 #include <functional>
 #include <type_traits>
@@ -195,48 +197,100 @@ struct Uniforms {
     }
 };
 
+/**
+ * Hash of a word array kept per block, so that a write only re-hashes the block it touched. Only
+ * the blocks up to the last word ever written are hashed, the rest hold their initial zeros.
+ */
+template <std::size_t Length>
+class IncrementalHash {
+public:
+    void MarkDirty(std::size_t offset) {
+        dirty_blocks.set(offset / BLOCK_LENGTH);
+        length = std::max(length, offset + 1);
+        dirty = true;
+    }
+
+    u64 Get(const std::array<u32, Length>& data) {
+        if (dirty) {
+            const std::size_t num_blocks{(length + BLOCK_LENGTH - 1) / BLOCK_LENGTH};
+            for (std::size_t block{}; block < num_blocks; ++block)
+                if (block >= hashed_blocks || dirty_blocks[block])
+                    block_hashes[block] = Common::ComputeHash64(&data[block * BLOCK_LENGTH],
+                                                                BLOCK_LENGTH * sizeof(u32));
+            dirty_blocks.reset();
+            hashed_blocks = num_blocks;
+            hash = Common::ComputeHash64(block_hashes.data(), num_blocks * sizeof(u64));
+            dirty = false;
+        }
+        return hash;
+    }
+
+    /// Number of words up to the last one written
+    std::size_t GetLength() const {
+        return length;
+    }
+
+private:
+    static constexpr std::size_t BLOCK_LENGTH{64};
+    static constexpr std::size_t NUM_BLOCKS{Length / BLOCK_LENGTH};
+    static_assert(Length % BLOCK_LENGTH == 0);
+
+    // Zero is a valid state, the Pica state is reset with memset
+    std::bitset<NUM_BLOCKS> dirty_blocks;
+    std::array<u64, NUM_BLOCKS> block_hashes;
+    /// Blocks with a hash in block_hashes, the blocks past them were never hashed
+    std::size_t hashed_blocks{};
+    std::size_t length{};
+    u64 hash{};
+    bool dirty{};
+};
+
 struct ShaderSetup {
     Uniforms uniforms;
 
-    std::array<u32, MAX_PROGRAM_CODE_LENGTH> program_code;
-    std::array<u32, MAX_SWIZZLE_DATA_LENGTH> swizzle_data;
+    std::array<u32, MAX_PROGRAM_CODE_LENGTH> program_code{};
+    std::array<u32, MAX_SWIZZLE_DATA_LENGTH> swizzle_data{};
 
     /// Data private to ShaderEngine
     struct EngineData {
         unsigned int entry_point;
-        /// Points to a compiled shader object.
+        /// Points to a compiled shader object, cleared when the program or swizzle data change.
         const void* cached_shader{};
     } engine_data;
 
-    void MarkProgramCodeDirty() {
-        program_code_hash_dirty = true;
+    /// Records a write to the word of program_code at offset
+    void MarkProgramCodeDirty(std::size_t offset) {
+        program_code_hash.MarkDirty(offset);
+        engine_data.cached_shader = nullptr;
     }
 
-    void MarkSwizzleDataDirty() {
-        swizzle_data_hash_dirty = true;
+    /// Records a write to the word of swizzle_data at offset
+    void MarkSwizzleDataDirty(std::size_t offset) {
+        swizzle_data_hash.MarkDirty(offset);
+        engine_data.cached_shader = nullptr;
     }
 
     u64 GetProgramCodeHash() {
-        if (program_code_hash_dirty) {
-            program_code_hash = Common::ComputeHash64(&program_code, sizeof(program_code));
-            program_code_hash_dirty = false;
-        }
-        return program_code_hash;
+        return program_code_hash.Get(program_code);
     }
 
     u64 GetSwizzleDataHash() {
-        if (swizzle_data_hash_dirty) {
-            swizzle_data_hash = Common::ComputeHash64(&swizzle_data, sizeof(swizzle_data));
-            swizzle_data_hash_dirty = false;
-        }
-        return swizzle_data_hash;
+        return swizzle_data_hash.Get(swizzle_data);
+    }
+
+    /// Number of words of program_code up to the last one written
+    std::size_t GetProgramCodeLength() const {
+        return program_code_hash.GetLength();
+    }
+
+    /// Number of words of swizzle_data up to the last one written
+    std::size_t GetSwizzleDataLength() const {
+        return swizzle_data_hash.GetLength();
     }
 
 private:
-    bool program_code_hash_dirty{true};
-    bool swizzle_data_hash_dirty{true};
-    u64 program_code_hash{0xDEADC0DE};
-    u64 swizzle_data_hash{0xDEADC0DE};
+    IncrementalHash<MAX_PROGRAM_CODE_LENGTH> program_code_hash;
+    IncrementalHash<MAX_SWIZZLE_DATA_LENGTH> swizzle_data_hash;
 };
 
 // TODO: Remove and make it non-global state somewhere
@@ -20,6 +20,7 @@ std::atomic_bool g_screenshot_requested;
 void* g_screenshot_bits;
 std::function<void()> g_screenshot_complete_callback;
 Layout::FramebufferLayout g_screenshot_framebuffer_layout;
+FrameExporter* g_frame_exporter;
 
 /// Initialize the video core
 Core::System::ResultStatus Init(Core::System& system) {
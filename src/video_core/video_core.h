@@ -5,6 +5,7 @@
 #pragma once
 
 #include <atomic>
+#include <functional>
 #include <memory>
 #include "core/core.h"
 #include "core/framebuffer_layout.h"
@@ -17,6 +18,21 @@ class Renderer;
 
 namespace VideoCore {
 
+/**
+ * Receives every presented frame, such as to share it with other processes. Frames are read back
+ * asynchronously, so they arrive in order but a swap or two after they were presented.
+ */
+class FrameExporter {
+public:
+    virtual ~FrameExporter() = default;
+
+    /// Called on the emu thread after every frame, a zero sized layout skips capturing it
+    virtual Layout::FramebufferLayout GetFrameLayout() = 0;
+
+    /// Receives a frame captured with the layout, as BGRA8 rows from the bottom up
+    virtual void ExportFrame(const Layout::FramebufferLayout& layout, const void* data) = 0;
+};
+
 extern std::unique_ptr<Renderer> g_renderer;
 extern std::atomic_bool g_hw_shaders_enabled;
 extern std::atomic_bool g_hw_shaders_accurate_gs;
@@ -27,6 +43,9 @@ extern void* g_screenshot_bits;
 extern std::function<void()> g_screenshot_complete_callback;
 extern Layout::FramebufferLayout g_screenshot_framebuffer_layout;
 
+/// Only changed while the video core isn't initialized
+extern FrameExporter* g_frame_exporter;
+
 /// Initialize the video core
 Core::System::ResultStatus Init(Core::System& system);
 